@@ -0,0 +1,1664 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <elf.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "asm.h"
+
+/*
+ * Integrated assembler: AT&T text, as write_asm() prints it, to an ELF64
+ * relocatable object.
+ *
+ * It only knows the instructions and directives the code generator
+ * emits (plus the obvious neighbours of each).  Anything else makes
+ * assemble_elf() return -1 with a message, and the caller falls back to
+ * running as on the same text, so a gap here costs speed, not
+ * correctness.
+ *
+ * Lines become items: a run of bytes, a label, an alignment, a branch or
+ * a CFI note.  Only branches change size: they all start short and any
+ * whose target ends up out of rel8 range is made long, until nothing
+ * changes.  Then symbol values are known and the fixups left in the
+ * bytes are either patched (a target in the same section) or written
+ * as relocations.  .eh_frame is built from the .cfi_ notes the way as
+ * would, so backtraces through k0 code still work.
+ */
+
+enum { SEC_TEXT, SEC_DATA, SEC_RELRO, SEC_RODATA, SEC_NOTE, NSECS };
+static const char *secname[NSECS] = {
+    ".text", ".data", ".data.rel.ro.local", ".rodata", ".note.GNU-stack"
+};
+
+enum { IT_BYTES, IT_LABEL, IT_ALIGN, IT_BRANCH, IT_CFI, IT_SIZE };
+
+/* fixup kinds; FX_DIFF64 is sym - sym2 + addend, resolved here */
+enum { FX_NONE, FX_PC32, FX_PLT32, FX_ABS64, FX_DIFF64 };
+
+struct fixup {
+    int kind, at;           /* at: byte offset within the item */
+    int sym, sym2;
+    long addend;
+};
+
+struct item {
+    int kind, sec;
+    int pos, len;           /* bytes in pool[pos .. pos+len) */
+    int off;                /* offset in the section after layout */
+    int sym;                /* IT_LABEL, IT_BRANCH target, IT_SIZE */
+    int cc;                 /* IT_BRANCH: condition, -1 for jmp */
+    int lng;                /* IT_BRANCH: rel32 form */
+    int align;              /* IT_ALIGN */
+    int cfi, a, b;          /* IT_CFI */
+    struct fixup fix;
+};
+
+struct sym {
+    char *name;
+    int defined, sec, item; /* item: the IT_LABEL defining it */
+    int global, func;
+    int referenced;
+    long size;
+    int elfidx;
+    int next;               /* hash chain */
+    void *addr;             /* -run: address of an undefined symbol */
+    int stub;               /* -run: 1 + its call stub, 0 if none yet */
+};
+
+enum { CFI_START, CFI_END, CFI_DEF_CFA_OFFSET, CFI_OFFSET, CFI_DEF_CFA_REGISTER,
+       CFI_DEF_CFA, CFI_REMEMBER, CFI_RESTORE_STATE };
+
+#define SYMHASH 1024
+
+static struct item *items;
+static int nitems, capitems;
+static unsigned char *pool;
+static int npool, cappool;
+static struct sym *syms;
+static int nsyms, capsyms;
+static int symhash[SYMHASH];
+static char *filename;
+static int cursec, lineno;
+static char errmsg[256];
+
+static int fail(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = snprintf(errmsg, sizeof errmsg, "line %d: ", lineno);
+    vsnprintf(errmsg + n, sizeof errmsg - n, fmt, ap);
+    va_end(ap);
+    return -1;
+}
+
+static void *grow(void *p, int *cap, int need, size_t size) {
+    if (need <= *cap) return p;
+    int n = *cap ? *cap : 256;
+    while (n < need) n *= 2;
+    p = realloc(p, n * size);
+    if (!p) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+    *cap = n;
+    return p;
+}
+
+static int lookup(const char *name, size_t len) {
+    unsigned h = 5381;
+    for (size_t i = 0; i < len; i++) h = h * 33 + (unsigned char)name[i];
+    h %= SYMHASH;
+    for (int i = symhash[h]; i >= 0; i = syms[i].next)
+        if (strlen(syms[i].name) == len && strncmp(syms[i].name, name, len) == 0)
+            return i;
+    syms = grow(syms, &capsyms, nsyms + 1, sizeof *syms);
+    struct sym *s = &syms[nsyms];
+    memset(s, 0, sizeof *s);
+    s->name = strndup(name, len);
+    s->next = symhash[h];
+    symhash[h] = nsyms;
+    return nsyms++;
+}
+
+static struct item *new_item(int kind) {
+    items = grow(items, &capitems, nitems + 1, sizeof *items);
+    struct item *it = &items[nitems++];
+    memset(it, 0, sizeof *it);
+    it->kind = kind;
+    it->sec = cursec;
+    it->pos = npool;
+    it->sym = -1;
+    return it;
+}
+
+static struct item *add_bytes(const unsigned char *b, int n) {
+    struct item *it = new_item(IT_BYTES);
+    pool = grow(pool, &cappool, npool + n, 1);
+    memcpy(pool + npool, b, n);
+    npool += n;
+    it->len = n;
+    return it;
+}
+
+/* ---------------------------------------------------------------- operands */
+
+enum { OP_REG, OP_IMM, OP_MEM, OP_SYM };
+#define REG_RIP 16
+
+struct operand {
+    int kind;
+    int reg, size;          /* OP_REG; size 8/16/32/64, 128 xmm, 256 ymm */
+    long imm;               /* OP_IMM */
+    int base, index, scale; /* OP_MEM; -1 for none */
+    long disp;              /* OP_MEM displacement, OP_SYM addend */
+    int sym;                /* OP_MEM (%rip), OP_SYM; -1 for none */
+};
+
+static const char *gpr[4][16] = {
+    { "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+      "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b" },
+    { "ax", "cx", "dx", "bx", "sp", "bp", "si", "di",
+      "r8w", "r9w", "r10w", "r11w", "r12w", "r13w", "r14w", "r15w" },
+    { "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+      "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d" },
+    { "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+      "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15" },
+};
+
+static int parse_reg(const char *s, size_t n, int *reg, int *size) {
+    char name[8];
+    if (n == 0 || n >= sizeof name) return 0;
+    memcpy(name, s, n);
+    name[n] = '\0';
+    for (int z = 0; z < 4; z++)
+        for (int r = 0; r < 16; r++)
+            if (strcmp(name, gpr[z][r]) == 0) {
+                *reg = r;
+                *size = 8 << z;
+                return 1;
+            }
+    if (strcmp(name, "rip") == 0) {
+        *reg = REG_RIP;
+        *size = 64;
+        return 1;
+    }
+    if ((strncmp(name, "xmm", 3) == 0 || strncmp(name, "ymm", 3) == 0) &&
+        isdigit((unsigned char)name[3])) {
+        int r = atoi(name + 3);
+        if (r > 15) return 0;
+        *reg = r;
+        *size = name[0] == 'x' ? 128 : 256;
+        return 1;
+    }
+    return 0;
+}
+
+static int parse_number(const char **p, long *v) {
+    char *end;
+    /* unsigned so $0xFFFF... masks fit */
+    *v = **p == '-' ? strtol(*p, &end, 0) : (long)strtoul(*p, &end, 0);
+    if (end == *p) return 0;
+    *p = end;
+    return 1;
+}
+
+static int is_symchar(int c) {
+    return isalnum(c) || c == '_' || c == '.' || c == '$';
+}
+
+/* sym, sym+n, sym-n, or a number */
+static int parse_symexpr(const char **p, int *sym, long *add) {
+    const char *s = *p;
+    *sym = -1;
+    *add = 0;
+    if (*s == '-' || isdigit((unsigned char)*s))
+        return parse_number(p, add);
+    if (!is_symchar((unsigned char)*s)) return 0;
+    const char *e = s;
+    while (is_symchar((unsigned char)*e)) e++;
+    *sym = lookup(s, e - s);
+    syms[*sym].referenced = 1;
+    if ((*e == '+' || *e == '-') && isdigit((unsigned char)e[1])) {
+        const char *q = e + (*e == '+');
+        if (!parse_number(&q, add)) return 0;
+        e = q;
+    }
+    *p = e;
+    return 1;
+}
+
+static int parse_operand(const char *s, struct operand *op) {
+    memset(op, 0, sizeof *op);
+    op->base = op->index = op->sym = -1;
+    while (isspace((unsigned char)*s)) s++;
+    if (*s == '%') {
+        size_t n = strlen(s + 1);
+        while (n && isspace((unsigned char)s[n])) n--;
+        op->kind = OP_REG;
+        return parse_reg(s + 1, n, &op->reg, &op->size) && op->reg != REG_RIP;
+    }
+    if (*s == '$') {
+        s++;
+        op->kind = OP_IMM;
+        return parse_number(&s, &op->imm);
+    }
+    if (!strchr(s, '(')) {
+        op->kind = OP_SYM;
+        return parse_symexpr(&s, &op->sym, &op->disp) && op->sym >= 0;
+    }
+    op->kind = OP_MEM;
+    if (*s != '(' && !parse_symexpr(&s, &op->sym, &op->disp)) return 0;
+    if (*s++ != '(') return 0;
+    const char *e = s;
+    int size;
+    if (*s == '%') {
+        while (isalnum((unsigned char)*++e)) ;
+        if (!parse_reg(s + 1, e - s - 1, &op->base, &size) || size != 64) return 0;
+        s = e;
+    }
+    if (*s == ',') {
+        s++;
+        if (*s != '%') return 0;
+        e = s;
+        while (isalnum((unsigned char)*++e)) ;
+        if (!parse_reg(s + 1, e - s - 1, &op->index, &size) || size != 64 ||
+            op->index == 4 || op->index == REG_RIP)
+            return 0;
+        s = e;
+        op->scale = 1;
+        if (*s == ',') {
+            s++;
+            long sc;
+            if (!parse_number(&s, &sc) || (sc != 1 && sc != 2 && sc != 4 && sc != 8))
+                return 0;
+            op->scale = (int)sc;
+        }
+    }
+    if (*s != ')') return 0;
+    if (op->base < 0) return 0;                 /* no absolute addressing */
+    if (op->sym >= 0 && op->base != REG_RIP) return 0;
+    return 1;
+}
+
+/* ---------------------------------------------------------------- encoding */
+
+struct enc {
+    unsigned char b[16];
+    int n;
+    struct fixup fix;
+};
+
+static void put(struct enc *e, int byte) { e->b[e->n++] = (unsigned char)byte; }
+
+static void put_imm(struct enc *e, long v, int size) {
+    for (int i = 0; i < size; i++) put(e, (int)(v >> (8 * i)));
+}
+
+static int fits8(long v)  { return v >= -128 && v <= 127; }
+static int fits32(long v) { return v >= INT32_MIN && v <= INT32_MAX; }
+
+/* REX.X/B bits of an r/m operand */
+static int rex_rm(const struct operand *rm) {
+    if (rm->kind == OP_REG) return (rm->reg >> 3) & 1;
+    int r = 0;
+    if (rm->index >= 0) r |= ((rm->index >> 3) & 1) << 1;
+    if (rm->base >= 0 && rm->base != REG_RIP) r |= (rm->base >> 3) & 1;
+    return r;
+}
+
+/* ModRM, SIB and displacement; immsize bytes of immediate follow */
+static void modrm(struct enc *e, int reg, const struct operand *rm, int immsize) {
+    reg &= 7;
+    if (rm->kind == OP_REG) {
+        put(e, 0xC0 | reg << 3 | (rm->reg & 7));
+        return;
+    }
+    if (rm->base == REG_RIP) {
+        put(e, reg << 3 | 5);
+        if (rm->sym >= 0) {
+            e->fix = (struct fixup){ FX_PC32, e->n, rm->sym, -1,
+                                     rm->disp - 4 - immsize };
+            put_imm(e, 0, 4);
+        } else {
+            put_imm(e, rm->disp, 4);
+        }
+        return;
+    }
+    int b = rm->base & 7;
+    int mod = (rm->disp == 0 && b != 5) ? 0 : fits8(rm->disp) ? 1 : 2;
+    if (rm->index >= 0 || b == 4) {
+        int ss = rm->scale == 8 ? 3 : rm->scale == 4 ? 2 : rm->scale == 2 ? 1 : 0;
+        put(e, mod << 6 | reg << 3 | 4);
+        put(e, ss << 6 | (rm->index >= 0 ? rm->index & 7 : 4) << 3 | b);
+    } else {
+        put(e, mod << 6 | reg << 3 | b);
+    }
+    if (mod == 1) put(e, (int)rm->disp);
+    else if (mod == 2) put_imm(e, rm->disp, 4);
+}
+
+/*
+ * Legacy encoding: [prefix] [REX] opcode ModRM ...  w sets REX.W;
+ * byteregs forces a REX byte so %sil/%dil/%spl/%bpl are not %dh etc.
+ */
+static void enc_rm(struct enc *e, int prefix, int w, const char *op, int oplen,
+                   int reg, const struct operand *rm, int byteregs, int immsize) {
+    if (prefix) put(e, prefix);
+    int rex = (w ? 8 : 0) | ((reg >> 3) & 1) << 2 | rex_rm(rm);
+    if (rex || byteregs) put(e, 0x40 | rex);
+    for (int i = 0; i < oplen; i++) put(e, (unsigned char)op[i]);
+    modrm(e, reg, rm, immsize);
+}
+
+/* VEX: pp 0/66/F3/F2 = 0..3, map 1/2/3 = 0F/0F38/0F3A */
+static void enc_vex(struct enc *e, int pp, int map, int w, int l, int opcode,
+                    int reg, int vvvv, const struct operand *rm, int immsize) {
+    int r = (reg >> 3) & 1, xb = rex_rm(rm);
+    int x = (xb >> 1) & 1, b = xb & 1;
+    if (map == 1 && !w && !x && !b) {
+        put(e, 0xC5);
+        put(e, (!r) << 7 | ((~vvvv) & 15) << 3 | l << 2 | pp);
+    } else {
+        put(e, 0xC4);
+        put(e, (!r) << 7 | (!x) << 6 | (!b) << 5 | map);
+        put(e, w << 7 | ((~vvvv) & 15) << 3 | l << 2 | pp);
+    }
+    put(e, opcode);
+    modrm(e, reg, rm, immsize);
+}
+
+static const char *ccnames[] = {
+    "o", "no", "b", "ae", "e", "ne", "be", "a",
+    "s", "ns", "p", "np", "l", "ge", "le", "g"
+};
+
+static int condition(const char *s) {
+    static const struct { const char *name; int cc; } alias[] = {
+        { "c", 2 }, { "nae", 2 }, { "nb", 3 }, { "nc", 3 }, { "z", 4 },
+        { "nz", 5 }, { "na", 6 }, { "nbe", 7 }, { "pe", 10 }, { "po", 11 },
+        { "nge", 12 }, { "nl", 13 }, { "ng", 14 }, { "nle", 15 },
+    };
+    for (int i = 0; i < 16; i++)
+        if (strcmp(s, ccnames[i]) == 0) return i;
+    for (size_t i = 0; i < sizeof alias / sizeof alias[0]; i++)
+        if (strcmp(s, alias[i].name) == 0) return alias[i].cc;
+    return -1;
+}
+
+static int suffix_size(char c) {
+    switch (c) {
+        case 'b': return 8;
+        case 'w': return 16;
+        case 'l': return 32;
+        case 'q': return 64;
+        default:  return 0;
+    }
+}
+
+/* name is base + size suffix, e.g. addl; *size gets the suffix's width */
+static int sized(const char *m, const char *base, int *size) {
+    size_t n = strlen(base);
+    if (strncmp(m, base, n) != 0 || strlen(m) != n + 1) return 0;
+    *size = suffix_size(m[n]);
+    return *size != 0;
+}
+
+static int is_reg(const struct operand *o, int size) {
+    return o->kind == OP_REG && o->size == size;
+}
+
+static int is_rm(const struct operand *o, int size) {
+    return is_reg(o, size) || o->kind == OP_MEM;
+}
+
+static int is_xmm(const struct operand *o) { return is_reg(o, 128); }
+
+static int byte_rex(const struct operand *o) {
+    return o->kind == OP_REG && o->size == 8 && o->reg >= 4 && o->reg < 8;
+}
+
+/* SSE instructions: src, dst with dst an xmm register */
+static const struct { const char *name; int prefix; unsigned char op; } sse[] = {
+    { "addsd", 0xF2, 0x58 }, { "subsd", 0xF2, 0x5C }, { "mulsd", 0xF2, 0x59 },
+    { "divsd", 0xF2, 0x5E }, { "minsd", 0xF2, 0x5D }, { "maxsd", 0xF2, 0x5F },
+    { "sqrtsd", 0xF2, 0x51 }, { "ucomisd", 0x66, 0x2E }, { "comisd", 0x66, 0x2F },
+    { "andpd", 0x66, 0x54 }, { "orpd", 0x66, 0x56 }, { "xorpd", 0x66, 0x57 },
+    { "paddd", 0x66, 0xFE }, { "psubd", 0x66, 0xFA }, { "paddq", 0x66, 0xD4 },
+    { "pand", 0x66, 0xDB }, { "pandn", 0x66, 0xDF }, { "por", 0x66, 0xEB },
+    { "pxor", 0x66, 0xEF }, { "pcmpgtd", 0x66, 0x66 }, { "pcmpeqd", 0x66, 0x76 },
+    { "pmuludq", 0x66, 0xF4 }, { "punpckldq", 0x66, 0x62 },
+    { "addpd", 0x66, 0x58 }, { "subpd", 0x66, 0x5C }, { "mulpd", 0x66, 0x59 },
+    { "unpcklpd", 0x66, 0x14 },
+};
+
+/* SSE moves: a load form (to xmm) and a store form (xmm to memory) */
+static const struct { const char *name; int prefix; unsigned char load, store; } sse_mov[] = {
+    { "movsd", 0xF2, 0x10, 0x11 }, { "movapd", 0x66, 0x28, 0x29 },
+    { "movdqa", 0x66, 0x6F, 0x7F }, { "movdqu", 0xF3, 0x6F, 0x7F },
+    { "movupd", 0x66, 0x10, 0x11 },
+};
+
+/* AVX three-operand forms: src2, src1, dst */
+static const struct { const char *name; int map; unsigned char op; } avx3[] = {
+    { "vpaddd", 1, 0xFE }, { "vpsubd", 1, 0xFA }, { "vpxor", 1, 0xEF },
+    { "vpand", 1, 0xDB }, { "vpor", 1, 0xEB }, { "vpcmpgtd", 1, 0x66 },
+    { "vpmulld", 2, 0x40 }, { "vpmaxsd", 2, 0x3D }, { "vpminsd", 2, 0x39 },
+    { "vaddpd", 1, 0x58 }, { "vsubpd", 1, 0x5C }, { "vmulpd", 1, 0x59 },
+};
+
+/* integer ALU group: add or adc sbb and sub xor cmp */
+static const char *alu[] = { "add", "or", "adc", "sbb", "and", "sub", "xor", "cmp" };
+static const char *shifts[] = { "rol", "ror", "rcl", "rcr", "shl", "shr", "sal", "sar" };
+
+static int encode(const char *m, struct operand *o, int n, struct enc *e) {
+    int size, cc;
+    char op[3];
+
+    if (n == 0) {
+        if (strcmp(m, "ret") == 0)   { put(e, 0xC3); return 0; }
+        if (strcmp(m, "leave") == 0) { put(e, 0xC9); return 0; }
+        if (strcmp(m, "cltd") == 0)  { put(e, 0x99); return 0; }
+        if (strcmp(m, "cqto") == 0)  { put(e, 0x48); put(e, 0x99); return 0; }
+        if (strcmp(m, "cltq") == 0)  { put(e, 0x48); put(e, 0x98); return 0; }
+        if (strcmp(m, "nop") == 0)   { put(e, 0x90); return 0; }
+        if (strcmp(m, "endbr64") == 0) {
+            put_imm(e, 0xFA1E0FF3, 4);
+            return 0;
+        }
+        if (strcmp(m, "vzeroupper") == 0) {
+            put(e, 0xC5); put(e, 0xF8); put(e, 0x77);
+            return 0;
+        }
+        return fail("unsupported instruction '%s'", m);
+    }
+
+    /* ---- SSE/AVX, matched by full name before the suffix forms */
+    for (size_t i = 0; i < sizeof sse / sizeof sse[0]; i++)
+        if (strcmp(m, sse[i].name) == 0 && n == 2 && is_xmm(&o[1]) &&
+            (is_xmm(&o[0]) || o[0].kind == OP_MEM)) {
+            op[0] = 0x0F; op[1] = sse[i].op;
+            enc_rm(e, sse[i].prefix, 0, op, 2, o[1].reg, &o[0], 0, 0);
+            return 0;
+        }
+    for (size_t i = 0; i < sizeof sse_mov / sizeof sse_mov[0]; i++) {
+        if (strcmp(m, sse_mov[i].name) != 0 || n != 2) continue;
+        op[0] = 0x0F;
+        if (is_xmm(&o[1]) && (is_xmm(&o[0]) || o[0].kind == OP_MEM)) {
+            op[1] = sse_mov[i].load;
+            enc_rm(e, sse_mov[i].prefix, 0, op, 2, o[1].reg, &o[0], 0, 0);
+            return 0;
+        }
+        if (is_xmm(&o[0]) && o[1].kind == OP_MEM) {
+            op[1] = sse_mov[i].store;
+            enc_rm(e, sse_mov[i].prefix, 0, op, 2, o[0].reg, &o[1], 0, 0);
+            return 0;
+        }
+    }
+    if ((strcmp(m, "movd") == 0 || strcmp(m, "movq") == 0) && n == 2 &&
+        (is_xmm(&o[0]) || is_xmm(&o[1]))) {
+        int w = m[3] == 'q';
+        op[0] = 0x0F;
+        if (is_xmm(&o[1]) && is_rm(&o[0], w ? 64 : 32) && !is_xmm(&o[0])) {
+            if (w && o[0].kind == OP_MEM) {         /* movq m64, xmm */
+                op[1] = 0x7E;
+                enc_rm(e, 0xF3, 0, op, 2, o[1].reg, &o[0], 0, 0);
+            } else {
+                op[1] = 0x6E;
+                enc_rm(e, 0x66, w, op, 2, o[1].reg, &o[0], 0, 0);
+            }
+            return 0;
+        }
+        if (is_xmm(&o[0]) && is_rm(&o[1], w ? 64 : 32) && !is_xmm(&o[1])) {
+            if (w && o[1].kind == OP_MEM) {         /* movq xmm, m64 */
+                op[1] = 0xD6;
+                enc_rm(e, 0x66, 0, op, 2, o[0].reg, &o[1], 0, 0);
+            } else {
+                op[1] = 0x7E;
+                enc_rm(e, 0x66, w, op, 2, o[0].reg, &o[1], 0, 0);
+            }
+            return 0;
+        }
+        if (w && is_xmm(&o[0]) && is_xmm(&o[1])) {
+            op[1] = 0x7E;
+            enc_rm(e, 0xF3, 0, op, 2, o[1].reg, &o[0], 0, 0);
+            return 0;
+        }
+        return fail("bad operands for %s", m);
+    }
+    if ((strcmp(m, "cvtsi2sdq") == 0 || strcmp(m, "cvtsi2sdl") == 0) && n == 2 &&
+        is_xmm(&o[1]) && is_rm(&o[0], m[8] == 'q' ? 64 : 32)) {
+        op[0] = 0x0F; op[1] = 0x2A;
+        enc_rm(e, 0xF2, m[8] == 'q', op, 2, o[1].reg, &o[0], 0, 0);
+        return 0;
+    }
+    if ((strcmp(m, "cvttsd2si") == 0 || strcmp(m, "cvttsd2siq") == 0) && n == 2 &&
+        o[1].kind == OP_REG && (o[1].size == 32 || o[1].size == 64) &&
+        (is_xmm(&o[0]) || o[0].kind == OP_MEM)) {
+        op[0] = 0x0F; op[1] = 0x2C;
+        enc_rm(e, 0xF2, o[1].size == 64, op, 2, o[1].reg, &o[0], 0, 0);
+        return 0;
+    }
+    if (strcmp(m, "pshufd") == 0 && n == 3 && o[0].kind == OP_IMM && is_xmm(&o[2])) {
+        op[0] = 0x0F; op[1] = 0x70;
+        enc_rm(e, 0x66, 0, op, 2, o[2].reg, &o[1], 0, 1);
+        put(e, (int)o[0].imm);
+        return 0;
+    }
+    if ((strcmp(m, "psrlq") == 0 || strcmp(m, "psllq") == 0 ||
+         strcmp(m, "psrld") == 0 || strcmp(m, "pslld") == 0) &&
+        n == 2 && o[0].kind == OP_IMM && is_xmm(&o[1])) {
+        op[0] = 0x0F; op[1] = m[4] == 'q' ? 0x73 : 0x72;
+        enc_rm(e, 0x66, 0, op, 2, m[2] == 'r' ? 2 : 6, &o[1], 0, 1);
+        put(e, (int)o[0].imm);
+        return 0;
+    }
+
+    if (m[0] == 'v') {
+        int l = (n >= 2 && o[n - 1].kind == OP_REG && o[n - 1].size == 256);
+        for (size_t i = 0; i < sizeof avx3 / sizeof avx3[0]; i++)
+            if (strcmp(m, avx3[i].name) == 0 && n == 3 && o[1].kind == OP_REG &&
+                o[2].kind == OP_REG && o[1].size == o[2].size &&
+                (o[0].kind == OP_MEM || is_reg(&o[0], o[2].size))) {
+                enc_vex(e, 1, avx3[i].map, 0, l, avx3[i].op, o[2].reg, o[1].reg, &o[0], 0);
+                return 0;
+            }
+        if ((strcmp(m, "vmovdqu") == 0 || strcmp(m, "vmovdqa") == 0) && n == 2) {
+            int pp = m[6] == 'u' ? 2 : 1;
+            if (o[1].kind == OP_REG && o[1].size >= 128 &&
+                (o[0].kind == OP_MEM || is_reg(&o[0], o[1].size))) {
+                enc_vex(e, pp, 1, 0, o[1].size == 256, 0x6F, o[1].reg, 0, &o[0], 0);
+                return 0;
+            }
+            if (o[0].kind == OP_REG && o[0].size >= 128 && o[1].kind == OP_MEM) {
+                enc_vex(e, pp, 1, 0, o[0].size == 256, 0x7F, o[0].reg, 0, &o[1], 0);
+                return 0;
+            }
+        }
+        if ((strcmp(m, "vmovupd") == 0 || strcmp(m, "vmovapd") == 0) && n == 2) {
+            int load = m[4] == 'u' ? 0x10 : 0x28;
+            if (o[1].kind == OP_REG && o[1].size >= 128 &&
+                (o[0].kind == OP_MEM || is_reg(&o[0], o[1].size))) {
+                enc_vex(e, 1, 1, 0, o[1].size == 256, load, o[1].reg, 0, &o[0], 0);
+                return 0;
+            }
+            if (o[0].kind == OP_REG && o[0].size >= 128 && o[1].kind == OP_MEM) {
+                enc_vex(e, 1, 1, 0, o[0].size == 256, load + 1, o[0].reg, 0, &o[1], 0);
+                return 0;
+            }
+        }
+        if (strcmp(m, "vbroadcastsd") == 0 && n == 2 && is_reg(&o[1], 256) &&
+            (is_xmm(&o[0]) || o[0].kind == OP_MEM)) {
+            enc_vex(e, 1, 2, 0, 1, 0x19, o[1].reg, 0, &o[0], 0);
+            return 0;
+        }
+        if (strcmp(m, "vmovd") == 0 && n == 2) {
+            if (is_xmm(&o[1]) && is_rm(&o[0], 32)) {
+                enc_vex(e, 1, 1, 0, 0, 0x6E, o[1].reg, 0, &o[0], 0);
+                return 0;
+            }
+            if (is_xmm(&o[0]) && is_rm(&o[1], 32)) {
+                enc_vex(e, 1, 1, 0, 0, 0x7E, o[0].reg, 0, &o[1], 0);
+                return 0;
+            }
+        }
+        if (strcmp(m, "vpbroadcastd") == 0 && n == 2 && o[1].kind == OP_REG &&
+            o[1].size >= 128 && (is_xmm(&o[0]) || o[0].kind == OP_MEM)) {
+            enc_vex(e, 1, 2, 0, l, 0x58, o[1].reg, 0, &o[0], 0);
+            return 0;
+        }
+        if (strcmp(m, "vpshufd") == 0 && n == 3 && o[0].kind == OP_IMM &&
+            o[2].kind == OP_REG && o[2].size >= 128) {
+            enc_vex(e, 1, 1, 0, l, 0x70, o[2].reg, 0, &o[1], 1);
+            put(e, (int)o[0].imm);
+            return 0;
+        }
+        if (strcmp(m, "vextracti128") == 0 && n == 3 && o[0].kind == OP_IMM &&
+            is_reg(&o[1], 256) && (is_xmm(&o[2]) || o[2].kind == OP_MEM)) {
+            enc_vex(e, 1, 3, 0, 1, 0x39, o[1].reg, 0, &o[2], 1);
+            put(e, (int)o[0].imm);
+            return 0;
+        }
+        return fail("unsupported instruction '%s'", m);
+    }
+
+    /* ---- integer instructions */
+    if (strcmp(m, "movabsq") == 0 && n == 2 && o[0].kind == OP_IMM && is_reg(&o[1], 64)) {
+        put(e, 0x48 | (o[1].reg >> 3));
+        put(e, 0xB8 + (o[1].reg & 7));
+        put_imm(e, o[0].imm, 8);
+        return 0;
+    }
+    if ((strcmp(m, "movslq") == 0 || strcmp(m, "movsbl") == 0 ||
+         strcmp(m, "movswl") == 0 || strcmp(m, "movzbl") == 0 ||
+         strcmp(m, "movzwl") == 0 || strcmp(m, "movsbq") == 0 ||
+         strcmp(m, "movswq") == 0 || strcmp(m, "movzbq") == 0) && n == 2) {
+        int from = suffix_size(m[4]), to = suffix_size(m[5]);
+        if (!is_rm(&o[0], from) || !is_reg(&o[1], to))
+            return fail("bad operands for %s", m);
+        if (from == 32) {
+            op[0] = 0x63;
+            enc_rm(e, 0, 1, op, 1, o[1].reg, &o[0], 0, 0);
+        } else {
+            op[0] = 0x0F;
+            op[1] = (m[3] == 's' ? 0xBE : 0xB6) + (from == 16);
+            enc_rm(e, 0, to == 64, op, 2, o[1].reg, &o[0], byte_rex(&o[0]), 0);
+        }
+        return 0;
+    }
+    if (sized(m, "mov", &size) && n == 2) {
+        int p = size == 16 ? 0x66 : 0, w = size == 64;
+        int br = byte_rex(&o[0]) || byte_rex(&o[1]);
+        if (o[0].kind == OP_IMM && is_reg(&o[1], size) && size != 64) {
+            if (p) put(e, p);
+            if (o[1].reg >= 8 || byte_rex(&o[1])) put(e, 0x40 | (o[1].reg >> 3));
+            put(e, (size == 8 ? 0xB0 : 0xB8) + (o[1].reg & 7));
+            put_imm(e, o[0].imm, size == 8 ? 1 : size / 8);
+            return 0;
+        }
+        if (o[0].kind == OP_IMM && is_rm(&o[1], size)) {
+            if (size == 64 && !fits32(o[0].imm))
+                return fail("immediate too large for movq");
+            int isz = size == 8 ? 1 : size == 16 ? 2 : 4;
+            op[0] = size == 8 ? 0xC6 : 0xC7;
+            enc_rm(e, p, w, op, 1, 0, &o[1], br, isz);
+            put_imm(e, o[0].imm, isz);
+            return 0;
+        }
+        if (is_reg(&o[0], size) && is_rm(&o[1], size)) {
+            op[0] = size == 8 ? 0x88 : 0x89;
+            enc_rm(e, p, w, op, 1, o[0].reg, &o[1], br, 0);
+            return 0;
+        }
+        if (o[0].kind == OP_MEM && is_reg(&o[1], size)) {
+            op[0] = size == 8 ? 0x8A : 0x8B;
+            enc_rm(e, p, w, op, 1, o[1].reg, &o[0], br, 0);
+            return 0;
+        }
+        return fail("bad operands for %s", m);
+    }
+    for (int g = 0; g < 8; g++)
+        if (sized(m, alu[g], &size) && n == 2) {
+            int p = size == 16 ? 0x66 : 0, w = size == 64;
+            int br = byte_rex(&o[0]) || byte_rex(&o[1]);
+            if (o[0].kind == OP_IMM && is_rm(&o[1], size)) {
+                int isz = size == 8 || fits8(o[0].imm) ? 1 : size == 16 ? 2 : 4;
+                op[0] = size == 8 ? 0x80 : isz == 1 ? 0x83 : 0x81;
+                enc_rm(e, p, w, op, 1, g, &o[1], br, isz);
+                put_imm(e, o[0].imm, isz);
+                return 0;
+            }
+            if (is_reg(&o[0], size) && is_rm(&o[1], size)) {
+                op[0] = g * 8 + (size == 8 ? 0 : 1);
+                enc_rm(e, p, w, op, 1, o[0].reg, &o[1], br, 0);
+                return 0;
+            }
+            if (o[0].kind == OP_MEM && is_reg(&o[1], size)) {
+                op[0] = g * 8 + (size == 8 ? 2 : 3);
+                enc_rm(e, p, w, op, 1, o[1].reg, &o[0], br, 0);
+                return 0;
+            }
+            return fail("bad operands for %s", m);
+        }
+    if (sized(m, "lea", &size) && size >= 32 && n == 2 &&
+        o[0].kind == OP_MEM && is_reg(&o[1], size)) {
+        op[0] = 0x8D;
+        enc_rm(e, 0, size == 64, op, 1, o[1].reg, &o[0], 0, 0);
+        return 0;
+    }
+    if (sized(m, "test", &size) && n == 2 && is_rm(&o[1], size)) {
+        int p = size == 16 ? 0x66 : 0, w = size == 64;
+        int br = byte_rex(&o[0]) || byte_rex(&o[1]);
+        if (o[0].kind == OP_IMM) {
+            int isz = size == 8 ? 1 : size == 16 ? 2 : 4;
+            op[0] = size == 8 ? 0xF6 : 0xF7;
+            enc_rm(e, p, w, op, 1, 0, &o[1], br, isz);
+            put_imm(e, o[0].imm, isz);
+            return 0;
+        }
+        if (is_reg(&o[0], size)) {
+            op[0] = size == 8 ? 0x84 : 0x85;
+            enc_rm(e, p, w, op, 1, o[0].reg, &o[1], br, 0);
+            return 0;
+        }
+    }
+    if (sized(m, "imul", &size) && size >= 16 && n == 2 &&
+        is_rm(&o[0], size) && is_reg(&o[1], size)) {
+        op[0] = 0x0F; op[1] = 0xAF;
+        enc_rm(e, size == 16 ? 0x66 : 0, size == 64, op, 2, o[1].reg, &o[0], 0, 0);
+        return 0;
+    }
+    {
+        static const struct { const char *name; int ext, grp; } unary[] = {
+            { "not", 2, 0xF6 }, { "neg", 3, 0xF6 }, { "mul", 4, 0xF6 },
+            { "div", 6, 0xF6 }, { "idiv", 7, 0xF6 }, { "inc", 0, 0xFE },
+            { "dec", 1, 0xFE },
+        };
+        for (size_t i = 0; i < sizeof unary / sizeof unary[0]; i++)
+            if (sized(m, unary[i].name, &size) && n == 1 && is_rm(&o[0], size)) {
+                op[0] = unary[i].grp + (size != 8);
+                enc_rm(e, size == 16 ? 0x66 : 0, size == 64, op, 1, unary[i].ext,
+                       &o[0], byte_rex(&o[0]), 0);
+                return 0;
+            }
+    }
+    for (int g = 0; g < 8; g++)
+        if (sized(m, shifts[g], &size) && n == 2 && is_rm(&o[1], size)) {
+            int p = size == 16 ? 0x66 : 0, w = size == 64, br = byte_rex(&o[1]);
+            if (o[0].kind == OP_IMM) {
+                op[0] = (size == 8 ? 0xC0 : 0xC1) + (o[0].imm == 1 ? 0x10 : 0);
+                enc_rm(e, p, w, op, 1, g, &o[1], br, o[0].imm == 1 ? 0 : 1);
+                if (o[0].imm != 1) put(e, (int)o[0].imm);
+                return 0;
+            }
+            if (is_reg(&o[0], 8) && o[0].reg == 1) {        /* %cl */
+                op[0] = size == 8 ? 0xD2 : 0xD3;
+                enc_rm(e, p, w, op, 1, g, &o[1], br, 0);
+                return 0;
+            }
+        }
+    {
+        static const struct { const char *name; int rop, ext; } bits[] = {
+            { "bt", 0xA3, 4 }, { "bts", 0xAB, 5 }, { "btr", 0xB3, 6 }, { "btc", 0xBB, 7 },
+        };
+        for (size_t i = 0; i < sizeof bits / sizeof bits[0]; i++)
+            if (sized(m, bits[i].name, &size) && size >= 16 && n == 2 &&
+                is_rm(&o[1], size)) {
+                int p = size == 16 ? 0x66 : 0, w = size == 64;
+                op[0] = 0x0F;
+                if (o[0].kind == OP_IMM) {
+                    op[1] = 0xBA;
+                    enc_rm(e, p, w, op, 2, bits[i].ext, &o[1], 0, 1);
+                    put(e, (int)o[0].imm);
+                    return 0;
+                }
+                if (is_reg(&o[0], size)) {
+                    op[1] = bits[i].rop;
+                    enc_rm(e, p, w, op, 2, o[0].reg, &o[1], 0, 0);
+                    return 0;
+                }
+            }
+    }
+    if ((strcmp(m, "pushq") == 0 || strcmp(m, "popq") == 0 ||
+         strcmp(m, "push") == 0 || strcmp(m, "pop") == 0) && n == 1 && is_reg(&o[0], 64)) {
+        if (o[0].reg >= 8) put(e, 0x41);
+        put(e, (m[1] == 'u' ? 0x50 : 0x58) + (o[0].reg & 7));
+        return 0;
+    }
+    if (strncmp(m, "set", 3) == 0 && (cc = condition(m + 3)) >= 0 && n == 1 &&
+        is_rm(&o[0], 8)) {
+        op[0] = 0x0F; op[1] = 0x90 + cc;
+        enc_rm(e, 0, 0, op, 2, 0, &o[0], byte_rex(&o[0]), 0);
+        return 0;
+    }
+    if (strncmp(m, "cmov", 4) == 0 && n == 2 && o[1].kind == OP_REG &&
+        o[1].size >= 16 && o[1].size <= 64 && is_rm(&o[0], o[1].size)) {
+        char c[8];
+        snprintf(c, sizeof c, "%s", m + 4);
+        size_t k = strlen(c);
+        /* cmovgl / cmovgq carry a size suffix; cmovg takes it from the register */
+        if ((cc = condition(c)) < 0 && k > 1 && suffix_size(c[k - 1]) == o[1].size) {
+            c[k - 1] = '\0';
+            cc = condition(c);
+        }
+        if (cc >= 0) {
+            op[0] = 0x0F; op[1] = 0x40 + cc;
+            enc_rm(e, o[1].size == 16 ? 0x66 : 0, o[1].size == 64, op, 2,
+                   o[1].reg, &o[0], 0, 0);
+            return 0;
+        }
+    }
+    return fail("unsupported instruction '%s'", m);
+}
+
+/* ---------------------------------------------------------------- directives */
+
+static int set_section(const char *name) {
+    for (int s = 0; s < NSECS; s++)
+        if (strcmp(name, secname[s]) == 0) {
+            cursec = s;
+            return 0;
+        }
+    return fail("unsupported section %s", name);
+}
+
+/* a quoted string with C escapes, NUL-terminated when zero */
+static int string_bytes(const char *s, int zero) {
+    unsigned char *buf = malloc(strlen(s) + 1), *p = buf;
+    if (*s++ != '"') {
+        free(buf);
+        return fail("expected a string");
+    }
+    while (*s && *s != '"') {
+        if (*s != '\\') {
+            *p++ = *s++;
+            continue;
+        }
+        s++;
+        switch (*s) {
+            case 'n': *p++ = '\n'; s++; break;
+            case 't': *p++ = '\t'; s++; break;
+            case 'r': *p++ = '\r'; s++; break;
+            case 'b': *p++ = '\b'; s++; break;
+            case 'f': *p++ = '\f'; s++; break;
+            case 'x': {
+                char *end;
+                *p++ = (unsigned char)strtol(s + 1, &end, 16);
+                s = end;
+                break;
+            }
+            default:
+                if (*s >= '0' && *s <= '7') {
+                    int v = 0;
+                    for (int k = 0; k < 3 && *s >= '0' && *s <= '7'; k++)
+                        v = v * 8 + (*s++ - '0');
+                    *p++ = (unsigned char)v;
+                } else if (*s) {
+                    *p++ = *s++;
+                }
+        }
+    }
+    if (*s != '"') {
+        free(buf);
+        return fail("unterminated string");
+    }
+    if (zero) *p++ = '\0';
+    add_bytes(buf, (int)(p - buf));
+    free(buf);
+    return 0;
+}
+
+/* .quad / .long: a sum of numbers, at most one symbol added and one subtracted */
+static int data_word(const char *s, int size) {
+    int plus = -1, minus = -1, neg = 0;
+    long add = 0;
+    unsigned char zero[8] = { 0 };
+    for (;;) {
+        while (isspace((unsigned char)*s)) s++;
+        if (isdigit((unsigned char)*s)) {
+            long v;
+            if (!parse_number(&s, &v)) return fail("bad expression");
+            add += neg ? -v : v;
+        } else if (is_symchar((unsigned char)*s)) {
+            const char *e = s;
+            while (is_symchar((unsigned char)*e)) e++;
+            int sym = lookup(s, e - s);
+            syms[sym].referenced = 1;
+            int *slot = neg ? &minus : &plus;
+            if (*slot >= 0) return fail("unsupported expression");
+            *slot = sym;
+            s = e;
+        } else {
+            return fail("bad expression");
+        }
+        while (isspace((unsigned char)*s)) s++;
+        if (!*s) break;
+        if (*s != '+' && *s != '-') return fail("bad expression");
+        neg = *s++ == '-';
+    }
+    if (minus >= 0 && plus < 0) return fail("unsupported expression");
+    struct item *it = add_bytes(zero, size);
+    if (plus < 0) {
+        memcpy(pool + it->pos, &add, size);
+    } else if (minus >= 0) {
+        if (size != 8) return fail("difference must be a .quad");
+        it->fix = (struct fixup){ FX_DIFF64, 0, plus, minus, add };
+    } else {
+        if (size != 8) return fail("address must be a .quad");
+        it->fix = (struct fixup){ FX_ABS64, 0, plus, -1, add };
+    }
+    return 0;
+}
+
+static void cfi(int op, int a, int b) {
+    struct item *it = new_item(IT_CFI);
+    it->cfi = op;
+    it->a = a;
+    it->b = b;
+}
+
+/* first operand of a directive, as a symbol */
+static int directive_sym(const char *s, size_t *len) {
+    while (isspace((unsigned char)*s)) s++;
+    *len = 0;
+    while (is_symchar((unsigned char)s[*len])) (*len)++;
+    return *len ? lookup(s, *len) : -1;
+}
+
+static int directive(const char *d, const char *args) {
+    size_t len;
+    int s;
+    if (strcmp(d, ".text") == 0) return set_section(".text");
+    if (strcmp(d, ".data") == 0) return set_section(".data");
+    if (strcmp(d, ".section") == 0) {
+        char name[64];
+        if (sscanf(args, " %63[^, \t]", name) != 1) return fail("bad .section");
+        return set_section(name);
+    }
+    if (strcmp(d, ".file") == 0) {
+        const char *q = strchr(args, '"'), *e = q ? strchr(q + 1, '"') : NULL;
+        if (q && e) {
+            free(filename);
+            filename = strndup(q + 1, e - q - 1);
+        }
+        return 0;
+    }
+    if (strcmp(d, ".align") == 0 || strcmp(d, ".p2align") == 0) {
+        long a = atol(args);
+        if (d[1] == 'p') a = 1L << a;
+        if (a <= 0 || (a & (a - 1))) return fail("bad alignment");
+        new_item(IT_ALIGN)->align = (int)a;
+        return 0;
+    }
+    if (strcmp(d, ".quad") == 0) return data_word(args, 8);
+    if (strcmp(d, ".long") == 0) return data_word(args, 4);
+    if (strcmp(d, ".string") == 0 || strcmp(d, ".asciz") == 0) {
+        while (isspace((unsigned char)*args)) args++;
+        return string_bytes(args, 1);
+    }
+    if (strcmp(d, ".ascii") == 0) {
+        while (isspace((unsigned char)*args)) args++;
+        return string_bytes(args, 0);
+    }
+    if (strcmp(d, ".double") == 0) {
+        char *end;
+        double v = strtod(args, &end);
+        if (end == args) return fail("bad .double");
+        add_bytes((unsigned char *)&v, 8);
+        return 0;
+    }
+    if (strcmp(d, ".globl") == 0 || strcmp(d, ".global") == 0) {
+        if ((s = directive_sym(args, &len)) < 0) return fail("bad .globl");
+        syms[s].global = 1;
+        return 0;
+    }
+    if (strcmp(d, ".type") == 0) {
+        if ((s = directive_sym(args, &len)) < 0) return fail("bad .type");
+        syms[s].func = strstr(args, "function") != NULL;
+        return 0;
+    }
+    if (strcmp(d, ".size") == 0) {
+        if ((s = directive_sym(args, &len)) < 0) return fail("bad .size");
+        const char *e = strchr(args, ',');
+        while (e && isspace((unsigned char)*++e)) ;
+        /* only  .size sym, .-sym */
+        if (!e || e[0] != '.' || e[1] != '-' || strncmp(e + 2, syms[s].name, len) != 0)
+            return fail("unsupported .size expression");
+        new_item(IT_SIZE)->sym = s;
+        return 0;
+    }
+    if (strcmp(d, ".cfi_startproc") == 0)        { cfi(CFI_START, 0, 0); return 0; }
+    if (strcmp(d, ".cfi_endproc") == 0)          { cfi(CFI_END, 0, 0); return 0; }
+    if (strcmp(d, ".cfi_remember_state") == 0)   { cfi(CFI_REMEMBER, 0, 0); return 0; }
+    if (strcmp(d, ".cfi_restore_state") == 0)    { cfi(CFI_RESTORE_STATE, 0, 0); return 0; }
+    if (strcmp(d, ".cfi_def_cfa_offset") == 0) {
+        cfi(CFI_DEF_CFA_OFFSET, atoi(args), 0);
+        return 0;
+    }
+    if (strcmp(d, ".cfi_def_cfa_register") == 0) {
+        cfi(CFI_DEF_CFA_REGISTER, atoi(args), 0);
+        return 0;
+    }
+    if (strcmp(d, ".cfi_offset") == 0 || strcmp(d, ".cfi_def_cfa") == 0) {
+        int a, b;
+        if (sscanf(args, " %d , %d", &a, &b) != 2) return fail("bad %s", d);
+        cfi(d[5] == 'o' ? CFI_OFFSET : CFI_DEF_CFA, a, b);
+        return 0;
+    }
+    return fail("unsupported directive %s", d);
+}
+
+/* ---------------------------------------------------------------- parsing */
+
+static int define_label(const char *name, size_t len) {
+    int s = lookup(name, len);
+    if (syms[s].defined) return fail("symbol %s defined twice", syms[s].name);
+    syms[s].defined = 1;
+    syms[s].sec = cursec;
+    syms[s].item = nitems;
+    new_item(IT_LABEL)->sym = s;
+    return 0;
+}
+
+/* split on commas outside parentheses */
+static int split_operands(char *s, char **ops, int max) {
+    int n = 0, depth = 0;
+    while (isspace((unsigned char)*s)) s++;
+    if (!*s) return 0;
+    ops[n++] = s;
+    for (; *s; s++) {
+        if (*s == '(') depth++;
+        else if (*s == ')') depth--;
+        else if (*s == ',' && depth == 0) {
+            if (n == max) return -1;
+            *s = '\0';
+            ops[n++] = s + 1;
+        }
+    }
+    return n;
+}
+
+static int instruction(char *m, char *args) {
+    char *ops[4];
+    struct operand o[4];
+    int n = split_operands(args, ops, 4);
+    if (n < 0) return fail("too many operands");
+
+    int cc = -2;
+    if (strcmp(m, "jmp") == 0) cc = -1;
+    else if (m[0] == 'j') cc = condition(m + 1);
+    if (cc >= -1 || strcmp(m, "call") == 0) {
+        if (n != 1 || !parse_operand(ops[0], &o[0]) || o[0].kind != OP_SYM)
+            return fail("bad operand for %s", m);
+        if (m[0] == 'c') {
+            unsigned char call[5] = { 0xE8 };
+            struct item *it = add_bytes(call, 5);
+            it->fix = (struct fixup){ FX_PLT32, 1, o[0].sym, -1, o[0].disp - 4 };
+        } else {
+            struct item *it = new_item(IT_BRANCH);
+            it->sym = o[0].sym;
+            it->cc = cc;
+            if (o[0].disp) return fail("branch to an offset");
+        }
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++)
+        if (!parse_operand(ops[i], &o[i]))
+            return fail("bad operand '%s' for %s", ops[i], m);
+    struct enc e;
+    memset(&e, 0, sizeof e);
+    if (encode(m, o, n, &e) < 0) return -1;
+    struct item *it = add_bytes(e.b, e.n);
+    it->fix = e.fix;
+    return 0;
+}
+
+static int parse_line(char *line) {
+    char *s = line;
+    /* comments: # outside a string */
+    for (char *p = s, in = 0; *p; p++) {
+        if (*p == '"' && (p == s || p[-1] != '\\')) in = !in;
+        if (*p == '#' && !in) {
+            *p = '\0';
+            break;
+        }
+    }
+    for (;;) {
+        while (isspace((unsigned char)*s)) s++;
+        if (!*s) return 0;
+        char *e = s;
+        while (is_symchar((unsigned char)*e)) e++;
+        if (*e == ':' && e > s) {
+            if (define_label(s, e - s) < 0) return -1;
+            s = e + 1;
+            continue;
+        }
+        break;
+    }
+    char *e = s;
+    while (*e && !isspace((unsigned char)*e)) e++;
+    char *args = *e ? e + 1 : e;
+    *e = '\0';
+    char *end = args + strlen(args);
+    while (end > args && isspace((unsigned char)end[-1])) *--end = '\0';
+    if (*s == '.') return directive(s, args);
+    if (cursec != SEC_TEXT) return fail("instruction outside .text");
+    return instruction(s, args);
+}
+
+/* ---------------------------------------------------------------- layout */
+
+static int branch_len(const struct item *it) {
+    if (!it->lng) return 2;
+    return it->cc < 0 ? 5 : 6;
+}
+
+static int target_off(const struct item *it) {
+    struct sym *s = &syms[it->sym];
+    return items[s->item].off;
+}
+
+/* offsets for every item; branches start short and only ever grow */
+static void layout(long secsize[NSECS]) {
+    for (int i = 0; i < nitems; i++)
+        if (items[i].kind == IT_BRANCH) {
+            struct sym *s = &syms[items[i].sym];
+            items[i].lng = !s->defined || s->sec != items[i].sec;
+        }
+    int changed;
+    do {
+        long off[NSECS] = { 0 };
+        for (int i = 0; i < nitems; i++) {
+            struct item *it = &items[i];
+            long *o = &off[it->sec];
+            if (it->kind == IT_ALIGN) *o = (*o + it->align - 1) & -(long)it->align;
+            it->off = (int)*o;
+            if (it->kind == IT_BYTES) *o += it->len;
+            else if (it->kind == IT_BRANCH) *o += branch_len(it);
+        }
+        changed = 0;
+        for (int i = 0; i < nitems; i++) {
+            struct item *it = &items[i];
+            if (it->kind != IT_BRANCH || it->lng) continue;
+            long d = target_off(it) - (it->off + 2);
+            if (!fits8(d)) {
+                it->lng = 1;
+                changed = 1;
+            }
+        }
+        memcpy(secsize, off, sizeof off);
+    } while (changed);
+}
+
+/* ---------------------------------------------------------------- output */
+
+struct buf {
+    unsigned char *p;
+    int n, cap;
+};
+
+static void bput(struct buf *b, const void *p, int n) {
+    b->p = grow(b->p, &b->cap, b->n + n, 1);
+    memcpy(b->p + b->n, p, n);
+    b->n += n;
+}
+
+static void bbyte(struct buf *b, int c) {
+    unsigned char x = (unsigned char)c;
+    bput(b, &x, 1);
+}
+
+static void buleb(struct buf *b, unsigned long v) {
+    do {
+        int c = v & 0x7F;
+        v >>= 7;
+        bbyte(b, c | (v ? 0x80 : 0));
+    } while (v);
+}
+
+static void b32(struct buf *b, uint32_t v) { bput(b, &v, 4); }
+
+static void balign(struct buf *b, int a, int fill) {
+    while (b->n % a) bbyte(b, fill);
+}
+
+/* relocations per section; the .eh_frame ones go in slot NSECS */
+static struct buf rela[NSECS + 1];
+
+static void add_rela(int sec, long off, int sym, int type, long addend) {
+    Elf64_Rela r = { (Elf64_Addr)off, ELF64_R_INFO((Elf64_Xword)sym, type), addend };
+    bput(&rela[sec], &r, sizeof r);
+}
+
+static int secsym[NSECS + 1];   /* symtab index of each section symbol */
+
+/*
+ * -run lays the sections out in memory instead of in a file, and every
+ * fixup is patched with a final address.  Symbols the text does not
+ * define come from the jit_extern callback: the runtime and libc, which
+ * are already in the k0 process.  They can be more than 2GB away, so a
+ * call goes through a 16-byte stub,  jmp *addr(%rip),  when its rel32
+ * does not reach.  A %rip-relative load has no such way out, which is
+ * why the mapping is placed near k0's own image (jit_map).
+ */
+static void *(*jit_extern)(const char *name);
+static unsigned char *jit_sec[NSECS];
+static unsigned char *jit_stubs;
+static int jit_nstubs;
+
+static int jit_target(struct sym *s, uintptr_t *addr) {
+    if (s->defined) {
+        *addr = (uintptr_t)(jit_sec[s->sec] + items[s->item].off);
+        return 0;
+    }
+    if (!s->addr && !(s->addr = jit_extern(s->name)))
+        return fail("undefined symbol %s", s->name);
+    *addr = (uintptr_t)s->addr;
+    return 0;
+}
+
+static uintptr_t jit_stub(struct sym *s) {
+    if (!s->stub) {
+        static const unsigned char jmp[6] = { 0xFF, 0x25, 0, 0, 0, 0 };
+        unsigned char *p = jit_stubs + 16 * jit_nstubs;
+        memcpy(p, jmp, sizeof jmp);
+        memcpy(p + sizeof jmp, &s->addr, 8);
+        s->stub = ++jit_nstubs;
+    }
+    return (uintptr_t)(jit_stubs + 16 * (s->stub - 1));
+}
+
+static int jit_fixup(int sec, long at, unsigned char *where, const struct fixup *f) {
+    struct sym *s = &syms[f->sym];
+    uintptr_t target, pc = (uintptr_t)(jit_sec[sec] + at);
+    if (jit_target(s, &target) < 0) return -1;
+    if (f->kind == FX_ABS64) {
+        uint64_t v = target + f->addend;
+        memcpy(where, &v, 8);
+        return 0;
+    }
+    long d = (long)(target - pc) + f->addend;
+    if (!fits32(d) && !s->defined && f->kind == FX_PLT32)
+        d = (long)(jit_stub(s) - pc) + f->addend;
+    if (!fits32(d)) return fail("%s is out of reach of %%rip-relative code", s->name);
+    int32_t v = (int32_t)d;
+    memcpy(where, &v, 4);
+    return 0;
+}
+
+/* value and relocation of one fixup at byte offset `at` of section sec */
+static int resolve(int sec, long at, unsigned char *where, const struct fixup *f) {
+    struct sym *s = &syms[f->sym];
+    if (f->kind == FX_DIFF64) {
+        struct sym *s2 = &syms[f->sym2];
+        if (!s->defined || !s2->defined || s->sec != s2->sec)
+            return fail("cannot subtract %s and %s", s->name, s2->name);
+        int64_t v = items[s->item].off - items[s2->item].off + f->addend;
+        memcpy(where, &v, 8);
+        return 0;
+    }
+    if (jit_extern) return jit_fixup(sec, at, where, f);
+    if (f->kind == FX_ABS64) {
+        if (s->defined) add_rela(sec, at, secsym[s->sec], R_X86_64_64,
+                                 items[s->item].off + f->addend);
+        else add_rela(sec, at, s->elfidx, R_X86_64_64, f->addend);
+        return 0;
+    }
+    /* FX_PC32 / FX_PLT32; like as, a global keeps its relocation */
+    if (s->defined && s->sec == sec && !s->global) {
+        int32_t v = (int32_t)(items[s->item].off + f->addend - at);
+        memcpy(where, &v, 4);
+    } else if (s->defined && !s->global) {
+        add_rela(sec, at, secsym[s->sec], R_X86_64_PC32, items[s->item].off + f->addend);
+    } else {
+        add_rela(sec, at, s->elfidx,
+                 f->kind == FX_PLT32 ? R_X86_64_PLT32 : R_X86_64_PC32, f->addend);
+    }
+    return 0;
+}
+
+/* .eh_frame: one CIE, then an FDE per .cfi_startproc/.cfi_endproc pair */
+static int build_eh_frame(struct buf *eh) {
+    static const unsigned char cie[] = {
+        0x14, 0, 0, 0,              /* length */
+        0, 0, 0, 0,                 /* CIE id */
+        1, 'z', 'R', 0,             /* version, augmentation */
+        1, 0x78, 16,                /* code align 1, data align -8, RA %rip */
+        1, 0x1B,                    /* pcrel sdata4 addresses */
+        0x0C, 7, 8,                 /* def_cfa %rsp+8 */
+        0x90, 1,                    /* %rip at cfa-8 */
+        0, 0,
+    };
+    bput(eh, cie, sizeof cie);
+    int start = -1, fde = 0, last = 0;
+    for (int i = 0; i < nitems; i++) {
+        struct item *it = &items[i];
+        if (it->kind != IT_CFI) continue;
+        if (it->cfi == CFI_START) {
+            if (start >= 0) return fail("nested .cfi_startproc");
+            start = last = it->off;
+            fde = eh->n;
+            b32(eh, 0);                         /* length, patched below */
+            b32(eh, eh->n);                     /* back to the CIE at 0 */
+            add_rela(NSECS, eh->n, secsym[SEC_TEXT], R_X86_64_PC32, it->off);
+            b32(eh, 0);                         /* pc begin */
+            b32(eh, 0);                         /* pc range, patched below */
+            bbyte(eh, 0);                       /* no augmentation data */
+            continue;
+        }
+        if (start < 0) return fail(".cfi directive outside a procedure");
+        if (it->cfi == CFI_END) {
+            uint32_t range = it->off - start;
+            memcpy(eh->p + fde + 12, &range, 4);
+            balign(eh, 8, 0);                   /* DW_CFA_nop padding */
+            uint32_t len = eh->n - fde - 4;
+            memcpy(eh->p + fde, &len, 4);
+            start = -1;
+            continue;
+        }
+        int delta = it->off - last;
+        if (delta) {
+            if (delta < 0x40) bbyte(eh, 0x40 | delta);
+            else if (delta < 0x100) { bbyte(eh, 0x02); bbyte(eh, delta); }
+            else if (delta < 0x10000) { bbyte(eh, 0x03); bput(eh, &delta, 2); }
+            else { bbyte(eh, 0x04); b32(eh, delta); }
+            last = it->off;
+        }
+        switch (it->cfi) {
+            case CFI_DEF_CFA_OFFSET:   bbyte(eh, 0x0E); buleb(eh, it->a); break;
+            case CFI_DEF_CFA_REGISTER: bbyte(eh, 0x0D); buleb(eh, it->a); break;
+            case CFI_DEF_CFA:
+                bbyte(eh, 0x0C); buleb(eh, it->a); buleb(eh, it->b);
+                break;
+            case CFI_OFFSET:
+                if (it->a > 63 || it->b % 8 || it->b > 0) return fail("bad .cfi_offset");
+                bbyte(eh, 0x80 | it->a);
+                buleb(eh, -it->b / 8);
+                break;
+            case CFI_REMEMBER:      bbyte(eh, 0x0A); break;
+            case CFI_RESTORE_STATE: bbyte(eh, 0x0B); break;
+        }
+    }
+    if (start >= 0) return fail("missing .cfi_endproc");
+    return 0;
+}
+
+/* section contents: bytes, branches and alignment padding */
+static int build_section(int sec, long size, struct buf *out) {
+    out->p = grow(out->p, &out->cap, (int)size + 1, 1);
+    out->n = (int)size;
+    memset(out->p, sec == SEC_TEXT ? 0x90 : 0, size);
+    for (int i = 0; i < nitems; i++) {
+        struct item *it = &items[i];
+        if (it->sec != sec) continue;
+        unsigned char *p = out->p + it->off;
+        if (it->kind == IT_BYTES) {
+            memcpy(p, pool + it->pos, it->len);
+            if (it->fix.kind != FX_NONE &&
+                resolve(sec, it->off + it->fix.at, p + it->fix.at, &it->fix) < 0)
+                return -1;
+        } else if (it->kind == IT_BRANCH) {
+            if (!it->lng) {
+                p[0] = it->cc < 0 ? 0xEB : 0x70 + it->cc;
+                p[1] = (unsigned char)(target_off(it) - (it->off + 2));
+                continue;
+            }
+            int at = it->cc < 0 ? 1 : 2;
+            if (it->cc < 0) p[0] = 0xE9;
+            else { p[0] = 0x0F; p[1] = 0x80 + it->cc; }
+            struct fixup f = { FX_PLT32, at, it->sym, -1, -4 };
+            if (resolve(sec, it->off + at, p + at, &f) < 0) return -1;
+        } else if (it->kind == IT_SIZE) {
+            struct sym *s = &syms[it->sym];
+            if (!s->defined || s->sec != sec) return fail("bad .size for %s", s->name);
+            s->size = it->off - items[s->item].off;
+        }
+    }
+    return 0;
+}
+
+static int write_elf(const char *ofile) {
+    long size[NSECS];
+    layout(size);
+
+    /* section header indices: each section then its .rela */
+    enum { SH_NULL, SH_TEXT, SH_RELA_TEXT, SH_DATA, SH_RELA_DATA, SH_RELRO,
+           SH_RELA_RELRO, SH_RODATA, SH_NOTE, SH_EH, SH_RELA_EH, SH_SYMTAB,
+           SH_STRTAB, SH_SHSTRTAB, SH_COUNT };
+    static const int shidx[NSECS] = { SH_TEXT, SH_DATA, SH_RELRO, SH_RODATA, SH_NOTE };
+
+    /* symbol table: null, file, section symbols, then globals */
+    struct buf symtab = { 0 }, strtab = { 0 };
+    bbyte(&strtab, 0);
+    Elf64_Sym sym;
+    memset(&sym, 0, sizeof sym);
+    bput(&symtab, &sym, sizeof sym);
+    int nsym = 1;
+    if (filename) {
+        sym.st_name = strtab.n;
+        bput(&strtab, filename, (int)strlen(filename) + 1);
+        sym.st_info = ELF64_ST_INFO(STB_LOCAL, STT_FILE);
+        sym.st_shndx = SHN_ABS;
+        bput(&symtab, &sym, sizeof sym);
+        nsym++;
+    }
+    for (int s = 0; s <= NSECS; s++) {
+        if (s == SEC_NOTE) continue;
+        memset(&sym, 0, sizeof sym);
+        sym.st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION);
+        sym.st_shndx = s == NSECS ? SH_EH : shidx[s];
+        bput(&symtab, &sym, sizeof sym);
+        secsym[s] = nsym++;
+    }
+    int firstglobal = nsym;
+    for (int i = 0; i < nsyms; i++) {
+        struct sym *s = &syms[i];
+        if (s->defined ? s->global : s->referenced)
+            s->elfidx = nsym++;
+    }
+
+    struct buf data[NSECS] = { { 0 } }, eh = { 0 };
+    for (int s = 0; s < NSECS; s++)
+        if (build_section(s, size[s], &data[s]) < 0) return -1;
+    if (build_eh_frame(&eh) < 0) return -1;
+
+    /* globals now that .size is known */
+    for (int i = 0; i < nsyms; i++) {
+        struct sym *s = &syms[i];
+        if (!s->elfidx) continue;
+        memset(&sym, 0, sizeof sym);
+        sym.st_name = strtab.n;
+        bput(&strtab, s->name, (int)strlen(s->name) + 1);
+        sym.st_info = ELF64_ST_INFO(STB_GLOBAL, s->func ? STT_FUNC : STT_NOTYPE);
+        if (s->defined) {
+            sym.st_shndx = shidx[s->sec];
+            sym.st_value = items[s->item].off;
+            sym.st_size = s->size;
+        }
+        bput(&symtab, &sym, sizeof sym);
+    }
+
+    struct buf shstr = { 0 };
+    int shname[SH_COUNT] = { 0 };
+    static const char *names[SH_COUNT] = {
+        "", ".text", ".rela.text", ".data", ".rela.data", ".data.rel.ro.local",
+        ".rela.data.rel.ro.local", ".rodata", ".note.GNU-stack", ".eh_frame",
+        ".rela.eh_frame", ".symtab", ".strtab", ".shstrtab"
+    };
+    for (int i = 0; i < SH_COUNT; i++) {
+        shname[i] = shstr.n;
+        bput(&shstr, names[i], (int)strlen(names[i]) + 1);
+    }
+
+    /* file: header, section contents, section headers */
+    struct buf out = { 0 };
+    Elf64_Ehdr eh_hdr;
+    memset(&eh_hdr, 0, sizeof eh_hdr);
+    bput(&out, &eh_hdr, sizeof eh_hdr);
+
+    Elf64_Shdr sh[SH_COUNT];
+    memset(sh, 0, sizeof sh);
+    struct { int idx; struct buf *b; int type, flags, align, link, info, entsize; } parts[] = {
+        { SH_TEXT,       &data[SEC_TEXT],   SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, 16, 0, 0, 0 },
+        { SH_RELA_TEXT,  &rela[SEC_TEXT],   SHT_RELA, SHF_INFO_LINK, 8, SH_SYMTAB, SH_TEXT, sizeof(Elf64_Rela) },
+        { SH_DATA,       &data[SEC_DATA],   SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, 8, 0, 0, 0 },
+        { SH_RELA_DATA,  &rela[SEC_DATA],   SHT_RELA, SHF_INFO_LINK, 8, SH_SYMTAB, SH_DATA, sizeof(Elf64_Rela) },
+        { SH_RELRO,      &data[SEC_RELRO],  SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, 8, 0, 0, 0 },
+        { SH_RELA_RELRO, &rela[SEC_RELRO],  SHT_RELA, SHF_INFO_LINK, 8, SH_SYMTAB, SH_RELRO, sizeof(Elf64_Rela) },
+        { SH_RODATA,     &data[SEC_RODATA], SHT_PROGBITS, SHF_ALLOC, 8, 0, 0, 0 },
+        { SH_NOTE,       &data[SEC_NOTE],   SHT_PROGBITS, 0, 1, 0, 0, 0 },
+        { SH_EH,         &eh,               SHT_X86_64_UNWIND, SHF_ALLOC, 8, 0, 0, 0 },
+        { SH_RELA_EH,    &rela[NSECS],      SHT_RELA, SHF_INFO_LINK, 8, SH_SYMTAB, SH_EH, sizeof(Elf64_Rela) },
+        { SH_SYMTAB,     &symtab,           SHT_SYMTAB, 0, 8, SH_STRTAB, firstglobal, sizeof(Elf64_Sym) },
+        { SH_STRTAB,     &strtab,           SHT_STRTAB, 0, 1, 0, 0, 0 },
+        { SH_SHSTRTAB,   &shstr,            SHT_STRTAB, 0, 1, 0, 0, 0 },
+    };
+    for (size_t i = 0; i < sizeof parts / sizeof parts[0]; i++) {
+        Elf64_Shdr *h = &sh[parts[i].idx];
+        balign(&out, parts[i].align, 0);
+        h->sh_name = shname[parts[i].idx];
+        h->sh_type = parts[i].type;
+        h->sh_flags = parts[i].flags;
+        h->sh_offset = out.n;
+        h->sh_size = parts[i].b->n;
+        h->sh_link = parts[i].link;
+        h->sh_info = parts[i].info;
+        h->sh_addralign = parts[i].align;
+        h->sh_entsize = parts[i].entsize;
+        if (parts[i].b->n) bput(&out, parts[i].b->p, parts[i].b->n);
+    }
+    balign(&out, 8, 0);
+    long shoff = out.n;
+    bput(&out, sh, sizeof sh);
+
+    Elf64_Ehdr *h = (Elf64_Ehdr *)out.p;
+    memcpy(h->e_ident, ELFMAG, SELFMAG);
+    h->e_ident[EI_CLASS] = ELFCLASS64;
+    h->e_ident[EI_DATA] = ELFDATA2LSB;
+    h->e_ident[EI_VERSION] = EV_CURRENT;
+    h->e_ident[EI_OSABI] = ELFOSABI_SYSV;
+    h->e_type = ET_REL;
+    h->e_machine = EM_X86_64;
+    h->e_version = EV_CURRENT;
+    h->e_shoff = shoff;
+    h->e_ehsize = sizeof(Elf64_Ehdr);
+    h->e_shentsize = sizeof(Elf64_Shdr);
+    h->e_shnum = SH_COUNT;
+    h->e_shstrndx = SH_SHSTRTAB;
+
+    int rc = 0;
+    FILE *f = fopen(ofile, "wb");
+    if (!f || fwrite(out.p, 1, out.n, f) != (size_t)out.n) {
+        snprintf(errmsg, sizeof errmsg, "cannot write %s", ofile);
+        rc = -1;
+    }
+    if (f && fclose(f) != 0) rc = -1;
+
+    for (int s = 0; s < NSECS; s++) free(data[s].p);
+    free(eh.p);
+    free(symtab.p);
+    free(strtab.p);
+    free(shstr.p);
+    free(out.p);
+    return rc;
+}
+
+/* size bytes within 1GB of k0's own data, so runtime variables are in reach */
+static unsigned char *jit_map(long size) {
+    uintptr_t near = (uintptr_t)&errmsg;
+    void *p;
+    for (uintptr_t d = 1UL << 26; d < 1UL << 30; d <<= 1) {
+        if (near < d) break;
+        p = mmap((void *)((near - d) & ~0xFFFFUL), size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) continue;
+        uintptr_t a = (uintptr_t)p;
+        if ((a > near ? a - near : near - a) < 1UL << 30) return p;
+        munmap(p, size);
+    }
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+/* text and call stubs, then the read-only data, then .data: each on
+   pages of their own so that only .data stays writable */
+static int jit_load(const char *entry, void **result) {
+    static const int datasecs[] = { SEC_RODATA, SEC_RELRO, SEC_DATA };
+    long size[NSECS], off[NSECS] = { 0 }, page = sysconf(_SC_PAGESIZE);
+    layout(size);
+
+    int nundef = 0;
+    for (int i = 0; i < nsyms; i++)
+        if (!syms[i].defined) nundef++;
+    long stubs = (size[SEC_TEXT] + 15) & -16L;
+    long textend = (stubs + 16L * nundef + page - 1) & -page;
+    long o = textend;
+    long dataoff = 0;
+    for (int i = 0; i < 3; i++) {
+        if (datasecs[i] == SEC_DATA) o = dataoff = (o + page - 1) & -page;
+        off[datasecs[i]] = o;
+        o = (o + size[datasecs[i]] + 15) & -16L;
+    }
+    long total = (o + page - 1) & -page;
+
+    unsigned char *base = jit_map(total);
+    if (!base) return fail("cannot map %ld bytes for -run", total);
+    for (int s = 0; s < NSECS; s++) jit_sec[s] = base + off[s];
+    jit_stubs = base + stubs;
+    jit_nstubs = 0;
+
+    struct buf b = { 0 };
+    int rc = 0;
+    for (int s = 0; s < NSECS && rc == 0; s++) {
+        if (s == SEC_NOTE) continue;
+        b.n = 0;
+        rc = build_section(s, size[s], &b);
+        if (rc == 0) memcpy(jit_sec[s], b.p, size[s]);
+    }
+    free(b.p);
+
+    int e = lookup(entry, strlen(entry));
+    if (rc == 0 && (!syms[e].defined || syms[e].sec != SEC_TEXT))
+        rc = fail("no %s function", entry);
+    if (rc == 0 && mprotect(base, textend, PROT_READ | PROT_EXEC) != 0)
+        rc = fail("cannot make the code executable");
+    if (rc == 0 && dataoff > textend &&
+        mprotect(base + textend, dataoff - textend, PROT_READ) != 0)
+        rc = fail("cannot make the constants read-only");
+    if (rc != 0) {
+        munmap(base, total);
+        return -1;
+    }
+    *result = jit_sec[SEC_TEXT] + items[syms[e].item].off;
+    return 0;
+}
+
+static void reset(void) {
+    for (int i = 0; i < nsyms; i++) free(syms[i].name);
+    for (int s = 0; s <= NSECS; s++) {
+        free(rela[s].p);
+        memset(&rela[s], 0, sizeof rela[s]);
+    }
+    free(items);
+    free(pool);
+    free(syms);
+    free(filename);
+    items = NULL;
+    pool = NULL;
+    syms = NULL;
+    filename = NULL;
+    nitems = capitems = npool = cappool = nsyms = capsyms = 0;
+    memset(symhash, -1, sizeof symhash);
+    cursec = SEC_TEXT;
+    lineno = 0;
+}
+
+/* every line of text into items; 0 or -1 with errmsg set */
+static int parse_text(const char *text, size_t len) {
+    reset();
+    errmsg[0] = '\0';
+    int rc = 0;
+    const char *p = text, *end = text + len;
+    char *line = NULL;
+    size_t cap = 0;
+    while (p < end && rc == 0) {
+        const char *nl = memchr(p, '\n', end - p);
+        size_t n = nl ? (size_t)(nl - p) : (size_t)(end - p);
+        if (n + 1 > cap) {
+            cap = n + 1;
+            line = realloc(line, cap);
+        }
+        memcpy(line, p, n);
+        line[n] = '\0';
+        lineno++;
+        rc = parse_line(line);
+        p += n + 1;
+    }
+    free(line);
+    return rc;
+}
+
+int assemble_elf(const char *text, size_t len, const char *ofile) {
+    int rc = parse_text(text, len);
+    if (rc == 0) rc = write_elf(ofile);
+    if (rc != 0)
+        fprintf(stderr, "k0: integrated assembler: %s; using as\n", errmsg);
+    reset();
+    return rc;
+}
+
+void *assemble_jit(const char *text, size_t len, const char *entry,
+                   void *(*extern_sym)(const char *name)) {
+    void *result = NULL;
+    int rc = parse_text(text, len);
+    jit_extern = extern_sym;
+    if (rc == 0) rc = jit_load(entry, &result);
+    jit_extern = NULL;
+    if (rc != 0)
+        fprintf(stderr, "k0: integrated assembler: %s; building an executable\n", errmsg);
+    reset();
+    return result;
+}
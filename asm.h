@@ -0,0 +1,16 @@
+#ifndef ASM_H
+#define ASM_H
+
+#include <stddef.h>
+
+/* assemble AT&T text into ELF64 object ofile; -1 if it needs as */
+int assemble_elf(const char *text, size_t len, const char *ofile);
+
+/*
+ * assemble into executable memory in this process, resolving symbols the
+ * text does not define with extern_sym; the address of entry, or NULL
+ */
+void *assemble_jit(const char *text, size_t len, const char *entry,
+                   void *(*extern_sym)(const char *name));
+
+#endif
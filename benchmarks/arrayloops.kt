@@ -0,0 +1,56 @@
+// arrayops.kt with each builtin written as a k0 loop (shellsort for sort)
+fun main() {
+    var n: Int = 1000000
+    var a: Array<Int> = Array<Int>(n) {0}
+    var i: Int = 0
+    var j: Int = 0
+    var v: Int = 0
+    var gap: Int = 0
+    var x: Int = 7
+    var r: Int = 0
+    var s: Int = 0
+    var m: Int = 0
+    var k: Int = 0
+    var check: Int = 0
+    while (r < 5) {
+        for (i in 0..n - 1) {
+            x = (x * 1103515245 + 12345) % 1000000007
+            a[i] = x
+        }
+        gap = 1
+        while (gap < n / 3) {
+            gap = gap * 3 + 1
+        }
+        while (gap > 0) {
+            for (i in gap..n - 1) {
+                v = a[i]
+                j = i
+                while (j >= gap && a[j - gap] > v) {
+                    a[j] = a[j - gap]
+                    j = j - gap
+                }
+                a[j] = v
+            }
+            gap = gap / 3
+        }
+        k = 0
+        while (a[k] != a[n - 1]) {
+            k = k + 1
+        }
+        check = check + a[n / 2] % 1000 + k % 1000
+        for (i in 0..n - 1) {
+            a[i] = r
+        }
+        s = 0
+        m = a[0]
+        for (i in 0..n - 1) {
+            s = s + a[i]
+            if (a[i] > m) {
+                m = a[i]
+            }
+        }
+        check = check + s % 1000 + m
+        r = r + 1
+    }
+    println(check)
+}
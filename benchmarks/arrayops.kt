@@ -0,0 +1,22 @@
+// sort, fill, sum, max and indexOf through the Array builtins;
+// arrayloops.kt does the same work with k0 loops
+fun main() {
+    var n: Int = 1000000
+    var a: Array<Int> = Array<Int>(n) {0}
+    var i: Int = 0
+    var x: Int = 7
+    var r: Int = 0
+    var check: Int = 0
+    while (r < 5) {
+        for (i in 0..n - 1) {
+            x = (x * 1103515245 + 12345) % 1000000007
+            a[i] = x
+        }
+        a.sort()
+        check = check + a[n / 2] % 1000 + a.indexOf(a[n - 1]) % 1000
+        a.fill(r)
+        check = check + a.sum() % 1000 + a.max()
+        r = r + 1
+    }
+    println(check)
+}
@@ -0,0 +1,13 @@
+fun main() {
+    var n: Int = 100000
+    var a: Array<Int> = Array<Int>(n) {0}
+    var i: Int = 0
+    var r: Int = 0
+    while (r < 2000) {
+        for (i in 0..n - 1) {
+            a[i] = i * 3 + r
+        }
+        r = r + 1
+    }
+    println(a[n - 1])
+}
@@ -0,0 +1,19 @@
+fun main() {
+    var n: Int = 100000
+    var a: Array<Int> = Array<Int>(n) {0}
+    var i: Int = 0
+    for (i in 0..n - 1) {
+        a[i] = (i * 7919) % 100003
+    }
+    var m: Int = 0
+    var r: Int = 0
+    while (r < 5000) {
+        for (i in 0..n - 1) {
+            if (a[i] > m) {
+                m = a[i]
+            }
+        }
+        r = r + 1
+    }
+    println(m)
+}
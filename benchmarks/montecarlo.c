@@ -0,0 +1,16 @@
+/* C counterpart of montecarlo.kt on libc rand(), what k0 used to call */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+int main(void) {
+    int n = 10000000, inside = 0;
+    srand(time(NULL));
+    for (int i = 0; i < n; i++) {
+        double x = rand() / (RAND_MAX + 1.0);
+        double y = rand() / (RAND_MAX + 1.0);
+        if (x * x + y * y < 1.0) inside++;
+    }
+    printf("%.17g\n", 4.0 * inside / n);
+    return 0;
+}
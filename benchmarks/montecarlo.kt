@@ -0,0 +1,16 @@
+fun main() {
+    var i: Int = 0
+    var n: Int = 10000000
+    var inside: Int = 0
+    var x: Double = 0.0
+    var y: Double = 0.0
+    while (i < n) {
+        x = java.util.Random.nextDouble()
+        y = java.util.Random.nextDouble()
+        if (x * x + y * y < 1.0) {
+            inside = inside + 1
+        }
+        i = i + 1
+    }
+    println(4.0 * inside / n)
+}
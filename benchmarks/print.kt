@@ -0,0 +1,11 @@
+fun main() {
+    var i: Int = 0
+    var x: Double = 0.5
+    var n: Int = 1000000
+    while (i < n) {
+        println(i)
+        println(x)
+        x = x + 1.25
+        i = i + 1
+    }
+}
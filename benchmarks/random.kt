@@ -0,0 +1,10 @@
+fun main() {
+    var i: Int = 0
+    var n: Int = 20000000
+    var s: Int = 0
+    while (i < n) {
+        s = s + java.util.Random.nextInt(100)
+        i = i + 1
+    }
+    println(s)
+}
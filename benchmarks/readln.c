@@ -0,0 +1,21 @@
+/* C counterpart of readln.kt: stdio line reads plus atoi/strtod */
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(void) {
+    char *line = NULL;
+    size_t cap = 0;
+    if (getline(&line, &cap, stdin) < 0) return 1;
+    int n = atoi(line);
+    int isum = 0;
+    double dsum = 0.0;
+    for (int i = 0; i < n; i++) {
+        if (getline(&line, &cap, stdin) < 0) break;
+        isum += atoi(line);
+        if (getline(&line, &cap, stdin) < 0) break;
+        dsum += strtod(line, NULL);
+    }
+    printf("%d\n%.17g\n", isum, dsum);
+    free(line);
+    return 0;
+}
@@ -0,0 +1,18 @@
+fun main() {
+    var header: String = readln()
+    var n: Int = header.toInt()
+    var i: Int = 0
+    var isum: Int = 0
+    var dsum: Double = 0.0
+    var a: String = ""
+    var b: String = ""
+    while (i < n) {
+        a = readln()
+        b = readln()
+        isum = isum + a.toInt()
+        dsum = dsum + b.toDouble()
+        i = i + 1
+    }
+    println(isum)
+    println(dsum)
+}
@@ -0,0 +1,14 @@
+fun main() {
+    var n: Int = 100000
+    var a: Array<Int> = Array<Int>(n) {2}
+    var s: Int = 0
+    var i: Int = 0
+    var r: Int = 0
+    while (r < 5000) {
+        for (i in 0..n - 1) {
+            s = s + a[i]
+        }
+        r = r + 1
+    }
+    println(s)
+}
@@ -0,0 +1,15 @@
+fun main() {
+    var n: Int = 100000
+    var a: Array<Int> = Array<Int>(n) {3}
+    var b: Array<Int> = Array<Int>(n) {4}
+    var c: Array<Int> = Array<Int>(n) {0}
+    var i: Int = 0
+    var r: Int = 0
+    while (r < 5000) {
+        for (i in 0..n - 1) {
+            c[i] = a[i] + b[i]
+        }
+        r = r + 1
+    }
+    println(c[n - 1])
+}
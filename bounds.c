@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tree.h"
+#include "tac.h"
+#include "k0gram.tab.h"
+#include "type.h"
+#include "codegen.h"
+#include "symtab.h"
+#include "bounds.h"
+
+/*
+ * Bounds-check elimination for range loops.
+ *
+ * Every O_ALOAD/O_ASTORE compares its index with the length in the array
+ * header unless it is marked unchecked.  In  for (i in lo..hi)  (or
+ * lo..<hi) the loop variable only takes values from lo to hi, so a[i + k]
+ * is in range on every iteration when lo + k >= 0 and hi + k < a.size.
+ * If the body assigns neither i, a, nor anything the bounds read, that
+ * can be tested once before the loop instead of on every access:
+ *
+ *         if (lo < -kmin) goto slow          for each array a
+ *         if (hi > a.size - kmax - 1) goto slow
+ *         <loop, a[i + k] unchecked>
+ *         goto done
+ *   slow: <the same loop, checked>
+ *   done:
+ *
+ * kmin and kmax are the smallest and largest offsets used with a.  The
+ * checked copy throws at the same iteration an unversioned loop would.
+ * Tests that hold by construction (a literal lo, or hi written as
+ * a.size - c) are left out, and when none is left there is no slow copy.
+ * Only the fast copy may be vectorized, since a vector kernel does no
+ * checking of its own.
+ */
+
+#define NULL_ADDR ((struct addr){R_NONE, {.offset = 0}})
+
+#define BOUNDS_MAX_NODES  400   /* max body size (tree nodes) to duplicate */
+#define BOUNDS_MAX_ARRAYS   8
+#define BOUNDS_MAX_NAMES   32
+#define BOUNDS_MAX_OFFSET 1024  /* |k| in a[i + k] */
+#define BOUNDS_MAX_DEPTH   16
+
+extern SymbolTable currentFunctionSymtab;
+extern struct addr new_temp(void);
+extern struct addr *genlabel(void);
+extern char *strprintf(const char *fmt, ...);
+
+struct array_use {
+    SymbolTableEntry arr;
+    int kmin, kmax;
+};
+
+struct safe_loop {
+    const char *ivar;
+    int narrays;
+    struct array_use use[BOUNDS_MAX_ARRAYS];
+    int nassigned;              /* names the body may change */
+    const char *assigned[BOUNDS_MAX_NAMES];
+    int failed;
+};
+
+/* loops whose fast copy is being generated, innermost last */
+static struct safe_loop *active[BOUNDS_MAX_DEPTH];
+static int nactive;
+
+static struct tree *strip(struct tree *t) {
+    while (t && !t->leaf && t->nkids == 1 && t->kids[0]) t = t->kids[0];
+    return t;
+}
+
+static int is_named(struct tree *t, const char *name) {
+    return t && t->symbolname && strcmp(t->symbolname, name) == 0;
+}
+
+static char *ident(struct tree *t) {
+    t = strip(t);
+    return (t && t->leaf && t->leaf->category == Identifier) ? t->leaf->text : NULL;
+}
+
+static int int_literal(struct tree *t, int *val) {
+    t = strip(t);
+    if (!t || !t->leaf || t->leaf->category != IntegerLiteral) return 0;
+    *val = t->leaf->value.ival;
+    return 1;
+}
+
+static struct addr immed(int v) {
+    return (struct addr){ .region = R_IMMED, .u.offset = v };
+}
+
+/* a local or parameter array; a global could be reassigned by a call */
+static SymbolTableEntry array_var(struct tree *t) {
+    char *name = ident(t);
+    if (!name) return NULL;
+    SymbolTableEntry e = lookup_symbol(currentFunctionSymtab, name);
+    if (!e || !e->type || e->type->basetype != ARRAY_TYPE ||
+        e->location.region == R_GLOBAL)
+        return NULL;
+    return e;
+}
+
+/* idx is ivar, ivar + k, k + ivar or ivar - k; the offset in *k */
+static int index_offset(struct tree *idx, const char *ivar, int *k) {
+    char *name;
+    int c;
+    idx = strip(idx);
+    if ((name = ident(idx))) {
+        *k = 0;
+        return strcmp(name, ivar) == 0;
+    }
+    if (!is_named(idx, "additive_expression") || idx->nkids != 2) return 0;
+    if ((name = ident(idx->kids[0])) && strcmp(name, ivar) == 0 &&
+        int_literal(idx->kids[1], &c))
+        *k = idx->prodrule == ADD ? c : -c;
+    else if (idx->prodrule == ADD && int_literal(idx->kids[0], &c) &&
+             (name = ident(idx->kids[1])) && strcmp(name, ivar) == 0)
+        *k = c;
+    else
+        return 0;
+    return *k >= -BOUNDS_MAX_OFFSET && *k <= BOUNDS_MAX_OFFSET;
+}
+
+static void note_assigned(struct safe_loop *s, struct tree *t) {
+    char *name = ident(t);
+    if (!name) return;
+    if (s->nassigned == BOUNDS_MAX_NAMES) {
+        s->failed = 1;
+        return;
+    }
+    s->assigned[s->nassigned++] = name;
+}
+
+static int is_assigned(struct safe_loop *s, const char *name) {
+    const char *dot = strchr(name, '.');    /* a.size reads a */
+    size_t n = dot ? (size_t)(dot - name) : strlen(name);
+    for (int i = 0; i < s->nassigned; i++)
+        if (strlen(s->assigned[i]) == n && strncmp(s->assigned[i], name, n) == 0)
+            return 1;
+    return 0;
+}
+
+static void note_use(struct safe_loop *s, SymbolTableEntry arr, int k) {
+    for (int i = 0; i < s->narrays; i++)
+        if (s->use[i].arr == arr) {
+            if (k < s->use[i].kmin) s->use[i].kmin = k;
+            if (k > s->use[i].kmax) s->use[i].kmax = k;
+            return;
+        }
+    if (s->narrays == BOUNDS_MAX_ARRAYS) return;   /* the rest stay checked */
+    s->use[s->narrays++] = (struct array_use){ arr, k, k };
+}
+
+/* collect indexed accesses and assigned names; returns the node count */
+static int scan(struct tree *t, struct safe_loop *s) {
+    if (!t || s->failed) return 0;
+    const char *sym = t->symbolname ? t->symbolname : "";
+    int k;
+
+    if ((strcmp(sym, "assignment") == 0 || strcmp(sym, "addAssignment") == 0 ||
+         strcmp(sym, "subAssignment") == 0 || strstr(sym, "Increment") ||
+         strstr(sym, "Decrement") || strstr(sym, "Declaration") ||
+         strncmp(sym, "forStatementKotlin", 18) == 0) && t->nkids >= 1)
+        note_assigned(s, t->kids[0]);
+
+    if (strcmp(sym, "arrayAccess") == 0 && t->nkids == 2) {
+        SymbolTableEntry arr = array_var(t->kids[0]);
+        if (arr && index_offset(t->kids[1], s->ivar, &k))
+            note_use(s, arr, k);
+    }
+
+    int n = 1;
+    for (int i = 0; i < t->nkids; i++)
+        n += scan(t->kids[i], s);
+    return n;
+}
+
+/* literals, locals, a.size and + - * of those: safe to evaluate twice */
+static int simple_bound(struct tree *t, struct safe_loop *s) {
+    int c;
+    char *name;
+    t = strip(t);
+    if (!t) return 0;
+    if (int_literal(t, &c)) return 1;
+    if ((name = ident(t))) {
+        SymbolTableEntry recv = NULL, e = lookup_symbol(currentFunctionSymtab, name);
+        if (!e) {
+            e = lookup_method(currentFunctionSymtab, name, &recv);
+            if (!e || !recv ||
+                (strcmp(e->s, "Array.size") != 0 && strcmp(e->s, "String.length") != 0))
+                return 0;
+            e = recv;
+        }
+        if (!e->type || e->location.region == R_GLOBAL || is_assigned(s, name))
+            return 0;
+        return e->type == integer_typeptr || e->type == string_typeptr ||
+               e->type->basetype == ARRAY_TYPE;
+    }
+    if ((is_named(t, "additive_expression") ||
+         (is_named(t, "multiplicative_expression") && t->prodrule == MULT)) &&
+        t->nkids == 2)
+        return simple_bound(t->kids[0], s) && simple_bound(t->kids[1], s);
+    return 0;
+}
+
+/* hi + kmax < a.size by construction: hi is  a.size - c  (minus one more for ..<) */
+static int hi_proven(struct tree *end, int until, struct array_use *u) {
+    int c = 0, same;
+    char *name, *size;
+    end = strip(end);
+    if (is_named(end, "additive_expression") && end->nkids == 2 &&
+        end->prodrule == SUB && int_literal(end->kids[1], &c))
+        end = end->kids[0];
+    if (!(name = ident(end))) return 0;
+    size = strprintf("%s.size", u->arr->s);
+    same = strcmp(name, size) == 0;
+    free(size);
+    return same && u->kmax <= c + until - 1;
+}
+
+static struct instr *guards(struct tree *t, struct safe_loop *s, int until,
+                            struct addr slow) {
+    struct tree *startExpr = t->kids[1], *endExpr = t->kids[2];
+    int lo, static_lo = int_literal(startExpr, &lo);
+    struct instr *code = NULL;
+    int need_start = 0, need_end = 0;
+
+    for (int i = 0; i < s->narrays; i++) {
+        if (!static_lo || lo + s->use[i].kmin < 0) need_start = 1;
+        if (!hi_proven(endExpr, until, &s->use[i])) need_end = 1;
+    }
+    if (need_start) {
+        generate_code(startExpr);
+        code = concat(code, ATTR(startExpr)->code);
+    }
+    if (need_end) {
+        generate_code(endExpr);
+        code = concat(code, ATTR(endExpr)->code);
+    }
+    for (int i = 0; i < s->narrays; i++) {
+        struct array_use *u = &s->use[i];
+        if (!static_lo || lo + u->kmin < 0)
+            code = concat(code, gen(O_BLT, slow, ATTR(startExpr)->place, immed(-u->kmin)));
+        if (!hi_proven(endExpr, until, u)) {
+            struct addr len = new_temp(), lim = new_temp();
+            code = concat(code, gen(O_ALEN, len, u->arr->location, NULL_ADDR));
+            code = concat(code, gen(O_ISUB, lim, len, immed(u->kmax + !until)));
+            code = concat(code, gen(O_BGT, slow, ATTR(endExpr)->place, lim));
+        }
+    }
+    return code;
+}
+
+struct instr *bounds_range_loop(struct tree *t,
+                                struct instr *(*loop)(struct tree *t, int proven)) {
+    char *ivar = ident(t->kids[0]);
+    int until = is_named(t, "forStatementKotlinRangeUntil");
+    if (!ivar || nactive == BOUNDS_MAX_DEPTH) return NULL;
+
+    SymbolTableEntry i = lookup_symbol(currentFunctionSymtab, ivar);
+    if (!i || i->location.region == R_GLOBAL) return NULL;
+
+    struct safe_loop *s = calloc(1, sizeof *s);
+    if (!s) return NULL;
+    s->ivar = ivar;
+    int size = scan(t->kids[3], s);
+    int ok = !s->failed && s->narrays > 0 && size <= BOUNDS_MAX_NODES &&
+             !is_assigned(s, ivar) &&
+             simple_bound(t->kids[1], s) && simple_bound(t->kids[2], s);
+    for (int k = 0; ok && k < s->narrays; k++)
+        if (is_assigned(s, s->use[k].arr->s)) ok = 0;
+    if (!ok) {
+        free(s);
+        return NULL;
+    }
+
+    struct addr *slow = genlabel();
+    struct instr *code = guards(t, s, until, *slow);
+
+    active[nactive++] = s;
+    struct instr *fast = loop(t, 1);
+    nactive--;
+
+    if (code) {
+        struct addr *done = genlabel();
+        fast = concat(fast, gen(O_BR, *done, NULL_ADDR, NULL_ADDR));
+        fast = concat(fast, gen(D_LABEL, *slow, NULL_ADDR, NULL_ADDR));
+        fast = concat(fast, loop(t, 0));
+        fast = concat(fast, gen(D_LABEL, *done, NULL_ADDR, NULL_ADDR));
+    }
+    free(s);
+    return concat(code, fast);
+}
+
+int bounds_proven(struct tree *access) {
+    int k;
+    if (!access || access->nkids != 2) return 0;
+    SymbolTableEntry arr = array_var(access->kids[0]);
+    if (!arr) return 0;
+    for (int d = nactive - 1; d >= 0; d--) {
+        struct safe_loop *s = active[d];
+        if (!index_offset(access->kids[1], s->ivar, &k)) continue;
+        for (int i = 0; i < s->narrays; i++)
+            if (s->use[i].arr == arr && k >= s->use[i].kmin && k <= s->use[i].kmax)
+                return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,10 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include "tree.h"
+
+struct instr *bounds_range_loop(struct tree *t,
+                                struct instr *(*loop)(struct tree *t, int proven));
+int bounds_proven(struct tree *access);
+
+#endif
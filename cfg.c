@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tac.h"
+#include "cfg.h"
+
+int is_cond_branch(int opcode) {
+    switch (opcode) {
+        case O_BZ: case O_BNZ:
+        case O_BLT: case O_BLE: case O_BGT: case O_BGE:
+        case O_BEQ: case O_BNE: case O_BIF: case O_BNIF:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int is_branch(int opcode) {
+    return opcode == O_BR || opcode == O_GOTO || is_cond_branch(opcode);
+}
+
+static int is_label(struct instr *i) {
+    return i->opcode == D_LABEL || i->opcode == O_LBL;
+}
+
+static struct block *new_block(struct cfg *g, struct instr *first) {
+    struct block *b = calloc(1, sizeof *b);
+    if (!b) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+    b->id = g->nblocks++;
+    b->first = first;
+    return b;
+}
+
+
+/* proc points at a D_PROC; returns NULL if the function has no D_END */
+struct cfg *build_cfg(struct instr *proc) {
+    struct cfg *g = calloc(1, sizeof *g);
+    struct block *tail = NULL;
+    struct instr *i;
+
+    if (!g) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+    g->proc = proc;
+    for (i = proc->next; i && i->opcode != D_END; i = i->next) {
+        if (!tail || is_label(i) || is_branch(tail->last->opcode)) {
+            struct block *b = new_block(g, i);
+            if (tail) tail->next = b;
+            else      g->blocks = b;
+            tail = b;
+        }
+        tail->last = i;
+    }
+    if (!i) {
+        free_cfg(g);
+        return NULL;
+    }
+    g->end = i;
+
+    /* label numbers are dense, so index the label blocks by number */
+    int lo = 0, hi = -1;
+    for (struct block *b = g->blocks; b; b = b->next)
+        if (is_label(b->first)) {
+            int l = b->first->dest.u.offset;
+            if (hi < lo)     lo = hi = l;
+            else if (l < lo) lo = l;
+            else if (l > hi) hi = l;
+        }
+    struct block **bylabel = calloc(hi - lo + 1 > 0 ? hi - lo + 1 : 1,
+                                    sizeof *bylabel);
+    if (!bylabel) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+    for (struct block *b = g->blocks; b; b = b->next)
+        if (is_label(b->first))
+            bylabel[b->first->dest.u.offset - lo] = b;
+
+    for (struct block *b = g->blocks; b; b = b->next) {
+        int op = b->last->opcode;
+        if (is_branch(op)) {
+            int l = b->last->dest.u.offset;
+            if (l >= lo && l <= hi && bylabel[l - lo])
+                b->succ[b->nsucc++] = bylabel[l - lo];
+        }
+        if (op != O_BR && op != O_GOTO && b->next)
+            b->succ[b->nsucc++] = b->next;
+    }
+    free(bylabel);
+    return g;
+}
+
+void mark_reachable(struct cfg *g) {
+    struct block **work;
+    int n = 0;
+
+    if (!g->blocks) return;
+    work = malloc(g->nblocks * sizeof *work);
+    if (!work) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+    g->blocks->reachable = 1;
+    work[n++] = g->blocks;
+    while (n > 0) {
+        struct block *b = work[--n];
+        for (int k = 0; k < b->nsucc; k++)
+            if (!b->succ[k]->reachable) {
+                b->succ[k]->reachable = 1;
+                work[n++] = b->succ[k];
+            }
+    }
+    free(work);
+}
+
+void free_cfg(struct cfg *g) {
+    if (!g) return;
+    struct block *b = g->blocks;
+    while (b) {
+        struct block *next = b->next;
+        free(b);
+        b = next;
+    }
+    free(g);
+}
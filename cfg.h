@@ -0,0 +1,31 @@
+#ifndef CFG_H
+#define CFG_H
+
+#include "tac.h"
+
+/*
+ * Basic blocks over the TAC of one function.  A block is the inclusive
+ * run first..last; it starts at a label or after a branch.
+ */
+struct block {
+    int id;
+    struct instr *first, *last;
+    struct block *succ[2];
+    int nsucc;
+    int reachable;
+    struct block *next;
+};
+
+struct cfg {
+    struct instr *proc, *end;   /* the D_PROC and D_END bracketing it */
+    struct block *blocks;       /* in code order; blocks is the entry */
+    int nblocks;
+};
+
+int is_branch(int opcode);
+int is_cond_branch(int opcode);
+struct cfg *build_cfg(struct instr *proc);
+void mark_reachable(struct cfg *g);
+void free_cfg(struct cfg *g);
+
+#endif
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <math.h>
 
 #include "tree.h"
 #include "tac.h"
@@ -9,6 +10,11 @@
 #include "type.h"
 #include "codegen.h"
 #include "symtab.h"
+#include "vectorize.h"
+#include "unroll.h"
+#include "bounds.h"
+#include "passes.h"
+#include "parallel.h"
 
 #define NULL_ADDR ((struct addr){R_NONE, {.offset = 0}})
 #define DEBUG_OUTPUT 0  // Set to 1 to enable debug output, 0 to disable
@@ -27,14 +33,27 @@ extern char *opcodename(int i);
 extern char *pseudoname(int i);
 
 typedef struct { char *label, *text; } StrLit;
-static StrLit strtab[128];
-static int   strcount = 0;
+static StrLit *strtab  = NULL;
+static int   strcount = 0, strcap = 0;
 
 typedef struct { char label[32]; double val; } RealEntry;
 static RealEntry *dbltab   = NULL;
-static int       dblcount = 0;
+static int       dblcount = 0, dblcap = 0;
+
+/* make room for one more entry in a literal pool, doubling it when full */
+static void *grow_pool(void *pool, int count, int *cap, size_t size) {
+    if (count < *cap) return pool;
+    *cap = *cap ? *cap * 2 : 64;
+    pool = realloc(pool, *cap * size);
+    if (!pool) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+    return pool;
+}
  
 static void add_string_literal(const char *label, const char *text) {
+    strtab = grow_pool(strtab, strcount, &strcap, sizeof *strtab);
     strtab[strcount].label = strdup(label);
     strtab[strcount].text  = strdup(text);
     strcount++;
@@ -50,12 +69,26 @@ struct addr empty_addr() {
 
 
 static int add_real_literal(const char *label, double v) {
-    dbltab = realloc(dbltab, (dblcount+1)*sizeof *dbltab);
+    dbltab = grow_pool(dbltab, dblcount, &dblcap, sizeof *dbltab);
     strcpy(dbltab[dblcount].label, label);
     dbltab[dblcount].val   = v;
     return dblcount++;
 }
 
+/* v in a fresh temp, loaded the way a RealLiteral is; for the vectorizer */
+struct addr double_const(double v, struct instr **code) {
+    char lbl[32];
+    snprintf(lbl, sizeof(lbl), "D%d", dblcount);
+    struct addr place = new_temp();
+    struct instr *lit = gen(O_LCONT, place,
+                            (struct addr){ .region = R_IMMED,
+                                           .u.offset = add_real_literal(lbl, v) },
+                            NULL_ADDR);
+    lit->is_double = 1;
+    *code = concat(*code, lit);
+    return place;
+}
+
 static void flattenExprList(struct tree *elist, struct tree ***outArgs, int *outCount) {
     if (!elist) return;
     if (elist->symbolname && (strcmp(elist->symbolname, "expressionList") == 0 || strcmp(elist->symbolname, "valueArgumentList") == 0)) {
@@ -63,8 +96,15 @@ static void flattenExprList(struct tree *elist, struct tree ***outArgs, int *out
             flattenExprList(elist->kids[i], outArgs, outCount);
         }
     } else {
-        *outArgs = realloc(*outArgs,
-        sizeof(struct tree*) * (*outCount + 1));
+        /* grow by doubling: the array is full whenever the count is 0 or a power of two */
+        int n = *outCount;
+        if (n == 0 || (n & (n - 1)) == 0) {
+            *outArgs = realloc(*outArgs, sizeof(struct tree*) * (n ? 2 * n : 1));
+            if (!*outArgs) {
+                fprintf(stderr, "out of memory\n");
+                exit(4);
+            }
+        }
         (*outArgs)[*outCount] = elist;
         (*outCount)++;
     }
@@ -80,38 +120,41 @@ static void flattenExprList(struct tree *elist, struct tree ***outArgs, int *out
  }
  
 
- static void generate_output_filename(const char *input_filename, char *output_filename, size_t size) {
-     if (!input_filename || !output_filename || size == 0) {
-         fprintf(stderr, "ERROR: Invalid parameters to generate_output_filename\n");
-         return;
-     }
-     
-     strncpy(output_filename, input_filename, size - 1);
-     output_filename[size - 1] = '\0';
-     char *dot = strrchr(output_filename, '.');
-     if (dot != NULL) {
-         strcpy(dot, ".ic");
-     } else {
-         strncat(output_filename, ".ic", size - strlen(output_filename) - 1);
+ /* input_filename with its extension replaced by .ic; malloc'd */
+ static char *generate_output_filename(const char *input_filename) {
+     size_t n = strlen(input_filename);
+     const char *dot = strrchr(input_filename, '.');
+     if (dot != NULL) n = dot - input_filename;
+     char *output_filename = malloc(n + sizeof ".ic");
+     if (!output_filename) {
+         fprintf(stderr, "out of memory\n");
+         exit(4);
      }
+     memcpy(output_filename, input_filename, n);
+     strcpy(output_filename + n, ".ic");
+     return output_filename;
  }
  
 
-static void format_operand(struct addr a, char *buf, size_t sz) {
+/* one operand, padded to width; a name is written whole however long */
+static void output_operand(FILE *f, struct addr a, int width) {
+    char buf[32];   /* region:offset */
+    const char *text = buf;
     if (a.region == R_NAME && a.u.name) {
-        snprintf(buf, sz, "%s", a.u.name);
+        text = a.u.name;
     }
     else if (a.region == R_NONE) {
-        snprintf(buf, sz, "none:%d", a.u.offset);
+        snprintf(buf, sizeof buf, "none:%d", a.u.offset);
     }
     else if (a.region < R_GLOBAL || a.region > R_RET) {
-        snprintf(buf, sz, "invalid:%d", a.u.offset);
+        snprintf(buf, sizeof buf, "invalid:%d", a.u.offset);
     }
     else {
-        snprintf(buf, sz, "%s:%d",
+        snprintf(buf, sizeof buf, "%s:%d",
                  regionname(a.region),
                  a.u.offset);
     }
+    fprintf(f, "%-*s", width, text);
 }
 
 
@@ -123,47 +166,65 @@ static void format_operand(struct addr a, char *buf, size_t sz) {
         regionname(instr->dest.region), instr->dest.u.offset,
         regionname(instr->src1.region), instr->src1.u.offset);
 
-    char destbuf[32], src1buf[32], src2buf[32];
-
-    format_operand(instr->dest,  destbuf, sizeof destbuf);
-    format_operand(instr->src1, src1buf, sizeof src1buf);
-    format_operand(instr->src2, src2buf, sizeof src2buf);
-
-    fprintf(f, "%-8s  %-16s  %-16s  %-16s\n",
-            opcodename(instr->opcode),
-            destbuf,
-            src1buf,
-            src2buf);
+    fprintf(f, "%-8s  ", opcodename(instr->opcode));
+    output_operand(f, instr->dest, 16);
+    fprintf(f, "  ");
+    output_operand(f, instr->src1, 16);
+    fprintf(f, "  ");
+    output_operand(f, instr->src2, 16);
+    // the flags the backend reads, so the TAC VM can run the file (vm.c)
+    if (instr->is_double) fprintf(f, "  d");
+    if (instr->is_ptr)    fprintf(f, "  p");
+    if (instr->width)     fprintf(f, "  w=%d", instr->width);
+    if (instr->unchecked) fprintf(f, "  u");
+    fprintf(f, "\n");
 }
  
 
- void write_ic_file(const char *input_filename, struct instr *code) {
+ /* the .ic for input_filename, opened for writing; NULL if it can't be */
+static FILE *open_ic_file(const char *input_filename) {
     if (!input_filename) {
         fprintf(stderr, "ERROR: NULL input filename provided to write_ic_file\n");
-        return;
+        return NULL;
     }
     
-    char output_filename[256];
-    generate_output_filename(input_filename, output_filename, sizeof(output_filename));
+    char *output_filename = generate_output_filename(input_filename);
     
     FILE *f = fopen(output_filename, "w");
     if (!f) {
         fprintf(stderr, "ERROR: Could not open output file %s for writing\n", output_filename);
-        return;
+        free(output_filename);
+        return NULL;
     }
     
     debug_print("DEBUG: Writing intermediate code to file %s\n", output_filename);
     printf("Intermediate code will be written to %s\n", output_filename);
-    
+    free(output_filename);
+    return f;
+}
+
+/* everything in the .ic before the code */
+static void write_ic_data(FILE *f) {
     fprintf(f, ".string\n");
 for (int i = 0; i < strcount; i++) {
     fprintf(f, "%s\t\"%s\"\n", strtab[i].label, strtab[i].text);
 }
     
+    // %.17g reads back as the same double, as in the .s
+    fprintf(f, ".double\n");
+    for (int i = 0; i < dblcount; i++)
+        fprintf(f, "%s\t%.17g\n", dbltab[i].label, dbltab[i].val);
+
     fprintf(f, ".data\n");
     fprintf(f, "/* global variable declarations */\n\n");
     
     fprintf(f, ".code\n");
+}
+
+ void write_ic_file(const char *input_filename, struct instr *code) {
+    FILE *f = open_ic_file(input_filename);
+    if (!f) return;
+    write_ic_data(f);
     
     if (code == NULL) {
         debug_print("DEBUG: write_ic_file: TAC code list is NULL!\n");
@@ -180,31 +241,516 @@ for (int i = 0; i < strcount; i++) {
         if (instrCount == 0) {
             fprintf(f, "/* No instructions generated */\n");
         }
-        debug_print("DEBUG: Finished writing %d instructions to %s\n", instrCount, output_filename);
+        debug_print("DEBUG: Finished writing %d instructions\n", instrCount);
     }
     
     fclose(f);
 }
  
 
+/* the literal tables behind R_GLOBAL strings and O_LCONT, for the TAC VM */
+void get_literals(struct tac_program *p) {
+    p->nstrings = strcount;
+    p->strings = malloc((strcount + 1) * sizeof *p->strings);
+    for (int i = 0; i < strcount; i++) p->strings[i] = strtab[i].text;
+    p->nreals = dblcount;
+    p->reals = malloc((dblcount + 1) * sizeof *p->reals);
+    for (int i = 0; i < dblcount; i++) p->reals[i] = dbltab[i].val;
+}
+
+/* empty the literal pools, so the next file's start again at S0 and D0 */
+void free_literals(void) {
+    for (int i = 0; i < strcount; i++) {
+        free(strtab[i].label);
+        free(strtab[i].text);
+    }
+    strcount = 0;
+    dblcount = 0;
+}
+
+/*
+ * Calls into the runtime library.  A PARM's is_ptr/is_double pick the
+ * register class just as for calls to k0 functions.
+ */
+static struct instr *parm_of(struct addr a, int is_ptr, int is_double) {
+    struct instr *p = gen(O_PARM, NULL_ADDR, a, NULL_ADDR);
+    p->is_ptr = is_ptr;
+    p->is_double = is_double;
+    return p;
+}
+
+static struct instr *call_runtime(const char *fn, struct addr dest,
+                                  int ret_ptr, int ret_double) {
+    struct addr name = { .region = R_NAME, .u.name = strdup(fn) };
+    struct instr *c = gen(O_CALL, dest, name, NULL_ADDR);
+    c->is_ptr = ret_ptr;
+    c->is_double = ret_double;
+    return c;
+}
+
+/* dest = k0_str_equals(a, b) or k0_str_compare(a, b) */
+static struct instr *string_compare(const char *fn, struct addr dest,
+                                    struct addr a, struct addr b) {
+    struct instr *code = parm_of(a, 1, 0);
+    code = concat(code, parm_of(b, 1, 0));
+    return concat(code, call_runtime(fn, dest, 0, 0));
+}
+
+/* Strings, maps and arrays live on the heap; a variable holds the pointer */
+static int is_pointer_type(typeptr t) {
+    return t == string_typeptr ||
+           (t && (t->basetype == MAP_TYPE || t->basetype == ARRAY_TYPE));
+}
+
+/*
+ * HashMap<K, Int>: a k0_map pointer.  Every operation is a direct call
+ * to the runtime, k0_map_<method>_int or _str by the key type; the value
+ * is an Int.
+ */
+static struct instr *map_call(const char *method, typeptr map, struct addr self,
+                              struct tree **args, int argc, struct addr dest) {
+    int str_key = map->u.m.keytype == string_typeptr;
+    char fn[64];
+    snprintf(fn, sizeof(fn), "k0_map_%s_%s", method, str_key ? "str" : "int");
+    struct instr *code = parm_of(self, 1, 0);
+    for (int i = 0; i < argc; i++)
+        code = concat(code, parm_of(ATTR(args[i])->place, i == 0 && str_key, 0));
+    return concat(code, call_runtime(fn, dest, 0, 0));
+}
+
+/*
+ * String + and templates.  A chain a + b + "c" and the pieces of
+ * "a$x${e}" flatten into one list of parts.  Every part is evaluated
+ * first, then passed to k0_cat_* in order, and k0_cat_end allocates the
+ * result once at its final length.
+ */
+static int is_string_concat(struct tree *t) {
+    if (!t || !t->symbolname) return 0;
+    if (strcmp(t->symbolname, "stringTemplate") == 0 ||
+        strcmp(t->symbolname, "templateParts") == 0)
+        return 1;
+    return strcmp(t->symbolname, "additive_expression") == 0 &&
+           t->nkids == 2 && t->prodrule == ADD && t->type == string_typeptr;
+}
+
+static void concat_parts(struct tree *t, struct instr **code,
+                         struct instr **calls) {
+    while (t && !t->leaf && t->nkids == 1 && !is_string_concat(t))
+        t = t->kids[0];
+    if (is_string_concat(t)) {
+        for (int i = 0; i < t->nkids; i++)
+            concat_parts(t->kids[i], code, calls);
+        return;
+    }
+
+    generate_code(t);
+    *code = concat(*code, ATTR(t)->code);
+
+    const char *fn;
+    int is_ptr = 0, is_double = 0;
+    if (t->type == string_typeptr)       { fn = "k0_cat_str"; is_ptr = 1; }
+    else if (t->type == double_typeptr)  { fn = "k0_cat_double"; is_double = 1; }
+    else if (t->type == boolean_typeptr) fn = "k0_cat_bool";
+    else if (t->type == integer_typeptr) fn = "k0_cat_int";
+    else {
+        fprintf(stderr, "ERROR: no String conversion for %s at line %d\n",
+                t->type ? typename(t->type) : "this value", t->lineno);
+        exit(1);
+    }
+    *calls = concat(*calls, parm_of(ATTR(t)->place, is_ptr, is_double));
+    *calls = concat(*calls, call_runtime(fn, NULL_ADDR, 0, 0));
+}
+
+static void gen_string_concat(struct tree *t) {
+    struct instr *code = NULL, *calls = NULL;
+    concat_parts(t, &code, &calls);
+    t->type  = string_typeptr;
+    ATTR(t)->place = new_temp();
+    ATTR(t)->code  = concat(concat(code, calls),
+                      call_runtime("k0_cat_end", ATTR(t)->place, 1, 0));
+}
+
+/*
+ * Branch to `label` when the Boolean condition t evaluates to `sense`.
+ * Int comparisons become one O_Bxx, and &&, || and ! are lowered to
+ * control flow, so a condition never materializes a Boolean unless it
+ * is some other expression (a variable, a call, ...).
+ */
+static int is_int_operand(struct tree *t) {
+    return t->type != double_typeptr && t->type != string_typeptr;
+}
+
+static int branch_opcode(int prodrule, int sense) {
+    switch (prodrule) {
+        case RANGLE:  return sense ? O_BGT : O_BLE;
+        case LANGLE:  return sense ? O_BLT : O_BGE;
+        case GE:      return sense ? O_BGE : O_BLT;
+        case LE:      return sense ? O_BLE : O_BGT;
+        case EQEQ:
+        case EQEQEQ:  return sense ? O_BEQ : O_BNE;
+        case EXCL_EQ: return sense ? O_BNE : O_BEQ;
+        default:      return 0;
+    }
+}
+
+/* a comparison as a Boolean temp, once both kids have their code */
+static void comparison_value(struct tree *t) {
+    int opcode;
+    if      (t->prodrule == RANGLE) opcode = O_IGT;
+    else if (t->prodrule == LANGLE) opcode = O_ILT;
+    else if (t->prodrule == GE) opcode = O_IGE;
+    else if (t->prodrule == LE) opcode = O_ILE;
+    else if (t->prodrule == EQEQ) opcode = O_IEQ;
+    else if (t->prodrule == EXCL_EQ) opcode = O_INE;
+    else                                    opcode = O_IGT; 
+
+    ATTR(t)->place = new_temp();
+    ATTR(t)->code  = concat(ATTR(t->kids[0])->code, ATTR(t->kids[1])->code);
+    t->type  = boolean_typeptr;
+    if (t->kids[0]->type == string_typeptr) {
+        // a < b on Strings is a.compareTo(b) < 0
+        struct addr order = new_temp(), zero = new_temp();
+        ATTR(t)->code = concat(ATTR(t)->code, string_compare("k0_str_compare", order,
+                                                 ATTR(t->kids[0])->place,
+                                                 ATTR(t->kids[1])->place));
+        ATTR(t)->code = concat(ATTR(t)->code, gen(O_ASN, zero,
+                                      (struct addr){ .region = R_IMMED, .u.offset = 0 },
+                                      NULL_ADDR));
+        ATTR(t)->code = concat(ATTR(t)->code, gen(opcode, ATTR(t)->place, order, zero));
+        return;
+    }
+    struct instr *cmp = gen(opcode, ATTR(t)->place,
+                            ATTR(t->kids[0])->place, ATTR(t->kids[1])->place);
+    cmp->is_double = t->kids[0]->type == double_typeptr;
+    ATTR(t)->code  = concat(ATTR(t)->code, cmp);
+}
+
+/* == or != as a Boolean temp, once both kids have their code */
+static void equality_value(struct tree *t) {
+    struct tree *lhs = t->kids[0];
+    struct tree *rhs = t->kids[1];
+
+    struct instr *code = NULL;
+    code = concat(ATTR(lhs)->code, ATTR(rhs)->code);
+
+    struct addr tmp = new_temp();
+
+    const char *op = t->leaf ? t->leaf->text : NULL;
+            
+    if (op) {
+        int opcode;
+        if (strcmp(op, "==") == 0 || strcmp(op, "===") == 0)
+            opcode = O_IEQ;
+        else if (strcmp(op, "!=") == 0)
+            opcode = O_INE;
+        else {
+            fprintf(stderr, "ERROR: unknown equality op: %s\n", op);
+            return;
+        }
+        if (lhs->type == string_typeptr) {
+            // == on Strings compares the text, like Kotlin
+            struct addr same = opcode == O_IEQ ? tmp : new_temp();
+            code = concat(code, string_compare("k0_str_equals", same,
+                                               ATTR(lhs)->place, ATTR(rhs)->place));
+            if (opcode == O_INE)
+                code = concat(code, gen(O_NOT, tmp, same, NULL_ADDR));
+        } else {
+            struct instr *cmp = gen(opcode, tmp, ATTR(lhs)->place, ATTR(rhs)->place);
+            cmp->is_double = lhs->type == double_typeptr;
+            code = concat(code, cmp);
+        }
+    }
+
+    ATTR(t)->code = code;
+    ATTR(t)->place = tmp;
+    t->type  = boolean_typeptr;
+}
+
+static struct instr *cond_jump(struct tree *t, struct addr label, int sense) {
+    struct instr *code = NULL;
+
+    if (t->symbolname && t->nkids == 2 &&
+        (strcmp(t->symbolname, "comparison") == 0 ||
+         strcmp(t->symbolname, "equality") == 0) &&
+        branch_opcode(t->prodrule, sense)) {
+        generate_code(t->kids[0]);
+        generate_code(t->kids[1]);
+        if (is_int_operand(t->kids[0]) && is_int_operand(t->kids[1])) {
+            code = concat(ATTR(t->kids[0])->code, ATTR(t->kids[1])->code);
+            return concat(code, gen(branch_opcode(t->prodrule, sense), label,
+                                    ATTR(t->kids[0])->place, ATTR(t->kids[1])->place));
+        }
+        // a Double or String compare: the kids' code is used as it is
+        if (strcmp(t->symbolname, "comparison") == 0)
+            comparison_value(t);
+        else
+            equality_value(t);
+        return concat(ATTR(t)->code, gen(sense ? O_BNZ : O_BZ, label, ATTR(t)->place, NULL_ADDR));
+    }
+    else if (t->symbolname && t->nkids == 2 &&
+             (strcmp(t->symbolname, "conjunction") == 0 ||
+              strcmp(t->symbolname, "disjunction") == 0)) {
+        /* a && b jumps on false as soon as either is false; a || b
+           jumps on true as soon as either is true */
+        int is_and = strcmp(t->symbolname, "conjunction") == 0;
+        if (sense != is_and) {
+            code = cond_jump(t->kids[0], label, sense);
+            return concat(code, cond_jump(t->kids[1], label, sense));
+        }
+        struct addr *skip = genlabel();
+        code = cond_jump(t->kids[0], *skip, !sense);
+        code = concat(code, cond_jump(t->kids[1], label, sense));
+        code = concat(code, gen(D_LABEL, *skip, NULL_ADDR, NULL_ADDR));
+        free(skip);
+        return code;
+    }
+    else if (t->symbolname && t->nkids == 1 &&
+             strcmp(t->symbolname, "negation") == 0) {
+        return cond_jump(t->kids[0], label, !sense);
+    }
+    else if (t->leaf && t->leaf->category == BooleanLiteral) {
+        int val = strcmp(t->leaf->text, "true") == 0;
+        if (val == sense)
+            return gen(O_BR, label, NULL_ADDR, NULL_ADDR);
+        return gen(D_LABEL, *genlabel(), NULL_ADDR, NULL_ADDR);
+    }
+
+    generate_code(t);
+    return concat(ATTR(t)->code, gen(sense ? O_BNZ : O_BZ, label, ATTR(t)->place, NULL_ADDR));
+}
+
+/*
+ * An Array<T>(n){init} initializer is loop-invariant when evaluating it
+ * once gives the same value for every element: no calls, increments or
+ * assignments anywhere inside it.
+ */
+static int is_invariant_init(struct tree *t) {
+    if (!t) return 1;
+    if (t->symbolname &&
+        (strcmp(t->symbolname, "functionCall") == 0 ||
+         strcmp(t->symbolname, "postIncrement") == 0 ||
+         strcmp(t->symbolname, "postDecrement") == 0 ||
+         strcmp(t->symbolname, "preIncrement") == 0 ||
+         strcmp(t->symbolname, "preDecrement") == 0 ||
+         strcmp(t->symbolname, "assignment") == 0))
+        return 0;
+    for (int i = 0; i < t->nkids; i++)
+        if (!is_invariant_init(t->kids[i])) return 0;
+    return 1;
+}
+
+/* literal 0, 0.0 or false: the element bytes are all zero */
+static int is_zero_init(struct tree *t) {
+    while (t && !t->leaf && t->nkids == 1) t = t->kids[0];
+    if (!t || !t->leaf) return 0;
+    switch (t->leaf->category) {
+        case IntegerLiteral: return t->leaf->value.ival == 0;
+        case RealLiteral:    return t->leaf->value.dval == 0.0 &&
+                                    !signbit(t->leaf->value.dval);
+        case BooleanLiteral: return strcmp(t->leaf->text, "false") == 0;
+        default:             return 0;
+    }
+}
+
+/* bits per element of an array type */
+static int elem_bits(typeptr arr) {
+    return (arr && arr->basetype == ARRAY_TYPE && arr->u.a.elembits)
+           ? arr->u.a.elembits : 32;
+}
+
+/* arr[idx] at the array's element width, into dest or from val */
+static struct instr *array_load(struct addr dest, struct addr arr,
+                                struct addr idx, typeptr arrType) {
+    struct instr *i = gen(O_ALOAD, dest, arr, idx);
+    i->width = elem_bits(arrType);
+    i->is_double = arrType->u.a.elemtype == double_typeptr;
+    i->is_ptr = is_pointer_type(arrType->u.a.elemtype);
+    return i;
+}
+
+static struct instr *array_store(struct addr arr, struct addr idx,
+                                 struct addr val, typeptr arrType) {
+    struct instr *i = gen(O_ASTORE, arr, idx, val);
+    i->width = elem_bits(arrType);
+    i->is_double = arrType->u.a.elemtype == double_typeptr;
+    i->is_ptr = is_pointer_type(arrType->u.a.elemtype);
+    return i;
+}
+
+/* the runtime fill for element widths O_FILL does not cover */
+static struct instr *array_fill_call(struct addr arr, struct addr val,
+                                     typeptr arrType) {
+    typeptr elem = arrType->u.a.elemtype;
+    const char *fn;
+    switch (elem_bits(arrType)) {
+        case 1:  fn = "k0_array_fill_bool"; break;
+        case 8:  fn = "k0_array_fill_byte"; break;
+        case 16: fn = "k0_array_fill_short"; break;
+        default: fn = elem == double_typeptr ? "k0_array_fill_double" :
+                      is_pointer_type(elem) ? "k0_array_fill_ptr" :
+                      "k0_array_fill_long";
+    }
+    struct instr *code = parm_of(arr, 1, 0);
+    code = concat(code, parm_of(val, is_pointer_type(elem), elem == double_typeptr));
+    return concat(code, call_runtime(fn, NULL_ADDR, 0, 0));
+}
+
+/*
+ * Allocate an n-element array into `dest` and initialize it.  Both
+ * allocations go through the runtime, which puts the length in front;
+ * the element width in bits is the allocation's src2.
+ *   zero init       -> k0_array_new, no store loop at all
+ *   invariant init  -> evaluate once, then O_FILL (vector store loop) for
+ *                      Int elements or a runtime fill for other widths
+ *   anything else   -> scalar loop re-evaluating init per element
+ */
+static struct instr *gen_array_init(struct addr dest, struct tree *sizeExpr,
+                                    struct tree *initExpr, typeptr arrType) {
+    struct addr bitsPer = { .region = R_IMMED, .u.offset = elem_bits(arrType) };
+
+    generate_code(sizeExpr);
+    struct instr *code = ATTR(sizeExpr)->code;
+    struct addr basePtr = new_temp();
+
+    if (is_zero_init(initExpr)) {
+        struct instr *c = gen(O_CALLOC, basePtr, ATTR(sizeExpr)->place, bitsPer);
+        c->is_ptr = 1;
+        code = concat(code, c);
+        struct instr *copyPtr = gen(O_ASN, dest, basePtr, NULL_ADDR);
+        copyPtr->is_ptr = 1;
+        return concat(code, copyPtr);
+    }
+
+    struct instr *m = gen(O_MALLOC, basePtr, ATTR(sizeExpr)->place, bitsPer);
+    m->is_ptr = 1;
+    code = concat(code, m);
+    struct instr *copyPtr = gen(O_ASN, dest, basePtr, NULL_ADDR);
+    copyPtr->is_ptr = 1;
+    code = concat(code, copyPtr);
+
+    if (is_invariant_init(initExpr)) {
+        generate_code(initExpr);
+        code = concat(code, ATTR(initExpr)->code);
+        if (bitsPer.u.offset != 32 || arrType->u.a.elemtype != integer_typeptr)
+            return concat(code, array_fill_call(dest, ATTR(initExpr)->place, arrType));
+        return concat(code, gen(O_FILL, dest, ATTR(sizeExpr)->place,
+                                ATTR(initExpr)->place));
+    }
+
+    struct addr idx = new_temp();
+    code = concat(code,
+                  gen(O_ASN,
+                      idx,
+                      (struct addr){ .region=R_IMMED, .u.offset=0 },
+                      NULL_ADDR));
+
+    struct addr *lblTop  = genlabel();
+    struct addr *lblExit = genlabel();
+    code = concat(code, gen(D_LABEL, *lblTop, NULL_ADDR, NULL_ADDR));
+
+    struct addr cmp = new_temp();
+    code = concat(code, gen(O_IGE, cmp, idx, ATTR(sizeExpr)->place));
+    code = concat(code, gen(O_BNZ, *lblExit, cmp, NULL_ADDR));
+
+    generate_code(initExpr);
+    code = concat(code, ATTR(initExpr)->code);
+    struct instr *st = array_store(dest, idx, ATTR(initExpr)->place, arrType);
+    st->unchecked = 1;      /* 0 <= idx < size */
+    code = concat(code, st);
+
+    code = concat(code,
+                  gen(O_IADD,
+                      idx,
+                      idx,
+                      (struct addr){ .region=R_IMMED, .u.offset=1 }));
+    code = concat(code, gen(O_BR, *lblTop, NULL_ADDR, NULL_ADDR));
+    code = concat(code, gen(D_LABEL, *lblExit, NULL_ADDR, NULL_ADDR));
+    free(lblTop);
+    free(lblExit);
+    return code;
+}
+
+/*
+ * for (i in lo..hi) and for (i in lo..<hi).  proven: bounds.c has shown
+ * every array index in the body built from i to be in range, so the
+ * vectorizer, which does not check, may take the loop.
+ */
+static struct instr *range_loop(struct tree *t, int proven) {
+    struct tree *loopVar = t->kids[0];
+    struct tree *startExpr = t->kids[1];
+    struct tree *endExpr = t->kids[2];
+    struct tree *body = t->kids[3];
+    int until = strcmp(t->symbolname, "forStatementKotlinRangeUntil") == 0;
+
+    SymbolTableEntry entry = lookup_symbol(currentFunctionSymtab, loopVar->leaf->text);
+    if (!entry) {
+        fprintf(stderr, "ERROR: loop variable %s not found\n", loopVar->leaf->text);
+        return NULL;
+    }
+
+    struct instr *vcode = NULL;
+    if (!until && proven && pass_enabled("vectorize") &&
+        (vcode = vectorize_range_loop(t)))
+        pass_note("vectorize");
+    else if (!until && pass_enabled("unroll") && (vcode = unroll_range_loop(t)))
+        pass_note("unroll");
+    if (vcode)
+        return vcode;
+
+    struct addr i_addr = entry->location;
+
+    generate_code(startExpr);
+    generate_code(endExpr);
+
+    struct instr *all_code = NULL;
+    all_code = concat(all_code, ATTR(startExpr)->code);
+    all_code = concat(all_code, ATTR(endExpr)->code);
+
+    all_code = concat(all_code, gen(O_ASN, i_addr, ATTR(startExpr)->place, NULL_ADDR));
+
+    struct addr *loop_start = genlabel();
+    struct addr *loop_end = genlabel();
+
+    struct instr *label_loop = gen(D_LABEL, *loop_start, NULL_ADDR, NULL_ADDR);
+    all_code = concat(all_code, label_loop);
+
+    all_code = concat(all_code, gen(until ? O_BGE : O_BGT, *loop_end,
+                                    i_addr, ATTR(endExpr)->place));
+
+    struct addr *prev_break_label = current_break_label;
+    current_break_label = loop_end;
+    generate_code(body);
+    all_code = concat(all_code, ATTR(body)->code);
+    current_break_label = prev_break_label;
+
+    struct addr one = { .region = R_IMMED, .u.offset = 1 };
+    struct addr inc_result = new_temp();
+    all_code = concat(all_code, gen(O_IADD, inc_result, i_addr, one));
+    all_code = concat(all_code, gen(O_ASN, i_addr, inc_result, NULL_ADDR));
+
+    all_code = concat(all_code, gen(O_BR, *loop_start, NULL_ADDR, NULL_ADDR));
+    all_code = concat(all_code, gen(D_LABEL, *loop_end, NULL_ADDR, NULL_ADDR));
+    return all_code;
+}
+
 void generate_code(struct tree *t) {
     if (!t) return;
 
-    t->returned = 0;
+    ATTR(t)->returned = 0;
 
     debug_print("Processing node: %s\n", t->symbolname?t->symbolname:"unnamed");
-    t->code  = NULL;
-    t->place = (struct addr){ R_NONE, { .offset = 0 } };
+    ATTR(t)->code  = NULL;
+    ATTR(t)->place = (struct addr){ R_NONE, { .offset = 0 } };
 
     if (t->symbolname && strcmp(t->symbolname, "postIncrement") == 0 && t->nkids == 1) {
         struct tree *varNode = t->kids[0];
         generate_code(varNode);
         struct addr oldval = new_temp();
-        struct instr *code = gen(O_ASN, oldval, varNode->place, NULL_ADDR);
+        struct instr *code = gen(O_ASN, oldval, ATTR(varNode)->place, NULL_ADDR);
         struct addr one = { .region = R_IMMED, .u.offset = 1 };
-        code = concat(code, gen(O_IADD, varNode->place, varNode->place, one));
-        t->code  = concat(varNode->code, code);
-        t->place = oldval;
+        code = concat(code, gen(O_IADD, ATTR(varNode)->place, ATTR(varNode)->place, one));
+        ATTR(t)->code  = concat(ATTR(varNode)->code, code);
+        ATTR(t)->place = oldval;
         return;
     }
     
@@ -212,19 +758,25 @@ void generate_code(struct tree *t) {
         struct tree *varNode = t->kids[0];
         generate_code(varNode);
         struct addr oldval = new_temp();
-        struct instr *code = gen(O_ASN, oldval, varNode->place, NULL_ADDR);
+        struct instr *code = gen(O_ASN, oldval, ATTR(varNode)->place, NULL_ADDR);
         struct addr one = { .region = R_IMMED, .u.offset = 1 };
-        code = concat(code, gen(O_ISUB, varNode->place, varNode->place, one));
-        t->code = concat(varNode->code, code);
-        t->place = oldval;
+        code = concat(code, gen(O_ISUB, ATTR(varNode)->place, ATTR(varNode)->place, one));
+        ATTR(t)->code = concat(ATTR(varNode)->code, code);
+        ATTR(t)->place = oldval;
+        return;
+    }
+
+    if (is_string_concat(t)) {
+        gen_string_concat(t);
         return;
     }
 
     // collapse any single-child node, propagating type too
-    if (!t->leaf && t->nkids == 1) {
+    if (!t->leaf && t->nkids == 1 &&
+        !(t->symbolname && strcmp(t->symbolname, "returnStatement") == 0)) {
         generate_code(t->kids[0]);
-        t->place = t->kids[0]->place;
-        t->code  = t->kids[0]->code;
+        ATTR(t)->place = ATTR(t->kids[0])->place;
+        ATTR(t)->code  = ATTR(t->kids[0])->code;
         t->type  = t->kids[0]->type;
         return;
     }
@@ -241,14 +793,14 @@ void generate_code(struct tree *t) {
         switch (t->leaf->category) {
             case IntegerLiteral: {
                 t->type  = integer_typeptr;
-                t->place = new_temp();
+                ATTR(t)->place = new_temp();
                 struct addr imm = { .region = R_IMMED,
                                     .u.offset = t->leaf->value.ival };
-                t->code  = gen(O_ASN, t->place, imm, NULL_ADDR);
+                ATTR(t)->code  = gen(O_ASN, ATTR(t)->place, imm, NULL_ADDR);
                 debug_print("LIT int %d -> %s:%d\n",
                             t->leaf->value.ival,
-                            regionname(t->place.region),
-                            t->place.u.offset);
+                            regionname(ATTR(t)->place.region),
+                            ATTR(t)->place.u.offset);
                 return;
             }
             case RealLiteral: {
@@ -261,80 +813,98 @@ void generate_code(struct tree *t) {
                 int id = add_real_literal(lbl, t->leaf->value.dval);
             
                 // 2) allocate an 8‐byte temp slot
-                t->place = new_temp();
+                ATTR(t)->place = new_temp();
             
                 // 3) load the constant into xmm0 then store it into the temp
                 struct instr *lit = gen(
                     O_LCONT,
-                    t->place,
+                    ATTR(t)->place,
                     (struct addr){ .region = R_IMMED, .u.offset = id },
                     NULL_ADDR
                 );
                 // mark this load as a double so downstream stores use movsd
                 lit->is_double = 1;
                 debug_print("CODEGEN RealLiteral: place=%s:%d  is_double=%d\n",
-                    regionname(t->place.region), t->place.u.offset,
+                    regionname(ATTR(t)->place.region), ATTR(t)->place.u.offset,
                     lit->is_double);
             
-                t->code = lit;
+                ATTR(t)->code = lit;
                 debug_print(
                   "LIT real %f → .D%d @ %s:%d\n",
                    t->leaf->value.dval,
                    id,
-                   regionname(t->place.region),
-                   t->place.u.offset
+                   regionname(ATTR(t)->place.region),
+                   ATTR(t)->place.u.offset
                 );
                 return;
             }
             
 
             case StringLiteral: {
-                static int stringLabelCounter = 0;
-            
                 for (int i = 0; i < strcount; i++) {
                     if (strcmp(strtab[i].text, t->leaf->text) == 0) {
-                        t->place.region = R_GLOBAL;
-                        t->place.u.offset = i;
+                        ATTR(t)->place.region = R_GLOBAL;
+                        ATTR(t)->place.u.offset = i;
+                        t->type = string_typeptr;
                         return;
                     }
                 }
             
                 char label[32];
-                snprintf(label, sizeof(label), "S%d", stringLabelCounter);
-                t->place.region = R_GLOBAL;
-                t->place.u.offset = stringLabelCounter;
+                snprintf(label, sizeof(label), "S%d", strcount);
+                ATTR(t)->place.region = R_GLOBAL;
+                ATTR(t)->place.u.offset = strcount;
                 t->type = string_typeptr;
                 add_string_literal(label, t->leaf->text);
-                stringLabelCounter++;
                 return;
             }
             
             case BooleanLiteral: {
-                t->place = new_temp();
+                ATTR(t)->place = new_temp();
                 int val = strcmp(t->leaf->text,"true")==0 ? 1 : 0;
                 struct addr imm = { .region = R_IMMED, .u.offset = val };
-                t->code = gen(O_ASN, t->place, imm, NULL_ADDR);
+                t->type = boolean_typeptr;
+                ATTR(t)->code = gen(O_ASN, ATTR(t)->place, imm, NULL_ADDR);
                 debug_print("LIT bool %s -> %s:%d\n",
                             t->leaf->text,
-                            regionname(t->place.region),
-                            t->place.u.offset);
+                            regionname(ATTR(t)->place.region),
+                            ATTR(t)->place.u.offset);
                 return;
             }
             case Identifier: {
+                SymbolTableEntry recv = NULL;
                 SymbolTableEntry e = lookup_symbol(currentFunctionSymtab, t->leaf->text);
                 if (e) {
-                    t->place = e->location;
+                    ATTR(t)->place = e->location;
                     t->type  = e->type;
                     debug_print("ID '%s' -> %s:%d\n",
                                 t->leaf->text,
-                                regionname(t->place.region),
-                                t->place.u.offset);
+                                regionname(ATTR(t)->place.region),
+                                ATTR(t)->place.u.offset);
+                } else if ((e = lookup_method(currentFunctionSymtab,
+                                              t->leaf->text, &recv)) &&
+                           strcmp(e->s, "String.length") == 0) {
+                    // s.length
+                    ATTR(t)->place = new_temp();
+                    t->type  = integer_typeptr;
+                    ATTR(t)->code  = gen(O_SLEN, ATTR(t)->place, recv->location, NULL_ADDR);
+                } else if (e && strcmp(e->s, "Array.size") == 0) {
+                    // a.size, from the array header
+                    ATTR(t)->place = new_temp();
+                    t->type  = integer_typeptr;
+                    ATTR(t)->code  = gen(O_ALEN, ATTR(t)->place, recv->location, NULL_ADDR);
+                } else if (e && strcmp(e->s, "HashMap.size") == 0) {
+                    // m.size
+                    ATTR(t)->place = new_temp();
+                    t->type  = integer_typeptr;
+                    ATTR(t)->code  = concat(parm_of(recv->location, 1, 0),
+                                      call_runtime("k0_map_size", ATTR(t)->place, 0, 0));
                 } else {
-                    t->place = new_temp();
+                    ATTR(t)->place = new_temp();
                     debug_print("ID '%s' missing -> temp %s:%d\n",
                                 t->leaf->text,
-                                regionname(t->place.region),
-                                t->place.u.offset);
+                                regionname(ATTR(t)->place.region),
+                                ATTR(t)->place.u.offset);
                 }
                 return;
             }
@@ -349,94 +919,33 @@ void generate_code(struct tree *t) {
             struct tree *varId    = t->kids[0];
             struct tree *typeNode = t->kids[1];
             struct tree *initTree = t->kids[4];
-            struct tree *sizeExpr = initTree->kids[0];
-            struct tree *initExpr = initTree->kids[1];
-        
-            generate_code(sizeExpr);
-            struct addr bytesPer   = { .region = R_IMMED, .u.offset = 4 };
-            struct addr totalBytes = new_temp();
-            struct instr *code     = gen(O_IMUL,
-                                         totalBytes,
-                                         sizeExpr->place,
-                                         bytesPer);
-            code = concat(sizeExpr->code, code);
-        
-            struct addr basePtr = new_temp();
-            struct instr *m = gen(O_MALLOC,
-                                  basePtr,
-                                  totalBytes,
-                                  NULL_ADDR);
-            m->is_ptr = 1;
-            code = concat(code, m);
-        
+
             SymbolTableEntry entry =
                 lookup_symbol(currentFunctionSymtab, varId->leaf->text);
-            struct instr *copyPtr = gen(O_ASN,
-                                        entry->location,
-                                        basePtr,
-                                        NULL_ADDR);
-            copyPtr->is_ptr = 1;
-            code = concat(code, copyPtr);
-        
-            struct addr idx = new_temp();
-            code = concat(code,
-                          gen(O_ASN,
-                              idx,
-                              (struct addr){ .region=R_IMMED, .u.offset=0 },
-                              NULL_ADDR));
-        
-            struct addr *lblTop  = genlabel();
-            struct addr *lblExit = genlabel();
-            code = concat(code,
-                          gen(D_LABEL,
-                              *lblTop,
-                              NULL_ADDR,
-                              NULL_ADDR));
-        
-            struct addr cmp = new_temp();
-            code = concat(code, gen(O_IGE, cmp, idx, sizeExpr->place));
-            code = concat(code, gen(O_BNZ, *lblExit, cmp, NULL_ADDR));
-        
-            struct addr off = new_temp();
-            code = concat(code,
-                          gen(O_IMUL, off, idx, bytesPer));
-            struct addr eltAddr = new_temp();
-            {
-              struct instr *addPtr = gen(O_IADD,
-                                         eltAddr,
-                                         entry->location,
-                                         off);
-              addPtr->is_ptr = 1;
-              code = concat(code, addPtr);
-            }
-        
-            generate_code(initExpr);
-            code = concat(code, initExpr->code);
-            code = concat(code,
-                          gen(O_ASN,
-                              (struct addr){ .region=R_MEM,
-                                             .u.offset=eltAddr.u.offset },
-                              initExpr->place,
-                              NULL_ADDR));
-        
-            code = concat(code,
-                          gen(O_IADD,
-                              idx,
-                              idx,
-                              (struct addr){ .region=R_IMMED, .u.offset=1 }));
-            code = concat(code,
-                          gen(O_BR, *lblTop, NULL_ADDR, NULL_ADDR));
-        
-            code = concat(code,
-                          gen(D_LABEL, *lblExit, NULL_ADDR, NULL_ADDR));
-        
-            t->place = entry->location;
-            t->code  = code;
+            ATTR(t)->code  = gen_array_init(entry->location,
+                                      initTree->kids[0],
+                                      initTree->kids[1],
+                                      typeNode->type);
+            ATTR(t)->place = entry->location;
             t->type  = typeNode->type;
             return;
         }
         
 
+        if (strcmp(t->symbolname, "arrayAccess")==0 &&
+            t->kids[0]->type && t->kids[0]->type->basetype == MAP_TYPE) {
+            // m[k] is m.get(k)
+            struct tree *map = t->kids[0];
+            generate_code(map);
+            generate_code(t->kids[1]);
+            t->type  = map->type->u.m.valtype;
+            ATTR(t)->place = new_temp();
+            ATTR(t)->code  = concat(concat(ATTR(map)->code, ATTR(t->kids[1])->code),
+                              map_call("get", map->type, ATTR(map)->place,
+                                       &t->kids[1], 1, ATTR(t)->place));
+            return;
+        }
+
         if (strcmp(t->symbolname, "arrayAccess")==0) {
             struct tree *arr = t->kids[0];
             struct tree *idx = t->kids[1];
@@ -445,38 +954,21 @@ void generate_code(struct tree *t) {
             struct addr ptrVal = new_temp();
             struct instr *ldPtr = gen(O_ASN,
                                      ptrVal,
-                                     arr->place,
+                                     ATTR(arr)->place,
                                      NULL_ADDR);
             ldPtr->is_ptr = 1;
-            struct instr *code = concat(arr->code, ldPtr);
+            struct instr *code = concat(ATTR(arr)->code, ldPtr);
         
             generate_code(idx);
-            code = concat(code, idx->code);
+            code = concat(code, ATTR(idx)->code);
         
             t->type = arr->type->u.a.elemtype;
-            struct addr bytesPer = { .region = R_IMMED, .u.offset = 4 };
-        
-            struct addr offset = new_temp();
-            code = concat(code,
-                          gen(O_IMUL, offset, idx->place, bytesPer));
-        
-            struct addr addrTemp = new_temp();
-            struct instr *addPtr = gen(O_IADD,
-                                       addrTemp,
-                                       ptrVal,
-                                       offset);
-            addPtr->is_ptr = 1;
-            code = concat(code, addPtr);
-        
-            t->place = new_temp();
-            struct instr *loadElem = gen(O_ASN,
-                                        t->place,
-                                        (struct addr){ .region=R_MEM,
-                                                       .u.offset=addrTemp.u.offset },
-                                        NULL_ADDR);
-            code = concat(code, loadElem);
-        
-            t->code = code;
+            ATTR(t)->place = new_temp();
+            struct instr *ld = array_load(ATTR(t)->place, ptrVal, ATTR(idx)->place, arr->type);
+            ld->unchecked = bounds_proven(t);
+            code = concat(code, ld);
+        
+            ATTR(t)->code = code;
             return;
         }
 
@@ -484,90 +976,37 @@ void generate_code(struct tree *t) {
             struct tree *varId    = t->kids[0];
             struct tree *typeNode = t->kids[1];
             struct tree *initTree = t->kids[2];
-            struct tree *sizeExpr = initTree->kids[0];
-        
-            generate_code(sizeExpr);
-            struct addr bytesPer   = { .region = R_IMMED, .u.offset = 4 };
-            struct addr totalBytes = new_temp();
-            struct instr *code     = gen(O_IMUL,
-                                         totalBytes,
-                                         sizeExpr->place,
-                                         bytesPer);
-            code = concat(sizeExpr->code, code);
-        
-            struct addr basePtr = new_temp();
-            struct instr *m = gen(O_MALLOC,
-                                  basePtr,
-                                  totalBytes,
-                                  NULL_ADDR);
-            m->is_ptr = 1;
-            code = concat(code, m);
-        
+
             SymbolTableEntry entry =
                 lookup_symbol(currentFunctionSymtab, varId->leaf->text);
-            struct instr *copyPtr = gen(O_ASN,
-                                        entry->location,
-                                        basePtr,
-                                        NULL_ADDR);
-            copyPtr->is_ptr = 1;
-            code = concat(code, copyPtr);
-        
-            struct addr idx = new_temp();
-            code = concat(code,
-                          gen(O_ASN,
-                              idx,
-                              (struct addr){ .region=R_IMMED, .u.offset=0 },
-                              NULL_ADDR));
-        
-            struct addr *lblTop  = genlabel();
-            struct addr *lblExit = genlabel();
-            code = concat(code,
-                          gen(D_LABEL,
-                              *lblTop,
-                              NULL_ADDR,
-                              NULL_ADDR));
-        
-            struct addr cmp = new_temp();
-            code = concat(code, gen(O_IGE, cmp, idx, sizeExpr->place));
-            code = concat(code, gen(O_BNZ, *lblExit, cmp, NULL_ADDR));
-        
-            struct addr off = new_temp();
-            code = concat(code,
-                          gen(O_IMUL, off, idx, bytesPer));
-            struct addr eltAddr = new_temp();
-            {
-              struct instr *addPtr = gen(O_IADD,
-                                         eltAddr,
-                                         entry->location,
-                                         off);
-              addPtr->is_ptr = 1;
-              code = concat(code, addPtr);
-            }
-        
-            code = concat(code,
-                          gen(O_ASN,
-                              (struct addr){ .region=R_MEM,
-                                             .u.offset=eltAddr.u.offset },
-                              (struct addr){ .region=R_IMMED, .u.offset=0 },
-                              NULL_ADDR));
-        
-            code = concat(code,
-                          gen(O_IADD,
-                              idx,
-                              idx,
-                              (struct addr){ .region=R_IMMED, .u.offset=1 }));
-            code = concat(code,
-                          gen(O_BR, *lblTop, NULL_ADDR, NULL_ADDR));
-        
-            code = concat(code,
-                          gen(D_LABEL, *lblExit, NULL_ADDR, NULL_ADDR));
-        
-            t->place = entry->location;
-            t->code  = code;
+            ATTR(t)->code  = gen_array_init(entry->location,
+                                      initTree->kids[0],
+                                      initTree->kids[1],
+                                      typeNode->type);
+            ATTR(t)->place = entry->location;
             t->type  = typeNode->type;
             return;
         }
         
+        if (strcmp(t->symbolname, "assignment")==0 && t->kids[0] &&
+            strcmp(t->kids[0]->symbolname, "arrayAccess")==0 &&
+            t->kids[0]->kids[0]->type &&
+            t->kids[0]->kids[0]->type->basetype == MAP_TYPE)
+        {
+            // m[k] = v is m.put(k, v)
+            struct tree *map = t->kids[0]->kids[0];
+            struct tree *kv[2] = { t->kids[0]->kids[1], t->kids[1] };
+            generate_code(map);
+            generate_code(kv[0]);
+            generate_code(kv[1]);
+            ATTR(t)->code = concat(concat(ATTR(map)->code, ATTR(kv[0])->code), ATTR(kv[1])->code);
+            ATTR(t)->code = concat(ATTR(t)->code, map_call("put", map->type, ATTR(map)->place,
+                                               kv, 2, NULL_ADDR));
+            ATTR(t)->place = ATTR(kv[1])->place;
+            t->type  = kv[1]->type;
+            return;
+        }
+
         if (strcmp(t->symbolname, "assignment")==0 && t->kids[0] && strcmp(t->kids[0]->symbolname, "arrayAccess")==0)
         {
             struct tree *access = t->kids[0];
@@ -580,41 +1019,22 @@ void generate_code(struct tree *t) {
             struct instr *ldPtr = gen(
                 O_ASN,
                 ptrVal,
-                arr->place,
+                ATTR(arr)->place,
                 NULL_ADDR);
             ldPtr->is_ptr = 1;
-            struct instr *code = concat(arr->code, ldPtr);
+            struct instr *code = concat(ATTR(arr)->code, ldPtr);
 
             generate_code(idx);
-            code = concat(code, idx->code);
+            code = concat(code, ATTR(idx)->code);
             generate_code(rhs);
 
             t->type = rhs->type;
-            struct addr bytesPer = { .region = R_IMMED, .u.offset = 4 };
-
-            struct addr offset = new_temp();
-            code = concat(code,
-                gen(O_IMUL, offset, idx->place, bytesPer));
+            struct instr *st = array_store(ptrVal, ATTR(idx)->place, ATTR(rhs)->place, arr->type);
+            st->unchecked = bounds_proven(access);
+            code = concat(code, st);
 
-            struct addr addrTemp = new_temp();
-            struct instr *addPtr = gen(
-                O_IADD,
-                addrTemp,
-                ptrVal,
-                offset);
-            addPtr->is_ptr = 1;
-            code = concat(code, addPtr);
-
-            struct instr *storeElem = gen(
-                O_ASN,
-                (struct addr){ .region=R_MEM,
-                            .u.offset=addrTemp.u.offset },
-                rhs->place,
-                NULL_ADDR);
-            code = concat(code, storeElem);
-
-            t->code  = concat(concat(arr->code, rhs->code), code);
-            t->place = rhs->place;
+            ATTR(t)->code  = concat(concat(ATTR(arr)->code, ATTR(rhs)->code), code);
+            ATTR(t)->place = ATTR(rhs)->place;
             t->type  = rhs->type;
             return;
         }
@@ -629,41 +1049,41 @@ void generate_code(struct tree *t) {
                 if (!entry) {
                     fprintf(stderr, "ERROR: Variable '%s' not found in symbol table\n", 
                             lhs->leaf->text);
-                    t->place = new_temp(); 
+                    ATTR(t)->place = new_temp(); 
                     return;
                 }
-                lhs->place = entry->location;
+                ATTR(lhs)->place = entry->location;
             } else {
                 if (lhs) generate_code(lhs);
             }
             
             if (rhs) generate_code(rhs);
             
-            if (lhs->place.region == R_NONE || rhs->place.region == R_NONE) {
+            if (ATTR(lhs)->place.region == R_NONE || ATTR(rhs)->place.region == R_NONE) {
                 fprintf(stderr, "ERROR: Invalid places in assignment\n");
-                t->place = lhs->place; 
+                ATTR(t)->place = ATTR(lhs)->place; 
                 return;
             }
             
-            t->place = lhs->place;
+            ATTR(t)->place = ATTR(lhs)->place;
             t->type  = rhs->type;
             struct instr *asn = gen(O_ASN,
-                            lhs->place,
-                            rhs->place,
+                            ATTR(lhs)->place,
+                            ATTR(rhs)->place,
                             NULL_ADDR);
             SymbolTableEntry entry = lookup_symbol(currentFunctionSymtab, lhs->leaf->text);
             asn->is_double = (entry && entry->type == double_typeptr) ? 1 : 0;
-            asn->is_ptr = (entry && entry->type == string_typeptr) ? 1 : 0;
+            asn->is_ptr = (entry && is_pointer_type(entry->type)) ? 1 : 0;
             debug_print("CODEGEN ASN to '%s': dest=%s:%d  src=%s:%d  is_double=%d\n",
                 lhs->leaf->text,
                 regionname(asn->dest.region), asn->dest.u.offset,
                 regionname(asn->src1.region), asn->src1.u.offset,
                 asn->is_double);
-            t->code = concat(rhs->code, asn);
+            ATTR(t)->code = concat(ATTR(rhs)->code, asn);
 
             debug_print("DEBUG: Generated assignment: %s:%d = %s:%d (is_double=%d)\n",
-                regionname(lhs->place.region), lhs->place.u.offset,
-                regionname(rhs->place.region), rhs->place.u.offset,
+                regionname(ATTR(lhs)->place.region), ATTR(lhs)->place.u.offset,
+                regionname(ATTR(rhs)->place.region), ATTR(rhs)->place.u.offset,
                 (int)asn->is_double);
             return;
         }
@@ -679,13 +1099,13 @@ void generate_code(struct tree *t) {
                        ? (t->prodrule==ADD ? O_DADD : O_DSUB)
                        : (t->prodrule==ADD ? O_IADD : O_ISUB);
         
-            t->place = new_temp();
-            t->code  = concat(
-                          concat(t->kids[0]->code, t->kids[1]->code),
+            ATTR(t)->place = new_temp();
+            ATTR(t)->code  = concat(
+                          concat(ATTR(t->kids[0])->code, ATTR(t->kids[1])->code),
                           gen(opcode,
-                              t->place,
-                              t->kids[0]->place,
-                              t->kids[1]->place)
+                              ATTR(t)->place,
+                              ATTR(t->kids[0])->place,
+                              ATTR(t->kids[1])->place)
                        );
             return;
         }
@@ -709,14 +1129,14 @@ void generate_code(struct tree *t) {
                 else                          opcode = O_IMOD;
             }
 
-            t->place = new_temp();
+            ATTR(t)->place = new_temp();
 
-            t->code = concat(
-                concat(t->kids[0]->code, t->kids[1]->code),
+            ATTR(t)->code = concat(
+                concat(ATTR(t->kids[0])->code, ATTR(t->kids[1])->code),
                 gen(opcode,
-                    t->place,
-                    t->kids[0]->place,
-                    t->kids[1]->place)
+                    ATTR(t)->place,
+                    ATTR(t->kids[0])->place,
+                    ATTR(t->kids[1])->place)
             );
             return;
         }
@@ -726,44 +1146,27 @@ void generate_code(struct tree *t) {
         else if (strcmp(t->symbolname, "comparison")==0 && t->nkids==2) {
             generate_code(t->kids[0]);
             generate_code(t->kids[1]);
-        
-            int opcode;
-            if      (t->prodrule == RANGLE) opcode = O_IGT;
-            else if (t->prodrule == LANGLE) opcode = O_ILT;
-            else if (t->prodrule == GE) opcode = O_IGE;
-            else if (t->prodrule == LE) opcode = O_ILE;
-            else if (t->prodrule == EQEQ) opcode = O_IEQ;
-            else if (t->prodrule == EXCL_EQ) opcode = O_INE;
-            else                                    opcode = O_IGT; 
-        
-            t->place = new_temp();
-            t->code  = concat(
-                          concat(t->kids[0]->code, t->kids[1]->code),
-                          gen(opcode,
-                              t->place,
-                              t->kids[0]->place,
-                              t->kids[1]->place)
-                       );
-            t->type  = boolean_typeptr;
+            comparison_value(t);
             return;
         }
 
         else if (strcmp(t->symbolname, "negation")==0 && t->nkids>=1) {
             generate_code(t->kids[0]);
-            t->place = new_temp();
-            t->code  = gen(O_NEG,
-                           t->place,
-                           t->kids[0]->place,
-                           NULL_ADDR);
+            ATTR(t)->place = new_temp();
+            ATTR(t)->code  = concat(ATTR(t->kids[0])->code,
+                              gen(O_NOT,
+                                  ATTR(t)->place,
+                                  ATTR(t->kids[0])->place,
+                                  NULL_ADDR));
             return;
         }
 
         else if (strcmp(t->symbolname, "logical_not")==0 && t->nkids>=1) {
             generate_code(t->kids[0]);
-            t->place = new_temp();
-            t->code  = gen(O_NOT,
-                           t->place,
-                           t->kids[0]->place,
+            ATTR(t)->place = new_temp();
+            ATTR(t)->code  = gen(O_NOT,
+                           ATTR(t)->place,
+                           ATTR(t->kids[0])->place,
                            NULL_ADDR);
             return;
         }
@@ -772,39 +1175,39 @@ void generate_code(struct tree *t) {
             struct tree *condition = t->kids[0];
             struct tree *body = t->kids[1];
             
-            if (!t->first_used) {
+            if (!ATTR(t)->first_used) {
                 struct addr *start_label = genlabel();
-                t->first = *start_label;
-                t->first_used = 1;
+                ATTR(t)->first = *start_label;
+                ATTR(t)->first_used = 1;
                 free(start_label);
             }
             
-            if (!condition->follow_used) {
+            if (!ATTR(condition)->follow_used) {
                 struct addr *cond_false_label = genlabel();
-                condition->follow = *cond_false_label;
-                condition->follow_used = 1;
+                ATTR(condition)->follow = *cond_false_label;
+                ATTR(condition)->follow_used = 1;
                 free(cond_false_label);
             }
             
             generate_code(condition);
             
-            struct instr *loop_code = gen(D_LABEL, t->first, NULL_ADDR, NULL_ADDR);
+            struct instr *loop_code = gen(D_LABEL, ATTR(t)->first, NULL_ADDR, NULL_ADDR);
             
-            loop_code = concat(loop_code, condition->code);
+            loop_code = concat(loop_code, ATTR(condition)->code);
             
-            struct instr *branch_exit = gen(O_BZ, condition->follow, condition->place, NULL_ADDR);
+            struct instr *branch_exit = gen(O_BZ, ATTR(condition)->follow, ATTR(condition)->place, NULL_ADDR);
             loop_code = concat(loop_code, branch_exit);
             
             generate_code(body);
-            loop_code = concat(loop_code, body->code);
+            loop_code = concat(loop_code, ATTR(body)->code);
             
-            struct instr *jump_back = gen(O_BR, t->first, NULL_ADDR, NULL_ADDR);
+            struct instr *jump_back = gen(O_BR, ATTR(t)->first, NULL_ADDR, NULL_ADDR);
             loop_code = concat(loop_code, jump_back);
             
-            struct instr *exit_label = gen(D_LABEL, condition->follow, NULL_ADDR, NULL_ADDR);
+            struct instr *exit_label = gen(D_LABEL, ATTR(condition)->follow, NULL_ADDR, NULL_ADDR);
             loop_code = concat(loop_code, exit_label);
             
-            t->code = loop_code;
+            ATTR(t)->code = loop_code;
             return;
         }
         
@@ -815,17 +1218,14 @@ void generate_code(struct tree *t) {
             struct addr *end_label = genlabel();
             struct instr *code = NULL;
         
-            generate_code(cond);
-            code = concat(code, cond->code);
-        
-            code = concat(code, gen(O_BZ, *end_label, cond->place, NULL_ADDR));
+            code = concat(code, cond_jump(cond, *end_label, 0));
         
             generate_code(then_stmt);
-            code = concat(code, then_stmt->code);
+            code = concat(code, ATTR(then_stmt)->code);
         
             code = concat(code, gen(D_LABEL, *end_label, NULL_ADDR, NULL_ADDR));
         
-            t->code = code;
+            ATTR(t)->code = code;
             return;
         }
         else if (strcmp(t->symbolname, "ifElseStatement") == 0 && t->nkids == 3) {
@@ -839,41 +1239,40 @@ void generate_code(struct tree *t) {
         
             struct instr *code = NULL;
         
-            generate_code(cond);
-            code = concat(code, cond->code);
-            code = concat(code, gen(O_BZ, *else_label, cond->place, NULL_ADDR));
+            code = concat(code, cond_jump(cond, *else_label, 0));
         
             generate_code(then_branch);
-            code = concat(code, then_branch->code);
+            code = concat(code, ATTR(then_branch)->code);
             code = concat(code, gen(O_BR, *end_label, NULL_ADDR, NULL_ADDR));
         
             code = concat(code, gen(D_LABEL, *else_label, NULL_ADDR, NULL_ADDR));
             generate_code(else_branch);
-            code = concat(code, else_branch->code);
+            code = concat(code, ATTR(else_branch)->code);
         
             code = concat(code, gen(D_LABEL, *end_label, NULL_ADDR, NULL_ADDR));
         
-            t->code = code;
+            ATTR(t)->code = code;
             return;
         }
         
-        else if (strcmp(t->symbolname, "logical_and") == 0 && t->nkids == 2) {
-            t->place = new_temp();
+        else if ((strcmp(t->symbolname, "logical_and") == 0 ||
+                  strcmp(t->symbolname, "conjunction") == 0) && t->nkids == 2) {
+            ATTR(t)->place = new_temp();
             
             struct addr *false_label = genlabel();
             struct addr *end_label = genlabel();
             
             generate_code(t->kids[0]);
             
-            struct instr *and_code = t->kids[0]->code;
+            struct instr *and_code = ATTR(t->kids[0])->code;
             
-            struct instr *branch_false = gen(O_BZ, *false_label, t->kids[0]->place, NULL_ADDR);
+            struct instr *branch_false = gen(O_BZ, *false_label, ATTR(t->kids[0])->place, NULL_ADDR);
             and_code = concat(and_code, branch_false);
             
             generate_code(t->kids[1]);
-            and_code = concat(and_code, t->kids[1]->code);
+            and_code = concat(and_code, ATTR(t->kids[1])->code);
             
-            struct instr *copy_result = gen(O_ASN, t->place, t->kids[1]->place, NULL_ADDR);
+            struct instr *copy_result = gen(O_ASN, ATTR(t)->place, ATTR(t->kids[1])->place, NULL_ADDR);
             and_code = concat(and_code, copy_result);
             
             struct instr *jump_end = gen(O_BR, *end_label, NULL_ADDR, NULL_ADDR);
@@ -883,39 +1282,40 @@ void generate_code(struct tree *t) {
             and_code = concat(and_code, false_instr);
             
             struct addr zero = { .region = R_IMMED, .u.offset = 0 };
-            struct instr *set_false = gen(O_ASN, t->place, zero, NULL_ADDR);
+            struct instr *set_false = gen(O_ASN, ATTR(t)->place, zero, NULL_ADDR);
             and_code = concat(and_code, set_false);
             
             struct instr *end_instr = gen(D_LABEL, *end_label, NULL_ADDR, NULL_ADDR);
             and_code = concat(and_code, end_instr);
             
-            t->code = and_code;
+            ATTR(t)->code = and_code;
             free(false_label);
             free(end_label);
             return;
         }
         
-        else if (strcmp(t->symbolname, "logical_or") == 0 && t->nkids == 2) {
-            t->place = new_temp();
+        else if ((strcmp(t->symbolname, "logical_or") == 0 ||
+                  strcmp(t->symbolname, "disjunction") == 0) && t->nkids == 2) {
+            ATTR(t)->place = new_temp();
             
             struct addr *true_label = genlabel();
             struct addr *end_label = genlabel();
             
             generate_code(t->kids[0]);
             
-            struct instr *or_code = t->kids[0]->code;
+            struct instr *or_code = ATTR(t->kids[0])->code;
             
             struct addr one = { .region = R_IMMED, .u.offset = 1 };
-            struct instr *comp_true = gen(O_INE, t->place, t->kids[0]->place, one);
+            struct instr *comp_true = gen(O_INE, ATTR(t)->place, ATTR(t->kids[0])->place, one);
             or_code = concat(or_code, comp_true);
             
-            struct instr *branch_true = gen(O_BNZ, *true_label, t->place, NULL_ADDR);
+            struct instr *branch_true = gen(O_BNZ, *true_label, ATTR(t)->place, NULL_ADDR);
             or_code = concat(or_code, branch_true);
             
             generate_code(t->kids[1]);
-            or_code = concat(or_code, t->kids[1]->code);
+            or_code = concat(or_code, ATTR(t->kids[1])->code);
             
-            struct instr *copy_result = gen(O_ASN, t->place, t->kids[1]->place, NULL_ADDR);
+            struct instr *copy_result = gen(O_ASN, ATTR(t)->place, ATTR(t->kids[1])->place, NULL_ADDR);
             or_code = concat(or_code, copy_result);
             
             struct instr *jump_end = gen(O_BR, *end_label, NULL_ADDR, NULL_ADDR);
@@ -924,13 +1324,13 @@ void generate_code(struct tree *t) {
             struct instr *true_instr = gen(D_LABEL, *true_label, NULL_ADDR, NULL_ADDR);
             or_code = concat(or_code, true_instr);
             
-            struct instr *set_true = gen(O_ASN, t->place, one, NULL_ADDR);
+            struct instr *set_true = gen(O_ASN, ATTR(t)->place, one, NULL_ADDR);
             or_code = concat(or_code, set_true);
             
             struct instr *end_instr = gen(D_LABEL, *end_label, NULL_ADDR, NULL_ADDR);
             or_code = concat(or_code, end_instr);
             
-            t->code = or_code;
+            ATTR(t)->code = or_code;
             free(true_label);
             free(end_label);
             return;
@@ -943,7 +1343,7 @@ void generate_code(struct tree *t) {
             generate_code(rhs);
         
             struct instr *code = NULL;
-            code = concat(lhs->code, rhs->code);
+            code = concat(ATTR(lhs)->code, ATTR(rhs)->code);
         
             struct addr tmp = new_temp();
         
@@ -951,51 +1351,27 @@ void generate_code(struct tree *t) {
         
             if (op) {
                 if (strcmp(op, "<") == 0)
-                    code = concat(code, gen(O_ILT, tmp, lhs->place, rhs->place));
+                    code = concat(code, gen(O_ILT, tmp, ATTR(lhs)->place, ATTR(rhs)->place));
                 else if (strcmp(op, "<=") == 0)
-                    code = concat(code, gen(O_ILE, tmp, lhs->place, rhs->place));
+                    code = concat(code, gen(O_ILE, tmp, ATTR(lhs)->place, ATTR(rhs)->place));
                 else if (strcmp(op, ">") == 0)
-                    code = concat(code, gen(O_IGT, tmp, lhs->place, rhs->place));
+                    code = concat(code, gen(O_IGT, tmp, ATTR(lhs)->place, ATTR(rhs)->place));
                 else if (strcmp(op, ">=") == 0)
-                    code = concat(code, gen(O_IGE, tmp, lhs->place, rhs->place));
+                    code = concat(code, gen(O_IGE, tmp, ATTR(lhs)->place, ATTR(rhs)->place));
                 else {
                     fprintf(stderr, "ERROR: unknown comparison op %s\n", op);
                     return;
                 }
             }
         
-            t->code = code;
-            t->place = tmp;
+            ATTR(t)->code = code;
+            ATTR(t)->place = tmp;
             return;
         }
         else if (strcmp(t->symbolname, "equality") == 0 && t->nkids == 2) {
-            struct tree *lhs = t->kids[0];
-            struct tree *rhs = t->kids[1];
-        
-            generate_code(lhs);
-            generate_code(rhs);
-        
-            struct instr *code = NULL;
-            code = concat(lhs->code, rhs->code);
-        
-            struct addr tmp = new_temp();
-        
-            const char *op = t->leaf ? t->leaf->text : NULL;
-                    
-            if (op) {
-                if (strcmp(op, "==") == 0 || strcmp(op, "===") == 0)
-                    code = concat(code, gen(O_IEQ, tmp, lhs->place, rhs->place));
-                else if (strcmp(op, "!=") == 0)
-                    code = concat(code, gen(O_INE, tmp, lhs->place, rhs->place));
-                else {
-                    fprintf(stderr, "ERROR: unknown equality op: %s\n", op);
-                    return;
-                }
-            }
-        
-            t->code = code;
-            t->place = tmp;
-            t->type  = boolean_typeptr;
+            generate_code(t->kids[0]);
+            generate_code(t->kids[1]);
+            equality_value(t);
             return;
         }       
 
@@ -1011,71 +1387,219 @@ void generate_code(struct tree *t) {
         
             if (strcmp(methodName, "java.lang.Math.abs") == 0 && argc == 1) {
                 generate_code(args[0]);
-                t->place = new_temp();
-                t->code = concat(args[0]->code, gen(O_ABS, t->place, args[0]->place, NULL_ADDR));
+                ATTR(t)->place = new_temp();
+                ATTR(t)->code = concat(ATTR(args[0])->code, gen(O_ABS, ATTR(t)->place, ATTR(args[0])->place, NULL_ADDR));
                 t->type = double_typeptr;
                 free(args);
                 return;
             } else if (strcmp(methodName, "java.lang.Math.max") == 0 && argc == 2) {
                 generate_code(args[0]); generate_code(args[1]);
-                t->place = new_temp();
-                t->code = concat(concat(args[0]->code, args[1]->code),
-                                 gen(O_MAX, t->place, args[0]->place, args[1]->place));
+                ATTR(t)->place = new_temp();
+                ATTR(t)->code = concat(concat(ATTR(args[0])->code, ATTR(args[1])->code),
+                                 gen(O_MAX, ATTR(t)->place, ATTR(args[0])->place, ATTR(args[1])->place));
                 t->type = double_typeptr;
                 free(args);
                 return;
             } else if (strcmp(methodName, "java.lang.Math.min") == 0 && argc == 2) {
                 generate_code(args[0]); generate_code(args[1]);
-                t->place = new_temp();
-                t->code = concat(concat(args[0]->code, args[1]->code),
-                                 gen(O_MIN, t->place, args[0]->place, args[1]->place));
+                ATTR(t)->place = new_temp();
+                ATTR(t)->code = concat(concat(ATTR(args[0])->code, ATTR(args[1])->code),
+                                 gen(O_MIN, ATTR(t)->place, ATTR(args[0])->place, ATTR(args[1])->place));
                 t->type = double_typeptr;
                 free(args);
                 return;
             } else if (strcmp(methodName, "java.lang.Math.pow") == 0 && argc == 2) {
                 generate_code(args[0]); generate_code(args[1]);
-                t->place = new_temp();
-                t->code = concat(concat(args[0]->code, args[1]->code),
-                                 gen(O_POW, t->place, args[0]->place, args[1]->place));
+                ATTR(t)->place = new_temp();
+                ATTR(t)->code = concat(concat(ATTR(args[0])->code, ATTR(args[1])->code),
+                                 gen(O_POW, ATTR(t)->place, ATTR(args[0])->place, ATTR(args[1])->place));
                 t->type = double_typeptr;
                 free(args);
                 return;
             } else if (strcmp(methodName, "java.lang.Math.cos") == 0 && argc == 1) {
                 generate_code(args[0]);
-                t->place = new_temp();
-                t->code = concat(args[0]->code, gen(O_COS, t->place, args[0]->place, NULL_ADDR));
+                ATTR(t)->place = new_temp();
+                ATTR(t)->code = concat(ATTR(args[0])->code, gen(O_COS, ATTR(t)->place, ATTR(args[0])->place, NULL_ADDR));
                 t->type = double_typeptr;
                 free(args);
                 return;
             } else if (strcmp(methodName, "java.lang.Math.sin") == 0 && argc == 1) {
                 generate_code(args[0]);
-                t->place = new_temp();
-                t->code = concat(args[0]->code, gen(O_SIN, t->place, args[0]->place, NULL_ADDR));
+                ATTR(t)->place = new_temp();
+                ATTR(t)->code = concat(ATTR(args[0])->code, gen(O_SIN, ATTR(t)->place, ATTR(args[0])->place, NULL_ADDR));
                 t->type = double_typeptr;
                 free(args);
                 return;
             } else if (strcmp(methodName, "java.lang.Math.tan") == 0 && argc == 1) {
                 generate_code(args[0]);
-                t->place = new_temp();
-                t->code = concat(args[0]->code, gen(O_TAN, t->place, args[0]->place, NULL_ADDR));
+                ATTR(t)->place = new_temp();
+                ATTR(t)->code = concat(ATTR(args[0])->code, gen(O_TAN, ATTR(t)->place, ATTR(args[0])->place, NULL_ADDR));
                 t->type = double_typeptr;
                 free(args);
                 return;
-            } else if (strcmp(fnNode->leaf->text, "java.util.Random.nextInt") == 0) {
-                static int seeded = 0;
+            } else if (strcmp(methodName, "java.util.Random.nextInt") == 0 && argc <= 1) {
+                // the runtime seeds the generator before main; src1 is the bound
                 struct instr *code = NULL;
-            
-                if (!seeded) {
-                    struct instr *srand_tac = gen(O_SRAND, empty_addr(), empty_addr(), empty_addr());
-                    code = append(code, srand_tac);
-                    seeded = 1;
+                struct addr bound = NULL_ADDR;
+                if (argc == 1) {
+                    generate_code(args[0]);
+                    code = ATTR(args[0])->code;
+                    bound = ATTR(args[0])->place;
                 }
-            
-                t->place = new_temp();
-                struct instr *rand_tac = gen(O_RAND, t->place, empty_addr(), empty_addr());
-                code = append(code, rand_tac);
-            
-                t->code = append(t->code, code);
+                ATTR(t)->place = new_temp();
+                ATTR(t)->code = concat(code, gen(O_RAND, ATTR(t)->place, bound, NULL_ADDR));
+                t->type = integer_typeptr;
+                free(args);
+                return;
+            } else if (strcmp(methodName, "java.util.Random.nextDouble") == 0 && argc == 0) {
+                ATTR(t)->place = new_temp();
+                ATTR(t)->code = gen(O_RAND, ATTR(t)->place, NULL_ADDR, NULL_ADDR);
+                ATTR(t)->code->is_double = 1;
+                t->type = double_typeptr;
+                free(args);
+                return;
+            } else if ((strcmp(methodName, "HashMap") == 0 ||
+                        strcmp(methodName, "hashMapOf") == 0 ||
+                        strcmp(methodName, "mutableMapOf") == 0) && argc == 0) {
+                // HashMap<K, V>() takes K and V from the declaration
+                ATTR(t)->place = new_temp();
+                ATTR(t)->code = call_runtime("k0_map_new", ATTR(t)->place, 1, 0);
+                free(args);
+                return;
+            } else if (strcmp(methodName, "readln") == 0 && argc == 0) {
+                // the line lives in the runtime's input buffer
+                ATTR(t)->place = new_temp();
+                ATTR(t)->code = call_runtime("k0_readln", ATTR(t)->place, 1, 0);
+                t->type = string_typeptr;
+                free(args);
+                return;
+            }
+
+            SymbolTableEntry receiver = NULL;
+            SymbolTableEntry method =
+                lookup_method(currentFunctionSymtab, (char *)methodName, &receiver);
+            if (method && receiver->type->basetype == MAP_TYPE) {
+                // m.get(k), m.put(k, v), ... on a HashMap variable
+                const char *name = method->s + strlen("HashMap.");
+                for (int i = 0; i < argc; i++) {
+                    generate_code(args[i]);
+                    code = concat(code, ATTR(args[i])->code);
+                }
+                t->type = method->type->u.f.returntype;
+                ATTR(t)->place = t->type == null_typeptr ? NULL_ADDR : new_temp();
+                ATTR(t)->code = concat(code, map_call(name, receiver->type, receiver->location,
+                                                args, argc, ATTR(t)->place));
+                free(args);
+                return;
+            }
+            if (method && receiver->type->basetype == ARRAY_TYPE) {
+                // a.sort(), a.sum(), ...: one runtime kernel per method
+                const char *name = method->s + strlen("Array.");
+                int dbl = receiver->type->u.a.elemtype == double_typeptr;
+                char fn[64];
+                snprintf(fn, sizeof(fn), "k0_array_%s_%s", name, dbl ? "double" : "int");
+                for (int i = 0; i < argc; i++) {
+                    generate_code(args[i]);
+                    code = concat(code, ATTR(args[i])->code);
+                }
+                code = concat(code, parm_of(receiver->location, 1, 0));
+                if (strcmp(name, "copyOf") == 0 && argc == 0) {
+                    // copyOf() copies the whole array
+                    struct addr len = new_temp();
+                    code = concat(gen(O_ALEN, len, receiver->location, NULL_ADDR), code);
+                    code = concat(code, parm_of(len, 0, 0));
+                }
+                for (int i = 0; i < argc; i++)
+                    code = concat(code, parm_of(ATTR(args[i])->place, 0,
+                                                args[i]->type == double_typeptr));
+                if (strcmp(name, "copyOf") == 0)
+                    t->type = receiver->type;
+                else if (strcmp(name, "sum") == 0 || strcmp(name, "min") == 0 ||
+                         strcmp(name, "max") == 0)
+                    t->type = receiver->type->u.a.elemtype;
+                else
+                    t->type = method->type->u.f.returntype;
+                ATTR(t)->place = t->type == null_typeptr ? NULL_ADDR : new_temp();
+                ATTR(t)->code = concat(code, call_runtime(fn, ATTR(t)->place,
+                                                    is_pointer_type(t->type),
+                                                    t->type == double_typeptr));
+                free(args);
+                return;
+            }
+            if (method) {
+                // a String method: s.name(args) with s a String variable
+                const char *name = method->s + strlen("String.");
+                struct addr self = receiver->location;
+                struct instr *code = NULL;
+                for (int i = 0; i < argc; i++) {
+                    generate_code(args[i]);
+                    code = concat(code, ATTR(args[i])->code);
+                }
+                ATTR(t)->place = new_temp();
+                t->type = integer_typeptr;
+                if (strcmp(name, "length") == 0 && argc == 0) {
+                    code = concat(code, gen(O_SLEN, ATTR(t)->place, self, NULL_ADDR));
+                } else if (strcmp(name, "get") == 0 && argc == 1) {
+                    code = concat(code, gen(O_SGET, ATTR(t)->place, self, ATTR(args[0])->place));
+                } else if (strcmp(name, "substring") == 0 && argc >= 1) {
+                    struct addr end;
+                    if (argc == 2) {
+                        end = ATTR(args[1])->place;
+                    } else {
+                        end = new_temp();
+                        code = concat(code, gen(O_SLEN, end, self, NULL_ADDR));
+                    }
+                    code = concat(code, parm_of(self, 1, 0));
+                    code = concat(code, parm_of(ATTR(args[0])->place, 0, 0));
+                    code = concat(code, parm_of(end, 0, 0));
+                    code = concat(code, call_runtime("k0_str_substring", ATTR(t)->place, 1, 0));
+                    t->type = string_typeptr;
+                } else if (strcmp(name, "equals") == 0 && argc == 1) {
+                    code = concat(code, string_compare("k0_str_equals", ATTR(t)->place,
+                                                       self, ATTR(args[0])->place));
+                    t->type = boolean_typeptr;
+                } else if (strcmp(name, "compareTo") == 0 && argc == 1) {
+                    code = concat(code, string_compare("k0_str_compare", ATTR(t)->place,
+                                                       self, ATTR(args[0])->place));
+                } else if (strcmp(name, "toInt") == 0 && argc == 0) {
+                    code = concat(code, parm_of(self, 1, 0));
+                    code = concat(code, call_runtime("k0_str_toInt", ATTR(t)->place, 0, 0));
+                } else if (strcmp(name, "toDouble") == 0 && argc == 0) {
+                    code = concat(code, parm_of(self, 1, 0));
+                    code = concat(code, call_runtime("k0_str_toDouble", ATTR(t)->place, 0, 1));
+                    t->type = double_typeptr;
+                } else if (strcmp(name, "toString") == 0 && argc == 0) {
+                    ATTR(t)->place = self;
+                    t->type = string_typeptr;
+                } else {
+                    fprintf(stderr, "ERROR: no code generation for call to \"%s\"\n",
+                            methodName);
+                    exit(1);
+                }
+                ATTR(t)->code = code;
+                free(args);
+                return;
+            }
+
+            if ((strcmp(methodName, "String.valueOf") == 0 ||
+                 strcmp(methodName, "String.toString") == 0) && argc == 1) {
+                // the text of an Int, Double, Boolean or String
+                generate_code(args[0]);
+                t->type = string_typeptr;
+                if (args[0]->type == string_typeptr) {
+                    ATTR(t)->place = ATTR(args[0])->place;
+                    ATTR(t)->code = ATTR(args[0])->code;
+                } else {
+                    const char *fn = args[0]->type == double_typeptr ? "k0_str_from_double"
+                                   : args[0]->type == boolean_typeptr ? "k0_str_from_bool"
+                                   : "k0_str_from_int";
+                    ATTR(t)->place = new_temp();
+                    ATTR(t)->code = concat(ATTR(args[0])->code,
+                                     parm_of(ATTR(args[0])->place, 0,
+                                             args[0]->type == double_typeptr));
+                    ATTR(t)->code = concat(ATTR(t)->code, call_runtime(fn, ATTR(t)->place, 1, 0));
+                }
+                free(args);
                 return;
             }
             
@@ -1083,13 +1607,22 @@ void generate_code(struct tree *t) {
                 lookup_symbol(globalSymtab, (char *)methodName);
             if (!fentry)
                 fentry = lookup_symbol(currentFunctionSymtab, (char *)methodName);
+            if (!fentry) {
+                fprintf(stderr, "ERROR: no code generation for call to \"%s\"\n",
+                        methodName);
+                exit(1);
+            }
         
+            // evaluate every argument before loading any: a nested call
+            // in a later argument would clobber the argument registers
             for (int i = 0; i < argc; i++) {
                 generate_code(args[i]);
-                code = concat(code, args[i]->code);
-                struct instr *p = gen(O_PARM, NULL_ADDR, args[i]->place, NULL_ADDR);
+                code = concat(code, ATTR(args[i])->code);
+            }
+            for (int i = 0; i < argc; i++) {
+                struct instr *p = gen(O_PARM, NULL_ADDR, ATTR(args[i])->place, NULL_ADDR);
                 p->is_double = (args[i]->type == double_typeptr);
-                p->is_ptr    = (args[i]->type == string_typeptr);
+                p->is_ptr    = is_pointer_type(args[i]->type);
                 code = concat(code, p);
             }
             free(args);
@@ -1104,16 +1637,17 @@ void generate_code(struct tree *t) {
                                fentry->type->u.f.returntype != null_typeptr;
         
             if (returnsValue) {
-                t->place = new_temp();
-                struct instr *callInstr = gen(O_CALL, t->place, nameAddr, NULL_ADDR);
+                ATTR(t)->place = new_temp();
+                struct instr *callInstr = gen(O_CALL, ATTR(t)->place, nameAddr, NULL_ADDR);
                 callInstr->is_double = (fentry->type->u.f.returntype == double_typeptr);
+                callInstr->is_ptr    = is_pointer_type(fentry->type->u.f.returntype);
                 code = concat(code, callInstr);
             } else {
-                t->place = (struct addr){ R_NONE, { .offset = 0 } };
+                ATTR(t)->place = (struct addr){ R_NONE, { .offset = 0 } };
                 code = concat(code, gen(O_CALL, NULL_ADDR, nameAddr, NULL_ADDR));
             }
         
-            t->code = code;
+            ATTR(t)->code = code;
             return;
         }   
 
@@ -1126,8 +1660,8 @@ void generate_code(struct tree *t) {
             if (fentry) fentry->location = label_addr;
         
             struct addr name_addr = { .region = R_NAME, .u.name = strdup(funcName) };
-            t->code = gen(D_GLOB,  name_addr, NULL_ADDR, NULL_ADDR);
-            t->code = concat(t->code,
+            ATTR(t)->code = gen(D_GLOB,  name_addr, NULL_ADDR, NULL_ADDR);
+            ATTR(t)->code = concat(ATTR(t)->code,
                              gen(D_PROC, label_addr, name_addr, NULL_ADDR));
         
             if (t->scope) currentFunctionSymtab = t->scope;
@@ -1139,21 +1673,27 @@ void generate_code(struct tree *t) {
                                .u.offset = currentFunctionSymtab->nextOffset },
                 NULL_ADDR
             );
-            t->code = concat(t->code, allocInstr);
+            ATTR(t)->code = concat(ATTR(t)->code, allocInstr);
         
             {
                 struct tree **params = NULL;
-                int paramCount = 0;
+                int paramCount = 0, nint = 0, ndouble = 0, nstack = 0;
                 flattenParameterList(t->kids[1], &params, &paramCount);
                 for (int i = 0; i < paramCount; i++) {
                     char *pname = params[i]->kids[0]->leaf->text;
                     SymbolTableEntry pe = lookup_symbol(currentFunctionSymtab, pname);
                     if (!pe) continue;
-                    struct addr preg = { .region = R_PARAM, .u.offset = i };
+                    // R_PARAM n is the n-th register of its class, as in the C ABI,
+                    // until those run out; later ones come on the stack
+                    int is_double = (pe->type == double_typeptr);
+                    int n = is_double ? (ndouble < PARAM_DOUBLE_REGS ? ndouble++ : -1)
+                                      : (nint < PARAM_INT_REGS ? nint++ : -1);
+                    struct addr preg = { .region = R_PARAM,
+                                         .u.offset = n >= 0 ? n : PARAM_STACK + nstack++ };
                     struct instr *parmCopy = gen(O_ASN, pe->location, preg, NULL_ADDR);
-                    parmCopy->is_double = (pe->type == double_typeptr);
-                    parmCopy->is_ptr    = (pe->type == string_typeptr);
-                    t->code = concat(t->code, parmCopy);
+                    parmCopy->is_double = is_double;
+                    parmCopy->is_ptr    = is_pointer_type(pe->type);
+                    ATTR(t)->code = concat(ATTR(t)->code, parmCopy);
                 }
                 free(params);
             }
@@ -1165,13 +1705,16 @@ void generate_code(struct tree *t) {
                     break;
                 }
             }
+            // the body is copied once here, and the epilogue appended to
+            // the copy in place: concat would copy the whole function again
+            // for each instruction added at the end
             if (body) {
                 generate_code(body);
-                t->code = concat(t->code, body->code);
+                ATTR(t)->code = append(ATTR(t)->code, copylist(ATTR(body)->code));
             }
         
             int maxOffset = currentFunctionSymtab->nextOffset;
-            for (struct instr *ip = t->code; ip; ip = ip->next) {
+            for (struct instr *ip = ATTR(t)->code; ip; ip = ip->next) {
                 if (ip->dest.region == R_LOCAL && ip->dest.u.offset > maxOffset)
                     maxOffset = ip->dest.u.offset;
                 if (ip->src1.region == R_LOCAL && ip->src1.u.offset > maxOffset)
@@ -1181,7 +1724,7 @@ void generate_code(struct tree *t) {
             }
             int frameSize = ((maxOffset + 15) / 16) * 16;
         
-            for (struct instr *ip = t->code; ip; ip = ip->next) {
+            for (struct instr *ip = ATTR(t)->code; ip; ip = ip->next) {
                 if (ip->opcode == O_ALLOC) {
                     ip->src1.u.offset = frameSize;
                     break;
@@ -1189,23 +1732,21 @@ void generate_code(struct tree *t) {
             }
         
             {
-                struct instr *last = t->code;
+                struct instr *last = ATTR(t)->code;
                 while (last && last->next) last = last->next;
                 if (!last || last->opcode != O_RET) {
-                    t->code = concat(t->code,
-                                     gen(O_DEALLOC,
-                                         NULL_ADDR,
-                                         (struct addr){ .region = R_IMMED,
-                                                        .u.offset = frameSize },
-                                         NULL_ADDR));
-                    t->code = concat(t->code,
-                                     gen(O_RET, NULL_ADDR, NULL_ADDR, NULL_ADDR));
+                    last = append(last,
+                                  gen(O_DEALLOC,
+                                      NULL_ADDR,
+                                      (struct addr){ .region = R_IMMED,
+                                                     .u.offset = frameSize },
+                                      NULL_ADDR))->next;
+                    last = append(last,
+                                  gen(O_RET, NULL_ADDR, NULL_ADDR, NULL_ADDR))->next;
                 }
+                append(last, gen(D_END, label_addr, name_addr, NULL_ADDR));
             }
         
-            t->code = concat(t->code,
-                             gen(D_END, label_addr, name_addr, NULL_ADDR));
-        
             currentFunctionSymtab = oldSymtab;
             return;
         }
@@ -1216,24 +1757,26 @@ void generate_code(struct tree *t) {
             int frameSize = currentFunctionSymtab->nextOffset;
             if (frameSize == 0) frameSize = 8;
             generate_code(t->kids[0]);
-            t->place = t->kids[0]->place;
+            ATTR(t)->place = ATTR(t->kids[0])->place;
         
-            t->code = concat(t->kids[0]->code,
+            ATTR(t)->code = concat(ATTR(t->kids[0])->code,
                              gen(O_DEALLOC, NULL_ADDR,
                                  (struct addr){ .region = R_IMMED, .u.offset = frameSize },
                                  NULL_ADDR));
-            t->code = concat(t->code,
-                             gen(O_RET, NULL_ADDR, t->kids[0]->place, NULL_ADDR));
+            struct instr *ret = gen(O_RET, NULL_ADDR, ATTR(t->kids[0])->place, NULL_ADDR);
+            ret->is_double = t->kids[0]->type == double_typeptr;
+            ret->is_ptr    = is_pointer_type(t->kids[0]->type);
+            ATTR(t)->code = concat(ATTR(t)->code, ret);
             return;
         }
         
         else if (strcmp(t->symbolname, "returnStatement") == 0 && t->nkids == 0) {
             int frameSize = currentFunctionSymtab->nextOffset;
             if (frameSize == 0) frameSize = 8;
-            t->code = gen(O_DEALLOC, NULL_ADDR,
+            ATTR(t)->code = gen(O_DEALLOC, NULL_ADDR,
                           (struct addr){ .region = R_IMMED, .u.offset = frameSize },
                           NULL_ADDR);
-            t->code = concat(t->code,
+            ATTR(t)->code = concat(ATTR(t)->code,
                              gen(O_RET, NULL_ADDR, NULL_ADDR, NULL_ADDR));
             return;
         }
@@ -1260,67 +1803,69 @@ void generate_code(struct tree *t) {
                 struct instr *asn = gen(
                     O_ASN,
                     entry->location,
-                    init->place,
+                    ATTR(init)->place,
                     NULL_ADDR
                 );
                 asn->is_double = (entry->type == double_typeptr) ? 1 : 0;
-                asn->is_ptr = (entry->type == string_typeptr) ? 1 : 0;
+                asn->is_ptr = is_pointer_type(entry->type);
                 debug_print("CODEGEN varDecl '%s': dest=%s:%d  init_place=%s:%d  is_double=%d\n",
                     idNode->leaf->text,
                     regionname(asn->dest.region), asn->dest.u.offset,
-                    regionname(init->place.region), init->place.u.offset,
+                    regionname(ATTR(init)->place.region), ATTR(init)->place.u.offset,
                     asn->is_double);
             
-                t->code  = concat(init->code, asn);
-                t->place = var_loc;
+                ATTR(t)->code  = concat(ATTR(init)->code, asn);
+                ATTR(t)->place = var_loc;
                 t->type  = init->type;
                 return;
             }       
-        else if (strcmp(t->symbolname, "forStatementKotlinRange") == 0 && t->nkids == 4) {
-            struct tree *loopVar = t->kids[0];     
-            struct tree *startExpr = t->kids[1];   
-            struct tree *endExpr = t->kids[2];     
-            struct tree *body = t->kids[3];        
-        
-            SymbolTableEntry entry = lookup_symbol(currentFunctionSymtab, loopVar->leaf->text);
-            if (!entry) {
-                fprintf(stderr, "ERROR: loop variable %s not found\n", loopVar->leaf->text);
-                return;
+        else if ((strcmp(t->symbolname, "forStatementKotlinRange") == 0 ||
+                  strcmp(t->symbolname, "forStatementKotlinRangeUntil") == 0) &&
+                 t->nkids == 4) {
+            struct instr *vcode = NULL;
+            if (pass_enabled("bounds") && (vcode = bounds_range_loop(t, range_loop)))
+                pass_note("bounds");
+            else
+                vcode = range_loop(t, 0);
+            ATTR(t)->code = vcode;
+            return;
+        }
+        else if (strcmp(t->symbolname, "forStatementKotlinIn") == 0 && t->nkids == 3) {
+            // for (k in m.keys): walk the table's slots in order
+            struct tree *iter = t->kids[1];
+            while (!iter->leaf && iter->nkids == 1) iter = iter->kids[0];
+            SymbolTableEntry map = NULL;
+            lookup_method(currentFunctionSymtab, iter->leaf->text, &map);
+            SymbolTableEntry var = lookup_symbol(currentFunctionSymtab, t->kids[0]->leaf->text);
+            if (!map || !var) {
+                fprintf(stderr, "ERROR: cannot iterate over %s\n", iter->leaf->text);
+                exit(1);
             }
-        
-            struct addr i_addr = entry->location;
-        
-            generate_code(startExpr);
-            generate_code(endExpr);
-        
-            struct instr *all_code = NULL;
-            all_code = concat(all_code, startExpr->code);
-            all_code = concat(all_code, endExpr->code);
-        
-            all_code = concat(all_code, gen(O_ASN, i_addr, startExpr->place, NULL_ADDR));
-        
+            struct addr pos = new_temp();
             struct addr *loop_start = genlabel();
             struct addr *loop_end = genlabel();
-        
-            struct instr *label_loop = gen(D_LABEL, *loop_start, NULL_ADDR, NULL_ADDR);
-            all_code = concat(all_code, label_loop);
-        
-            struct addr cond_result = new_temp();
-            all_code = concat(all_code, gen(O_ILE, cond_result, i_addr, endExpr->place));
-            all_code = concat(all_code, gen(O_BZ, *loop_end, cond_result, NULL_ADDR));
-        
-            generate_code(body);
-            all_code = concat(all_code, body->code);
-        
-            struct addr one = { .region = R_IMMED, .u.offset = 1 };
-            struct addr inc_result = new_temp();
-            all_code = concat(all_code, gen(O_IADD, inc_result, i_addr, one));
-            all_code = concat(all_code, gen(O_ASN, i_addr, inc_result, NULL_ADDR));
-        
-            all_code = concat(all_code, gen(O_BR, *loop_start, NULL_ADDR, NULL_ADDR));
-            all_code = concat(all_code, gen(D_LABEL, *loop_end, NULL_ADDR, NULL_ADDR));
-        
-            t->code = all_code;
+
+            struct instr *code = gen(O_ASN, pos, (struct addr){ .region = R_IMMED,
+                                                               .u.offset = 0 }, NULL_ADDR);
+            code = concat(code, gen(D_LABEL, *loop_start, NULL_ADDR, NULL_ADDR));
+            code = concat(code, parm_of(map->location, 1, 0));
+            code = concat(code, parm_of(pos, 0, 0));
+            code = concat(code, call_runtime("k0_map_next", pos, 0, 0));
+            code = concat(code, gen(O_BZ, *loop_end, pos, NULL_ADDR));
+            code = concat(code, parm_of(map->location, 1, 0));
+            code = concat(code, parm_of(pos, 0, 0));
+            code = concat(code, call_runtime("k0_map_key", var->location,
+                                             var->type == string_typeptr, 0));
+
+            struct addr *prev_break_label = current_break_label;
+            current_break_label = loop_end;
+            generate_code(t->kids[2]);
+            code = concat(code, ATTR(t->kids[2])->code);
+            current_break_label = prev_break_label;
+
+            code = concat(code, gen(O_BR, *loop_start, NULL_ADDR, NULL_ADDR));
+            code = concat(code, gen(D_LABEL, *loop_end, NULL_ADDR, NULL_ADDR));
+            ATTR(t)->code = code;
             return;
         }
         else if (strcmp(t->symbolname, "forStatement") == 0 && t->nkids == 4) {
@@ -1330,42 +1875,38 @@ void generate_code(struct tree *t) {
             struct tree *body     = t->kids[3]; 
         
             generate_code(init);
-            generate_code(cond);
             generate_code(update);
         
             struct instr *code = NULL;
-            code = concat(code, init->code); 
+            code = concat(code, ATTR(init)->code); 
         
             struct addr *loop_start = genlabel();
             struct addr *loop_end = genlabel();
         
             code = concat(code, gen(D_LABEL, *loop_start, NULL_ADDR, NULL_ADDR));
         
-            code = concat(code, cond->code);
-            code = concat(code, gen(O_BZ, *loop_end, cond->place, NULL_ADDR));
+            code = concat(code, cond_jump(cond, *loop_end, 0));
         
             struct addr *prev_break = current_break_label;
             current_break_label = loop_end;
         
             generate_code(body);
-            code = concat(code, body->code);
+            code = concat(code, ATTR(body)->code);
         
             current_break_label = prev_break; 
         
-            code = concat(code, update->code);
+            code = concat(code, ATTR(update)->code);
         
             code = concat(code, gen(O_BR, *loop_start, NULL_ADDR, NULL_ADDR));
             code = concat(code, gen(D_LABEL, *loop_end, NULL_ADDR, NULL_ADDR));
         
-            t->code = code;
+            ATTR(t)->code = code;
             return;
         }
         else if (strcmp(t->symbolname, "whileStatement") == 0 && t->nkids == 2) {
             struct tree *cond = t->kids[0];
             struct tree *body = t->kids[1];
         
-            generate_code(cond);
-        
             struct addr *loop_start = genlabel();
             struct addr *loop_end = genlabel();
         
@@ -1373,23 +1914,20 @@ void generate_code(struct tree *t) {
         
             code = concat(code, gen(D_LABEL, *loop_start, NULL_ADDR, NULL_ADDR));
         
-            generate_code(cond);
-            code = concat(code, cond->code);
-        
-            code = concat(code, gen(O_BZ, *loop_end, cond->place, NULL_ADDR));
+            code = concat(code, cond_jump(cond, *loop_end, 0));
         
             struct addr *prev_break_label = current_break_label;
             current_break_label = loop_end;
         
             generate_code(body);
-            code = concat(code, body->code);
+            code = concat(code, ATTR(body)->code);
         
             current_break_label = prev_break_label;
         
             code = concat(code, gen(O_BR, *loop_start, NULL_ADDR, NULL_ADDR));
             code = concat(code, gen(D_LABEL, *loop_end, NULL_ADDR, NULL_ADDR));
         
-            t->code = code;
+            ATTR(t)->code = code;
             return;
         }
         else if (strcmp(t->symbolname, "breakStatement") == 0) {
@@ -1397,7 +1935,7 @@ void generate_code(struct tree *t) {
                 fprintf(stderr, "ERROR: 'break' used outside of loop.\n");
                 return;
             }
-            t->code = gen(O_BR, *current_break_label, NULL_ADDR, NULL_ADDR);
+            ATTR(t)->code = gen(O_BR, *current_break_label, NULL_ADDR, NULL_ADDR);
             return;
         }
         
@@ -1411,63 +1949,485 @@ void generate_code(struct tree *t) {
         }
     }
     
-    struct instr *children_code = NULL;
-    for (int i = 0; i < t->nkids; i++) {
-        if (t->kids[i] && t->kids[i]->code) {
-            children_code = concat(children_code, t->kids[i]->code);
-        }
+    // the kids' code in order: copy each list onto the end of the result
+    // (a list node can have a million kids, so no concat, which would
+    // copy everything so far again each time); the last is shared, as
+    // concat shares its second list
+    int last = t->nkids - 1;
+    while (last >= 0 && !(t->kids[last] && ATTR(t->kids[last])->code)) last--;
+    struct instr *children_code = NULL, *tail = NULL;
+    for (int i = 0; i <= last; i++) {
+        if (!t->kids[i] || !ATTR(t->kids[i])->code) continue;
+        struct instr *kid_code = ATTR(t->kids[i])->code;
+        if (i < last) kid_code = copylist(kid_code);
+        if (tail) tail->next = kid_code;
+        else      children_code = kid_code;
+        if (i < last)
+            for (tail = kid_code; tail->next; tail = tail->next)
+                ;
     }
-    t->code = children_code;
+    ATTR(t)->code = children_code;
     
 }
 
-static void asm_output_filename(const char *in, char *out, size_t sz) {
-    strncpy(out, in, sz-1);
-    out[sz-1] = '\0';
-    char *dot = strrchr(out, '.');
-    if (dot) strcpy(dot, ".s");
-    else strncat(out, ".s", sz - strlen(out) - 1);
+int target_avx2 = 0;
+
+/*
+ * Vector kernels for the loops vectorize.c replaces.  Operands arrive
+ * through the preceding O_PARMs.  SSE2 handles 4 Ints per trip, AVX2
+ * (-mavx2) 8; the remainder runs through a scalar tail.
+ */
+
+/* load a scalar Int operand into %reg */
+static void emit_int_operand(FILE *f, int region, int off, const char *reg) {
+    if (region == R_IMMED)
+        fprintf(f, "\tmovl\t$%d, %s\n", off, reg);
+    else
+        fprintf(f, "\tmovl\t-%d(%%rbp), %s\n", off, reg);
 }
 
-void write_asm_file(const char *input_filename, struct instr *code) {
-    char outfn[256];
-    asm_output_filename(input_filename, outfn, sizeof outfn);
-    FILE *f = fopen(outfn, "w");
-    if (!f) { perror(outfn); return; }
+/* a String value: a literal's header, or the pointer in a slot */
+static void emit_str_ptr(FILE *f, struct addr a, const char *reg) {
+    if (a.region == R_GLOBAL)
+        fprintf(f, "\tleaq\t.LC%d(%%rip), %s\n", a.u.offset, reg);
+    else
+        fprintf(f, "\tmovq\t-%d(%%rbp), %s\n", a.u.offset, reg);
+}
 
-    fprintf(f, "\t.file\t\"%s\"\n", input_filename);
-    fprintf(f, "\t.section\t.rodata\n\t.align\t8\n");
-    for (int i = 0; i < strcount; i++) {
-        fprintf(f,
-                ".LC%d:\n"
-                "\t.string\t%s\n",
-                i, strtab[i].text);
+/*
+ * Local labels the emitted code makes up for itself: .Lidx<n> after an
+ * index check, .Lfill<n>_v, .Lvec<n>_v, .Lrand<n>_s, .Lsget<n>.  Each
+ * function's numbers start where the previous function's end, so the
+ * functions can be written in any order, or at once (see write_asm).
+ */
+struct asm_labels {
+    int idx, fill, vec, rand, sget;
+};
+
+/* the local labels the code for the list takes, added onto *n */
+static void count_labels(struct instr *code, struct asm_labels *n) {
+    for (; code; code = code->next) {
+        switch (code->opcode) {
+            case O_ALOAD: case O_ASTORE:
+                if (!code->unchecked) n->idx++;
+                break;
+            case O_FILL:
+                n->fill++;
+                break;
+            case O_VADD: case O_VSUB: case O_VMUL:
+            case O_VSUM: case O_VMIN: case O_VMAX:
+                n->vec++;
+                break;
+            case O_RAND:
+                n->rand++;
+                break;
+            case O_SGET:
+                n->sget++;
+                break;
+        }
     }
-    for (int i = 0; i < dblcount; i++) {
-        fprintf(f,
-            ".%s:\n"
-            "\t.double\t%f\n",
-            dbltab[i].label,
-            dbltab[i].val);
+}
+
+/*
+ * Array elements: %rax = the array, %rcx = the index (sign-extended), then
+ * a load or store scaled by the element width.  A bitset element is bit
+ * (i & 63) of 64-bit word i >> 6.
+ */
+static void emit_array_index(FILE *f, struct instr *cur, struct addr arr,
+                             struct addr idx, struct asm_labels *lab) {
+    fprintf(f, "\tmovq\t-%d(%%rbp), %%rax\n", arr.u.offset);
+    if (idx.region == R_IMMED)
+        fprintf(f, "\tmovq\t$%d, %%rcx\n", idx.u.offset);
+    else
+        fprintf(f, "\tmovslq\t-%d(%%rbp), %%rcx\n", idx.u.offset);
+    if (!cur->unchecked) {
+        // one unsigned compare catches both i < 0 and i >= length
+        fprintf(f, "\tcmpq\t-16(%%rax), %%rcx\n"
+                   "\tjb\t.Lidx%d\n"
+                   "\tmovl\t%%ecx, %%edi\n"
+                   "\tmovq\t-16(%%rax), %%rsi\n"
+                   "\tcall\tk0_array_index_error\n"
+                   ".Lidx%d:\n", lab->idx, lab->idx);
+        lab->idx++;
     }
-    fprintf(f,
-        ".LCdouble_fmt:\n"
-        "\t.string \"%%f\\n\"\n");
-    fprintf(f,
-        ".LCint_fmt:\n"
-        "\t.string \"%%d\\n\"\n");
-    fprintf(f, "\t.text\n");
+    if (cur->width == 1)
+        fprintf(f, "\tmovq\t%%rcx, %%rdx\n"
+                   "\tshrq\t$6, %%rdx\n"
+                   "\tleaq\t(%%rax,%%rdx,8), %%rax\n");
+}
+
+static void emit_array_load(FILE *f, struct instr *cur, struct asm_labels *lab) {
+    emit_array_index(f, cur, cur->src1, cur->src2, lab);
+    switch (cur->width) {
+        case 1:
+            fprintf(f, "\tmovq\t(%%rax), %%rdx\n"
+                       "\txorl\t%%eax, %%eax\n"
+                       "\tbtq\t%%rcx, %%rdx\n"
+                       "\tsetc\t%%al\n");
+            break;
+        case 8:  fprintf(f, "\tmovsbl\t(%%rax,%%rcx), %%eax\n"); break;
+        case 16: fprintf(f, "\tmovswl\t(%%rax,%%rcx,2), %%eax\n"); break;
+        case 64: fprintf(f, "\tmovq\t(%%rax,%%rcx,8), %%rax\n"); break;
+        default: fprintf(f, "\tmovl\t(%%rax,%%rcx,4), %%eax\n"); break;
+    }
+    if (cur->width == 64)
+        fprintf(f, "\tmovq\t%%rax, -%d(%%rbp)\n", cur->dest.u.offset);
+    else
+        fprintf(f, "\tmovl\t%%eax, -%d(%%rbp)\n", cur->dest.u.offset);
+}
+
+static void emit_array_store(FILE *f, struct instr *cur, struct asm_labels *lab) {
+    emit_array_index(f, cur, cur->dest, cur->src1, lab);
+    struct addr v = cur->src2;
+    if (cur->width == 64 && cur->is_ptr)
+        emit_str_ptr(f, v, "%rdx");
+    else if (cur->width == 64 && cur->is_double)
+        fprintf(f, "\tmovq\t-%d(%%rbp), %%rdx\n", v.u.offset);
+    else if (cur->width == 64 && v.region == R_IMMED)
+        fprintf(f, "\tmovq\t$%d, %%rdx\n", v.u.offset);
+    else if (cur->width == 64)
+        fprintf(f, "\tmovslq\t-%d(%%rbp), %%rdx\n", v.u.offset);
+    else
+        emit_int_operand(f, v.region, v.u.offset, "%edx");
+    switch (cur->width) {
+        case 1:
+            // clear the bit, then or in the value shifted into place
+            fprintf(f, "\tmovq\t(%%rax), %%rsi\n"
+                       "\tbtrq\t%%rcx, %%rsi\n"
+                       "\tandl\t$1, %%edx\n"
+                       "\tshlq\t%%cl, %%rdx\n"
+                       "\torq\t%%rdx, %%rsi\n"
+                       "\tmovq\t%%rsi, (%%rax)\n");
+            break;
+        case 8:  fprintf(f, "\tmovb\t%%dl, (%%rax,%%rcx)\n"); break;
+        case 16: fprintf(f, "\tmovw\t%%dx, (%%rax,%%rcx,2)\n"); break;
+        case 64: fprintf(f, "\tmovq\t%%rdx, (%%rax,%%rcx,8)\n"); break;
+        default: fprintf(f, "\tmovl\t%%edx, (%%rax,%%rcx,4)\n"); break;
+    }
+}
+
+/* parms: dst ptr, lhs, rhs, count.  Vector operands walk %rsi/%rdx;
+   scalars are kept in %r8d/%r9d and broadcast into vector register 1/2. */
+static void emit_vec_binop(FILE *f, int opcode, int n, int off[],
+                           int region[], int is_ptr[]) {
+    const char *preg[2] = { "%rsi", "%rdx" };
+    const char *sreg[2] = { "%r8d", "%r9d" };
+    int w = target_avx2 ? 8 : 4;
+    const char *v = target_avx2 ? "ymm" : "xmm";
+
+    fprintf(f, "\tmovq\t-%d(%%rbp), %%rdi\n", off[0]);
+    for (int k = 0; k < 2; k++) {
+        if (is_ptr[k+1]) {
+            fprintf(f, "\tmovq\t-%d(%%rbp), %s\n", off[k+1], preg[k]);
+            continue;
+        }
+        emit_int_operand(f, region[k+1], off[k+1], sreg[k]);
+        if (target_avx2)
+            fprintf(f, "\tvmovd\t%s, %%xmm%d\n"
+                       "\tvpbroadcastd\t%%xmm%d, %%ymm%d\n",
+                    sreg[k], k+1, k+1, k+1);
+        else
+            fprintf(f, "\tmovd\t%s, %%xmm%d\n"
+                       "\tpshufd\t$0, %%xmm%d, %%xmm%d\n",
+                    sreg[k], k+1, k+1, k+1);
+    }
+    fprintf(f, "\tmovslq\t-%d(%%rbp), %%rcx\n", off[3]);
+
+    fprintf(f, ".Lvec%d_v:\n"
+               "\tcmpq\t$%d, %%rcx\n"
+               "\tjl\t.Lvec%d_s\n", n, w, n);
+    /* lhs -> reg 0, rhs -> reg 3 */
+    if (target_avx2) {
+        if (is_ptr[1]) fprintf(f, "\tvmovdqu\t(%%rsi), %%ymm0\n");
+        else           fprintf(f, "\tvmovdqa\t%%ymm1, %%ymm0\n");
+        if (is_ptr[2]) fprintf(f, "\tvmovdqu\t(%%rdx), %%ymm3\n");
+        else           fprintf(f, "\tvmovdqa\t%%ymm2, %%ymm3\n");
+        fprintf(f, "\t%s\t%%ymm3, %%ymm0, %%ymm0\n",
+                opcode == O_VADD ? "vpaddd" :
+                opcode == O_VSUB ? "vpsubd" : "vpmulld");
+    } else {
+        if (is_ptr[1]) fprintf(f, "\tmovdqu\t(%%rsi), %%xmm0\n");
+        else           fprintf(f, "\tmovdqa\t%%xmm1, %%xmm0\n");
+        if (is_ptr[2]) fprintf(f, "\tmovdqu\t(%%rdx), %%xmm3\n");
+        else           fprintf(f, "\tmovdqa\t%%xmm2, %%xmm3\n");
+        if (opcode == O_VADD)
+            fprintf(f, "\tpaddd\t%%xmm3, %%xmm0\n");
+        else if (opcode == O_VSUB)
+            fprintf(f, "\tpsubd\t%%xmm3, %%xmm0\n");
+        else
+            /* no pmulld before SSE4.1: multiply the even and odd lanes
+               with pmuludq and interleave the low halves back together */
+            fprintf(f,
+                "\tmovdqa\t%%xmm0, %%xmm4\n"
+                "\tpmuludq\t%%xmm3, %%xmm0\n"
+                "\tpsrlq\t$32, %%xmm4\n"
+                "\tmovdqa\t%%xmm3, %%xmm5\n"
+                "\tpsrlq\t$32, %%xmm5\n"
+                "\tpmuludq\t%%xmm5, %%xmm4\n"
+                "\tpshufd\t$8, %%xmm0, %%xmm0\n"
+                "\tpshufd\t$8, %%xmm4, %%xmm4\n"
+                "\tpunpckldq\t%%xmm4, %%xmm0\n");
+    }
+    fprintf(f, "\t%s\t%%%s0, (%%rdi)\n",
+            target_avx2 ? "vmovdqu" : "movdqu", v);
+    fprintf(f, "\taddq\t$%d, %%rdi\n", 4*w);
+    for (int k = 0; k < 2; k++)
+        if (is_ptr[k+1]) fprintf(f, "\taddq\t$%d, %s\n", 4*w, preg[k]);
+    fprintf(f, "\tsubq\t$%d, %%rcx\n"
+               "\tjmp\t.Lvec%d_v\n", w, n);
+
+    fprintf(f, ".Lvec%d_s:\n"
+               "\ttestq\t%%rcx, %%rcx\n"
+               "\tjle\t.Lvec%d_d\n", n, n);
+    if (is_ptr[1]) fprintf(f, "\tmovl\t(%%rsi), %%eax\n");
+    else           fprintf(f, "\tmovl\t%%r8d, %%eax\n");
+    fprintf(f, "\t%s\t%s, %%eax\n",
+            opcode == O_VADD ? "addl" : opcode == O_VSUB ? "subl" : "imull",
+            is_ptr[2] ? "(%rdx)" : "%r9d");
+    fprintf(f, "\tmovl\t%%eax, (%%rdi)\n"
+               "\taddq\t$4, %%rdi\n");
+    for (int k = 0; k < 2; k++)
+        if (is_ptr[k+1]) fprintf(f, "\taddq\t$4, %s\n", preg[k]);
+    fprintf(f, "\tdecq\t%%rcx\n"
+               "\tjmp\t.Lvec%d_s\n"
+               ".Lvec%d_d:\n", n, n);
+    if (target_avx2) fprintf(f, "\tvzeroupper\n");
+}
 
+/* emit_vec_binop for Doubles, two or four to a vector: the scalars are
+   broadcast from their slots, and the tail runs on the low lanes */
+static void emit_vec_binop_double(FILE *f, int opcode, int n, int off[],
+                                  int is_ptr[]) {
+    const char *preg[2] = { "%rsi", "%rdx" };
+    const char *op = opcode == O_VADD ? "add" : opcode == O_VSUB ? "sub" : "mul";
+    int w = target_avx2 ? 4 : 2;
+    const char *v = target_avx2 ? "ymm" : "xmm";
+
+    fprintf(f, "\tmovq\t-%d(%%rbp), %%rdi\n", off[0]);
+    for (int k = 0; k < 2; k++) {
+        if (is_ptr[k+1])
+            fprintf(f, "\tmovq\t-%d(%%rbp), %s\n", off[k+1], preg[k]);
+        else if (target_avx2)
+            fprintf(f, "\tvbroadcastsd\t-%d(%%rbp), %%ymm%d\n", off[k+1], k+1);
+        else
+            fprintf(f, "\tmovsd\t-%d(%%rbp), %%xmm%d\n"
+                       "\tunpcklpd\t%%xmm%d, %%xmm%d\n", off[k+1], k+1, k+1, k+1);
+    }
+    fprintf(f, "\tmovslq\t-%d(%%rbp), %%rcx\n", off[3]);
+
+    fprintf(f, ".Lvec%d_v:\n"
+               "\tcmpq\t$%d, %%rcx\n"
+               "\tjl\t.Lvec%d_t\n", n, w, n);
+    /* lhs -> reg 0, rhs -> reg 3 */
+    if (target_avx2) {
+        if (is_ptr[1]) fprintf(f, "\tvmovupd\t(%%rsi), %%ymm0\n");
+        else           fprintf(f, "\tvmovapd\t%%ymm1, %%ymm0\n");
+        if (is_ptr[2]) fprintf(f, "\tvmovupd\t(%%rdx), %%ymm3\n");
+        else           fprintf(f, "\tvmovapd\t%%ymm2, %%ymm3\n");
+        fprintf(f, "\tv%spd\t%%ymm3, %%ymm0, %%ymm0\n", op);
+    } else {
+        if (is_ptr[1]) fprintf(f, "\tmovupd\t(%%rsi), %%xmm0\n");
+        else           fprintf(f, "\tmovapd\t%%xmm1, %%xmm0\n");
+        if (is_ptr[2]) fprintf(f, "\tmovupd\t(%%rdx), %%xmm3\n");
+        else           fprintf(f, "\tmovapd\t%%xmm2, %%xmm3\n");
+        fprintf(f, "\t%spd\t%%xmm3, %%xmm0\n", op);
+    }
+    fprintf(f, "\t%s\t%%%s0, (%%rdi)\n",
+            target_avx2 ? "vmovupd" : "movupd", v);
+    fprintf(f, "\taddq\t$%d, %%rdi\n", 8*w);
+    for (int k = 0; k < 2; k++)
+        if (is_ptr[k+1]) fprintf(f, "\taddq\t$%d, %s\n", 8*w, preg[k]);
+    fprintf(f, "\tsubq\t$%d, %%rcx\n"
+               "\tjmp\t.Lvec%d_v\n", w, n);
+
+    fprintf(f, ".Lvec%d_t:\n", n);
+    if (target_avx2) fprintf(f, "\tvzeroupper\n");
+    fprintf(f, ".Lvec%d_s:\n"
+               "\ttestq\t%%rcx, %%rcx\n"
+               "\tjle\t.Lvec%d_d\n", n, n);
+    if (is_ptr[1]) fprintf(f, "\tmovsd\t(%%rsi), %%xmm0\n");
+    else           fprintf(f, "\tmovapd\t%%xmm1, %%xmm0\n");
+    if (is_ptr[2]) fprintf(f, "\t%ssd\t(%%rdx), %%xmm0\n", op);
+    else           fprintf(f, "\t%ssd\t%%xmm2, %%xmm0\n", op);
+    fprintf(f, "\tmovsd\t%%xmm0, (%%rdi)\n"
+               "\taddq\t$8, %%rdi\n");
+    for (int k = 0; k < 2; k++)
+        if (is_ptr[k+1]) fprintf(f, "\taddq\t$8, %s\n", preg[k]);
+    fprintf(f, "\tdecq\t%%rcx\n"
+               "\tjmp\t.Lvec%d_s\n"
+               ".Lvec%d_d:\n", n, n);
+}
+
+/* xmm0 = lane-wise max/min(xmm0, xmm1), clobbers xmm1, xmm2 */
+static void emit_sse2_pick(FILE *f, int is_max) {
+    if (is_max)
+        fprintf(f, "\tmovdqa\t%%xmm1, %%xmm2\n"
+                   "\tpcmpgtd\t%%xmm0, %%xmm2\n");
+    else
+        fprintf(f, "\tmovdqa\t%%xmm0, %%xmm2\n"
+                   "\tpcmpgtd\t%%xmm1, %%xmm2\n");
+    fprintf(f, "\tpand\t%%xmm2, %%xmm1\n"
+               "\tpandn\t%%xmm0, %%xmm2\n"
+               "\tpor\t%%xmm2, %%xmm1\n"
+               "\tmovdqa\t%%xmm1, %%xmm0\n");
+}
+
+/* dest = accumulator, parms: src ptr, count.  The vector part reduces
+   into lanes of xmm0/ymm0 which are then folded into %eax for the tail. */
+static void emit_vec_reduce(FILE *f, int opcode, int n, int acc, int off[]) {
+    int w = target_avx2 ? 8 : 4;
+    int is_max = opcode == O_VMAX;
+
+    fprintf(f, "\tmovq\t-%d(%%rbp), %%rsi\n"
+               "\tmovslq\t-%d(%%rbp), %%rcx\n", off[0], off[1]);
+    if (opcode == O_VSUM)
+        fprintf(f, "\t%s\n", target_avx2 ? "vpxor\t%ymm0, %ymm0, %ymm0"
+                                         : "pxor\t%xmm0, %xmm0");
+    else if (target_avx2)
+        fprintf(f, "\tvpbroadcastd\t-%d(%%rbp), %%ymm0\n", acc);
+    else
+        fprintf(f, "\tmovd\t-%d(%%rbp), %%xmm0\n"
+                   "\tpshufd\t$0, %%xmm0, %%xmm0\n", acc);
+
+    fprintf(f, ".Lvec%d_v:\n"
+               "\tcmpq\t$%d, %%rcx\n"
+               "\tjl\t.Lvec%d_h\n", n, w, n);
+    if (target_avx2) {
+        fprintf(f, "\t%s\t(%%rsi), %%ymm0, %%ymm0\n",
+                opcode == O_VSUM ? "vpaddd" : is_max ? "vpmaxsd" : "vpminsd");
+    } else {
+        fprintf(f, "\tmovdqu\t(%%rsi), %%xmm1\n");
+        if (opcode == O_VSUM) fprintf(f, "\tpaddd\t%%xmm1, %%xmm0\n");
+        else                  emit_sse2_pick(f, is_max);
+    }
+    fprintf(f, "\taddq\t$%d, %%rsi\n"
+               "\tsubq\t$%d, %%rcx\n"
+               "\tjmp\t.Lvec%d_v\n", 4*w, w, n);
+
+    /* horizontal fold */
+    fprintf(f, ".Lvec%d_h:\n", n);
+    if (target_avx2) {
+        const char *op = opcode == O_VSUM ? "vpaddd"
+                       : is_max ? "vpmaxsd" : "vpminsd";
+        fprintf(f, "\tvextracti128\t$1, %%ymm0, %%xmm1\n"
+                   "\t%s\t%%xmm1, %%xmm0, %%xmm0\n"
+                   "\tvpshufd\t$0x4e, %%xmm0, %%xmm1\n"
+                   "\t%s\t%%xmm1, %%xmm0, %%xmm0\n"
+                   "\tvpshufd\t$0xb1, %%xmm0, %%xmm1\n"
+                   "\t%s\t%%xmm1, %%xmm0, %%xmm0\n"
+                   "\tvmovd\t%%xmm0, %%eax\n"
+                   "\tvzeroupper\n", op, op, op);
+    } else {
+        fprintf(f, "\tpshufd\t$0x4e, %%xmm0, %%xmm1\n");
+        if (opcode == O_VSUM) fprintf(f, "\tpaddd\t%%xmm1, %%xmm0\n");
+        else                  emit_sse2_pick(f, is_max);
+        fprintf(f, "\tpshufd\t$0xb1, %%xmm0, %%xmm1\n");
+        if (opcode == O_VSUM) fprintf(f, "\tpaddd\t%%xmm1, %%xmm0\n");
+        else                  emit_sse2_pick(f, is_max);
+        fprintf(f, "\tmovd\t%%xmm0, %%eax\n");
+    }
+    if (opcode == O_VSUM)
+        fprintf(f, "\taddl\t-%d(%%rbp), %%eax\n", acc);
+
+    fprintf(f, ".Lvec%d_s:\n"
+               "\ttestq\t%%rcx, %%rcx\n"
+               "\tjle\t.Lvec%d_d\n", n, n);
+    if (opcode == O_VSUM)
+        fprintf(f, "\taddl\t(%%rsi), %%eax\n");
+    else
+        fprintf(f, "\tmovl\t(%%rsi), %%edx\n"
+                   "\tcmpl\t%%eax, %%edx\n"
+                   "\t%s\t%%edx, %%eax\n", is_max ? "cmovg" : "cmovl");
+    fprintf(f, "\taddq\t$4, %%rsi\n"
+               "\tdecq\t%%rcx\n"
+               "\tjmp\t.Lvec%d_s\n"
+               ".Lvec%d_d:\n"
+               "\tmovl\t%%eax, -%d(%%rbp)\n", n, n, acc);
+}
+
+/*
+ * java.util.Random inline: one xoshiro256** step on the runtime's k0_rng
+ * state leaves the 64-bit output in %rax.  nextInt() keeps the high 32
+ * bits, nextInt(n) (src1 = n) multiplies them by n and only calls the
+ * runtime when the low word is below n and might need rejecting, and
+ * nextDouble() (is_double) scales the top 53 bits by 2^-53.
+ */
+static void emit_rand(FILE *f, struct instr *cur, int n) {
+    fprintf(f, "\tmovq\tk0_rng+8(%%rip), %%rdx\n"
+               "\tleaq\t(%%rdx,%%rdx,4), %%rax\n"
+               "\trolq\t$7, %%rax\n"
+               "\tleaq\t(%%rax,%%rax,8), %%rax\n"
+               "\tmovq\t%%rdx, %%rcx\n"
+               "\tshlq\t$17, %%rcx\n"
+               "\tmovq\tk0_rng(%%rip), %%rsi\n"
+               "\tmovq\tk0_rng+16(%%rip), %%rdi\n"
+               "\tmovq\tk0_rng+24(%%rip), %%r8\n"
+               "\txorq\t%%rsi, %%rdi\n"
+               "\txorq\t%%rdx, %%r8\n"
+               "\txorq\t%%rdi, %%rdx\n"
+               "\txorq\t%%r8, %%rsi\n"
+               "\txorq\t%%rcx, %%rdi\n"
+               "\trolq\t$45, %%r8\n"
+               "\tmovq\t%%rsi, k0_rng(%%rip)\n"
+               "\tmovq\t%%rdx, k0_rng+8(%%rip)\n"
+               "\tmovq\t%%rdi, k0_rng+16(%%rip)\n"
+               "\tmovq\t%%r8, k0_rng+24(%%rip)\n");
+
+    if (cur->is_double) {
+        fprintf(f, "\tshrq\t$11, %%rax\n"
+                   "\tcvtsi2sdq\t%%rax, %%xmm0\n"
+                   "\tmovabsq\t$0x3ca0000000000000, %%rdx\n"
+                   "\tmovq\t%%rdx, %%xmm1\n"
+                   "\tmulsd\t%%xmm1, %%xmm0\n"
+                   "\tmovsd\t%%xmm0, -%d(%%rbp)\n", cur->dest.u.offset);
+        return;
+    }
+    fprintf(f, "\tshrq\t$32, %%rax\n");
+    if (cur->src1.region != R_NONE) {
+        emit_int_operand(f, cur->src1.region, cur->src1.u.offset, "%ecx");
+        fprintf(f, "\timulq\t%%rcx, %%rax\n"
+                   "\ttestl\t%%ecx, %%ecx\n"
+                   "\tjle\t.Lrand%d_s\n"
+                   "\tcmpl\t%%ecx, %%eax\n"
+                   "\tjae\t.Lrand%d_d\n"
+                   ".Lrand%d_s:\n"
+                   "\tmovl\t%%ecx, %%edi\n"
+                   "\tmovq\t%%rax, %%rsi\n"
+                   "\tcall\tk0_rand_bounded_slow\n"
+                   "\tjmp\t.Lrand%d_r\n"
+                   ".Lrand%d_d:\n"
+                   "\tshrq\t$32, %%rax\n"
+                   ".Lrand%d_r:\n", n, n, n, n, n, n);
+    }
+    fprintf(f, "\tmovl\t%%eax, -%d(%%rbp)\n", cur->dest.u.offset);
+}
+
+/* jcc taken when the Ixx compare that just ran was true (or false) */
+static const char *setcc_jump(int opcode, int when_true) {
+    switch (opcode) {
+        case O_IEQ: return when_true ? "je"  : "jne";
+        case O_INE: return when_true ? "jne" : "je";
+        case O_ILT: return when_true ? "jl"  : "jge";
+        case O_ILE: return when_true ? "jle" : "jg";
+        case O_IGT: return when_true ? "jg"  : "jle";
+        default:    return when_true ? "jge" : "jl";
+    }
+}
+
+/* the assembly for one function's code; its local labels start at *lab */
+static void write_code(FILE *f, struct instr *code, struct asm_labels *lab) {
     const char *ireg[6] = { "%edi","%esi","%edx","%ecx","%r8d","%r9d" };
     const char *qreg[6] = { "%rdi","%rsi","%rdx","%rcx","%r8","%r9" };
-    const char *xmmreg[6] = {"%xmm0","%xmm1","%xmm2","%xmm3","%xmm4","%xmm5"};
-    int argc = 0, args_off[6], args_is_ptr[6] = {0}, args_is_double[6] = {0};
-    int args_region[6];
+    const char *xmmreg[8] = {"%xmm0","%xmm1","%xmm2","%xmm3","%xmm4","%xmm5","%xmm6","%xmm7"};
+    int argc = 0, argcap = 0;       /* the PARMs of the call being built */
+    int *args_off = NULL, *args_region = NULL, *args_is_ptr = NULL, *args_is_double = NULL;
 
     int inFunction = 0;
+    int inMain     = 0;
     int frameSize  = 0;
 
-    for (struct instr *cur = code; cur; cur = cur->next) {
+    struct instr *prev = NULL;
+    for (struct instr *cur = code; cur; prev = cur, cur = cur->next) {
         switch (cur->opcode) {
 
           // ————————— PSEUDO‐OPS —————————
@@ -1479,6 +2439,7 @@ void write_asm_file(const char *input_filename, struct instr *code) {
 
             case D_PROC:
                 inFunction = 1;
+                inMain     = strcmp(cur->src1.u.name, "main") == 0;
                 argc       = 0;
                 frameSize  = 0;
             
@@ -1506,6 +2467,9 @@ void write_asm_file(const char *input_filename, struct instr *code) {
                 break;
 
             case D_END:
+                // main ending without a return exits 0, not with what eax held
+                if (inMain && (!prev || prev->opcode != O_RET))
+                    fprintf(f, "\txorl\t%%eax, %%eax\n");
                 fprintf(f,
                     "\taddq\t$%d, %%rsp\n"
                     "\tleave\n"
@@ -1533,20 +2497,97 @@ void write_asm_file(const char *input_filename, struct instr *code) {
                 }
                 break;
 
+            // dest = new array, src1 = element count, src2 = element bits;
+            // MALLOC leaves the elements uninitialized, CALLOC zeroes them
             case O_MALLOC: {
+                if (cur->src1.region == R_IMMED) {
+                    fprintf(f, "\tmovq\t$%d, %%rdi\n", cur->src1.u.offset);
+                } else {
+                    fprintf(f, "\tmovslq\t-%d(%%rbp), %%rdi\n",
+                            cur->src1.u.offset);
+                }
+                fprintf(f, "\tmovl\t$%d, %%esi\n", cur->src2.u.offset);
+                fprintf(f, "\tcall\tk0_array_alloc\n");
+                fprintf(f, "\tmovq\t%%rax, -%d(%%rbp)\n",
+                        cur->dest.u.offset);
+                argc = 0;
+                break;
+            }
+
+            case O_CALLOC: {
                 if (cur->src1.region == R_IMMED) {
                     fprintf(f, "\tmovl\t$%d, %%edi\n", cur->src1.u.offset);
                 } else {
-                    fprintf(f, "\tmovl\t-%d(%%rbp), %%edi\n",
+                    fprintf(f, "\tmovslq\t-%d(%%rbp), %%rdi\n",
                             cur->src1.u.offset);
                 }
-                fprintf(f, "\tcall\tmalloc\n");
+                fprintf(f, "\tmovl\t$%d, %%esi\n", cur->src2.u.offset);
+                fprintf(f, "\tcall\tk0_array_new\n");
                 fprintf(f, "\tmovq\t%%rax, -%d(%%rbp)\n",
                         cur->dest.u.offset);
                 argc = 0;
                 break;
             }
 
+            // dest = array pointer slot, src1 = element count, src2 = value.
+            // Broadcast the value into xmm0 and store 32 bytes per trip,
+            // then finish the last <8 elements one at a time.
+            case O_FILL: {
+                int n = lab->fill++;
+                fprintf(f, "\tmovq\t-%d(%%rbp), %%rdi\n", cur->dest.u.offset);
+                if (cur->src1.region == R_IMMED)
+                    fprintf(f, "\tmovq\t$%d, %%rcx\n", cur->src1.u.offset);
+                else
+                    fprintf(f, "\tmovslq\t-%d(%%rbp), %%rcx\n",
+                            cur->src1.u.offset);
+                if (cur->src2.region == R_IMMED)
+                    fprintf(f, "\tmovl\t$%d, %%eax\n", cur->src2.u.offset);
+                else
+                    fprintf(f, "\tmovl\t-%d(%%rbp), %%eax\n",
+                            cur->src2.u.offset);
+                fprintf(f,
+                    "\tmovd\t%%eax, %%xmm0\n"
+                    "\tpshufd\t$0, %%xmm0, %%xmm0\n"
+                    ".Lfill%d_v:\n"
+                    "\tcmpq\t$8, %%rcx\n"
+                    "\tjl\t.Lfill%d_s\n"
+                    "\tmovdqu\t%%xmm0, (%%rdi)\n"
+                    "\tmovdqu\t%%xmm0, 16(%%rdi)\n"
+                    "\taddq\t$32, %%rdi\n"
+                    "\tsubq\t$8, %%rcx\n"
+                    "\tjmp\t.Lfill%d_v\n"
+                    ".Lfill%d_s:\n"
+                    "\ttestq\t%%rcx, %%rcx\n"
+                    "\tjle\t.Lfill%d_d\n"
+                    "\tmovl\t%%eax, (%%rdi)\n"
+                    "\taddq\t$4, %%rdi\n"
+                    "\tdecq\t%%rcx\n"
+                    "\tjmp\t.Lfill%d_s\n"
+                    ".Lfill%d_d:\n",
+                    n, n, n, n, n, n, n);
+                break;
+            }
+
+            case O_VADD:
+            case O_VSUB:
+            case O_VMUL:
+                if (cur->is_double)
+                    emit_vec_binop_double(f, cur->opcode, lab->vec++,
+                                          args_off, args_is_ptr);
+                else
+                    emit_vec_binop(f, cur->opcode, lab->vec++,
+                                   args_off, args_region, args_is_ptr);
+                argc = 0;
+                break;
+
+            case O_VSUM:
+            case O_VMIN:
+            case O_VMAX:
+                emit_vec_reduce(f, cur->opcode, lab->vec++,
+                                cur->dest.u.offset, args_off);
+                argc = 0;
+                break;
+
             case O_DEALLOC:
                 if (!inFunction) {
                     fprintf(f, "\taddq\t$%d, %%rsp\n",
@@ -1557,20 +2598,33 @@ void write_asm_file(const char *input_filename, struct instr *code) {
             // ——————— PARAM / CALL ———————
 
             case O_PARM:
-                if (argc < 6) {
-                    args_off[argc]     = cur->src1.u.offset;
-                    args_region[argc]  = cur->src1.region;
-                    args_is_double[argc] = cur->is_double;
-                    args_is_ptr[argc]    = (cur->src1.region == R_GLOBAL)
-                                          || cur->is_ptr;
-                    argc++;
+                if (argc == argcap) {
+                    argcap = argcap ? 2 * argcap : 8;
+                    args_off       = realloc(args_off,       argcap * sizeof(int));
+                    args_region    = realloc(args_region,    argcap * sizeof(int));
+                    args_is_ptr    = realloc(args_is_ptr,    argcap * sizeof(int));
+                    args_is_double = realloc(args_is_double, argcap * sizeof(int));
+                    if (!args_off || !args_region || !args_is_ptr || !args_is_double) {
+                        fprintf(stderr, "out of memory\n");
+                        exit(4);
+                    }
                 }
+                args_off[argc]     = cur->src1.u.offset;
+                args_region[argc]  = cur->src1.region;
+                args_is_double[argc] = cur->is_double;
+                args_is_ptr[argc]    = (cur->src1.region == R_GLOBAL)
+                                      || cur->is_ptr;
+                argc++;
                 break;
 
             case O_CALL: {
+                // print/println go to the typed k0 runtime entry points;
+                // a String is written as is, with no newline added
                 if (cur->src1.region == R_NAME
-                    && strcmp(cur->src1.u.name, "println") == 0
+                    && (strcmp(cur->src1.u.name, "println") == 0
+                        || strcmp(cur->src1.u.name, "print") == 0)
                     && argc == 1) {
+                    int ln = strcmp(cur->src1.u.name, "println") == 0;
                     if (args_is_ptr[0]) {
                         if (args_region[0] == R_GLOBAL) {
                             fprintf(f, "\tleaq\t.LC%d(%%rip), %%rdi\n",
@@ -1579,48 +2633,75 @@ void write_asm_file(const char *input_filename, struct instr *code) {
                             fprintf(f, "\tmovq\t-%d(%%rbp), %%rdi\n",
                                     args_off[0]);
                         }
-                        fprintf(f, "\txor\t%%eax, %%eax\n");
+                        fprintf(f, "\tcall\tk0_print_str\n");
                     }
                     else if (args_is_double[0]) {
-                        fprintf(f, "\tleaq\t.LCdouble_fmt(%%rip), %%rdi\n");
                         fprintf(f, "\tmovsd\t-%d(%%rbp), %%xmm0\n", args_off[0]);
-                        fprintf(f, "\tmovl\t$1, %%eax\n");
+                        fprintf(f, "\tcall\t%s\n",
+                                ln ? "k0_println_double" : "k0_print_double");
                     }
                     else {
-                        fprintf(f, "\tleaq\t.LCint_fmt(%%rip), %%rdi\n");
-                        fprintf(f, "\tmovl\t-%d(%%rbp), %%esi\n", args_off[0]);
-                        fprintf(f, "\txor\t%%eax, %%eax\n");
+                        fprintf(f, "\tmovl\t-%d(%%rbp), %%edi\n", args_off[0]);
+                        fprintf(f, "\tcall\t%s\n",
+                                ln ? "k0_println_int" : "k0_print_int");
                     }
-                    fprintf(f, "\tcall\tprintf\n");
                     argc = 0;
                     break;
                 }
                 
-                for (int i = 0; i < argc && i < 6; i++) {
+                // Doubles and the rest are numbered separately, as the
+                // C ABI of the runtime (and R_PARAM in the callee) has them.
+                // Those past the registers of their class go in order into
+                // an area on top of the stack, kept 16-byte aligned
+                int nstack = 0;
+                for (int i = 0, ni = 0, nx = 0; i < argc; i++)
+                    if (args_is_double[i] ? nx++ >= PARAM_DOUBLE_REGS
+                                          : ni++ >= PARAM_INT_REGS)
+                        nstack++;
+                if (nstack > 0)
+                    fprintf(f, "\tsubq\t$%d, %%rsp\n", 8 * (nstack + (nstack & 1)));
+                for (int i = 0, ni = 0, nx = 0, k = 0; i < argc; i++) {
+                    if (args_is_double[i] ? nx++ < PARAM_DOUBLE_REGS
+                                          : ni++ < PARAM_INT_REGS)
+                        continue;
+                    if (args_is_double[i])
+                        fprintf(f, "\tmovq\t-%d(%%rbp), %%rax\n", args_off[i]);
+                    else if (args_is_ptr[i])
+                        emit_str_ptr(f, (struct addr){ .region = args_region[i],
+                                                       .u.offset = args_off[i] },
+                                     "%rax");
+                    else
+                        emit_int_operand(f, args_region[i], args_off[i], "%eax");
+                    fprintf(f, "\tmovq\t%%rax, %d(%%rsp)\n", 8 * k++);
+                }
+                for (int i = 0, ni = 0, nx = 0; i < argc; i++) {
+                    if (args_is_double[i] ? nx >= PARAM_DOUBLE_REGS
+                                          : ni >= PARAM_INT_REGS)
+                        continue;
                     if (args_is_double[i]) {
                         fprintf(f,
                             "\tmovsd\t-%d(%%rbp), %s\n",
                             args_off[i],
-                            xmmreg[i]);
+                            xmmreg[nx++]);
                     }
                     else if (args_is_ptr[i]) {
                         if (args_region[i] == R_GLOBAL) {
                             fprintf(f,
                                 "\tleaq\t.LC%d(%%rip), %s\n",
                                 args_off[i],
-                                qreg[i]);
+                                qreg[ni++]);
                         } else {
                             fprintf(f,
                                 "\tmovq\t-%d(%%rbp), %s\n",
                                 args_off[i],
-                                qreg[i]);
+                                qreg[ni++]);
                         }
                     }
                     else {
                         fprintf(f,
                             "\tmovl\t-%d(%%rbp), %s\n",
                             args_off[i],
-                            ireg[i]);
+                            ireg[ni++]);
                     }
                 }
                 if (cur->src1.region == R_NAME) {
@@ -1628,11 +2709,17 @@ void write_asm_file(const char *input_filename, struct instr *code) {
                 } else {
                     fprintf(f, "\tcall\t.L%d\n", cur->src1.u.offset);
                 }
+                if (nstack > 0)
+                    fprintf(f, "\taddq\t$%d, %%rsp\n", 8 * (nstack + (nstack & 1)));
                 if (cur->dest.u.offset > 0) {
                     if (cur->is_double) {
                         fprintf(f,
                             "\tmovsd\t%%xmm0, -%d(%%rbp)\n",
                             cur->dest.u.offset);
+                    } else if (cur->is_ptr) {
+                        fprintf(f,
+                            "\tmovq\t%%rax, -%d(%%rbp)\n",
+                            cur->dest.u.offset);
                     } else {
                         fprintf(f,
                             "\tmovl\t%%eax, -%d(%%rbp)\n",
@@ -1644,19 +2731,59 @@ void write_asm_file(const char *input_filename, struct instr *code) {
             }               
 
             case O_RET:
-                if (cur->src1.region == R_IMMED) {
+                if (cur->src1.region == R_NONE) {
+                    if (inMain) fprintf(f, "\txorl\t%%eax, %%eax\n");
+                }
+                else if (cur->is_double) {
+                    fprintf(f, "\tmovsd\t-%d(%%rbp), %%xmm0\n",
+                            cur->src1.u.offset);
+                }
+                else if (cur->is_ptr) {
+                    emit_str_ptr(f, cur->src1, "%rax");
+                }
+                else if (cur->src1.region == R_IMMED) {
                     fprintf(f, "\tmovl\t$%d, %%eax\n",
                             cur->src1.u.offset);
                 }
-                else if (cur->src1.region != R_NONE) {
+                else {
                     fprintf(f, "\tmovl\t-%d(%%rbp), %%eax\n",
                             cur->src1.u.offset);
                 }
+                // a return before the end of the function leaves from here
+                if (!cur->next || cur->next->opcode != D_END) {
+                    fprintf(f,
+                        "\t.cfi_remember_state\n"
+                        "\tleave\n"
+                        "\t.cfi_def_cfa 7, 8\n"
+                        "\tret\n"
+                        "\t.cfi_restore_state\n");
+                }
                 break;
 
           // ———————— ARITHMETIC ————————
 
             case O_ASN:
+                // a parameter the caller passed on the stack, above the
+                // return address and the saved %rbp
+                if (cur->src1.region == R_PARAM && cur->src1.u.offset >= PARAM_STACK) {
+                    int disp = 16 + 8 * (cur->src1.u.offset - PARAM_STACK);
+                    if (cur->is_double)
+                        fprintf(f,
+                            "\tmovsd\t%d(%%rbp), %%xmm0\n"
+                            "\tmovsd\t%%xmm0, -%d(%%rbp)\n",
+                            disp, cur->dest.u.offset);
+                    else if (cur->is_ptr)
+                        fprintf(f,
+                            "\tmovq\t%d(%%rbp), %%rax\n"
+                            "\tmovq\t%%rax, -%d(%%rbp)\n",
+                            disp, cur->dest.u.offset);
+                    else
+                        fprintf(f,
+                            "\tmovl\t%d(%%rbp), %%eax\n"
+                            "\tmovl\t%%eax, -%d(%%rbp)\n",
+                            disp, cur->dest.u.offset);
+                    break;
+                }
                 if (cur->dest.region == R_MEM) {
                     fprintf(f, "\tmovq\t-%d(%%rbp), %%rax\n",
                             cur->dest.u.offset);
@@ -1933,6 +3060,30 @@ void write_asm_file(const char *input_filename, struct instr *code) {
           case O_ILT: case O_ILE:
           case O_IGT: case O_IGE: {
             const char *mn;
+            if (cur->is_double) {
+                // ucomisd sets CF/ZF like an unsigned compare, and PF when
+                // either side is NaN; every ordered test is false for NaN
+                // and != is true
+                int swap = cur->opcode == O_ILT || cur->opcode == O_ILE;
+                fprintf(f,
+                    "\tmovsd\t%d(%%rbp), %%xmm0\n"
+                    "\tucomisd\t%d(%%rbp), %%xmm0\n",
+                    -(swap ? cur->src2 : cur->src1).u.offset,
+                    -(swap ? cur->src1 : cur->src2).u.offset);
+                if (cur->opcode == O_IEQ)
+                    fprintf(f, "\tsete\t%%al\n\tsetnp\t%%cl\n\tandb\t%%cl, %%al\n");
+                else if (cur->opcode == O_INE)
+                    fprintf(f, "\tsetne\t%%al\n\tsetp\t%%cl\n\torb\t%%cl, %%al\n");
+                else
+                    fprintf(f, "\t%s\t%%al\n",
+                            (cur->opcode == O_IGT || cur->opcode == O_ILT)
+                            ? "seta" : "setae");
+                fprintf(f,
+                    "\tmovzbl\t%%al, %%eax\n"
+                    "\tmovl\t%%eax, %d(%%rbp)\n",
+                    -cur->dest.u.offset);
+                break;
+            }
             if      (cur->opcode == O_IEQ) mn = "sete";
             else if (cur->opcode == O_INE) mn = "setne";
             else if (cur->opcode == O_ILT) mn = "setl";
@@ -1965,43 +3116,57 @@ void write_asm_file(const char *input_filename, struct instr *code) {
             break;
 
           case O_BZ:
-            fprintf(f,
-                "\tcmpl\t$0, %d(%%rbp)\n"
-                "\tje\t.L%d\n",
-               -cur->src1.u.offset,
-                cur->dest.u.offset);
-            break;
-
           case O_BNZ:
+            // right after the compare that produced src1 the flags are
+            // still live (setcc/movzbl/movl leave them alone): just jump
+            if (prev && prev->opcode >= O_IEQ && prev->opcode <= O_INE &&
+                !prev->is_double && prev->dest.region == R_LOCAL &&
+                cur->src1.region == R_LOCAL &&
+                prev->dest.u.offset == cur->src1.u.offset) {
+                fprintf(f, "\t%s\t.L%d\n",
+                        setcc_jump(prev->opcode, cur->opcode == O_BNZ),
+                        cur->dest.u.offset);
+                break;
+            }
             fprintf(f,
                 "\tcmpl\t$0, %d(%%rbp)\n"
-                "\tjne\t.L%d\n",
+                "\t%s\t.L%d\n",
                -cur->src1.u.offset,
+                cur->opcode == O_BZ ? "je" : "jne",
                 cur->dest.u.offset);
             break;
 
           case O_BLT: case O_BLE:
           case O_BGT: case O_BGE:
-          case O_BEQ: case O_BNE:
-          case O_BIF: case O_BNIF: {
+          case O_BEQ: case O_BNE: {
             const char *jmn;
             if      (cur->opcode == O_BLT)  jmn = "jl";
             else if (cur->opcode == O_BLE)  jmn = "jle";
             else if (cur->opcode == O_BGT)  jmn = "jg";
             else if (cur->opcode == O_BGE)  jmn = "jge";
             else if (cur->opcode == O_BEQ)  jmn = "je";
-            else if (cur->opcode == O_BNE)  jmn = "jne";
-            else if (cur->opcode == O_BIF)  jmn = "jnz";
-            else                             jmn = "jz";
+            else                             jmn = "jne";
+            // src1 into a register, compare against src2 in place
+            if (cur->src1.region == R_IMMED)
+                fprintf(f, "\tmovl\t$%d, %%eax\n", cur->src1.u.offset);
+            else
+                fprintf(f, "\tmovl\t-%d(%%rbp), %%eax\n", cur->src1.u.offset);
+            if (cur->src2.region == R_IMMED)
+                fprintf(f, "\tcmpl\t$%d, %%eax\n", cur->src2.u.offset);
+            else
+                fprintf(f, "\tcmpl\t-%d(%%rbp), %%eax\n", cur->src2.u.offset);
+            fprintf(f, "\t%s\t.L%d\n", jmn, cur->dest.u.offset);
+            break;
+          }
+
+          case O_BIF: case O_BNIF:
             fprintf(f,
-                "\tcmpl\t%d(%%rbp), %d(%%rbp)\n"
+                "\tcmpl\t$0, -%d(%%rbp)\n"
                 "\t%s\t.L%d\n",
-               -cur->src2.u.offset,
-               -cur->src1.u.offset,
-                jmn,
+                cur->src1.u.offset,
+                cur->opcode == O_BIF ? "jne" : "je",
                 cur->dest.u.offset);
             break;
-          }
 
           case O_POP:
             fprintf(f, "\tpopq\t%%rbp\n");
@@ -2079,18 +3244,45 @@ void write_asm_file(const char *input_filename, struct instr *code) {
             break;
         
         case O_RAND:
-            fprintf(f,
-                "\tcall\trand\n"
-                "\tmovl\t%%eax, %d(%%rbp)\n",
-                -cur->dest.u.offset);
+            emit_rand(f, cur, lab->rand++);
             break;
-        
-        case O_SRAND:
-            fprintf(f,
-                "\tmovl\t$0, %%edi\n"
-                "\tcall\ttime\n"
-                "\tmovq\t%%rax, %%rdi\n"
-                "\tcall\tsrand\n");
+
+        case O_SLEN:
+            emit_str_ptr(f, cur->src1, "%rax");
+            fprintf(f, "\tmovl\t(%%rax), %%eax\n"
+                       "\tmovl\t%%eax, -%d(%%rbp)\n", cur->dest.u.offset);
+            break;
+
+        case O_ALEN:
+            fprintf(f, "\tmovq\t-%d(%%rbp), %%rax\n"
+                       "\tmovl\t-16(%%rax), %%eax\n"
+                       "\tmovl\t%%eax, -%d(%%rbp)\n",
+                    cur->src1.u.offset, cur->dest.u.offset);
+            break;
+
+        case O_ALOAD:
+            emit_array_load(f, cur, lab);
+            break;
+
+        case O_ASTORE:
+            emit_array_store(f, cur, lab);
+            break;
+
+        case O_SGET:
+            // the index is zero-extended, so a negative one fails too
+            emit_str_ptr(f, cur->src1, "%rax");
+            emit_int_operand(f, cur->src2.region, cur->src2.u.offset, "%ecx");
+            fprintf(f, "\tcmpq\t(%%rax), %%rcx\n"
+                       "\tjb\t.Lsget%d\n"
+                       "\tmovl\t%%ecx, %%edi\n"
+                       "\tmovq\t(%%rax), %%rsi\n"
+                       "\tcall\tk0_str_index_error\n"
+                       ".Lsget%d:\n"
+                       "\tmovq\t8(%%rax), %%rax\n"
+                       "\tmovzbl\t(%%rax,%%rcx), %%eax\n"
+                       "\tmovl\t%%eax, -%d(%%rbp)\n",
+                    lab->sget, lab->sget, cur->dest.u.offset);
+            lab->sget++;
             break;
         
           default:
@@ -2100,7 +3292,374 @@ void write_asm_file(const char *input_filename, struct instr *code) {
             break;
         }
     }
-    fprintf(f, "\t.section .note.GNU-stack,\"\",@progbits\n");
+    free(args_off);
+    free(args_region);
+    free(args_is_ptr);
+    free(args_is_double);
+}
 
+/* one function's assembly, written on whichever thread takes it */
+struct asm_text {
+    struct instr *code;
+    struct asm_labels labels;  /* where its local label numbers start */
+    char *text;
+    size_t len;
+};
+
+static void write_function_asm(int k, void *arg) {
+    struct asm_text *t = (struct asm_text *)arg + k;
+    FILE *f = open_memstream(&t->text, &t->len);
+    if (!f) {
+        perror("open_memstream");
+        exit(4);
+    }
+    write_code(f, t->code, &t->labels);
     fclose(f);
-}
\ No newline at end of file
+}
+
+/* the literal pools, ahead of the code that refers to them */
+static void write_asm_data(FILE *f, const char *input_filename) {
+    fprintf(f, "\t.file\t\"%s\"\n", input_filename);
+    // a String literal .LCn is a k0_str header {length, bytes} over the
+    // bytes .LCnS; the assembler works out the length of the escaped text
+    fprintf(f, "\t.section\t.data.rel.ro.local,\"aw\"\n\t.align\t8\n");
+    for (int i = 0; i < strcount; i++) {
+        fprintf(f,
+                ".LC%d:\n"
+                "\t.quad\t.LC%dE-.LC%dS-1\n"
+                "\t.quad\t.LC%dS\n",
+                i, i, i, i);
+    }
+    fprintf(f, "\t.section\t.rodata\n\t.align\t8\n");
+    for (int i = 0; i < strcount; i++) {
+        fprintf(f,
+                ".LC%dS:\n"
+                "\t.string\t%s\n"
+                ".LC%dE:\n",
+                i, strtab[i].text, i);
+    }
+    for (int i = 0; i < dblcount; i++) {
+        fprintf(f,
+            ".%s:\n"
+            "\t.double\t%.17g\n",
+            dbltab[i].label,
+            dbltab[i].val);
+    }
+    fprintf(f, "\t.text\n");
+}
+
+/*
+ * The functions in code: each is written to memory on its own (in
+ * parallel when there are threads to spare) and they are copied out in
+ * source order.  Local label numbers start at *lab and end up past the
+ * last one used.
+ */
+static void write_functions(FILE *f, struct instr *code, struct asm_labels *lab) {
+    int n;
+    struct instr **piece = split_functions(code, &n);
+    struct asm_text *out = calloc(n + 1, sizeof *out);
+    if (!out) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+    out[0].labels = *lab;
+    for (int k = 0; k < n; k++) {
+        out[k].code = piece[k];
+        out[k + 1].labels = out[k].labels;
+        count_labels(piece[k], &out[k + 1].labels);
+    }
+    parallel_for(n, write_function_asm, out);
+    for (int k = 0; k < n; k++) {
+        fwrite(out[k].text, 1, out[k].len, f);
+        free(out[k].text);
+    }
+    *lab = out[n].labels;
+    free(out);
+    join_functions(piece, n);
+}
+
+void write_asm(FILE *f, const char *input_filename, struct instr *code) {
+    struct asm_labels lab = { 0 };
+    write_asm_data(f, input_filename);
+    write_functions(f, code, &lab);
+    fprintf(f, "\t.section .note.GNU-stack,\"\",@progbits\n");
+}
+
+static void assign_first(struct tree *t)
+{
+    if (!t) return;
+    
+    for(int i = 0; i < t->nkids; i++) {
+        assign_first(t->kids[i]);
+    }
+    
+    if (t->symbolname) {
+        if (strcmp(t->symbolname, "while_statement") == 0 ||
+            strcmp(t->symbolname, "if_statement") == 0 ||
+            strcmp(t->symbolname, "else_clause") == 0 ||
+            strcmp(t->symbolname, "for_statement") == 0) {
+            
+            struct addr *label = genlabel();
+            ATTR(t)->first = *label;
+            ATTR(t)->first_used = 1;
+            free(label); 
+            
+            printf("Assigned first label %d to %s node\n", 
+                        ATTR(t)->first.u.offset, t->symbolname);
+        }
+    }
+}
+
+static void assign_follow(struct tree *t)
+{
+    if (!t) return;
+    
+    if (t->symbolname) {
+        if (strcmp(t->symbolname, "while_statement") == 0 && t->nkids >= 2) {
+
+            struct tree *cond = t->kids[0];
+            struct tree *body = t->kids[1];
+            
+            if (cond && body) {
+                if (ATTR(cond)->first_used) {
+                    ATTR(body)->follow = ATTR(cond)->first;
+                    ATTR(body)->follow_used = 1;
+                } else {
+                    struct addr *loop_label = genlabel();
+                    ATTR(body)->follow = *loop_label;
+                    ATTR(body)->follow_used = 1;
+                    free(loop_label);
+                }
+                
+                if (ATTR(t)->follow_used) {
+                    ATTR(cond)->follow = ATTR(t)->follow;
+                    ATTR(cond)->follow_used = 1;
+                }
+            }
+        }
+        else if (strcmp(t->symbolname, "if_statement") == 0 && t->nkids >= 2) {
+
+            struct tree *cond = t->kids[0];
+            struct tree *then_clause = t->kids[1];
+            struct tree *else_clause = t->nkids > 2 ? t->kids[2] : NULL;
+            
+            if (cond && then_clause) {
+                if (ATTR(then_clause)->first_used) {
+                    ATTR(cond)->follow = ATTR(then_clause)->first;
+                    ATTR(cond)->follow_used = 1;
+                }
+                
+                if (ATTR(t)->follow_used) {
+                    ATTR(then_clause)->follow = ATTR(t)->follow;
+                    ATTR(then_clause)->follow_used = 1;
+                    
+                    if (else_clause) {
+                        ATTR(else_clause)->follow = ATTR(t)->follow;
+                        ATTR(else_clause)->follow_used = 1;
+                    }
+                }
+                
+                if (else_clause && ATTR(else_clause)->first_used) {
+                    ATTR(cond)->onFalse = ATTR(else_clause)->first;
+                    ATTR(cond)->onFalse_used = 1;
+                } else if (ATTR(t)->follow_used) {
+                    ATTR(cond)->onFalse = ATTR(t)->follow;
+                    ATTR(cond)->onFalse_used = 1;
+                }
+            }
+        }
+        else if (strcmp(t->symbolname, "statement_sequence") == 0 && t->nkids >= 2) {
+            for (int i = 0; i < t->nkids - 1; i++) {
+                if (t->kids[i] && t->kids[i+1] && ATTR(t->kids[i+1])->first_used) {
+                    ATTR(t->kids[i])->follow = ATTR(t->kids[i+1])->first;
+                    ATTR(t->kids[i])->follow_used = 1;
+                }
+            }
+            
+            if (t->nkids > 0 && t->kids[t->nkids-1] && ATTR(t)->follow_used) {
+                ATTR(t->kids[t->nkids-1])->follow = ATTR(t)->follow;
+                ATTR(t->kids[t->nkids-1])->follow_used = 1;
+            }
+        }
+    }
+    
+    for(int i = 0; i < t->nkids; i++) {
+        assign_follow(t->kids[i]);
+    }
+}
+
+static void assign_conditional_labels(struct tree *t)
+{
+    if (!t) return;
+    
+    if (t->symbolname) {
+        if (strcmp(t->symbolname, "comparison") == 0 || 
+            strcmp(t->symbolname, "logical_and") == 0 ||
+            strcmp(t->symbolname, "logical_or") == 0) {
+            
+            if (!ATTR(t)->onTrue_used) {
+                struct addr *true_label = genlabel();
+                ATTR(t)->onTrue = *true_label;
+                ATTR(t)->onTrue_used = 1;
+                free(true_label);
+            }
+            
+            if (!ATTR(t)->onFalse_used) {
+                struct addr *false_label = genlabel();
+                ATTR(t)->onFalse = *false_label;
+                ATTR(t)->onFalse_used = 1;
+                free(false_label);
+            }
+            
+            if (strcmp(t->symbolname, "logical_and") == 0 && t->nkids >= 2) {
+
+                ATTR(t->kids[0])->onFalse = ATTR(t)->onFalse;
+                ATTR(t->kids[0])->onFalse_used = 1;
+                
+                struct addr *second_label = genlabel();
+                ATTR(t->kids[0])->onTrue = *second_label;
+                ATTR(t->kids[0])->onTrue_used = 1;
+                free(second_label);
+                
+                ATTR(t->kids[1])->onTrue = ATTR(t)->onTrue;
+                ATTR(t->kids[1])->onTrue_used = 1;
+                ATTR(t->kids[1])->onFalse = ATTR(t)->onFalse;
+                ATTR(t->kids[1])->onFalse_used = 1;
+            }
+            else if (strcmp(t->symbolname, "logical_or") == 0 && t->nkids >= 2) {
+                ATTR(t->kids[0])->onTrue = ATTR(t)->onTrue;
+                ATTR(t->kids[0])->onTrue_used = 1;
+                
+                struct addr *second_label = genlabel();
+                ATTR(t->kids[0])->onFalse = *second_label;
+                ATTR(t->kids[0])->onFalse_used = 1;
+                free(second_label);
+                
+                ATTR(t->kids[1])->onTrue = ATTR(t)->onTrue;
+                ATTR(t->kids[1])->onTrue_used = 1;
+                ATTR(t->kids[1])->onFalse = ATTR(t)->onFalse;
+                ATTR(t->kids[1])->onFalse_used = 1;
+            }
+        }
+    }
+    
+    for(int i = 0; i < t->nkids; i++) {
+        assign_conditional_labels(t->kids[i]);
+    }
+}
+
+/* the first, follow and branch labels of every node under t */
+void assign_labels(struct tree *t) {
+    assign_first(t);
+    assign_follow(t);
+    assign_conditional_labels(t);
+}
+
+/*
+ * Streaming output: write_streamed generates the program one top-level
+ * declaration at a time instead of all at once.  Whenever a few thousand
+ * instructions have piled up they go through the passes and out as
+ * assembly (and .ic lines), and then their TAC and the syntax trees they
+ * came from are freed; so besides the trees not yet generated, only the
+ * symbol tables, the literal pools and one batch of code are ever held.
+ * The literal pools head the .s and the .ic but are only complete at the
+ * end, so the code is spooled to temporary files until then.
+ */
+#define STREAM_BATCH 4096   /* instructions optimized and written at a time */
+
+static FILE *spool_file(void) {
+    FILE *t = tmpfile();
+    if (!t) {
+        perror("tmpfile");
+        exit(4);
+    }
+    return t;
+}
+
+static void copy_spool(FILE *from, FILE *to) {
+    char buf[8192];
+    size_t n;
+    rewind(from);
+    while ((n = fread(buf, 1, sizeof buf, from)) > 0) fwrite(buf, 1, n, to);
+    fclose(from);
+}
+
+/*
+ * optimize a batch, write it to the spools and free it, along with every
+ * copy of its code made on the way
+ */
+static void flush_batch(struct instr *code, FILE *text, FILE *ic,
+                        struct asm_labels *lab) {
+    code = run_passes(code);
+    if (ic)
+        for (struct instr *i = code; i; i = i->next) output_instruction(ic, i);
+    write_functions(text, code, lab);
+    free_instrs();
+}
+
+void write_streamed(FILE *f, const char *input_filename, struct tree *root,
+                    int with_ic) {
+    FILE *text = spool_file(), *ic = with_ic ? spool_file() : NULL;
+    struct asm_labels lab = { 0 };
+    struct instr *batch = NULL, *tail = NULL;
+    long pending = 0, total = 0;
+
+    // the top-level objects, or the one object of a one-object file;
+    // copied, since the list node goes with the first release
+    struct tree **kids = &root;
+    int n = 1;
+    if (root && root->symbolname && strcmp(root->symbolname, "topLevelObjectList") == 0) {
+        kids = root->kids;
+        n = root->nkids;
+    }
+    struct tree **object = malloc(n * sizeof *object);
+    if (!object) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+    memcpy(object, kids, n * sizeof *object);
+    // each object was marked as the parser reduced it
+    int marked = declaration_count() == n;
+
+    for (int k = 0; k < n; k++) {
+        struct tree *t = object[k];
+        if (!t) continue;
+        int lo = 0, hi = node_count();
+        if (marked) declaration_ids(k, &lo, &hi);
+        alloc_node_attrs(lo, hi);
+        assign_labels(t);
+        generate_code(t);
+        for (struct instr *i = ATTR(t)->code; i; i = i->next) {
+            if (tail) tail->next = i;
+            else      batch = i;
+            tail = i;
+            pending++;
+        }
+        if (pending >= STREAM_BATCH) {
+            flush_batch(batch, text, ic, &lab);
+            if (marked) release_declarations(k);
+            total += pending;
+            batch = tail = NULL;
+            pending = 0;
+        }
+    }
+    free(object);
+    if (batch) flush_batch(batch, text, ic, &lab);
+    total += pending;
+
+    write_asm_data(f, input_filename);
+    copy_spool(text, f);
+    fprintf(f, "\t.section .note.GNU-stack,\"\",@progbits\n");
+
+    if (ic) {
+        FILE *out = open_ic_file(input_filename);
+        if (out) {
+            write_ic_data(out);
+            if (total == 0) fprintf(out, "/* No code generated */\n");
+            copy_spool(ic, out);
+            fclose(out);
+        } else {
+            fclose(ic);
+        }
+    }
+}
@@ -1,11 +1,19 @@
 #ifndef CODEGEN_H
 #define CODEGEN_H
 
+#include <stdio.h>
 #include "tree.h"
 
 void generate_code(struct tree *t);
+void assign_labels(struct tree *t);
 void write_ic_file(const char *input_filename, struct instr *code);
-void write_asm_file(const char *input_filename, struct instr *code);
+void write_asm(FILE *f, const char *input_filename, struct instr *code);
+void write_streamed(FILE *f, const char *input_filename, struct tree *root,
+                    int with_ic);
 struct addr empty_addr();
+void get_literals(struct tac_program *p);
+void free_literals(void);
+
+extern int target_avx2;
 
 #endif
\ No newline at end of file
@@ -0,0 +1,61 @@
+fun total(a: Array<Int>): Int {
+    return a.sum()
+}
+
+fun main() {
+    var n: Int = 1000
+    var a: Array<Int> = Array<Int>(n) {0}
+    var i: Int = 0
+    var x: Int = 12345
+    for (i in 0..n - 1) {
+        x = (x * 1103 + 12345) % 100003
+        a[i] = x - 50000
+    }
+    println("size ${a.size} sum ${a.sum()} total ${total(a)}\n")
+    println("min ${a.min()} max ${a.max()}\n")
+    val m: Int = a.max()
+    println("indexOf max ${a.indexOf(m)} missing ${a.indexOf(77777)}\n")
+    var b: Array<Int> = a.copyOf()
+    a.sort()
+    var sorted: Boolean = true
+    for (i in 1..n - 1) {
+        if (a[i - 1] > a[i]) {
+            sorted = false
+        }
+    }
+    println("sorted $sorted first ${a[0]} last ${a[n - 1]} same sum ${a.sum() == b.sum()}\n")
+    println("copy unchanged ${b[0] != a[0]}\n")
+    var c: Array<Int> = b.copyOf(1003)
+    println("padded ${c.size} ${c[1002]} ${c[999] == b[999]}\n")
+    var d: Array<Int> = b.copyOf(3)
+    println("short ${d.size} ${d[2] == b[2]}\n")
+    c.fill(7)
+    println("fill ${c.sum()} ${c.min()} ${c[1002]}\n")
+    var e: Array<Int> = Array<Int>(5) {9}
+    e[3] = -2
+    e.sort()
+    println("small ${e[0]} ${e[1]} ${e[4]} ${e.indexOf(9)}\n")
+    var f: Array<Double> = Array<Double>(n) {0.0}
+    var y: Double = 0.5
+    for (i in 0..n - 1) {
+        y = y * 3.7
+        if (y > 100.0) {
+            y = y - 199.3
+        }
+        f[i] = y
+    }
+    f[17] = -0.0
+    var g: Array<Double> = f.copyOf()
+    g.sort()
+    sorted = true
+    for (i in 1..n - 1) {
+        if (g[i - 1] > g[i]) {
+            sorted = false
+        }
+    }
+    println("double sorted $sorted min ${f.min() == g[0]} max ${f.max() == g[n - 1]}\n")
+    println("double indexOf ${f.indexOf(f[400])} ${f.indexOf(0.0)} ${f.indexOf(-0.0)} ${f.indexOf(2.0)}\n")
+    var h: Array<Double> = g.copyOf(2)
+    g.fill(0.25)
+    println("double fill ${g.sum()} ${h.size} ${h[0] == f.min()}\n")
+}
@@ -0,0 +1,13 @@
+fun main() {
+    var n: Int = 13
+    var z: Array<Int> = Array<Int>(n) {0}
+    var s: Array<Int> = Array<Int>(n) {7}
+    var k: Int = 3
+    var t: Array<Int> = Array<Int>(n) {k * 2 + 1}
+    var i: Int = 0
+    for (i in 0..12) {
+        println(z[i] + s[i] + t[i])
+    }
+    var b: Array<Int> = Array<Int>(3) {java.util.Random.nextInt()}
+    println("done\n")
+}
@@ -0,0 +1,54 @@
+fun countTrue(flags: Array<Boolean>, n: Int): Int {
+    var c: Int = 0
+    var i: Int = 0
+    for (i in 0..n - 1) {
+        if (flags[i]) {
+            c = c + 1
+        }
+    }
+    return c
+}
+
+fun main() {
+    var n: Int = 100
+    var b: Array<Byte> = Array<Byte>(n) {0}
+    var s: Array<Short> = Array<Short>(n) {-3}
+    var l: Array<Long> = Array<Long>(n) {-7}
+    var d: Array<Double> = Array<Double>(n) {0.5}
+    var z: Array<Double> = Array<Double>(4) {0.0}
+    var f: Array<Boolean> = Array<Boolean>(n) {false}
+    var t: Array<Boolean> = Array<Boolean>(70) {true}
+    var w: Array<String> = Array<String>(3) {"x"}
+    var i: Int = 0
+    for (i in 0..n - 1) {
+        b[i] = i * 3
+        d[i] = d[i] * 2.0 + 0.25
+    }
+    s[5] = 1000
+    l[99] = 123456
+    println("byte ${b[10]} ${b[42]} ${b[99]}\n")
+    println("short ${s[4]} ${s[5]} ${s.size}\n")
+    println("long ${l[0]} ${l[99]}\n")
+    println("double ${d[0]} ${d[99]} ${z[3]}\n")
+    var sieve: Int = 0
+    var j: Int = 0
+    for (i in 2..n - 1) {
+        if (!f[i]) {
+            sieve = sieve + 1
+            j = i * i
+            while (j < n) {
+                f[j] = true
+                j = j + i
+            }
+        }
+    }
+    println("primes below $n: $sieve, composite ${countTrue(f, n)}\n")
+    t[3] = false
+    t[64] = false
+    t[69] = false
+    println("bits ${t[2]} ${t[3]} ${t[63]} ${t[64]} ${t[68]} ${countTrue(t, 70)}\n")
+    w[1] = "yz"
+    println("strings ${w[0]}${w[1]}${w[2]}\n")
+    var c: Array<Int> = Array<Int>(n) {3}
+    println("int ${c[7]} ${c.sum()}\n")
+}
@@ -0,0 +1,54 @@
+// array index checks: loops whose indices are proven in range run unchecked,
+// anything else is checked and ends the program with an exception
+fun prefix(a: Array<Int>, n: Int): Int {
+    var i: Int = 0
+    // n is only known at run time: versioned on n <= a.size
+    for (i in 1..n - 1) {
+        a[i] = a[i] + a[i - 1]
+    }
+    return a[n - 1]
+}
+
+fun main() {
+    var n: Int = 10
+    var a: Array<Int> = Array<Int>(n) {0}
+    var b: Array<Int> = Array<Int>(n) {0}
+    var f: Array<Boolean> = Array<Boolean>(n) {false}
+    var i: Int = 0
+    var s: Int = 0
+
+    // 0..a.size - 1 and 0..<a.size are in range without a test
+    for (i in 0..a.size - 1) {
+        a[i] = i * i
+    }
+    for (i in 0..<a.size) {
+        s = s + a[i]
+    }
+    println("sum $s\n")
+
+    // neighbours: a[i - 1] and a[i + 1] need 1..size - 2
+    for (i in 1..a.size - 2) {
+        b[i] = a[i - 1] + a[i + 1]
+    }
+    println("b ${b[0]} ${b[1]} ${b[8]} ${b[9]}\n")
+
+    for (i in 0..<n) {
+        f[i] = a[i] % 2 == 0
+    }
+    s = 0
+    for (i in 0..n - 1) {
+        if (f[i]) {
+            s = s + 1
+        }
+    }
+    println("even $s\n")
+    println("prefix ${prefix(a, n)} ${prefix(b, 3)}\n")
+
+    // a range that fails the test runs checked and throws at a[10]
+    s = 0
+    for (i in 5..n) {
+        s = s + a[i]
+        println("a[$i] = ${a[i]}\n")
+    }
+    println("not reached $s\n")
+}
@@ -0,0 +1,40 @@
+fun main() {
+    var a: Int = 3
+    var b: Int = 7
+    var t: Boolean = true
+    if (a < b && b < 10) {
+        println("and\n")
+    }
+    if (a > b || b == 7) {
+        println("or\n")
+    }
+    if (!(a > b) && !t) {
+        println("wrong\n")
+    } else {
+        println("not\n")
+    }
+    if (a >= 3 && (b != 7 || a <= 3)) {
+        println("nested\n")
+    }
+    var both: Boolean = false
+    both = a < b && t
+    if (both) {
+        println("value\n")
+    }
+    var n: Int = 0
+    while (n < 10 && n * n < 20) {
+        n = n + 1
+    }
+    println(n)
+    while (false) {
+        println("never\n")
+    }
+    var c: Int = 0
+    var i: Int = 0
+    for (i in 1..20) {
+        if (i == 5 || i > 17) {
+            c = c + i
+        }
+    }
+    println(c)
+}
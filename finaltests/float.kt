@@ -21,5 +21,7 @@ fun main(){
     println(d)
     println("Integer addition of 1 and 2 but with function:\n")
     println(use_ints(2, 30))
+    println(3.14159265358979)
+    println(1.0E-7)
     return
 }
\ No newline at end of file
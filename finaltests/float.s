@@ -0,0 +1,169 @@
+	.file	"finaltests/float.kt"
+	.section	.data.rel.ro.local,"aw"
+	.align	8
+.LC0:
+	.quad	.LC0E-.LC0S-1
+	.quad	.LC0S
+.LC1:
+	.quad	.LC1E-.LC1S-1
+	.quad	.LC1S
+.LC2:
+	.quad	.LC2E-.LC2S-1
+	.quad	.LC2S
+.LC3:
+	.quad	.LC3E-.LC3S-1
+	.quad	.LC3S
+	.section	.rodata
+	.align	8
+.LC0S:
+	.string	"Double addition of 5.4 and 2.1:\n"
+.LC0E:
+.LC1S:
+	.string	"Double addition of 5.4 and 2.1 but with function:\n"
+.LC1E:
+.LC2S:
+	.string	"Integer addition of 1 and 2:\n"
+.LC2E:
+.LC3S:
+	.string	"Integer addition of 1 and 2 but with function:\n"
+.LC3E:
+.D0:
+	.double	5.4000000000000004
+.D1:
+	.double	2.1000000000000001
+.D2:
+	.double	3.14159265358979
+.D3:
+	.double	9.9999999999999995e-08
+	.text
+	.globl	use_double
+	.type	use_double, @function
+use_double:
+.LFB0:
+	.cfi_startproc
+	endbr64
+	pushq	%rbp
+	.cfi_def_cfa_offset 16
+	.cfi_offset 6, -16
+	movq	%rsp, %rbp
+	.cfi_def_cfa_register 6
+	subq	$48, %rsp
+	movsd	%xmm0, -8(%rbp)
+	movsd	%xmm1, -16(%rbp)
+	movsd	-8(%rbp), %xmm0
+	addsd	-16(%rbp), %xmm0
+	movsd	%xmm0, -32(%rbp)
+	movsd	-32(%rbp), %xmm0
+	movsd	%xmm0, -24(%rbp)
+	movsd	-24(%rbp), %xmm0
+	addq	$48, %rsp
+	leave
+	.cfi_def_cfa   7, 8
+	.cfi_endproc
+	ret
+.LFE0:
+	.size	use_double, .-use_double
+	.globl	use_ints
+	.type	use_ints, @function
+use_ints:
+.LFB1:
+	.cfi_startproc
+	endbr64
+	pushq	%rbp
+	.cfi_def_cfa_offset 16
+	.cfi_offset 6, -16
+	movq	%rsp, %rbp
+	.cfi_def_cfa_register 6
+	subq	$48, %rsp
+	movl	%edi, -8(%rbp)
+	movl	%esi, -16(%rbp)
+	movl	-8(%rbp), %eax
+	addl	-16(%rbp), %eax
+	movl	%eax, -32(%rbp)
+	movl	-32(%rbp), %eax
+	movl	%eax, -24(%rbp)
+	movl	-24(%rbp), %eax
+	addq	$48, %rsp
+	leave
+	.cfi_def_cfa   7, 8
+	.cfi_endproc
+	ret
+.LFE1:
+	.size	use_ints, .-use_ints
+	.globl	main
+	.type	main, @function
+main:
+.LFB2:
+	.cfi_startproc
+	endbr64
+	pushq	%rbp
+	.cfi_def_cfa_offset 16
+	.cfi_offset 6, -16
+	movq	%rsp, %rbp
+	.cfi_def_cfa_register 6
+	subq	$144, %rsp
+	movsd	.D0(%rip), %xmm0
+	movsd	%xmm0, -40(%rbp)
+	movsd	-40(%rbp), %xmm0
+	movsd	%xmm0, -8(%rbp)
+	movsd	.D1(%rip), %xmm0
+	movsd	%xmm0, -48(%rbp)
+	movsd	-48(%rbp), %xmm0
+	movsd	%xmm0, -16(%rbp)
+	movsd	-8(%rbp), %xmm0
+	movsd	-16(%rbp), %xmm1
+	call	use_double
+	movsd	%xmm0, -56(%rbp)
+	movsd	-56(%rbp), %xmm0
+	movsd	%xmm0, -24(%rbp)
+	leaq	.LC0(%rip), %rdi
+	call	k0_print_str
+	movsd	-24(%rbp), %xmm0
+	call	k0_println_double
+	leaq	.LC1(%rip), %rdi
+	call	k0_print_str
+	movsd	-8(%rbp), %xmm0
+	movsd	-16(%rbp), %xmm1
+	call	use_double
+	movsd	%xmm0, -64(%rbp)
+	movsd	-64(%rbp), %xmm0
+	call	k0_println_double
+	movl	$1, -72(%rbp)
+	movl	$2, -80(%rbp)
+	movl	-72(%rbp), %edi
+	movl	-80(%rbp), %esi
+	call	use_ints
+	movl	%eax, -88(%rbp)
+	movl	-88(%rbp), %eax
+	movl	%eax, -32(%rbp)
+	leaq	.LC2(%rip), %rdi
+	call	k0_print_str
+	movl	-32(%rbp), %edi
+	call	k0_println_int
+	leaq	.LC3(%rip), %rdi
+	call	k0_print_str
+	movl	$2, -96(%rbp)
+	movl	$30, -104(%rbp)
+	movl	-96(%rbp), %edi
+	movl	-104(%rbp), %esi
+	call	use_ints
+	movl	%eax, -112(%rbp)
+	movl	-112(%rbp), %edi
+	call	k0_println_int
+	movsd	.D2(%rip), %xmm0
+	movsd	%xmm0, -120(%rbp)
+	movsd	-120(%rbp), %xmm0
+	call	k0_println_double
+	movsd	.D3(%rip), %xmm0
+	movsd	%xmm0, -128(%rbp)
+	movsd	-128(%rbp), %xmm0
+	call	k0_println_double
+	xorl	%eax, %eax
+	addq	$144, %rsp
+	leave
+	.cfi_def_cfa   7, 8
+	.cfi_endproc
+	ret
+.LFE2:
+	.size	main, .-main
+	.section .note.GNU-stack,"",@progbits
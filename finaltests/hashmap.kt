@@ -0,0 +1,50 @@
+fun count(counts: HashMap<String, Int>, word: String) {
+    counts[word] = counts.getOrDefault(word, 0) + 1
+}
+
+fun main() {
+    val squares: HashMap<Int, Int> = HashMap()
+    var i: Int = 0
+    for (i in 1..1000) {
+        squares.put(i, i * i)
+    }
+    println("size ${squares.size}\n")
+    println("get ${squares.get(12)} ${squares[999]}\n")
+    println("missing ${squares[5000]} ${squares.getOrDefault(5000, -1)}\n")
+    println("has ${squares.containsKey(7)} ${squares.containsKey(1001)}\n")
+
+    var k: Int = 0
+    while (k < 1000) {
+        k = k + 2
+        squares.remove(k)
+    }
+    println("after remove ${squares.size} ${squares.containsKey(10)} ${squares.containsKey(11)}\n")
+
+    var sum: Int = 0
+    var key: Int = 0
+    for (key in squares.keys) {
+        sum = sum + key
+    }
+    println("key sum $sum\n")
+
+    squares[3] = squares[3] + 1
+    println("updated ${squares[3]} ${squares.size}\n")
+    println("removed ${squares.remove(3)} ${squares.remove(4)} ${squares.size}\n")
+
+    val counts: HashMap<String, Int> = HashMap()
+    count(counts, "a")
+    count(counts, "bb")
+    count(counts, "a")
+    count(counts, "c" + "cc")
+    count(counts, "b" + "b")
+    count(counts, "a")
+    println("words ${counts.size} a=${counts["a"]} bb=${counts["bb"]} d=${counts["d"]}\n")
+    var w: String = ""
+    var total: Int = 0
+    var letters: Int = 0
+    for (w in counts.keys) {
+        total = total + counts[w]
+        letters = letters + w.length
+    }
+    println("total $total letters $letters\n")
+}
@@ -0,0 +1,45 @@
+fun main() {
+    var i: Int = 0
+    var bad: Int = 0
+    var d: Int = 0
+    var x: Double = 0.0
+    while (i < 100000) {
+        d = java.util.Random.nextInt(10)
+        if (d < 0 || d >= 10) {
+            bad = bad + 1
+        }
+        x = java.util.Random.nextDouble()
+        if (x < 0.0 || x >= 1.0) {
+            bad = bad + 1
+        }
+        i = i + 1
+    }
+    println("out of range: ")
+    println(bad)
+    var one: Int = java.util.Random.nextInt(1)
+    println("nextInt(1): ")
+    println(one)
+    var h: Double = 0.5
+    var q: Double = 0.25
+    println("Double comparisons:\n")
+    if (q < h) {
+        println("True\n")
+    } else {
+        println("False\n")
+    }
+    if (h <= q) {
+        println("True\n")
+    } else {
+        println("False\n")
+    }
+    if (q == 0.25) {
+        println("True\n")
+    } else {
+        println("False\n")
+    }
+    if (h != q) {
+        println("True\n")
+    } else {
+        println("False\n")
+    }
+}
@@ -0,0 +1,25 @@
+fun main() {
+    var line: String = readln()
+    var n: Int = line.toInt()
+    var total: Int = 0
+    var i: Int = 0
+    while (i < n) {
+        line = readln()
+        total = total + line.toInt()
+        i = i + 1
+    }
+    println(total)
+    var x: Double = 0.0
+    line = readln()
+    x = line.toDouble()
+    println(x)
+    line = readln()
+    x = x + line.toDouble()
+    println(x)
+    line = readln()
+    println(line)
+    println("\n")
+    line = readln()
+    println(line)
+    println("\n")
+}
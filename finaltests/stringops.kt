@@ -0,0 +1,60 @@
+fun count(s: String, c: Int): Int {
+    var n: Int = 0
+    var i: Int = 0
+    while (i < s.length) {
+        if (s.get(i) == c) {
+            n = n + 1
+        }
+        i = i + 1
+    }
+    return n
+}
+fun longer(a: String, b: String): String {
+    if (a.length >= b.length) {
+        return a
+    }
+    return b
+}
+fun main() {
+    var s: String = "hello, world"
+    println("length: ")
+    println(s.length)
+    var w: String = s.substring(7, 12)
+    println("substring: ")
+    println(w)
+    println("\n")
+    var rest: String = s.substring(7)
+    println("substring to end: ")
+    println(rest.length)
+    println("get(0): ")
+    println(s.get(0))
+    println("count of l: ")
+    println(count(s, 108))
+    if (w == "world") {
+        println("== compares text\n")
+    }
+    if (w.equals(rest)) {
+        println("equals\n")
+    }
+    var a: String = "apple"
+    var b: String = "banana"
+    if (a < b) {
+        println("apple < banana\n")
+    }
+    println("compareTo: ")
+    println(a.compareTo(b))
+    println("longer: ")
+    println(longer(a, b))
+    println("\n")
+    var n: String = String.valueOf(42)
+    var d: String = String.valueOf(2.5)
+    println(n)
+    println("\n")
+    println(d)
+    println("\n")
+    var long1: String = "abcdefghijklmnopqrstuvwxyz0123456789"
+    var long2: String = "abcdefghijklmnopqrstuvwxyz0123456788"
+    if (long1 != long2) {
+        println("differ after 16 bytes\n")
+    }
+}
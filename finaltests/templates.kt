@@ -0,0 +1,31 @@
+fun label(n: Int): String {
+    return "item" + n
+}
+
+fun main() {
+    val name: String = "k0"
+    val n: Int = 42
+    val x: Double = 2.5
+    val ok: Boolean = true
+    println("hello, $name!\n")
+    println("n = $n, x = $x, ok = $ok\n")
+    println("sum ${n + 1} and ${n * 2 - 4}\n")
+    println("len ${name.length} of $name.length\n")
+    val s: String = name + " v" + n + "." + x
+    println(s)
+    println("\n")
+    println(1 + 2 + " three " + (4 + 5) + "\n")
+    println("nested ${"<$name>"} \$n $ cost\n")
+    println("call ${label(7)} ${label(n - 40)}\n")
+    var line: String = ""
+    var i: Int = 0
+    for (i in 1..3) {
+        line = line + i + ","
+    }
+    println("$line\n")
+    println("neg ${0 - n} ${0.0 - x}\n")
+    if ("a$n" == "a42") {
+        println("equal\n")
+    }
+    println("${n}${n}\n")
+}
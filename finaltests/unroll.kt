@@ -0,0 +1,28 @@
+fun main() {
+    var i: Int = 0
+    var j: Int = 0
+    var s: Int = 0
+    for (i in 3..6) {
+        println(i * i)
+    }
+    println(i)
+    for (i in 5..4) {
+        println(i)
+    }
+    println(i)
+    var n: Int = 0
+    while (n < 7) {
+        s = 0
+        for (i in 0..n - 1) {
+            s = s + i * 2
+        }
+        println(s)
+        n = n + 1
+    }
+    for (i in 1..3) {
+        for (j in 1..n) {
+            s = s + i * j
+        }
+    }
+    println(s)
+}
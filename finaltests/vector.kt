@@ -0,0 +1,81 @@
+fun main() {
+    var n: Int = 19
+    var a: Array<Int> = Array<Int>(n) {0}
+    var b: Array<Int> = Array<Int>(n) {0}
+    var c: Array<Int> = Array<Int>(n) {0}
+    var i: Int = 0
+    for (i in 0..n - 1) {
+        a[i] = i * 3 - 20
+        b[i] = 7 - i
+    }
+    var k: Int = 5
+    for (i in 0..n - 1) {
+        c[i] = a[i] * b[i]
+    }
+    for (i in 0..n - 1) {
+        println(c[i])
+    }
+    for (i in 2..n - 1) {
+        c[i] = a[i] + k
+    }
+    for (i in 0..n - 1) {
+        println(c[i])
+    }
+    for (i in 0..n - 1) {
+        c[i] = k - b[i]
+    }
+    for (i in 0..n - 1) {
+        println(c[i])
+    }
+    for (i in 0..n - 1) {
+        c[i] = 9
+    }
+    var s: Int = 100
+    for (i in 0..n - 1) {
+        s = s + c[i]
+    }
+    println(s)
+    for (i in 0..n - 1) {
+        s = a[i] + s
+    }
+    println(s)
+    var m: Int = 0
+    for (i in 0..n - 1) {
+        if (a[i] > m) {
+            m = a[i]
+        }
+    }
+    println(m)
+    for (i in 0..n - 1) {
+        if (m > a[i]) {
+            m = a[i]
+        }
+    }
+    println(m)
+    for (i in 0..n - 1) {
+        if (b[i] < m) {
+            m = b[i]
+        }
+    }
+    println(m)
+    for (i in 1..n - 2) {
+        c[i] = a[i] - b[i]
+    }
+    println(i)
+    var da: Array<Double> = Array<Double>(n) {0.5}
+    var db: Array<Double> = Array<Double>(n) {0.0}
+    var x: Double = 0.25
+    for (i in 0..n - 1) {
+        db[i] = da[i] * x - 1.0
+        x = x + 1.0
+    }
+    for (i in 0..n - 1) {
+        da[i] = da[i] + db[i]
+    }
+    println("${da[0]} ${da[7]} ${da[n - 1]}\n")
+    for (i in 0..n - 1) {
+        db[i] = x * da[i]
+    }
+    println("${db[0]} ${db[7]} ${db[n - 1]}\n")
+    println("done\n")
+}
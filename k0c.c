@@ -0,0 +1,34 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libgen.h>
+#include <unistd.h>
+
+#include "server.h"
+
+/*
+ * k0c: the thin client for k0 -server.  Takes the same arguments as k0
+ * and hands them, with its descriptors and working directory, to the
+ * server on $K0_SERVER, so a build that runs the compiler thousands of
+ * times pays for this small program instead of k0's startup.  With no
+ * server up it runs the k0 next to it instead.
+ */
+int main(int argc, char *argv[]) {
+    const char *server = getenv("K0_SERVER");
+    if (server && *server) {
+        int rc = submit(server, argc, argv);
+        if (rc >= 0) return rc;
+    }
+
+    char exe[1024];
+    ssize_t n = readlink("/proc/self/exe", exe, sizeof exe - 1);
+    if (n > 0) exe[n] = '\0';
+    else       snprintf(exe, sizeof exe, "%s", argv[0]);
+    char k0[1100];
+    snprintf(k0, sizeof k0, "%s/k0", dirname(exe));
+    argv[0] = k0;
+    execv(k0, argv);
+    perror(k0);
+    return 1;
+}
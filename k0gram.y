@@ -1,6 +1,7 @@
 %{
     #include <stdio.h>
     #include <stdlib.h>
+    #include <string.h>
     #include "tree.h"
     #include "type.h"
     #include "symtab.h"
@@ -11,6 +12,15 @@
     extern SymbolTable globalSymtab;
     extern SymbolTable currentFunctionSymtab;
 
+    /* list followed by item: a list node of this rule grows, anything else starts one */
+    static struct tree *extend_list(int prodrule, char *name, struct tree *list,
+                                    struct tree *item) {
+        if (list && !list->leaf && list->prodrule == prodrule &&
+            strcmp(list->symbolname, name) == 0)
+            return tree_append(list, item);
+        return alctree(prodrule, name, 2, list, item);
+    }
+
 %}
 
 %token <treeptr> RESERVED DOT COMMA LPAREN RPAREN LSQUARE RSQUARE
@@ -35,6 +45,7 @@
 %token <treeptr> IntegerLiteral RealLiteral FloatLiteral DoubleLiteral
 %token <treeptr> BooleanLiteral NullLiteral StringLiteral Identifier
 %token <treeptr> HexLiteral BinLiteral
+%token <treeptr> TEMPLATE_BEGIN TEMPLATE_END TEMPLATE_EXPR_BEGIN
 
 %type <treeptr> program topLevelObject topLevelObjectList declaration globalVariableDeclaration
 %type <treeptr> propertyDeclaration type functionDeclaration functionValueParameters
@@ -47,6 +58,7 @@
 %type <treeptr> unaryExpression boolExpression returnStatement typeAlias
 %type <treeptr> expressionList breakStatement continueStatement disjunction conjunction
 %type <treeptr> equality comparison logical_unary_expression arrayInitializer arrayAccess
+%type <treeptr> stringTemplate templateParts templatePart
 
 %start program
 
@@ -61,6 +73,9 @@
 %precedence FUNCTION_CALL_ARGS 
 %precedence EXPR  
 %precedence LOWER_THAN_FUNCTION_CALL_ARGS
+/* return "${x}..." returns the template rather than ending at return */
+%precedence BARE_RETURN
+%precedence TEMPLATE_BEGIN
 
 %union {
    struct tree *treeptr;
@@ -81,14 +96,14 @@ program:
 topLevelObjectList:
     topLevelObject { $$ = $1; }
     | topLevelObjectList nl_opt topLevelObject { 
-          $$ = alctree(101, "topLevelObjectList", 2, $1, $3); 
+          $$ = extend_list(101, "topLevelObjectList", $1, $3); 
           $$->type = NULL; 
       }
     ;
 
 topLevelObject:
-    declaration { $$ = $1; }
-    | globalVariableDeclaration { $$ = $1; }
+    declaration { $$ = $1; end_declaration(yychar != YYEMPTY); }
+    | globalVariableDeclaration { $$ = $1; end_declaration(yychar != YYEMPTY); }
     ;
 
 declaration:
@@ -133,6 +148,15 @@ type:
             $$->type = typeptr_name($1->leaf->text);
         }
     }
+    | Identifier LANGLE type COMMA type RANGLE {
+        $$ = alctree(106, "mapType", 3, $1, $3, $5);
+        $$->is_nullable = 0;
+        if (strcmp($1->leaf->text, "HashMap") == 0 ||
+            strcmp($1->leaf->text, "MutableMap") == 0)
+            $$->type = alcmaptype($3, $5);
+        else
+            $$->type = typeptr_name($1->leaf->text);
+    }
     | Identifier LANGLE type RANGLE QUEST_NO_WS { 
          $$ = alctree(105, "nullableGenericType", 2, $1, $3); 
          $$->is_nullable = 1;
@@ -162,7 +186,7 @@ functionParameterList_opt:
     /* epsilon */ { $$ = NULL; }
     | functionValueParameter { $$ = $1; }
     | functionParameterList_opt COMMA functionValueParameter { 
-          $$ = alctree(109, "functionParameterList", 2, $1, $3); 
+          $$ = extend_list(109, "functionParameterList", $1, $3); 
           $$->type = NULL;
     }
     ;
@@ -190,7 +214,7 @@ block:
 statements:
     nl_opt statement nl_opt { $$ = $2; }
     | statements nl_opt statement { 
-          $$ = alctree(112, "statements", 2, $1, $3); 
+          $$ = extend_list(112, "statements", $1, $3); 
           $$->type = NULL;
       }
     ;
@@ -228,6 +252,8 @@ forStatement:
         { $$ = alctree(FOR, "forStatementKotlinRange", 4, $3, $5, $7, $9); $$->type = NULL; }
     | FOR LPAREN Identifier IN expression RANGE_UNTIL expression RPAREN controlStructureBody nl_opt
         { $$ = alctree(FOR, "forStatementKotlinRangeUntil", 4, $3, $5, $7, $9); $$->type = NULL; }
+    | FOR LPAREN Identifier IN expression RPAREN controlStructureBody
+        { $$ = alctree(FOR, "forStatementKotlinIn", 3, $3, $5, $7); $$->type = NULL; }
     ;
 
 whileStatement:
@@ -449,7 +475,7 @@ multiVariableDeclaration:
 variableDeclarationList:
     variableDeclaration { $$ = $1; }
     | variableDeclarationList COMMA nl_opt variableDeclaration { 
-         $$ = alctree(113, "variableDeclarationList", 2, $1, $4); 
+         $$ = extend_list(113, "variableDeclarationList", $1, $4); 
          $$->type = NULL; 
       }
     ;
@@ -468,7 +494,9 @@ additive_expression:
     | additive_expression ADD multiplicative_expression {
         $$ = alctree(114, "additive_expression", 2, $1, $3);
         $$->prodrule = ADD;  
-        if (check_type_compatibility($1->type, $3->type))
+        if ($1->type == string_typeptr || $3->type == string_typeptr)
+            $$->type = string_typeptr;
+        else if (check_type_compatibility($1->type, $3->type))
             $$->type = $1->type;
         else
             $$->type = double_typeptr;
@@ -486,7 +514,7 @@ additive_expression:
 
 expressionList:
     expression { $$ = alctree(116, "expressionList", 1, $1); }
-    | expressionList COMMA expression { $$ = alctree(117, "expressionList", 2, $1, $3); }
+    | expressionList COMMA expression { $$ = extend_list(117, "expressionList", $1, $3); }
     ;
 
 multiplicative_expression:
@@ -543,6 +571,7 @@ primary_expression:
          $$ = alctree(StringLiteral, "StringLiteral", 1, $1); 
          $$->type = string_typeptr; 
     }
+    | stringTemplate { $$ = $1; }
     | Identifier {
         $$ = alctree(Identifier, "Identifier", 1, $1);
 
@@ -577,6 +606,35 @@ functionCallArguments:
     | expressionList { $$ = $1; }
     ;
 
+stringTemplate:
+    TEMPLATE_BEGIN templateParts TEMPLATE_END {
+         $$ = alctree(400, "stringTemplate", 1, $2);
+         $$->type = string_typeptr;
+    }
+    ;
+
+templateParts:
+    templatePart { $$ = $1; }
+    | templateParts templatePart { $$ = extend_list(401, "templateParts", $1, $2); }
+    ;
+
+templatePart:
+    StringLiteral {
+         $$ = alctree(StringLiteral, "StringLiteral", 1, $1);
+         $$->type = string_typeptr;
+    }
+    | Identifier {
+        $$ = alctree(Identifier, "Identifier", 1, $1);
+
+        SymbolTableEntry entry = lookup_symbol(currentFunctionSymtab, $1->leaf->text);
+        if (!entry && globalSymtab)
+            entry = lookup_symbol(globalSymtab, $1->leaf->text);
+        if (entry && entry->type)
+            $$->type = entry->type;
+    }
+    | TEMPLATE_EXPR_BEGIN expression RCURL { $$ = $2; }
+    ;
+
 arrayAccess:
     primary_expression LSQUARE expression RSQUARE { 
          $$ = alctree(300, "arrayAccess", 2, $1, $3); 
@@ -592,8 +650,8 @@ arrayInitializer:
     ;
 
 returnStatement:
-    RETURN expression { $$ = $2; }
-    | RETURN { $$ = alctree(RETURN, "returnStatement", 0); $$->type = NULL; }
+    RETURN expression { $$ = alctree(RETURN, "returnStatement", 1, $2); }
+    | RETURN %prec BARE_RETURN { $$ = alctree(RETURN, "returnStatement", 0); $$->type = NULL; }
     ;
 
 typeAlias:
@@ -1,5 +1,7 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
 #include <math.h>
 #include <ctype.h>
@@ -7,20 +9,33 @@
 #include <unistd.h>
 #include <errno.h>
 #include <stdbool.h>
+#include <dlfcn.h>
+#include <signal.h>
+#include <sys/wait.h>
 #include "k0gram.tab.h"
 #include "semantics.h"
 #include "tree.h"
 #include "symtab.h"
 #include "codegen.h"
+#include "unroll.h"
+#include "passes.h"
+#include "asm.h"
+#include "vm.h"
+#include "server.h"
+#include "parallel.h"
+#include "source.h"
+#include "runtime/k0rt.h"
 #define EXTENSION ".kt"
 
 extern int yylex();
 extern int yyparse();
 extern char *yytext;
-extern FILE *yyin;
 extern int yylineno;
+extern void lex_from_buffer(char *base, size_t size);
+extern void lex_done(void);
 extern char *current_filename;
 extern struct tree *root;
+extern int labelcounter;
 
 char *current_filename = NULL;
 
@@ -30,48 +45,184 @@ char last_token[256] = "";
 
 SymbolTable globalSymtab;
 
-struct tokenlist {
-    struct token *t;
-    struct tokenlist *next;
+/* asprintf that cannot fail: file names, commands and qualified names
+   are as long as they need */
+char *strprintf(const char *fmt, ...) {
+    char *s;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vasprintf(&s, fmt, ap);
+    va_end(ap);
+    if (n < 0) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+    return s;
+}
+
+/* directory holding libk0rt.a: $K0_RUNTIME, else runtime/ beside k0 */
+static char *runtime_dir;
+
+static void find_runtime(const char *argv0) {
+    const char *env = getenv("K0_RUNTIME");
+    if (env && *env) {
+        runtime_dir = strprintf("%s", env);
+        return;
+    }
+    char *exe = realpath("/proc/self/exe", NULL);
+    if (!exe) exe = strprintf("%s", argv0);
+    runtime_dir = strprintf("%s/runtime", dirname(exe));
+    free(exe);
+}
+
+static bool stop_at_asm   = false;  /* -s: stop after emitting .s */
+static bool integrated_as = true;   /* -no-integrated-as: always run as */
+static bool assembled     = false;  /* the integrated assembler wrote the .o */
+static bool run_program   = false;  /* -run: compile into memory and call main */
+static int (*jit_main)(void);       /* -run: main in memory, NULL if not assembled */
+static bool run_vm        = false;  /* -vm: run the TAC on the interpreter in vm.c */
+
+/* "dir/foo.kt" -> "dir/foo<ext>", malloc'd */
+static char *output_name(const char *in, const char *ext) {
+    int n = strlen(in);
+    const char *dot = strrchr(in, '.');
+    if (dot && !strchr(dot, '/')) n = dot - in;
+    return strprintf("%.*s%s", n, in, ext);
+}
+
+/*
+ * What the assembly is made from.  Normally that is the tree: its
+ * functions are generated, optimized and written one batch at a time
+ * (write_streamed in codegen.c), and the .ic is written along the way if
+ * asked for.  -dot needs the whole code list first for the TAC graph, so
+ * then code is that list, already optimized.
+ */
+struct program {
+    struct tree *root;
+    struct instr *code;
+    bool ic;            /* write the .ic too */
 };
 
-struct tokenlist *head = NULL;
-struct tokenlist *tail = NULL;
+static void write_program(FILE *f, struct program *p) {
+    if (p->code) {
+        write_asm(f, current_filename, p->code);
+        if (p->ic) write_ic_file(current_filename, p->code);
+    } else {
+        write_streamed(f, current_filename, p->root, p->ic);
+    }
+}
 
-static void finish_and_emit(const char *stem, bool emit_asm, bool emit_obj) {
-    char sfile[512], ofile[512], cmd[2048];
-    size_t need;
+static void write_s_file(const char *text, size_t len) {
+    char *sfile = output_name(current_filename, ".s");
+    FILE *f = fopen(sfile, "w");
+    if (!f || fwrite(text, 1, len, f) != len) perror(sfile);
+    if (f) fclose(f);
+    free(sfile);
+}
+
+/*
+ * Assembly text to the .o through the integrated assembler (asm.c); if it
+ * meets something it cannot encode, the .s is written instead and
+ * finish_and_emit runs as on it.
+ */
+static void emit_text(const char *text, size_t len) {
+    char *ofile = output_name(current_filename, ".o");
+    assembled = assemble_elf(text, len, ofile) == 0;
+    free(ofile);
+    if (!assembled) write_s_file(text, len);
+}
+
+/*
+ * Assembly for the program.  Normally it never reaches the disk: the
+ * text goes through the integrated assembler straight into the .o.  The
+ * .s is written for -s, for -no-integrated-as, and when the integrated
+ * assembler gives up.
+ */
+static void emit_code(struct program *p) {
+    char *text = NULL;
+    size_t len = 0;
+    FILE *f;
+
+    assembled = false;
+    if (stop_at_asm || !integrated_as || !(f = open_memstream(&text, &len))) {
+        char *sfile = output_name(current_filename, ".s");
+        if (!(f = fopen(sfile, "w"))) {
+            perror(sfile);
+            free(sfile);
+            return;
+        }
+        free(sfile);
+        write_program(f, p);
+        fclose(f);
+        return;
+    }
+    write_program(f, p);
+    fclose(f);
+    emit_text(text, len);
+    free(text);
+}
+
+/* k0 links the runtime in, so the program's calls resolve to k0's copy */
+static void *runtime_symbol(const char *name) {
+    return dlsym(RTLD_DEFAULT, name);
+}
 
-    /* build names "<stem>.s" and "<stem>.o" */
-    snprintf(sfile, sizeof sfile, "%s.s", stem);
-    snprintf(ofile, sizeof ofile, "%s.o", stem);
+/*
+ * -run: assemble straight into executable memory; main() calls the
+ * result once the compiler has cleaned up.  Nothing is written unless
+ * the integrated assembler gives up (or is off), and then the program is
+ * built the normal way and exec'd.
+ */
+static void run_code(struct program *p) {
+    char *text = NULL;
+    size_t len = 0;
+    FILE *f = integrated_as ? open_memstream(&text, &len) : NULL;
+
+    jit_main = NULL;
+    if (!f) {
+        emit_code(p);
+        return;
+    }
+    write_program(f, p);
+    fclose(f);
+    jit_main = (int (*)(void))assemble_jit(text, len, "main", runtime_symbol);
+    assembled = false;
+    if (!jit_main) {
+        if (stop_at_asm) write_s_file(text, len);
+        else             emit_text(text, len);
+    }
+    free(text);
+}
 
+static void finish_and_emit(const char *stem, bool emit_asm, bool emit_obj) {
     /* if user only wanted the .s, stop here */
     if (emit_asm) return;
 
-    /* 1) assemble → .o */
-    need = strlen(sfile) + strlen(ofile) + sizeof("as  -o ") + 1;
-    if (need > sizeof cmd) {
-        fprintf(stderr, "error: command line too long\n");
-        exit(1);
-    }
-    snprintf(cmd, sizeof cmd, "as %s -o %s", sfile, ofile);
-    if (system(cmd) != 0) {
-        fprintf(stderr, "error: assembler failed\n");
-        exit(1);
+    /* 1) assemble "<stem>.s" → "<stem>.o", unless emit_code already did */
+    if (!assembled) {
+        char *cmd = strprintf("as %s.s -o %s.o", stem, stem);
+        int failed = system(cmd) != 0;
+        free(cmd);
+        if (failed) {
+            fprintf(stderr, "error: assembler failed\n");
+            exit(1);
+        }
     }
 
     /* if user only wanted the .o, stop here */
     if (emit_obj) return;
 
-    /* 2) link → executable named "stem" */
-    need = strlen(ofile) + strlen(stem) + sizeof("cc  -o ") + 1;
-    if (need > sizeof cmd) {
-        fprintf(stderr, "error: command line too long\n");
+    /* 2) link against the k0 runtime → executable named "stem" */
+    char *lib = strprintf("%s/libk0rt.a", runtime_dir);
+    if (access(lib, R_OK) != 0) {
+        fprintf(stderr, "error: k0 runtime %s not found (set K0_RUNTIME)\n", lib);
         exit(1);
     }
-    snprintf(cmd, sizeof cmd, "cc %s -lm -o %s", ofile, stem);
-    if (system(cmd) != 0) {
+    free(lib);
+    char *cmd = strprintf("cc %s.o -L%s -lk0rt -lm -o %s", stem, runtime_dir, stem);
+    int failed = system(cmd) != 0;
+    free(cmd);
+    if (failed) {
         fprintf(stderr, "error: linker failed\n");
         exit(1);
     }
@@ -83,23 +234,15 @@ void yyerror(const char *s) {
     fprintf(stderr, "\nError #%d at line %d: %s\n", error_count, yylineno, s);
     fprintf(stderr, "Near token: '%s'\n", near_text);
 
-    FILE *f = fopen(current_filename, "r");
-    if (f) {
-        char line[1024];
-        int current_line = 1;
-        while (fgets(line, sizeof(line), f) && current_line <= yylineno) {
-            if (current_line == yylineno) {
-                fprintf(stderr, "Line %d: %s", yylineno, line);
-                int i;
-                for (i = 0; i < strlen("Line ") + floor(log10(yylineno)) + 2; i++) {
-                    fprintf(stderr, " ");
-                }
-                fprintf(stderr, "^\n");
-                break;
-            }
-            current_line++;
+    size_t len;
+    const char *line = source_line(yylineno, &len);
+    if (line) {
+        fprintf(stderr, "Line %d: %.*s\n", yylineno, (int)len, line);
+        int i;
+        for (i = 0; i < strlen("Line ") + floor(log10(yylineno)) + 2; i++) {
+            fprintf(stderr, " ");
         }
-        fclose(f);
+        fprintf(stderr, "^\n");
     }
 
     if (strstr(s, "syntax error")) {
@@ -119,53 +262,15 @@ void yyerror(const char *s) {
     }
 }
 
-void add_extension_if_needed(char *filename) {
+/* filename, with EXTENSION added if it does not end in it; malloc'd */
+char *add_extension_if_needed(const char *filename) {
     size_t len = strlen(filename);
 
     if (len >= 3 && strcmp(filename + len - 3, EXTENSION) == 0) {
-        return;
-    }
-
-    strcat(filename, EXTENSION);
-}
-
-char *process_escape_sequences(const char *input) {
-    size_t len = strlen(input);
-    
-    if (len < 2 || (input[0] != '"' && input[0] != '\'')) {
-        return strdup(input);
-    }
-
-    char *output = malloc(len - 1);
-    if (!output) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(1);
-    }
-
-    char *dest = output;
-    const char *src = input + 1;
-
-    while (*src && *(src + 1)) {
-        if (*src == '\\' && *(src + 1)) {
-            src++;
-            switch (*src) {
-                case 't': *dest = '\t'; break;
-                case 'n': *dest = '\n'; break;
-                case 'r': *dest = '\r'; break;
-                case '\\': *dest = '\\'; break;
-                case '"': *dest = '\"'; break;
-                case '\'': *dest = '\''; break;
-                default: *dest = *src; break;
-            }
-        } else {
-            *dest = *src;
-        }
-        dest++;
-        src++;
+        return strprintf("%s", filename);
     }
 
-    *dest = '\0';
-    return output;
+    return strprintf("%s%s", filename, EXTENSION);
 }
 
 void update_last_token(const char *token_text) {
@@ -173,239 +278,36 @@ void update_last_token(const char *token_text) {
     last_token[sizeof(last_token) - 1] = '\0';
 }
 
-void add_token(int category, char *text, int lineno, const char *filename) {
-    update_last_token(text);  
-    
-    struct token *new_token = malloc(sizeof(struct token));
-    struct tokenlist *new_node = malloc(sizeof(struct tokenlist));
-
-    new_token->category = category;
-    new_token->text = strdup(text);
-    new_token->lineno = lineno;
-    new_token->filename = strdup(filename);
-
-    new_token->value.ival = 0;
-    new_token->value.dval = 0.0;
-    new_token->value.sval = NULL;
-    if (category == IntegerLiteral) {
-        new_token->value.ival = atoi(text);
-    } 
-    else if (category == RealLiteral) {
-        new_token->value.dval = atof(text);
-    }
-    else if (category == StringLiteral) {
-        new_token->value.sval = process_escape_sequences(text);
-    }
-
-    new_node->t = new_token;
-    new_node->next = NULL;
-
-    if (tail) {
-        tail->next = new_node;
-        tail = new_node;
-    } else {
-        head = tail = new_node;
-    }
-}
-
-void free_tokens() {
-    struct tokenlist *current = head;
-    while (current) {
-        struct tokenlist *next = current->next;
-        free(current->t->text);
-        free(current->t->filename);
-        if (current->t->category == StringLiteral) free(current->t->value.sval);
-        free(current->t);
-        free(current);
-        current = next;
-    }
-    head = tail = NULL; 
-}
-
-void assign_first(struct tree *t)
-{
-    if (!t) return;
-    
-    for(int i = 0; i < t->nkids; i++) {
-        assign_first(t->kids[i]);
-    }
-    
-    if (t->symbolname) {
-        if (strcmp(t->symbolname, "while_statement") == 0 ||
-            strcmp(t->symbolname, "if_statement") == 0 ||
-            strcmp(t->symbolname, "else_clause") == 0 ||
-            strcmp(t->symbolname, "for_statement") == 0) {
-            
-            struct addr *label = genlabel();
-            t->first = *label;
-            t->first_used = 1;
-            free(label); 
-            
-            printf("Assigned first label %d to %s node\n", 
-                        t->first.u.offset, t->symbolname);
-        }
-    }
-}
-
-void assign_follow(struct tree *t)
-{
-    if (!t) return;
-    
-    if (t->symbolname) {
-        if (strcmp(t->symbolname, "while_statement") == 0 && t->nkids >= 2) {
-
-            struct tree *cond = t->kids[0];
-            struct tree *body = t->kids[1];
-            
-            if (cond && body) {
-                if (cond->first_used) {
-                    body->follow = cond->first;
-                    body->follow_used = 1;
-                } else {
-                    struct addr *loop_label = genlabel();
-                    body->follow = *loop_label;
-                    body->follow_used = 1;
-                    free(loop_label);
-                }
-                
-                if (t->follow_used) {
-                    cond->follow = t->follow;
-                    cond->follow_used = 1;
-                }
-            }
-        }
-        else if (strcmp(t->symbolname, "if_statement") == 0 && t->nkids >= 2) {
-
-            struct tree *cond = t->kids[0];
-            struct tree *then_clause = t->kids[1];
-            struct tree *else_clause = t->nkids > 2 ? t->kids[2] : NULL;
-            
-            if (cond && then_clause) {
-                if (then_clause->first_used) {
-                    cond->follow = then_clause->first;
-                    cond->follow_used = 1;
-                }
-                
-                if (t->follow_used) {
-                    then_clause->follow = t->follow;
-                    then_clause->follow_used = 1;
-                    
-                    if (else_clause) {
-                        else_clause->follow = t->follow;
-                        else_clause->follow_used = 1;
-                    }
-                }
-                
-                if (else_clause && else_clause->first_used) {
-                    cond->onFalse = else_clause->first;
-                    cond->onFalse_used = 1;
-                } else if (t->follow_used) {
-                    cond->onFalse = t->follow;
-                    cond->onFalse_used = 1;
-                }
-            }
-        }
-        else if (strcmp(t->symbolname, "statement_sequence") == 0 && t->nkids >= 2) {
-            for (int i = 0; i < t->nkids - 1; i++) {
-                if (t->kids[i] && t->kids[i+1] && t->kids[i+1]->first_used) {
-                    t->kids[i]->follow = t->kids[i+1]->first;
-                    t->kids[i]->follow_used = 1;
-                }
-            }
-            
-            if (t->nkids > 0 && t->kids[t->nkids-1] && t->follow_used) {
-                t->kids[t->nkids-1]->follow = t->follow;
-                t->kids[t->nkids-1]->follow_used = 1;
-            }
-        }
-    }
-    
-    for(int i = 0; i < t->nkids; i++) {
-        assign_follow(t->kids[i]);
-    }
-}
-
-void assign_conditional_labels(struct tree *t)
-{
-    if (!t) return;
-    
-    if (t->symbolname) {
-        if (strcmp(t->symbolname, "comparison") == 0 || 
-            strcmp(t->symbolname, "logical_and") == 0 ||
-            strcmp(t->symbolname, "logical_or") == 0) {
-            
-            if (!t->onTrue_used) {
-                struct addr *true_label = genlabel();
-                t->onTrue = *true_label;
-                t->onTrue_used = 1;
-                free(true_label);
-            }
-            
-            if (!t->onFalse_used) {
-                struct addr *false_label = genlabel();
-                t->onFalse = *false_label;
-                t->onFalse_used = 1;
-                free(false_label);
-            }
-            
-            if (strcmp(t->symbolname, "logical_and") == 0 && t->nkids >= 2) {
+/* the predefined names; a compile server builds them once for every request */
+static SymbolTable builtins;
 
-                t->kids[0]->onFalse = t->onFalse;
-                t->kids[0]->onFalse_used = 1;
-                
-                struct addr *second_label = genlabel();
-                t->kids[0]->onTrue = *second_label;
-                t->kids[0]->onTrue_used = 1;
-                free(second_label);
-                
-                t->kids[1]->onTrue = t->onTrue;
-                t->kids[1]->onTrue_used = 1;
-                t->kids[1]->onFalse = t->onFalse;
-                t->kids[1]->onFalse_used = 1;
-            }
-            else if (strcmp(t->symbolname, "logical_or") == 0 && t->nkids >= 2) {
-                t->kids[0]->onTrue = t->onTrue;
-                t->kids[0]->onTrue_used = 1;
-                
-                struct addr *second_label = genlabel();
-                t->kids[0]->onFalse = *second_label;
-                t->kids[0]->onFalse_used = 1;
-                free(second_label);
-                
-                t->kids[1]->onTrue = t->onTrue;
-                t->kids[1]->onTrue_used = 1;
-                t->kids[1]->onFalse = t->onFalse;
-                t->kids[1]->onFalse_used = 1;
-            }
-        }
-    }
-    
-    for(int i = 0; i < t->nkids; i++) {
-        assign_conditional_labels(t->kids[i]);
-    }
+static SymbolTable builtin_symtab(void) {
+    SymbolTable st = mksymtab(50, NULL);
+    set_package_scope_name(st, "global");
+    add_predefined_symbols(st);
+    return st;
 }
 
 int process_file(char *filename, int print_tree, int print_symtab, int generate_dot) {
-    char filepath[256];
-    strncpy(filepath, filename, sizeof(filepath) - 1);
-    filepath[sizeof(filepath) - 1] = '\0';
-
-    add_extension_if_needed(filepath);
-    current_filename = strdup(filepath);
+    char *filepath = add_extension_if_needed(filename);
+    current_filename = filepath;
 
-    yyin = fopen(filepath, "r");
-    if (!yyin) {
+    if (map_source(filepath) != 0) {
         perror("Error opening file");
+        free(current_filename);
         return EXIT_FAILURE;
     }
+    size_t scan_size;
+    char *scan = source_buffer(&scan_size);
+    lex_from_buffer(scan, scan_size);
 
-    printf("Processing file: %s\n", filepath);
+    if (!run_program && !run_vm) printf("Processing file: %s\n", filepath);
 
-    globalSymtab = mksymtab(50, NULL);
-    set_package_scope_name(globalSymtab, "global");
+    globalSymtab = builtins ? builtins : builtin_symtab();
+    currentFunctionSymtab = NULL;   // the last file's scopes are freed
+    labelcounter = 0;
     SymbolTable packageSymtab = mksymtab(50, globalSymtab);
     set_package_scope_name(packageSymtab, "main"); 
-    add_predefined_symbols(globalSymtab);
 
     error_count = 0;
     yylineno = 1;
@@ -436,25 +338,35 @@ int process_file(char *filename, int print_tree, int print_symtab, int generate_
                 printf("Syntax tree for %s:\n", filepath);
                 printtree(root, 0);
             }
-            assign_first(root);
-        
-            assign_follow(root);
-            
-            assign_conditional_labels(root);
-            generate_code(root);
+            struct program prog = { root, NULL, !run_program };
+            if (generate_dot || run_vm) {
+                alloc_node_attrs(0, node_count());
+                assign_labels(root);
+                generate_code(root);
+                prog.code = ATTR(root)->code;
+            }
             if (generate_dot) {
-                char dot_filename[300];
-                snprintf(dot_filename, sizeof(dot_filename), "%s.dot", filepath);
+                char *dot_filename = strprintf("%s.dot", filepath);
                 print_graph(root, dot_filename);
                 printf("DOT file generated: %s\n", dot_filename);
+                free(dot_filename);
             
-                char tac_dot_filename[300];
-                snprintf(tac_dot_filename, sizeof(tac_dot_filename), "%sTAC.dot", filepath);
+                char *tac_dot_filename = strprintf("%sTAC.dot", filepath);
                 print_graph_TAC(root, tac_dot_filename);
                 printf("TAC DOT file generated: %s\n", tac_dot_filename);
+                free(tac_dot_filename);
+            }
+            if (prog.code) ATTR(root)->code = prog.code = run_passes(prog.code);
+            if (run_vm) {
+                if (print_stats) print_pass_stats(stderr);
+                struct tac_program tp = { prog.code };
+                get_literals(&tp);
+                fflush(stdout);
+                exit(vm_run(&tp));
             }
-            write_asm_file(current_filename, root->code);
-            write_ic_file(current_filename, root->code);
+            if (run_program) run_code(&prog);
+            else             emit_code(&prog);
+            if (print_stats) print_pass_stats(stderr);
         } else {
             fprintf(stderr, "\nParsing completed with %d semantic error(s)\n", error_count);
             parse_result = 3;  
@@ -468,67 +380,261 @@ int process_file(char *filename, int print_tree, int print_symtab, int generate_
         fprintf(stderr, "\nParsing failed with %d error(s)\n", error_count);
     }
 
-    fclose(yyin);
+    lex_done();
+    unmap_source();
     free(current_filename);
     free_symbol_table(packageSymtab);
-    free_symbol_table(globalSymtab);
-    freetree(root);
+    if (globalSymtab != builtins) free_symbol_table(globalSymtab);
+    free_trees();
     root = NULL;
-    free_tokens();
+    free_instrs();
+    free_literals();
+    free_interned();
 
     return parse_result;
 }
 
-int main(int argc, char *argv[]) {
+/* one input file through to its .s, .o or executable; process_file's result */
+static int compile_file(char *file, int print_tree, int print_symtab,
+                        int generate_dot, bool flag_c) {
+    /* 1) parse/semantic/generate code + write out `stem.o` (or `stem.s`) */
+    int r = process_file(file,
+                         print_tree,
+                         print_symtab,
+                         generate_dot);
+    if (r) return r;
+
+    /* 2) strip extension: "foo.kt" → "foo" */
+    char *stem = output_name(file, "");
+
+    if (run_program) {
+        /* the program's exit status is ours, as if it had been exec'd */
+        fflush(stdout);
+        if (jit_main) exit(jit_main());
+        finish_and_emit(stem, false, false);
+        char *exe = strprintf("%s%s", strchr(stem, '/') ? "" : "./", stem);
+        execl(exe, exe, (char *)NULL);
+        perror(exe);
+        exit(1);
+    }
+
+    /* 3) assemble/link as needed */
+    finish_and_emit(stem, stop_at_asm, flag_c);
+    free(stem);
+    return 0;
+}
+
+/*
+ * -j N: each file is compiled, assembled and linked in a process of its
+ * own, up to N at a time.  A worker's stdout and stderr go to temporary
+ * files that are copied out in command-line order, so the output is what
+ * a serial run prints (process_file resets the symbol table, label and
+ * literal state between files, so that matches too).  A front-end error
+ * in one file does not stop the
+ * others; an assembler or linker failure (exit(1) in finish_and_emit)
+ * ends the run at that file, as it would serially.
+ */
+#define JOB_FRONTEND 64     /* worker exit status: 64 + process_file's result */
+
+struct job {
+    char *file;
+    pid_t pid;
+    FILE *out, *err;
+    int status;
+    bool done;
+};
+
+static void copy_out(FILE *from, FILE *to) {
+    char buf[8192];
+    size_t n;
+    rewind(from);
+    while ((n = fread(buf, 1, sizeof buf, from)) > 0) fwrite(buf, 1, n, to);
+    fclose(from);
+    fflush(to);
+}
+
+static void start_job(struct job *j, int print_tree, int print_symtab,
+                      int generate_dot, bool flag_c) {
+    j->out = tmpfile();
+    j->err = tmpfile();
+    if (!j->out || !j->err) {
+        perror("tmpfile");
+        exit(1);
+    }
+    fflush(NULL);
+    if ((j->pid = fork()) < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (j->pid == 0) {
+        dup2(fileno(j->out), 1);
+        dup2(fileno(j->err), 2);
+        int r = compile_file(j->file, print_tree, print_symtab, generate_dot, flag_c);
+        fflush(NULL);
+        _exit(r ? JOB_FRONTEND + r : 0);
+    }
+}
+
+static int compile_parallel(char **files, int nfiles, int njobs, int print_tree,
+                            int print_symtab, int generate_dot, bool flag_c) {
+    struct job *job = calloc(nfiles, sizeof *job);
+    int started = 0, running = 0, shown = 0, exit_code = 0;
+    if (!job) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+
+    while (shown < nfiles) {
+        for (; running < njobs && started < nfiles; started++, running++) {
+            job[started].file = files[started];
+            start_job(&job[started], print_tree, print_symtab, generate_dot, flag_c);
+        }
+
+        int st;
+        pid_t pid = wait(&st);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            perror("wait");
+            exit(1);
+        }
+        for (int k = 0; k < started; k++) {
+            if (job[k].pid != pid || job[k].done) continue;
+            job[k].status = WIFEXITED(st) ? WEXITSTATUS(st) : 128 + WTERMSIG(st);
+            job[k].done = true;
+            running--;
+        }
+
+        while (shown < started && job[shown].done) {
+            struct job *j = &job[shown++];
+            copy_out(j->out, stdout);
+            copy_out(j->err, stderr);
+            if (j->status >= JOB_FRONTEND && j->status < 128) {
+                exit_code = j->status - JOB_FRONTEND;
+            } else if (j->status) {
+                /* what a serial run would have stopped at: drop the rest */
+                for (int k = shown; k < started; k++)
+                    if (!job[k].done) kill(job[k].pid, SIGTERM);
+                while (wait(NULL) > 0 || errno == EINTR)
+                    ;
+                return j->status;
+            }
+        }
+    }
+    free(job);
+    return exit_code;
+}
+
+static int compile_main(int argc, char *argv[]) {
     if (argc < 2) {
         fprintf(stderr,
-                "Usage: %s <input_file.kt> [-tree] [-symtab] [-dot] [-s] [-c]\n",
-                argv[0]);
+                "Usage: %s <input_file.kt> [-tree] [-symtab] [-dot] [-s] [-c] [-run] [-vm] [-O0|-O1|-O2]\n"
+                "       [-fno-<pass>] [-funroll=N] [-mavx2] [-stats] [-verify] [-no-integrated-as]\n"
+                "       [-j N] [-threads=N]\n"
+                "       %s -server <socket>\n",
+                argv[0], argv[0]);
         return 1;
     }
 
     int print_tree   = 0;
     int print_symtab = 0;
     int generate_dot = 0;
-    bool flag_s      = false;  /* -s: stop after emitting .s */
     bool flag_c      = false;  /* -c: stop after emitting .o */
+    int  njobs       = 1;      /* -j N: compile N files at a time */
     int  exit_code   = 0;
 
-    /* scan flags */
+    find_runtime(argv[0]);
+
+    /* scan flags; every other argument is a file */
+    char **files = malloc(argc * sizeof *files);
+    int nfiles = 0;
     for (int i = 1; i < argc; i++) {
         if      (strcmp(argv[i], "-tree")   == 0) print_tree   = 1;
         else if (strcmp(argv[i], "-symtab") == 0) print_symtab = 1;
         else if (strcmp(argv[i], "-dot")    == 0) generate_dot = 1;
-        else if (strcmp(argv[i], "-s")      == 0) flag_s       = true;
+        else if (strcmp(argv[i], "-s")      == 0) stop_at_asm  = true;
         else if (strcmp(argv[i], "-c")      == 0) flag_c       = true;
+        else if (strcmp(argv[i], "-run")    == 0) run_program  = true;
+        else if (strcmp(argv[i], "-vm")     == 0) run_vm       = true;
+        else if (strcmp(argv[i], "-mavx2")  == 0) target_avx2  = 1;
+        else if (strcmp(argv[i], "-stats")  == 0) print_stats  = 1;
+        else if (strcmp(argv[i], "-verify") == 0) verify_passes = 1;
+        else if (strcmp(argv[i], "-no-integrated-as") == 0) integrated_as = false;
+        else if (strncmp(argv[i], "-j", 2) == 0) {
+            /* -j N or -jN */
+            const char *n = argv[i][2] ? argv[i] + 2 : i + 1 < argc ? argv[++i] : "";
+            if ((njobs = atoi(n)) < 1) {
+                fprintf(stderr, "-j needs a number of jobs\n");
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "-threads=", 9) == 0)
+            codegen_threads = atoi(argv[i] + 9);
+        else if (strncmp(argv[i], "-funroll=", 9) == 0)
+            unroll_factor = atoi(argv[i] + 9);
+        else if (argv[i][0] == '-' && argv[i][1] == 'O' &&
+                 argv[i][2] >= '0' && argv[i][2] <= '2'
+                 && argv[i][3] == '\0')
+            opt_level = argv[i][2] - '0';
+        else if (strncmp(argv[i], "-fno-", 5) == 0 &&
+                 !disable_pass(argv[i] + 5)) {
+            fprintf(stderr, "unknown pass '%s'; passes are:\n", argv[i] + 5);
+            list_passes(stderr);
+            return 1;
+        }
+        else if (argv[i][0] != '-')
+            files[nfiles++] = argv[i];
     }
 
-    /* for each non-flag argument */
-    for (int i = 1; i < argc; i++) {
-        if (argv[i][0] == '-') continue;
-
-        /* 1) parse/semantic/generate code + write out `stem.s` */
-        int r = process_file(argv[i],
-                             print_tree,
-                             print_symtab,
-                             generate_dot);
-        if (r) {
-            exit_code = r;
-            continue;
-        }
+    /* a .ic file written by an earlier compile runs on the TAC VM */
+    bool any_ic = false;
+    for (int f = 0; f < nfiles; f++) {
+        const char *ext = strrchr(files[f], '.');
+        if (ext && strcmp(ext, ".ic") == 0) any_ic = true;
+    }
+
+    if (njobs > 1 && nfiles > 1 && !run_program && !run_vm && !any_ic) {
+        /* the jobs already keep the CPUs busy; don't thread each one too */
+        if (codegen_threads == 0) codegen_threads = 1;
+        return compile_parallel(files, nfiles, njobs, print_tree, print_symtab,
+                                generate_dot, flag_c);
+    }
 
-        /* 2) strip extension: "foo.kt" → "foo" */
-        char stem[256];
-        strncpy(stem, argv[i], sizeof(stem)-1);
-        stem[sizeof(stem)-1] = '\0';
-        char *dot = strrchr(stem, '.');
-        if (dot != NULL) {
-            *dot = '\0';
+    for (int f = 0; f < nfiles; f++) {
+        const char *ext = strrchr(files[f], '.');
+        if (ext && strcmp(ext, ".ic") == 0) {
+            struct tac_program prog;
+            if (read_ic_file(files[f], &prog)) return 1;
+            fflush(stdout);
+            exit(vm_run(&prog));
         }
 
-        /* 3) assemble/link as needed */
-        finish_and_emit(stem, flag_s, flag_c);
+        int r = compile_file(files[f], print_tree, print_symtab, generate_dot, flag_c);
+        if (r) exit_code = r;
     }
 
     return exit_code;
-}
\ No newline at end of file
+}
+
+/* a -server request, in its forked child: the runtime was set up for
+   the server's stdout and environment, not the client's */
+static int compile_request(int argc, char **argv) {
+    k0_runtime_reinit();
+    return compile_main(argc, argv);
+}
+
+int main(int argc, char *argv[]) {
+    /* -server PATH: compile for K0_SERVER clients until killed */
+    if (argc == 3 && strcmp(argv[1], "-server") == 0) {
+        builtins = builtin_symtab();
+        find_runtime(argv[0]);
+        return serve(argv[2], compile_request);
+    }
+
+    /* K0_SERVER=PATH: hand the whole run to the server if one is up */
+    const char *server = getenv("K0_SERVER");
+    if (server && *server) {
+        int rc = submit(server, argc, argv);
+        if (rc >= 0) return rc;
+    }
+    return compile_main(argc, argv);
+}
@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tac.h"
+#include "cfg.h"
+#include "opt.h"
+
+/*
+ * Local constant folding over the TAC list.
+ *
+ * Within a straight-line run of code (a label starts a new run) we track
+ * which Int stack slots hold a known constant.  Integer arithmetic and
+ * comparisons whose operands are all known become  dest = $imm, and a
+ * conditional branch on known values becomes an unconditional BR or
+ * disappears.
+ * Doubles and pointers are never tracked.
+ * The table is per thread: functions are folded in parallel.
+ */
+
+#define MAXCONST 256
+
+static __thread struct { int offset, val; } known[MAXCONST];
+static __thread int nknown;
+
+static int lookup_const(struct addr a, int *val) {
+    if (a.region == R_IMMED) { *val = a.u.offset; return 1; }
+    if (a.region != R_LOCAL) return 0;
+    for (int i = 0; i < nknown; i++)
+        if (known[i].offset == a.u.offset) { *val = known[i].val; return 1; }
+    return 0;
+}
+
+static void kill(struct addr a) {
+    if (a.region != R_LOCAL) return;
+    for (int i = 0; i < nknown; i++)
+        if (known[i].offset == a.u.offset) {
+            known[i] = known[--nknown];
+            return;
+        }
+}
+
+static void record(struct addr a, int val) {
+    kill(a);
+    if (a.region == R_LOCAL && nknown < MAXCONST) {
+        known[nknown].offset = a.u.offset;
+        known[nknown].val    = val;
+        nknown++;
+    }
+}
+
+/* evaluate an integer opcode; 0 if it can't be folded */
+static int eval(int op, int a, int b, int *r) {
+    switch (op) {
+        case O_IADD: *r = (int)((unsigned)a + (unsigned)b); return 1;
+        case O_ISUB: *r = (int)((unsigned)a - (unsigned)b); return 1;
+        case O_IMUL: *r = (int)((unsigned)a * (unsigned)b); return 1;
+        case O_IDIV:
+            if (b == 0 || (a == -2147483647 - 1 && b == -1)) return 0;
+            *r = a / b; return 1;
+        case O_IMOD:
+            if (b == 0 || (a == -2147483647 - 1 && b == -1)) return 0;
+            *r = a % b; return 1;
+        case O_IEQ: *r = a == b; return 1;
+        case O_INE: *r = a != b; return 1;
+        case O_ILT: *r = a <  b; return 1;
+        case O_ILE: *r = a <= b; return 1;
+        case O_IGT: *r = a >  b; return 1;
+        case O_IGE: *r = a >= b; return 1;
+        default: return 0;
+    }
+}
+
+/* the Ixx compare a Bxx branch tests */
+static int compare_of(int branch) {
+    switch (branch) {
+        case O_BLT: return O_ILT;
+        case O_BLE: return O_ILE;
+        case O_BGT: return O_IGT;
+        case O_BGE: return O_IGE;
+        case O_BEQ: return O_IEQ;
+        default:    return O_INE;
+    }
+}
+
+struct instr *fold_constants(struct instr *code) {
+    struct instr *prev = NULL, *cur = code, *next;
+    nknown = 0;
+
+    for (; cur; cur = next) {
+        next = cur->next;
+        int a, b, r;
+
+        switch (cur->opcode) {
+            case D_PROC: case D_LABEL: case O_LBL: case D_END:
+                nknown = 0;
+                break;
+
+            case O_ASN:
+                if (cur->dest.region != R_LOCAL) break;
+                if (!cur->is_double && !cur->is_ptr &&
+                    cur->src1.region != R_MEM && lookup_const(cur->src1, &a)) {
+                    cur->src1 = (struct addr){ .region = R_IMMED, .u.offset = a };
+                    record(cur->dest, a);
+                } else {
+                    kill(cur->dest);
+                }
+                break;
+
+            case O_IADD: case O_ISUB: case O_IMUL: case O_IDIV: case O_IMOD:
+            case O_IEQ: case O_INE: case O_ILT: case O_ILE: case O_IGT: case O_IGE:
+                if (!cur->is_double && !cur->is_ptr &&
+                    lookup_const(cur->src1, &a) && lookup_const(cur->src2, &b) &&
+                    eval(cur->opcode, a, b, &r)) {
+                    cur->opcode = O_ASN;
+                    cur->src1 = (struct addr){ .region = R_IMMED, .u.offset = r };
+                    cur->src2 = (struct addr){ .region = R_NONE, .u.offset = 0 };
+                    record(cur->dest, r);
+                } else {
+                    kill(cur->dest);
+                }
+                break;
+
+            case O_BZ: case O_BNZ:
+            case O_BLT: case O_BLE: case O_BGT: case O_BGE:
+            case O_BEQ: case O_BNE: {
+                int known_cond = 0, taken = 0;
+                if (cur->opcode == O_BZ || cur->opcode == O_BNZ) {
+                    if ((known_cond = lookup_const(cur->src1, &a)))
+                        taken = (cur->opcode == O_BZ) ? (a == 0) : (a != 0);
+                } else if (lookup_const(cur->src1, &a) &&
+                           lookup_const(cur->src2, &b)) {
+                    known_cond = 1;
+                    eval(compare_of(cur->opcode), a, b, &taken);
+                }
+                if (known_cond) {
+                    if (taken) {
+                        cur->opcode = O_BR;
+                        cur->src1 = (struct addr){ .region = R_NONE, .u.offset = 0 };
+                        cur->src2 = (struct addr){ .region = R_NONE, .u.offset = 0 };
+                    } else {
+                        /* never taken: unlink it */
+                        if (prev) prev->next = next;
+                        else      code = next;
+                        continue;
+                    }
+                }
+                break;
+            }
+
+            default:
+                kill(cur->dest);
+                break;
+        }
+        prev = cur;
+    }
+    return code;
+}
+
+/*
+ * Drop  BR L  when L is the very next instruction, and turn a branch to
+ * an unconditional  BR M  into a branch straight to M.
+ */
+struct instr *thread_jumps(struct instr *code) {
+    struct instr *prev = NULL, *cur, *next;
+    int minlabel = -1, maxlabel = -1;
+
+    /* the code is often one function: index only its range of labels */
+    for (cur = code; cur; cur = cur->next)
+        if (cur->opcode == D_LABEL && cur->dest.u.offset >= 0) {
+            if (minlabel < 0 || cur->dest.u.offset < minlabel)
+                minlabel = cur->dest.u.offset;
+            if (cur->dest.u.offset > maxlabel)
+                maxlabel = cur->dest.u.offset;
+        }
+    struct instr **at = calloc(maxlabel - minlabel + 2, sizeof *at);
+    if (!at) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+    for (cur = code; cur; cur = cur->next)
+        if (cur->opcode == D_LABEL && cur->dest.u.offset >= 0)
+            at[cur->dest.u.offset - minlabel] = cur;
+
+    for (cur = code; cur; cur = cur->next) {
+        if (!is_branch(cur->opcode)) continue;
+        /* bounded so a cycle of BRs cannot loop forever */
+        for (int hops = 0; hops < 8; hops++) {
+            int l = cur->dest.u.offset;
+            struct instr *t = (l >= minlabel && l <= maxlabel && minlabel >= 0)
+                              ? at[l - minlabel] : NULL;
+            while (t && t->opcode == D_LABEL) t = t->next;
+            if (!t || t->opcode != O_BR || t->dest.u.offset == l)
+                break;
+            cur->dest = t->dest;
+        }
+    }
+    free(at);
+
+    for (cur = code; cur; cur = next) {
+        next = cur->next;
+        if (cur->opcode == O_BR) {
+            struct instr *t = next;
+            while (t && t->opcode == D_LABEL &&
+                   t->dest.u.offset != cur->dest.u.offset)
+                t = t->next;
+            if (t && t->opcode == D_LABEL) {
+                if (prev) prev->next = next;
+                else      code = next;
+                continue;
+            }
+        }
+        prev = cur;
+    }
+    return code;
+}
+
+/* remove the blocks of each function that no path from its entry reaches */
+struct instr *remove_unreachable(struct instr *code) {
+    for (struct instr *p = code; p; p = p->next) {
+        if (p->opcode != D_PROC) continue;
+        struct cfg *g = build_cfg(p);
+        if (!g) break;
+        mark_reachable(g);
+
+        struct instr *prev = p;
+        for (struct block *b = g->blocks; b; b = b->next) {
+            struct instr *after = b->last->next;
+            if (b->reachable) {
+                prev = b->last;
+                continue;
+            }
+            prev->next = after;
+        }
+        p = g->end;
+        free_cfg(g);
+    }
+    return code;
+}
+
+/*
+ * Fuse  t = a <op> b; BZ/BNZ L, t  into one  B<op> L, a, b  when t is
+ * read nowhere else in the function, so no Boolean is materialized.
+ */
+static int fused_branch(int cmp, int on_true) {
+    static const int br[] = { O_BEQ, O_BLT, O_BLE, O_BGT, O_BGE, O_BNE };
+    static const int inv[] = { O_BNE, O_BGE, O_BGT, O_BLE, O_BLT, O_BEQ };
+    return on_true ? br[cmp - O_IEQ] : inv[cmp - O_IEQ];
+}
+
+static void count_use(int *uses, int max, struct addr a) {
+    if (a.region == R_LOCAL && a.u.offset >= 0 && a.u.offset <= max)
+        uses[a.u.offset]++;
+}
+
+struct instr *fuse_branches(struct instr *code) {
+    for (struct instr *p = code; p; p = p->next) {
+        if (p->opcode != D_PROC) continue;
+
+        struct instr *end, *i;
+        int max = 0;
+        for (end = p->next; end && end->opcode != D_END; end = end->next) {
+            if (end->dest.region == R_LOCAL && end->dest.u.offset > max)
+                max = end->dest.u.offset;
+            if (end->src1.region == R_LOCAL && end->src1.u.offset > max)
+                max = end->src1.u.offset;
+            if (end->src2.region == R_LOCAL && end->src2.u.offset > max)
+                max = end->src2.u.offset;
+        }
+        if (!end) break;
+
+        int *uses = calloc(max + 1, sizeof *uses);
+        if (!uses) {
+            fprintf(stderr, "out of memory\n");
+            exit(4);
+        }
+        for (i = p->next; i != end; i = i->next) {
+            count_use(uses, max, i->dest);
+            count_use(uses, max, i->src1);
+            count_use(uses, max, i->src2);
+        }
+
+        /* the compare's dest and the branch's src1: two mentions in all */
+        for (i = p; i->next != end; ) {
+            struct instr *cmp = i->next, *br = cmp->next;
+            if (cmp->opcode >= O_IEQ && cmp->opcode <= O_INE &&
+                !cmp->is_double && br &&
+                (br->opcode == O_BZ || br->opcode == O_BNZ) &&
+                cmp->dest.region == R_LOCAL && br->src1.region == R_LOCAL &&
+                cmp->dest.u.offset == br->src1.u.offset &&
+                uses[cmp->dest.u.offset] == 2) {
+                br->opcode = fused_branch(cmp->opcode, br->opcode == O_BNZ);
+                br->src1 = cmp->src1;
+                br->src2 = cmp->src2;
+                i->next = br;
+                continue;
+            }
+            i = cmp;
+        }
+        free(uses);
+        p = end;
+    }
+    return code;
+}
@@ -0,0 +1,11 @@
+#ifndef OPT_H
+#define OPT_H
+
+#include "tac.h"
+
+struct instr *fold_constants(struct instr *code);
+struct instr *fuse_branches(struct instr *code);
+struct instr *thread_jumps(struct instr *code);
+struct instr *remove_unreachable(struct instr *code);
+
+#endif
@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "tac.h"
+#include "parallel.h"
+
+/*
+ * Function-level parallelism for the back end.
+ *
+ * generate_code walks the tree serially, but what it produces is a list
+ * of self-contained functions: every branch stays inside its D_PROC ..
+ * D_END, and the stack slots, PARMs and CALLs of one function never
+ * refer to another's.  So the optimization passes and the assembly
+ * writer cut the list into one piece per function and hand the pieces
+ * to parallel_for.  Workers take the next unclaimed piece off a shared
+ * counter, so a long function does not hold up the short ones queued
+ * behind it, and each result goes back into its own slot; the caller
+ * stitches the slots together in source order, which keeps the output
+ * the same for any thread count.
+ */
+
+#define MAX_THREADS 64
+
+int codegen_threads = 0;
+
+struct instr **split_functions(struct instr *code, int *n) {
+    int count = 0, cap = 16;
+    struct instr **piece = malloc(cap * sizeof *piece);
+    if (!piece) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+    while (code) {
+        if (count == cap) {
+            cap *= 2;
+            piece = realloc(piece, cap * sizeof *piece);
+            if (!piece) {
+                fprintf(stderr, "out of memory\n");
+                exit(4);
+            }
+        }
+        piece[count++] = code;
+        struct instr *last = code;
+        while (last->next && last->opcode != D_END) last = last->next;
+        code = last->next;
+        last->next = NULL;
+    }
+    *n = count;
+    return piece;
+}
+
+struct instr *join_functions(struct instr **piece, int n) {
+    struct instr *head = NULL, *tail = NULL;
+    for (int k = 0; k < n; k++) {
+        if (!piece[k]) continue;
+        if (tail) tail->next = piece[k];
+        else      head = piece[k];
+        for (tail = piece[k]; tail->next; tail = tail->next)
+            ;
+    }
+    free(piece);
+    return head;
+}
+
+struct work {
+    int n;
+    atomic_int next;
+    void (*task)(int i, void *arg);
+    void *arg;
+};
+
+static void *worker(void *p) {
+    struct work *w = p;
+    int i;
+    while ((i = atomic_fetch_add(&w->next, 1)) < w->n)
+        w->task(i, w->arg);
+    return NULL;
+}
+
+void parallel_for(int n, void (*task)(int i, void *arg), void *arg) {
+    int nthreads = codegen_threads;
+    if (nthreads <= 0) nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads > MAX_THREADS) nthreads = MAX_THREADS;
+    if (nthreads > n) nthreads = n;
+
+    struct work w = { n, 0, task, arg };
+    pthread_t tid[MAX_THREADS];
+    int started = 0;
+    // the calling thread is one of the workers; if a thread cannot be
+    // started the others just take more pieces each
+    while (started < nthreads - 1 &&
+           pthread_create(&tid[started], NULL, worker, &w) == 0)
+        started++;
+    worker(&w);
+    for (int k = 0; k < started; k++)
+        pthread_join(tid[k], NULL);
+}
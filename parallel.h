@@ -0,0 +1,20 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "tac.h"
+
+extern int codegen_threads;  /* -threads=N; 0 = one per online CPU */
+
+/*
+ * cut the code list after every D_END, so each piece is one function
+ * (with the D_GLOB lines in front of it); *n is set to the piece count
+ */
+struct instr **split_functions(struct instr *code, int *n);
+
+/* link the pieces back up in order, free the array and return the list */
+struct instr *join_functions(struct instr **piece, int n);
+
+/* task(i, arg) for every i in [0, n), on up to codegen_threads threads */
+void parallel_for(int n, void (*task)(int i, void *arg), void *arg);
+
+#endif
@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "tac.h"
+#include "cfg.h"
+#include "opt.h"
+#include "passes.h"
+#include "parallel.h"
+
+/*
+ * Pass manager.
+ *
+ * Every optimization is registered here under a name with the lowest -O
+ * level that turns it on; -fno-<name> turns it off again.  Passes with a
+ * run function transform the TAC list after generate_code, in table
+ * order.  The others (vectorize, unroll, bounds) rewrite loops while the
+ * TAC is generated and only ask pass_enabled() whether they may; they
+ * call pass_note() for each loop they take.
+ *
+ * The run passes only ever look inside one function at a time, so each
+ * function goes through the whole pipeline on its own, on parallel.c's
+ * threads, and the list is put back together afterwards.
+ */
+
+extern char *opcodename(int i);
+
+int opt_level     = 1;
+int verify_passes = 0;
+int print_stats   = 0;
+
+/* array accesses in the final code with and without an index check */
+static long checks_kept, checks_removed;
+
+/* the counts and times below are summed over the functions' threads */
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+struct pass {
+    const char *name;
+    int level;
+    struct instr *(*run)(struct instr *code);
+    int disabled;
+    int changed;        /* loops rewritten, for lowering passes */
+    long before, after; /* instruction counts around each run, summed */
+    double seconds;
+};
+
+static struct pass passes[] = {
+    { "vectorize",   2, NULL },
+    { "unroll",      2, NULL },
+    { "bounds",      1, NULL },
+    { "fold",        1, fold_constants },
+    { "fuse",        1, fuse_branches },
+    { "jumps",       1, thread_jumps },
+    { "unreachable", 1, remove_unreachable },
+};
+#define NPASSES ((int)(sizeof passes / sizeof passes[0]))
+
+static struct pass *find_pass(const char *name) {
+    for (int i = 0; i < NPASSES; i++)
+        if (strcmp(passes[i].name, name) == 0)
+            return &passes[i];
+    return NULL;
+}
+
+int disable_pass(const char *name) {
+    struct pass *p = find_pass(name);
+    if (!p) return 0;
+    p->disabled = 1;
+    return 1;
+}
+
+int pass_enabled(const char *name) {
+    struct pass *p = find_pass(name);
+    return p && !p->disabled && opt_level >= p->level;
+}
+
+void pass_note(const char *name) {
+    struct pass *p = find_pass(name);
+    if (p) p->changed++;
+}
+
+static long count_instrs(struct instr *code) {
+    long n = 0;
+    for (; code; code = code->next) n++;
+    return n;
+}
+
+/* every enabled run pass, in order, over the function in piece[k] */
+static void optimize_function(int k, void *arg) {
+    struct instr **piece = arg;
+    struct instr *code = piece[k];
+    for (int i = 0; i < NPASSES; i++) {
+        struct pass *p = &passes[i];
+        if (!p->run || !pass_enabled(p->name)) continue;
+
+        struct timespec t0, t1;
+        long before = count_instrs(code);
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        code = p->run(code);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        long after = count_instrs(code);
+
+        pthread_mutex_lock(&stats_lock);
+        p->before  += before;
+        p->after   += after;
+        p->seconds += (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+        pthread_mutex_unlock(&stats_lock);
+
+        if (verify_passes) verify_tac(code, p->name);
+    }
+    piece[k] = code;
+}
+
+struct instr *run_passes(struct instr *code) {
+    if (verify_passes) verify_tac(code, "codegen");
+    int n;
+    struct instr **piece = split_functions(code, &n);
+    parallel_for(n, optimize_function, piece);
+    code = join_functions(piece, n);
+    // labels are numbered across the whole program, so check them across it
+    if (verify_passes) verify_tac(code, "passes");
+
+    for (struct instr *i = code; i; i = i->next)
+        if (i->opcode == O_ALOAD || i->opcode == O_ASTORE) {
+            if (i->unchecked) checks_removed++;
+            else checks_kept++;
+        }
+    return code;
+}
+
+/*
+ * Structural checks: D_PROC/D_END pair up, every label is defined once,
+ * every branch inside a function targets a label of that function, and
+ * every opcode has a name.  A failure is a compiler bug, so stop.
+ */
+static void verify_fail(const char *after, struct instr *i, const char *msg) {
+    fprintf(stderr, "verify: after %s: %s (%s %d)\n",
+            after, msg, opcodename(i->opcode), i->dest.u.offset);
+    exit(4);
+}
+
+void verify_tac(struct instr *code, const char *after) {
+    int maxlabel = -1;
+    for (struct instr *i = code; i; i = i->next) {
+        if (strcmp(opcodename(i->opcode), "UNKNOWN") == 0)
+            verify_fail(after, i, "unknown opcode");
+        if ((i->opcode == D_LABEL || is_branch(i->opcode)) &&
+            i->dest.u.offset > maxlabel)
+            maxlabel = i->dest.u.offset;
+    }
+
+    /* owner[l]: 0 = undefined, else the index of the defining function */
+    int *owner = calloc(maxlabel + 2, sizeof *owner);
+    if (!owner) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+    int fn = 0, infn = 0;
+    for (struct instr *i = code; i; i = i->next) {
+        if (i->opcode == D_PROC) {
+            if (infn) verify_fail(after, i, "nested D_PROC");
+            infn = 1;
+            fn++;
+        } else if (i->opcode == D_END) {
+            if (!infn) verify_fail(after, i, "D_END outside a function");
+            infn = 0;
+        } else if (i->opcode == D_LABEL) {
+            if (i->dest.u.offset < 0 || owner[i->dest.u.offset])
+                verify_fail(after, i, "label defined twice");
+            owner[i->dest.u.offset] = fn;
+        }
+    }
+    if (infn) verify_fail(after, code, "missing D_END");
+
+    fn = 0;
+    for (struct instr *i = code; i; i = i->next) {
+        if (i->opcode == D_PROC) fn++;
+        if (is_branch(i->opcode) &&
+            (i->dest.u.offset < 0 || owner[i->dest.u.offset] != fn))
+            verify_fail(after, i, "branch to a label outside its function");
+    }
+    free(owner);
+}
+
+void print_pass_stats(FILE *f) {
+    fprintf(f, "%-12s %8s %8s %8s %10s\n",
+            "pass", "before", "after", "removed", "ms");
+    for (int i = 0; i < NPASSES; i++) {
+        struct pass *p = &passes[i];
+        if (!pass_enabled(p->name)) {
+            fprintf(f, "%-12s  (off)\n", p->name);
+        } else if (!p->run) {
+            fprintf(f, "%-12s  %d loop(s) rewritten\n", p->name, p->changed);
+            if (strcmp(p->name, "bounds") == 0)
+                fprintf(f, "%-12s  %ld check(s) removed, %ld kept\n", "",
+                        checks_removed, checks_kept);
+        } else {
+            fprintf(f, "%-12s %8ld %8ld %8ld %10.3f\n", p->name,
+                    p->before, p->after, p->before - p->after,
+                    p->seconds * 1000);
+        }
+    }
+}
+
+void list_passes(FILE *f) {
+    for (int i = 0; i < NPASSES; i++)
+        fprintf(f, "  %-12s -O%d\n", passes[i].name, passes[i].level);
+}
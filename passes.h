@@ -0,0 +1,19 @@
+#ifndef PASSES_H
+#define PASSES_H
+
+#include <stdio.h>
+#include "tac.h"
+
+extern int opt_level;       /* -O0, -O1 (default), -O2 */
+extern int verify_passes;   /* -verify: check the TAC after every pass */
+extern int print_stats;     /* -stats: per-pass report on stderr */
+
+int  disable_pass(const char *name);
+int  pass_enabled(const char *name);
+void pass_note(const char *name);
+struct instr *run_passes(struct instr *code);
+void verify_tac(struct instr *code, const char *after);
+void print_pass_stats(FILE *f);
+void list_passes(FILE *f);
+
+#endif
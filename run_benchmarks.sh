@@ -0,0 +1,64 @@
+#!/usr/bin/env bash
+set -uo pipefail
+
+# Times each benchmark in benchmarks/ at -O2.  Extra arguments are passed
+# to k0, e.g. ./run_benchmarks.sh -mavx2  or  ./run_benchmarks.sh -O0
+# A benchmark reads benchmarks/<name>.in if there is one, and is then also
+# reported in lines/s and MB/s.  A benchmarks/<name>.c next to it is the
+# same program in C, timed on the same input for comparison.  Each one is
+# also timed on the TAC interpreter (k0 -vm), compile time included.
+BENCHDIR="benchmarks"
+CC="${CC:-cc}"
+
+# Path to your compiler
+K0="./k0"
+
+if [ ! -x "$K0" ]; then
+  echo "Error: compiler '$K0' not found or not executable"
+  exit 1
+fi
+
+# readln input: a count, then that many Int and Double lines (about 15 MB)
+if [ ! -f "$BENCHDIR/readln.in" ]; then
+  awk 'BEGIN { n = 1000000; srand(7); print n
+               for (i = 0; i < n; i++) {
+                 print int(rand() * 1000); printf "%.3f\n", rand() * 1000 } }' \
+    > "$BENCHDIR/readln.in"
+fi
+
+# run_one <label> <input> <output> <command...>
+run_one() {
+  TIMEFORMAT="%R"
+  local label="$1" in="$2" out="$3" secs
+  shift 3
+  secs=$( { time "$@" < "$in" > "$out"; } 2>&1 )
+  printf "%-10s %8ss   %s" "$label" "$secs" "$(tail -n 1 "$out")"
+  if [ "$in" != /dev/null ]; then
+    wc -lc < "$in" | awk -v s="$secs" '{
+      if (s > 0) printf "   %.0f lines/s  %.1f MB/s", $1 / s, $2 / s / 1e6 }'
+  fi
+  printf "\n"
+}
+
+shopt -s nullglob
+for kt in "$BENCHDIR"/*.kt; do
+  base="$(basename "$kt" .kt)"
+  if ! "$K0" -O2 "$@" "$kt" > /dev/null; then
+    echo ">> Compilation failed for $kt"
+    exit 1
+  fi
+
+  input=/dev/null
+  [ -f "$BENCHDIR/$base.in" ] && input="$BENCHDIR/$base.in"
+  run_one "$base" "$input" "$BENCHDIR/$base.out" "$BENCHDIR/$base"
+
+  if [ -f "$BENCHDIR/$base.c" ]; then
+    if ! $CC -O2 "$BENCHDIR/$base.c" -o "$BENCHDIR/$base.cbin"; then
+      echo ">> Compilation failed for $BENCHDIR/$base.c"
+      exit 1
+    fi
+    run_one "$base (C)" "$input" "$BENCHDIR/$base.c.out" "$BENCHDIR/$base.cbin"
+  fi
+
+  run_one "$base (vm)" "$input" "$BENCHDIR/$base.vm.out" "$K0" -O2 "$@" -vm "$kt"
+done
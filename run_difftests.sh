@@ -0,0 +1,49 @@
+#!/usr/bin/env bash
+set -uo pipefail
+
+# Runs every test in finaltests/ three ways -- the native executable, the
+# TAC interpreter (k0 -vm) and the interpreter on the .ic the compile
+# wrote -- and reports any difference in output or exit status.  Extra
+# arguments are passed to k0, e.g. ./run_difftests.sh -O0 -mavx2
+SRCDIR="finaltests"
+
+# Path to your compiler
+K0="./k0"
+
+if [ ! -x "$K0" ]; then
+  echo "Error: compiler '$K0' not found or not executable"
+  exit 1
+fi
+
+fail=0
+shopt -s nullglob
+for kt in "$SRCDIR"/*.kt; do
+  base="$(basename "$kt" .kt)"
+  input=/dev/null
+  [ -f "$SRCDIR/$base.in" ] && input="$SRCDIR/$base.in"
+
+  if ! "$K0" "$@" "$kt" > /dev/null; then
+    echo ">> Compilation failed for $kt"
+    exit 1
+  fi
+  # builtin.kt prints one unseeded random number
+  native=$("$SRCDIR/$base" < "$input" 2>&1; echo "exit $?")
+  native=$(grep -v "^Random number" <<< "$native")
+  vm=$("$K0" "$@" -vm "$kt" < "$input" 2>&1; echo "exit $?")
+  vm=$(grep -v "^Random number" <<< "$vm")
+  ic=$("$K0" "$SRCDIR/$base.ic" < "$input" 2>&1; echo "exit $?")
+  ic=$(grep -v "^Random number" <<< "$ic")
+
+  if [ "$native" != "$vm" ]; then
+    echo "DIFF $base: native vs -vm"
+    diff <(echo "$native") <(echo "$vm") | head -n 10
+    fail=1
+  elif [ "$native" != "$ic" ]; then
+    echo "DIFF $base: native vs $base.ic"
+    diff <(echo "$native") <(echo "$ic") | head -n 10
+    fail=1
+  else
+    echo "ok   $base"
+  fi
+done
+exit $fail
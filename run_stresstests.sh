@@ -0,0 +1,176 @@
+#!/usr/bin/env bash
+set -uo pipefail
+
+# Compiles machine-generated programs far bigger than anything in
+# finaltests/ and checks what they print: a million statements spread
+# over a thousand functions, and a hundred thousand statements in a
+# single function body.  Then, at 10 and 100 times the fixed limits k0
+# used to have, String literals of 163840 and 1638400 characters, 1280
+# and 12800 distinct literals, functions of 60 and 600 parameters, and
+# identifiers of 2560 and 25600 characters;
+# the source path is only taken to 10 times (2560 characters), as the
+# kernel refuses paths beyond 4096.  The sources are written to a
+# temporary directory and removed afterwards.  Extra arguments are
+# passed to k0, e.g. ./run_stresstests.sh -O0
+K0="$(pwd)/k0"
+
+if [ ! -x "$K0" ]; then
+  echo "Error: compiler '$K0' not found or not executable"
+  exit 1
+fi
+
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+
+# functions <name> <nfunctions> <nstatements>: f<k>(k) adds i % 7 to k for
+# each of its statements, and main prints the sum of all of them
+functions() {
+  awk -v nf="$2" -v ns="$3" 'BEGIN {
+    for (f = 0; f < nf; f++) {
+      print "fun f" f "(x: Int): Int {"
+      print "  var s: Int = x"
+      for (i = 0; i < ns; i++) print "  s = s + " (i % 7)
+      print "  return s"
+      print "}"
+    }
+    print "fun main() {"
+    print "  var t = 0"
+    for (f = 0; f < nf; f++) print "  t = t + f" f "(" f ")"
+    print "  println(t)"
+    print "}"
+  }' > "$WORK/$1.kt"
+  awk -v nf="$2" -v ns="$3" 'BEGIN {
+    t = 0
+    for (f = 0; f < nf; f++) { t += f; for (i = 0; i < ns; i++) t += i % 7 }
+    print t
+  }' > "$WORK/$1.expected"
+}
+
+# params <name> <nparams>: f takes every third parameter as a Double and
+# the rest as Ints, prints the sum of the Doubles and returns that of the Ints
+params() {
+  awk -v np="$2" 'BEGIN {
+    printf "fun f("
+    for (i = 0; i < np; i++) printf "%sp%d: %s", (i ? ", " : ""), i, (i % 3 == 1 ? "Double" : "Int")
+    print "): Int {"
+    print "  var s: Int = 0"
+    print "  var d: Double = 0.0"
+    for (i = 0; i < np; i++) print "  " (i % 3 == 1 ? "d = d + p" i : "s = s + p" i)
+    print "  println(d)"
+    print "  return s"
+    print "}"
+    print "fun main() {"
+    printf "  println(f("
+    for (i = 0; i < np; i++) printf "%s%s", (i ? ", " : ""), (i % 3 == 1 ? i ".5" : i)
+    print "))"
+    print "}"
+  }' > "$WORK/$1.kt"
+  awk -v np="$2" 'BEGIN {
+    s = 0; d = 0
+    for (i = 0; i < np; i++) if (i % 3 == 1) d += i + 0.5; else s += i
+    printf (d == int(d) ? "%d.0\n" : "%.1f\n"), d
+    print s
+  }' > "$WORK/$1.expected"
+}
+
+# literals <name> <count>: prints count distinct String literals, which
+# println writes without a newline, then the count
+literals() {
+  awk -v n="$2" 'BEGIN {
+    print "fun main() {"
+    for (i = 0; i < n; i++) print "  println(\"s" i "\")"
+    print "  println(" n ")"
+    print "}"
+  }' > "$WORK/$1.kt"
+  awk -v n="$2" 'BEGIN { for (i = 0; i < n; i++) printf "s%d", i; print n }' > "$WORK/$1.expected"
+}
+
+# longstring <name> <length>: one String literal of length characters, and
+# a template with a piece of the same length
+longstring() {
+  awk -v n="$2" 'BEGIN {
+    for (s = "x"; length(s) < n; ) s = s s; s = substr(s, 1, n)
+    print "fun main() {"
+    print "  val k: Int = 7"
+    print "  println(\"" s "\")"
+    print "  println(\"${k}" s "\")"
+    print "  println(k)"
+    print "}"
+  }' > "$WORK/$1.kt"
+  awk -v n="$2" 'BEGIN { for (s = "x"; length(s) < n; ) s = s s; s = substr(s, 1, n); print s "7" s "7" }' > "$WORK/$1.expected"
+}
+
+# longident <name> <length>: a function, a String, an array and a loop
+# variable whose names are length characters long, the String and the
+# array reached through method calls and .size on those names
+longident() {
+  awk -v n="$2" 'BEGIN {
+    for (s = "v"; length(s) < n; ) s = s s; s = substr(s, 1, n - 1)
+    print "fun f" s "(x" s ": Int): Int {"
+    print "  return x" s " + 1"
+    print "}"
+    print "fun main() {"
+    print "  var s" s ": String = \"123\""
+    print "  println(s" s ".length() + f" s "(1))"
+    print "  var a" s ": Array<Int> = Array<Int>(10) {2}"
+    print "  var t: Int = 0"
+    print "  var i" s ": Int = 0"
+    print "  for (i" s " in 0..a" s ".size - 1) { t = t + a" s "[i" s "] }"
+    print "  println(t)"
+    print "}"
+  }' > "$WORK/$1.kt"
+  printf '5\n20\n' > "$WORK/$1.expected"
+}
+
+# longpath <name> <length>: the wide program's little sibling, in a
+# directory nest that makes its path about length characters long; the
+# name to run it by is left in long_name
+longpath() {
+  local dir="$WORK" part
+  part=$(printf '%0200d' 0)
+  while [ ${#dir} -lt $(( $2 - 210 )) ]; do dir="$dir/$part"; done
+  mkdir -p "$dir"
+  long_name="${dir#"$WORK"/}/$1"
+  functions "$long_name" 3 3
+}
+
+fail=0
+# run_one <name>: compile, run and compare with the expected output
+run_one() {
+  TIMEFORMAT="%R"
+  local name="$1" secs
+  secs=$( { time "$K0" ${ARGS[@]+"${ARGS[@]}"} "$WORK/$name.kt" > "$WORK/$name.compile" 2>&1; } 2>&1 )
+  if [ ! -x "$WORK/$name" ]; then
+    echo "FAIL ${name##*/}: compilation failed"
+    tail -n 5 "$WORK/$name.compile"
+    fail=1
+    return
+  fi
+  if "$WORK/$name" | cmp -s - "$WORK/$name.expected"; then
+    printf "ok   %-14s compiled in %ss\n" "${name##*/}" "$secs"
+  else
+    echo "FAIL ${name##*/}: wrong output"
+    fail=1
+  fi
+}
+
+ARGS=("$@")
+functions wide 1000 1000      # 1,000,000 statements
+functions long 1 100000       # one statement list 100,000 long
+params params60 60
+params params600 600
+literals literals1280 1280
+literals literals12800 12800
+longstring string163840 163840
+longstring string1638400 1638400
+longident ident2560 2560
+longident ident25600 25600
+longpath path2560 2560
+run_one wide
+run_one long
+for name in params60 params600 literals1280 literals12800 string163840 string1638400 \
+            ident2560 ident25600; do
+  run_one "$name"
+done
+run_one "$long_name"
+exit $fail
@@ -26,7 +26,12 @@ for kt in "$SRCDIR"/*.kt; do
   # Now run the produced executable, if it exists
   if [ -x "$SRCDIR/$base" ]; then
     echo "=== Running $base ==="
-    "$SRCDIR/$base"
+    # a test that reads stdin gets <name>.in next to it
+    if [ -f "$SRCDIR/$base.in" ]; then
+      "$SRCDIR/$base" < "$SRCDIR/$base.in"
+    else
+      "$SRCDIR/$base"
+    fi
     echo
   else
     echo ">> Warning: executable '$SRCDIR/$base' not found or not executable"
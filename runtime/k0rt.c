@@ -0,0 +1,1217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <emmintrin.h>
+
+#include "k0rt.h"
+
+#define OUTBUF_SIZE (1 << 16)
+
+static char   outbuf[OUTBUF_SIZE];
+static size_t outlen;
+static int    line_buffered;   /* stdout is a terminal */
+
+void k0_flush(void) {
+    size_t done = 0;
+    while (done < outlen) {
+        ssize_t n = write(1, outbuf + done, outlen - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        done += n;
+    }
+    outlen = 0;
+}
+
+__attribute__((constructor))
+static void k0_runtime_init(void) {
+    line_buffered = isatty(1);
+    atexit(k0_flush);
+}
+
+static void out(const char *s, size_t n) {
+    if (n > OUTBUF_SIZE - outlen) {
+        k0_flush();
+        if (n > OUTBUF_SIZE) {   /* too big to buffer: write it through */
+            while (n > 0) {
+                ssize_t w = write(1, s, n);
+                if (w < 0) {
+                    if (errno == EINTR) continue;
+                    return;
+                }
+                s += w;
+                n -= w;
+            }
+            return;
+        }
+    }
+    memcpy(outbuf + outlen, s, n);
+    outlen += n;
+}
+
+static void newline(void) {
+    out("\n", 1);
+    if (line_buffered) k0_flush();
+}
+
+void k0_print_str(const k0_str *s) {
+    out(s->data, s->len);
+    if (line_buffered && memchr(s->data, '\n', s->len)) k0_flush();
+}
+
+/* digits of v written backwards ending at `end`; returns the start */
+static char *itoa_tail(int v, char *end) {
+    unsigned u = v < 0 ? 0u - (unsigned)v : (unsigned)v;
+    char *p = end;
+    do {
+        *--p = '0' + u % 10;
+        u /= 10;
+    } while (u);
+    if (v < 0) *--p = '-';
+    return p;
+}
+
+void k0_print_int(int v) {
+    char buf[12];
+    char *p = itoa_tail(v, buf + sizeof buf);
+    out(p, buf + sizeof buf - p);
+}
+
+void k0_println_int(int v) {
+    k0_print_int(v);
+    newline();
+}
+
+/*
+ * Shortest round-trip digits.  For p = 1, 2, ... significant digits take
+ * m = round(|v| * 10^k) with k = p - 1 - exponent and accept the first m
+ * for which m / 10^k (or m * 10^-k) gives back v.  Both m < 2^53 and
+ * 10^|k| for |k| <= 22 are exact doubles, so that one IEEE division or
+ * multiplication is correctly rounded and the check is exact -- the same
+ * test strtod would apply.  Outside that range fall back to printf.
+ */
+static const double pow10tab[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* digits into d (no leading/trailing zeros), returns decimal exponent
+   of the first digit: v = 0.d1d2d3... * 10^(exp+1) */
+static int shortest_digits(double v, char *d, int *nd) {
+    int e = (int)floor(log10(v));
+    for (int p = 1; p <= 17; p++) {
+        int k = p - 1 - e;
+        if (k < -22 || k > 22) break;
+        /* scale in extended precision so m is the nearest p-digit value */
+        long double scaled = k >= 0 ? (long double)v * pow10tab[k]
+                                    : (long double)v / pow10tab[-k];
+        if (scaled >= 9007199254740992.0L) break;
+        uint64_t m = (uint64_t)(scaled + 0.5L);
+        double back = k >= 0 ? (double)m / pow10tab[k]
+                             : (double)m * pow10tab[-k];
+        if (back != v) continue;
+
+        char tmp[24];
+        int n = 0;
+        do { tmp[n++] = '0' + m % 10; m /= 10; } while (m);
+        int exp10 = n - 1 - k;
+        /* tmp holds m least significant digit first: drop its zeros */
+        while (n > 1 && tmp[0] == '0') { memmove(tmp, tmp + 1, --n); }
+        for (int i = 0; i < n; i++) d[i] = tmp[n - 1 - i];
+        *nd = n;
+        return exp10;
+    }
+
+    char buf[32];
+    for (int p = 1; p <= 17; p++) {
+        snprintf(buf, sizeof buf, "%.*e", p - 1, v);
+        if (strtod(buf, NULL) == v) break;
+    }
+    int n = 0;
+    char *s = buf;
+    for (; *s && *s != 'e'; s++)
+        if (*s >= '0' && *s <= '9') d[n++] = *s;
+    while (n > 1 && d[n - 1] == '0') n--;
+    *nd = n;
+    return atoi(s + 1);
+}
+
+int k0_dtoa(double v, char *out) {
+    char *o = out;
+    if (isnan(v)) return sprintf(out, "NaN");
+    if (signbit(v)) { *o++ = '-'; v = -v; }
+    if (isinf(v)) return (int)(o - out) + sprintf(o, "Infinity");
+    if (v == 0) { strcpy(o, "0.0"); return (int)(o - out) + 3; }
+
+    char d[20];
+    int nd, e = shortest_digits(v, d, &nd);
+
+    if (v >= 1e-3 && v < 1e7) {
+        /* plain decimal, at least one digit after the point */
+        if (e < 0) {
+            *o++ = '0'; *o++ = '.';
+            for (int i = -1; i > e; i--) *o++ = '0';
+            memcpy(o, d, nd); o += nd;
+        } else {
+            for (int i = 0; i <= e; i++) *o++ = i < nd ? d[i] : '0';
+            *o++ = '.';
+            if (nd > e + 1) { memcpy(o, d + e + 1, nd - e - 1); o += nd - e - 1; }
+            else            *o++ = '0';
+        }
+    } else {
+        /* Kotlin/Java scientific form: d.dddE[-]n */
+        *o++ = d[0]; *o++ = '.';
+        if (nd > 1) { memcpy(o, d + 1, nd - 1); o += nd - 1; }
+        else        *o++ = '0';
+        *o++ = 'E';
+        char buf[12];
+        char *p = itoa_tail(e, buf + sizeof buf);
+        memcpy(o, p, buf + sizeof buf - p);
+        o += buf + sizeof buf - p;
+    }
+    *o = '\0';
+    return (int)(o - out);
+}
+
+void k0_print_double(double v) {
+    char buf[32];
+    out(buf, k0_dtoa(v, buf));
+}
+
+void k0_println_double(double v) {
+    k0_print_double(v);
+    newline();
+}
+
+/*
+ * Strings.  A k0 String is a pointer to an immutable k0_str header: the
+ * byte length and a pointer to the bytes, which need not be
+ * NUL-terminated.  Literals are emitted by the compiler as headers over
+ * .rodata, a substring or an input line is a header over someone else's
+ * bytes, and new text is allocated together with its header.  Headers
+ * come from a bump allocator; strings are never freed.
+ */
+#define HDR_BLOCK 4096
+
+static k0_str *hdr_next, *hdr_end;
+
+k0_str *k0_str_view(const char *data, int64_t len) {
+    if (hdr_next == hdr_end) {
+        hdr_next = malloc(HDR_BLOCK * sizeof *hdr_next);
+        if (!hdr_next) {
+            k0_flush();
+            fprintf(stderr, "k0: out of memory\n");
+            exit(1);
+        }
+        hdr_end = hdr_next + HDR_BLOCK;
+    }
+    k0_str *s = hdr_next++;
+    s->len = len;
+    s->data = data;
+    return s;
+}
+
+/* a header followed by room for len bytes (and a NUL) in one block */
+k0_str *k0_str_alloc(int64_t len) {
+    k0_str *s = malloc(sizeof *s + len + 1);
+    if (!s) {
+        k0_flush();
+        fprintf(stderr, "k0: out of memory\n");
+        exit(1);
+    }
+    s->len = len;
+    s->data = (char *)(s + 1);
+    ((char *)(s + 1))[len] = '\0';
+    return s;
+}
+
+void k0_str_index_error(int index, int64_t len) {
+    k0_flush();
+    fprintf(stderr, "Exception in thread \"main\" java.lang.StringIndexOutOfBoundsException: "
+                    "index %d, length %lld\n", index, (long long)len);
+    exit(1);
+}
+
+/* s.substring(begin, end): a view, nothing is copied */
+k0_str *k0_str_substring(const k0_str *s, int begin, int end) {
+    if (begin < 0 || end > s->len || begin > end) {
+        k0_flush();
+        fprintf(stderr, "Exception in thread \"main\" java.lang.StringIndexOutOfBoundsException: "
+                        "begin %d, end %d, length %lld\n", begin, end, (long long)s->len);
+        exit(1);
+    }
+    return k0_str_view(s->data + begin, end - begin);
+}
+
+/* index of the first byte where a and b differ, 16 at a time; n if none */
+static int64_t mismatch(const char *a, const char *b, int64_t n) {
+    int64_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        unsigned same = _mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+        if (same != 0xffff) return i + __builtin_ctz(~same);
+    }
+    for (; i < n; i++)
+        if (a[i] != b[i]) return i;
+    return n;
+}
+
+int k0_str_equals(const k0_str *a, const k0_str *b) {
+    if (a->len != b->len) return 0;
+    if (a->data == b->data) return 1;
+    return mismatch(a->data, b->data, a->len) == a->len;
+}
+
+/* compareTo: by unsigned bytes, then a prefix sorts first */
+int k0_str_compare(const k0_str *a, const k0_str *b) {
+    int64_t n = a->len < b->len ? a->len : b->len;
+    int64_t i = a->data == b->data ? n : mismatch(a->data, b->data, n);
+    if (i < n)
+        return (unsigned char)a->data[i] - (unsigned char)b->data[i];
+    return a->len < b->len ? -1 : a->len > b->len;
+}
+
+k0_str *k0_str_from_int(int v) {
+    char buf[12];
+    char *p = itoa_tail(v, buf + sizeof buf);
+    k0_str *s = k0_str_alloc(buf + sizeof buf - p);
+    memcpy((char *)s->data, p, s->len);
+    return s;
+}
+
+k0_str *k0_str_from_double(double v) {
+    char buf[32];
+    int n = k0_dtoa(v, buf);
+    k0_str *s = k0_str_alloc(n);
+    memcpy((char *)s->data, buf, n);
+    return s;
+}
+
+k0_str *k0_str_from_bool(int v) {
+    static k0_str t = { 4, "true" }, f = { 5, "false" };
+    return v ? &t : &f;
+}
+
+/*
+ * String templates and +.  The compiler evaluates every part of
+ * "a$x${y}" or a + b + c first and then passes them in order, one
+ * k0_cat_* call each.  Only lengths are recorded (a double is formatted
+ * here since its length is only known then); k0_cat_end allocates the
+ * result once and writes the parts straight into it.
+ */
+enum { CAT_BYTES, CAT_INT, CAT_TEXT };
+
+struct cat_part {
+    int kind;
+    int len;
+    union {
+        const char *data;   /* CAT_BYTES */
+        int i;              /* CAT_INT */
+        char text[32];      /* CAT_TEXT */
+    } u;
+};
+
+static struct cat_part *cat;
+static int ncat, catcap;
+static int64_t catlen;
+
+static struct cat_part *cat_next(int kind, int len) {
+    if (ncat == catcap) {
+        catcap = catcap ? catcap * 2 : 16;
+        cat = realloc(cat, catcap * sizeof *cat);
+        if (!cat) {
+            k0_flush();
+            fprintf(stderr, "k0: out of memory\n");
+            exit(1);
+        }
+    }
+    struct cat_part *p = &cat[ncat++];
+    p->kind = kind;
+    p->len = len;
+    catlen += len;
+    return p;
+}
+
+void k0_cat_str(const k0_str *s) {
+    if (s->len > INT32_MAX) {
+        k0_flush();
+        fprintf(stderr, "k0: string too long\n");
+        exit(1);
+    }
+    cat_next(CAT_BYTES, (int)s->len)->u.data = s->data;
+}
+
+void k0_cat_int(int v) {
+    unsigned u = v < 0 ? 0u - (unsigned)v : (unsigned)v;
+    int len = 1 + (v < 0);
+    while (u >= 10) { u /= 10; len++; }
+    cat_next(CAT_INT, len)->u.i = v;
+}
+
+void k0_cat_double(double v) {
+    char buf[32];
+    int n = k0_dtoa(v, buf);
+    memcpy(cat_next(CAT_TEXT, n)->u.text, buf, n);
+}
+
+void k0_cat_bool(int v) {
+    if (v) cat_next(CAT_BYTES, 4)->u.data = "true";
+    else   cat_next(CAT_BYTES, 5)->u.data = "false";
+}
+
+k0_str *k0_cat_end(void) {
+    k0_str *s = k0_str_alloc(catlen);
+    char *o = (char *)s->data;
+    for (int i = 0; i < ncat; i++) {
+        struct cat_part *p = &cat[i];
+        if (p->kind == CAT_INT)       itoa_tail(p->u.i, o + p->len);
+        else if (p->kind == CAT_TEXT) memcpy(o, p->u.text, p->len);
+        else                          memcpy(o, p->u.data, p->len);
+        o += p->len;
+    }
+    ncat = 0;
+    catlen = 0;
+    return s;
+}
+
+/*
+ * Input.  stdin is read in chunks of at least INCHUNK_SIZE and each line
+ * is returned in place, as a string header over the chunk without its
+ * '\n' (or "\r\n").  k0 strings are immutable and may be kept, so a chunk is never
+ * reused: when it fills up, the unfinished line is copied to the start of
+ * a fresh chunk and the old one stays alive for the lines already handed
+ * out.  That is one malloc and a few reads per megabyte instead of per
+ * line.  Nothing frees a String, so nothing frees a chunk either: the
+ * whole input read so far stays in memory, plus a header per line.
+ */
+#define INCHUNK_SIZE (1 << 20)
+
+static char  *inbuf;
+static size_t inpos;    /* start of the next line */
+static size_t inscan;   /* bytes before this hold no '\n' */
+static size_t inlen;
+static size_t incap;
+static int    ineof;
+
+static void refill(void) {
+    if (inlen == incap) {
+        size_t part = inlen - inpos;
+        size_t cap = part * 2 > INCHUNK_SIZE ? part * 2 : INCHUNK_SIZE;
+        char *nb = malloc(cap);
+        if (!nb) {
+            k0_flush();
+            fprintf(stderr, "k0: out of memory reading input\n");
+            exit(1);
+        }
+        memcpy(nb, inbuf + inpos, part);
+        inbuf = nb;
+        incap = cap;
+        inscan -= inpos;
+        inlen = part;
+        inpos = 0;
+    }
+    /* pending output (a prompt, say) must be visible before we block */
+    k0_flush();
+    for (;;) {
+        ssize_t n = read(0, inbuf + inlen, incap - inlen);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) ineof = 1;
+        else        inlen += n;
+        return;
+    }
+}
+
+static k0_str *take_line(char *end) {
+    char *line = inbuf + inpos;
+    inpos = inscan = end - inbuf + (end < inbuf + inlen);
+    if (end > line && end[-1] == '\r') end--;
+    return k0_str_view(line, end - line);
+}
+
+/* the next line of stdin without its terminator; "" once input runs out */
+k0_str *k0_readln(void) {
+    static k0_str empty = { 0, "" };
+    for (;;) {
+        char *nl = inscan < inlen ? memchr(inbuf + inscan, '\n', inlen - inscan)
+                                  : NULL;
+        if (nl) return take_line(nl);
+        inscan = inlen;
+        if (ineof) {
+            if (inpos == inlen) return &empty;
+            return take_line(inbuf + inlen);   /* no final newline */
+        }
+        refill();
+    }
+}
+
+static void number_format_error(const k0_str *s) {
+    k0_flush();
+    fprintf(stderr, "Exception in thread \"main\" java.lang.NumberFormatException: "
+                    "For input string: \"%.*s\"\n", (int)s->len, s->data);
+    exit(1);
+}
+
+/* String.toInt(): optional sign and decimal digits, nothing else */
+int k0_str_toInt(const k0_str *s) {
+    const char *p = s->data, *end = p + s->len;
+    int neg = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) p++;
+    if (p == end) number_format_error(s);
+    uint64_t v = 0;
+    for (; p < end; p++) {
+        if (*p < '0' || *p > '9') number_format_error(s);
+        v = v * 10 + (*p - '0');
+        if (v > (uint64_t)INT32_MAX + neg) number_format_error(s);
+    }
+    return neg ? (int)(0 - v) : (int)v;
+}
+
+/*
+ * String.toDouble().  A plain decimal with at most 15 significant digits
+ * and a power of ten within 10^22 is m * 10^k or m / 10^k with both
+ * operands exact, so one IEEE operation gives the correctly rounded
+ * result (Clinger's fast path).  Anything else -- more digits, NaN,
+ * Infinity, hex, surrounding blanks -- goes through strtod on a
+ * NUL-terminated copy, which must be consumed entirely.
+ */
+double k0_str_toDouble(const k0_str *s) {
+    const char *p = s->data, *end = p + s->len;
+    int neg = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) p++;
+
+    uint64_t m = 0;
+    int digits = 0, scale = 0, any = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++, any = 1) {
+        if (m == 0 && *p == '0') continue;
+        m = m * 10 + (*p - '0');
+        digits++;
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, any = 1) {
+            if (m == 0 && *p == '0') { scale--; continue; }
+            m = m * 10 + (*p - '0');
+            digits++;
+            scale--;
+        }
+    }
+    if (any && p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        int eneg = q < end && *q == '-';
+        if (q < end && (*q == '-' || *q == '+')) q++;
+        if (q < end && *q >= '0' && *q <= '9') {
+            int e = 0;
+            for (; q < end && *q >= '0' && *q <= '9'; q++)
+                if (e < 10000) e = e * 10 + (*q - '0');
+            scale += eneg ? -e : e;
+            p = q;
+        }
+    }
+    if (any && p == end && digits <= 15 && scale >= -22 && scale <= 22) {
+        double v = scale >= 0 ? (double)m * pow10tab[scale]
+                              : (double)m / pow10tab[-scale];
+        return neg ? -v : v;
+    }
+
+    char small[64];
+    char *buf = s->len < (int64_t)sizeof small ? small : malloc(s->len + 1);
+    if (!buf) number_format_error(s);
+    memcpy(buf, s->data, s->len);
+    buf[s->len] = '\0';
+    char *stop;
+    double v = strtod(buf, &stop);
+    while (*stop == ' ' || *stop == '\t' || *stop == '\n' || *stop == '\r') stop++;
+    int bad = stop == buf || *stop;
+    if (buf != small) free(buf);
+    if (bad) number_format_error(s);
+    return v;
+}
+
+/*
+ * java.util.Random: xoshiro256** with the state in k0_rng so compiled
+ * code can step it inline (see O_RAND in codegen.c).  It is seeded
+ * before main (and again by k0_runtime_reinit), from the kernel's
+ * entropy, or from $K0_SEED for a reproducible run.
+ */
+uint64_t k0_rng[4];
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t rng_next(void) {
+    uint64_t *s = k0_rng;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+__attribute__((constructor))
+static void k0_rng_init(void) {
+    uint64_t seed;
+    const char *env = getenv("K0_SEED");
+    if (env && *env) {
+        seed = strtoull(env, NULL, 0);
+    } else if (getentropy(&seed, sizeof seed) != 0) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        seed = ((uint64_t)ts.tv_sec << 32) ^ ts.tv_nsec ^ ((uint64_t)getpid() << 16);
+    }
+    /* splitmix64 never yields an all-zero xoshiro state */
+    for (int i = 0; i < 4; i++) k0_rng[i] = splitmix64(&seed);
+}
+
+void k0_runtime_reinit(void) {
+    outlen = 0;
+    line_buffered = isatty(1);
+    k0_rng_init();
+}
+
+/* nextInt(): all 32-bit values, from the high bits */
+int k0_rand_int(void) {
+    return (int)(rng_next() >> 32);
+}
+
+/*
+ * nextInt(n), Lemire's multiply-shift: the high word of x * n for a
+ * 32-bit x is in [0, n), and rejecting the few x whose low word falls
+ * below 2^32 mod n removes the bias.  That remainder is only needed when
+ * the low word is below n, which the inline code checks before calling
+ * here with its product m.
+ */
+int k0_rand_bounded_slow(int n, uint64_t m) {
+    if (n <= 0) {
+        k0_flush();
+        fprintf(stderr, "Exception in thread \"main\" java.lang.IllegalArgumentException: "
+                        "bound must be positive\n");
+        exit(1);
+    }
+    uint32_t t = (0u - (uint32_t)n) % (uint32_t)n;
+    while ((uint32_t)m < t)
+        m = (rng_next() >> 32) * (uint32_t)n;
+    return (int)(m >> 32);
+}
+
+int k0_rand_bounded(int n) {
+    uint64_t m = (rng_next() >> 32) * (uint32_t)n;
+    if (n <= 0 || (uint32_t)m < (uint32_t)n) return k0_rand_bounded_slow(n, m);
+    return (int)(m >> 32);
+}
+
+/* nextDouble(): 53 random bits scaled into [0, 1) */
+double k0_rand_double(void) {
+    return (rng_next() >> 11) * 0x1.0p-53;
+}
+
+/*
+ * HashMap<K, Int> for Int and String keys: open addressing with Robin
+ * Hood probing.  A slot is 16 bytes, so four share a cache line, and
+ * every key sits at most `dist` slots from its home; an insert takes the
+ * slot of any key that is closer to home than itself.  A lookup can then
+ * stop at the first slot whose key is closer to home than the one being
+ * sought, which keeps misses short even at 7/8 load.  Removal shifts the
+ * following keys back instead of leaving tombstones.
+ *
+ * Int keys are stored as is; String keys as the k0_str pointer (strings
+ * are immutable and never freed) with 16 bits of the hash in tag so most
+ * mismatches skip the byte compare.  Iteration is in slot order.
+ */
+struct k0_slot {
+    int64_t key;
+    int32_t value;
+    uint16_t dist;      /* probe distance + 1; 0 marks an empty slot */
+    uint16_t tag;
+};
+
+struct k0_map {
+    int64_t size;
+    uint64_t mask;
+    int shift;          /* 64 - log2(capacity): home = hash >> shift */
+    struct k0_slot *slots;
+};
+
+#define MAP_MIN_BITS 4
+#define FIB 0x9E3779B97F4A7C15ull
+
+static uint64_t hash_int(int64_t key) {
+    return (uint64_t)(uint32_t)key * FIB;
+}
+
+static uint64_t hash_str(const k0_str *s) {
+    const unsigned char *p = (const unsigned char *)s->data;
+    int64_t n = s->len;
+    uint64_t h = 0x243F6A8885A308D3ull ^ (uint64_t)n, w;
+    for (; n >= 8; p += 8, n -= 8) {
+        memcpy(&w, p, 8);
+        h = (h ^ w) * FIB;
+        h ^= h >> 29;
+    }
+    w = 0;
+    memcpy(&w, p, n);
+    h = (h ^ w) * FIB;
+    return (h ^ (h >> 32)) * FIB;
+}
+
+static struct k0_slot *map_slots(int bits) {
+    struct k0_slot *s = calloc((size_t)1 << bits, sizeof *s);
+    if (!s) {
+        k0_flush();
+        fprintf(stderr, "k0: out of memory\n");
+        exit(1);
+    }
+    return s;
+}
+
+k0_map *k0_map_new(void) {
+    k0_map *m = malloc(sizeof *m);
+    if (!m) {
+        k0_flush();
+        fprintf(stderr, "k0: out of memory\n");
+        exit(1);
+    }
+    m->size = 0;
+    m->mask = (1u << MAP_MIN_BITS) - 1;
+    m->shift = 64 - MAP_MIN_BITS;
+    m->slots = map_slots(MAP_MIN_BITS);
+    return m;
+}
+
+static int key_eq(const struct k0_slot *s, int64_t key, uint16_t tag, int str) {
+    if (s->key == key) return 1;
+    return str && s->tag == tag &&
+           k0_str_equals((const k0_str *)s->key, (const k0_str *)key);
+}
+
+static struct k0_slot *map_find(const k0_map *m, int64_t key, uint64_t h, int str) {
+    uint64_t i = h >> m->shift;
+    uint16_t tag = (uint16_t)h;
+    for (unsigned d = 1;; d++, i = (i + 1) & m->mask) {
+        struct k0_slot *s = &m->slots[i];
+        if (s->dist < d) return NULL;
+        if (key_eq(s, key, tag, str)) return s;
+    }
+}
+
+static uint64_t slot_hash(const struct k0_slot *s, int str) {
+    return str ? hash_str((const k0_str *)s->key) : hash_int(s->key);
+}
+
+/*
+ * Give the absent key *e a slot.  Returns 0 if some probe got too long
+ * for dist; *e is then the key that was left without a slot.
+ */
+static int map_place(k0_map *m, struct k0_slot *e, uint64_t h) {
+    uint64_t i = h >> m->shift;
+    for (e->dist = 1;; e->dist++, i = (i + 1) & m->mask) {
+        struct k0_slot *s = &m->slots[i];
+        if (s->dist == 0) {
+            *s = *e;
+            return 1;
+        }
+        if (s->dist < e->dist) {
+            struct k0_slot t = *s;
+            *s = *e;
+            *e = t;
+        }
+        if (e->dist == UINT16_MAX) return 0;
+    }
+}
+
+static void map_grow(k0_map *m, int str) {
+    struct k0_slot *old = m->slots;
+    uint64_t n = m->mask + 1;
+    for (int bits = 64 - m->shift + 1;; bits++) {
+        m->slots = map_slots(bits);
+        m->mask = ((uint64_t)1 << bits) - 1;
+        m->shift = 64 - bits;
+        uint64_t i;
+        for (i = 0; i < n; i++) {
+            struct k0_slot e = old[i];
+            if (e.dist && !map_place(m, &e, slot_hash(&e, str))) break;
+        }
+        if (i == n) break;
+        free(m->slots);
+    }
+    free(old);
+}
+
+static void map_put(k0_map *m, int64_t key, uint64_t h, int str, int value) {
+    struct k0_slot *s = map_find(m, key, h, str);
+    if (s) {
+        s->value = value;
+        return;
+    }
+    if ((uint64_t)(m->size + 1) > (m->mask + 1) - ((m->mask + 1) >> 3))
+        map_grow(m, str);
+    struct k0_slot e = { key, value, 0, (uint16_t)h };
+    while (!map_place(m, &e, h)) {
+        map_grow(m, str);
+        h = slot_hash(&e, str);
+    }
+    m->size++;
+}
+
+static int map_remove(k0_map *m, int64_t key, uint64_t h, int str) {
+    struct k0_slot *s = map_find(m, key, h, str);
+    if (!s) return 0;
+    int value = s->value;
+    uint64_t i = s - m->slots, j = (i + 1) & m->mask;
+    while (m->slots[j].dist > 1) {
+        m->slots[i] = m->slots[j];
+        m->slots[i].dist--;
+        i = j;
+        j = (j + 1) & m->mask;
+    }
+    m->slots[i].dist = 0;
+    m->size--;
+    return value;
+}
+
+int k0_map_get_int(const k0_map *m, int key) {
+    struct k0_slot *s = map_find(m, key, hash_int(key), 0);
+    return s ? s->value : 0;
+}
+
+int k0_map_get_str(const k0_map *m, const k0_str *key) {
+    struct k0_slot *s = map_find(m, (int64_t)key, hash_str(key), 1);
+    return s ? s->value : 0;
+}
+
+int k0_map_getOrDefault_int(const k0_map *m, int key, int dflt) {
+    struct k0_slot *s = map_find(m, key, hash_int(key), 0);
+    return s ? s->value : dflt;
+}
+
+int k0_map_getOrDefault_str(const k0_map *m, const k0_str *key, int dflt) {
+    struct k0_slot *s = map_find(m, (int64_t)key, hash_str(key), 1);
+    return s ? s->value : dflt;
+}
+
+int k0_map_containsKey_int(const k0_map *m, int key) {
+    return map_find(m, key, hash_int(key), 0) != NULL;
+}
+
+int k0_map_containsKey_str(const k0_map *m, const k0_str *key) {
+    return map_find(m, (int64_t)key, hash_str(key), 1) != NULL;
+}
+
+void k0_map_put_int(k0_map *m, int key, int value) {
+    map_put(m, key, hash_int(key), 0, value);
+}
+
+void k0_map_put_str(k0_map *m, const k0_str *key, int value) {
+    map_put(m, (int64_t)key, hash_str(key), 1, value);
+}
+
+int k0_map_remove_int(k0_map *m, int key) {
+    return map_remove(m, key, hash_int(key), 0);
+}
+
+int k0_map_remove_str(k0_map *m, const k0_str *key) {
+    return map_remove(m, (int64_t)key, hash_str(key), 1);
+}
+
+int k0_map_size(const k0_map *m) {
+    return (int)m->size;
+}
+
+/* the slot after position i (0 to start) that holds a key, plus one; 0 at the end */
+int k0_map_next(const k0_map *m, int i) {
+    for (uint64_t n = m->mask + 1; (uint64_t)i < n; i++)
+        if (m->slots[i].dist) return i + 1;
+    return 0;
+}
+
+int64_t k0_map_key(const k0_map *m, int i) {
+    return m->slots[i - 1].key;
+}
+
+/*
+ * Arrays: the elements follow a 16-byte header whose first word is the
+ * length, and an array value points at element 0, so indexing needs no
+ * adjustment and the data stays 16-byte aligned.  Elements are `bits`
+ * wide (1 for a Boolean bitset), rounded up to whole 8-byte words so a
+ * bitset can be read a word at a time.
+ */
+#define ARRAY_HEADER 16
+
+static void *array_new(int64_t n, int bits, int zero) {
+    if (n < 0) {
+        k0_flush();
+        fprintf(stderr, "Exception in thread \"main\" java.lang.NegativeArraySizeException: "
+                        "%lld\n", (long long)n);
+        exit(1);
+    }
+    size_t bytes = ARRAY_HEADER + ((size_t)n * (size_t)bits + 63) / 64 * 8;
+    char *p = zero ? calloc(1, bytes) : malloc(bytes);
+    if (!p) {
+        k0_flush();
+        fprintf(stderr, "k0: out of memory\n");
+        exit(1);
+    }
+    *(int64_t *)p = n;
+    return p + ARRAY_HEADER;
+}
+
+void *k0_array_new(int64_t n, int bits) {
+    return array_new(n, bits, 1);
+}
+
+void *k0_array_alloc(int64_t n, int bits) {
+    return array_new(n, bits, 0);
+}
+
+static int64_t array_len(const void *a) {
+    return ((const int64_t *)a)[-2];
+}
+
+/* a failed bounds check; the compiler calls this instead of indexing */
+void k0_array_index_error(int index, int64_t len) {
+    k0_flush();
+    fprintf(stderr, "Exception in thread \"main\" java.lang.ArrayIndexOutOfBoundsException: "
+                    "Index %d out of bounds for length %lld\n", index, (long long)len);
+    exit(1);
+}
+
+static void no_such_element(void) {
+    k0_flush();
+    fprintf(stderr, "Exception in thread \"main\" java.util.NoSuchElementException: "
+                    "Array is empty.\n");
+    exit(1);
+}
+
+void k0_array_fill_int(int *a, int v) {
+    int64_t n = array_len(a), i = 0;
+    __m128i x = _mm_set1_epi32(v);
+    for (; i + 8 <= n; i += 8) {
+        _mm_store_si128((__m128i *)(a + i), x);
+        _mm_store_si128((__m128i *)(a + i + 4), x);
+    }
+    for (; i < n; i++) a[i] = v;
+}
+
+/* Array<T>(n) {v} for the element widths the inline Int fill does not cover */
+void k0_array_fill_byte(int8_t *a, int v) {
+    memset(a, v, (size_t)array_len(a));
+}
+
+void k0_array_fill_short(int16_t *a, int v) {
+    int64_t n = array_len(a);
+    for (int64_t i = 0; i < n; i++) a[i] = (int16_t)v;
+}
+
+void k0_array_fill_long(int64_t *a, int v) {
+    int64_t n = array_len(a);
+    for (int64_t i = 0; i < n; i++) a[i] = v;
+}
+
+void k0_array_fill_double(double *a, double v) {
+    int64_t n = array_len(a);
+    for (int64_t i = 0; i < n; i++) a[i] = v;
+}
+
+void k0_array_fill_ptr(const void **a, const void *v) {
+    int64_t n = array_len(a);
+    for (int64_t i = 0; i < n; i++) a[i] = v;
+}
+
+/* whole words at once; the bits past the end are never read */
+void k0_array_fill_bool(uint64_t *a, int v) {
+    memset(a, v ? 0xff : 0, (size_t)(array_len(a) + 63) / 64 * 8);
+}
+
+/* copyOf(n): the first n elements, padded with zeros past the end of a */
+int *k0_array_copyOf_int(const int *a, int n) {
+    int64_t len = array_len(a);
+    int *b = array_new(n, 32, n > len);
+    memcpy(b, a, (size_t)(n < len ? n : len) * sizeof *b);
+    return b;
+}
+
+/* wraps like Int addition does */
+int k0_array_sum_int(const int *a) {
+    int64_t n = array_len(a), i = 0;
+    __m128i s0 = _mm_setzero_si128(), s1 = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8) {
+        s0 = _mm_add_epi32(s0, _mm_load_si128((const __m128i *)(a + i)));
+        s1 = _mm_add_epi32(s1, _mm_load_si128((const __m128i *)(a + i + 4)));
+    }
+    s0 = _mm_add_epi32(s0, s1);
+    s0 = _mm_add_epi32(s0, _mm_shuffle_epi32(s0, _MM_SHUFFLE(1, 0, 3, 2)));
+    s0 = _mm_add_epi32(s0, _mm_shuffle_epi32(s0, _MM_SHUFFLE(2, 3, 0, 1)));
+    uint32_t s = (uint32_t)_mm_cvtsi128_si32(s0);
+    for (; i < n; i++) s += (uint32_t)a[i];
+    return (int)s;
+}
+
+/* SSE2 has no pminsd/pmaxsd: select with a compare mask instead */
+static __m128i select_epi32(__m128i take_a, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(take_a, a), _mm_andnot_si128(take_a, b));
+}
+
+static int array_extreme(const int *a, int want_max) {
+    int64_t n = array_len(a), i = 4;
+    if (n == 0) no_such_element();
+    if (n < 8) {
+        int m = a[0];
+        for (i = 1; i < n; i++)
+            if (want_max ? a[i] > m : a[i] < m) m = a[i];
+        return m;
+    }
+    __m128i m = _mm_load_si128((const __m128i *)a);
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_load_si128((const __m128i *)(a + i));
+        m = select_epi32(want_max ? _mm_cmpgt_epi32(x, m) : _mm_cmplt_epi32(x, m), x, m);
+    }
+    int lanes[4], r;
+    _mm_storeu_si128((__m128i *)lanes, m);
+    r = lanes[0];
+    for (int k = 1; k < 4; k++)
+        if (want_max ? lanes[k] > r : lanes[k] < r) r = lanes[k];
+    for (; i < n; i++)
+        if (want_max ? a[i] > r : a[i] < r) r = a[i];
+    return r;
+}
+
+int k0_array_min_int(const int *a) {
+    return array_extreme(a, 0);
+}
+
+int k0_array_max_int(const int *a) {
+    return array_extreme(a, 1);
+}
+
+/* first index of v, or -1; compares four elements per step */
+int k0_array_indexOf_int(const int *a, int v) {
+    int64_t n = array_len(a), i = 0;
+    __m128i x = _mm_set1_epi32(v);
+    for (; i + 4 <= n; i += 4) {
+        unsigned hit = _mm_movemask_ps(_mm_castsi128_ps(
+            _mm_cmpeq_epi32(_mm_load_si128((const __m128i *)(a + i)), x)));
+        if (hit) return (int)i + __builtin_ctz(hit);
+    }
+    for (; i < n; i++)
+        if (a[i] == v) return (int)i;
+    return -1;
+}
+
+static void insertion_sort_int(int *a, int64_t n) {
+    for (int64_t i = 1; i < n; i++) {
+        int v = a[i];
+        int64_t j = i;
+        for (; j > 0 && a[j - 1] > v; j--) a[j] = a[j - 1];
+        a[j] = v;
+    }
+}
+
+/*
+ * sort(): LSD radix sort, three passes of 11 bits over the keys with the
+ * sign bit flipped so negative numbers order first.  All three counts
+ * are taken in one read of the input, and a pass whose digit is the same
+ * for every key is skipped.  Short arrays use insertion sort.
+ */
+#define RADIX_BITS 11
+#define RADIX_SIZE (1 << RADIX_BITS)
+
+void k0_array_sort_int(int *a) {
+    int64_t n = array_len(a);
+    if (n <= 64) {
+        insertion_sort_int(a, n);
+        return;
+    }
+    uint32_t *src = (uint32_t *)a;
+    uint32_t *tmp = malloc((size_t)n * sizeof *tmp);
+    int64_t (*count)[RADIX_SIZE] = calloc(3, sizeof *count);
+    if (!tmp || !count) {
+        k0_flush();
+        fprintf(stderr, "k0: out of memory\n");
+        exit(1);
+    }
+    for (int64_t i = 0; i < n; i++) {
+        uint32_t k = src[i] ^ 0x80000000u;
+        count[0][k & (RADIX_SIZE - 1)]++;
+        count[1][(k >> RADIX_BITS) & (RADIX_SIZE - 1)]++;
+        count[2][k >> (2 * RADIX_BITS)]++;
+    }
+    uint32_t *from = src, *to = tmp;
+    for (int pass = 0; pass < 3; pass++) {
+        int shift = pass * RADIX_BITS;
+        int64_t *c = count[pass];
+        if (c[((from[0] ^ 0x80000000u) >> shift) & (RADIX_SIZE - 1)] == n)
+            continue;
+        int64_t sum = 0;
+        for (int d = 0; d < RADIX_SIZE; d++) {
+            int64_t t = c[d];
+            c[d] = sum;
+            sum += t;
+        }
+        for (int64_t i = 0; i < n; i++) {
+            uint32_t k = from[i];
+            to[c[((k ^ 0x80000000u) >> shift) & (RADIX_SIZE - 1)]++] = k;
+        }
+        uint32_t *t = from;
+        from = to;
+        to = t;
+    }
+    if (from != src) memcpy(src, from, (size_t)n * sizeof *src);
+    free(tmp);
+    free(count);
+}
+
+/*
+ * Array<Double> kernels.  Kotlin's DoubleArray is the model: sum adds
+ * left to right (so no reassociation, the result rounds as the loop
+ * would), min and max return NaN if any element is NaN and order -0.0
+ * below 0.0, indexOf compares with ==, and sort puts -0.0 before 0.0
+ * and NaN last.
+ */
+double *k0_array_copyOf_double(const double *a, int n) {
+    int64_t len = array_len(a);
+    double *b = array_new(n, 64, n > len);
+    memcpy(b, a, (size_t)(n < len ? n : len) * sizeof *b);
+    return b;
+}
+
+double k0_array_sum_double(const double *a) {
+    int64_t n = array_len(a);
+    double s = 0.0;
+    for (int64_t i = 0; i < n; i++) s += a[i];
+    return s;
+}
+
+/* Math.min / Math.max on two values */
+static double extreme_of(double a, double b, int want_max) {
+    if (a != a) return a;
+    if (b != b) return b;
+    if (a == b) return (signbit(a) != 0) == want_max ? b : a;
+    return (want_max ? a > b : a < b) ? a : b;
+}
+
+static double array_extreme_double(const double *a, int want_max) {
+    int64_t n = array_len(a), i = 1;
+    if (n == 0) no_such_element();
+    double r = a[0];
+    if (n >= 4) {
+        __m128d m = _mm_load_pd(a), nan = _mm_cmpunord_pd(m, m);
+        for (i = 2; i + 2 <= n; i += 2) {
+            __m128d x = _mm_load_pd(a + i);
+            nan = _mm_or_pd(nan, _mm_cmpunord_pd(x, x));
+            m = want_max ? _mm_max_pd(m, x) : _mm_min_pd(m, x);
+        }
+        if (_mm_movemask_pd(nan)) return NAN;
+        double lanes[2];
+        _mm_storeu_pd(lanes, m);
+        r = extreme_of(lanes[0], lanes[1], want_max);
+    }
+    for (; i < n; i++)
+        r = extreme_of(r, a[i], want_max);
+    /* minpd/maxpd take -0.0 and 0.0 as equal: settle a zero's sign */
+    if (r == 0)
+        for (i = 0; i < n; i++) r = extreme_of(r, a[i], want_max);
+    return r;
+}
+
+double k0_array_min_double(const double *a) {
+    return array_extreme_double(a, 0);
+}
+
+double k0_array_max_double(const double *a) {
+    return array_extreme_double(a, 1);
+}
+
+/* first index of an element == v, or -1; two elements per step */
+int k0_array_indexOf_double(const double *a, double v) {
+    int64_t n = array_len(a), i = 0;
+    __m128d x = _mm_set1_pd(v);
+    for (; i + 2 <= n; i += 2) {
+        unsigned hit = _mm_movemask_pd(_mm_cmpeq_pd(_mm_load_pd(a + i), x));
+        if (hit) return (int)i + __builtin_ctz(hit);
+    }
+    for (; i < n; i++)
+        if (a[i] == v) return (int)i;
+    return -1;
+}
+
+/* the bits of v as an unsigned key that orders like v; every NaN is one
+   key above +Infinity */
+static uint64_t double_key(uint64_t bits) {
+    if ((bits & 0x7fffffffffffffffull) > 0x7ff0000000000000ull)
+        bits = 0x7ff8000000000000ull;
+    return bits >> 63 ? ~bits : bits | 0x8000000000000000ull;
+}
+
+static uint64_t key_double(uint64_t k) {
+    return k >> 63 ? k & 0x7fffffffffffffffull : ~k;
+}
+
+/*
+ * sort(): the Int sort's radix passes over 64-bit keys, six of 11 bits,
+ * after mapping each double to a key that orders as sort must.
+ */
+void k0_array_sort_double(double *a) {
+    int64_t n = array_len(a);
+    uint64_t *src = (uint64_t *)a;
+    for (int64_t i = 0; i < n; i++) src[i] = double_key(src[i]);
+    if (n <= 64) {
+        for (int64_t i = 1; i < n; i++) {
+            uint64_t v = src[i];
+            int64_t j = i;
+            for (; j > 0 && src[j - 1] > v; j--) src[j] = src[j - 1];
+            src[j] = v;
+        }
+    } else {
+        uint64_t *tmp = malloc((size_t)n * sizeof *tmp);
+        int64_t (*count)[RADIX_SIZE] = calloc(6, sizeof *count);
+        if (!tmp || !count) {
+            k0_flush();
+            fprintf(stderr, "k0: out of memory\n");
+            exit(1);
+        }
+        for (int64_t i = 0; i < n; i++)
+            for (int pass = 0; pass < 6; pass++)
+                count[pass][(src[i] >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)]++;
+        uint64_t *from = src, *to = tmp;
+        for (int pass = 0; pass < 6; pass++) {
+            int shift = pass * RADIX_BITS;
+            int64_t *c = count[pass];
+            if (c[(from[0] >> shift) & (RADIX_SIZE - 1)] == n)
+                continue;
+            int64_t sum = 0;
+            for (int d = 0; d < RADIX_SIZE; d++) {
+                int64_t t = c[d];
+                c[d] = sum;
+                sum += t;
+            }
+            for (int64_t i = 0; i < n; i++) {
+                uint64_t k = from[i];
+                to[c[(k >> shift) & (RADIX_SIZE - 1)]++] = k;
+            }
+            uint64_t *t = from;
+            from = to;
+            to = t;
+        }
+        if (from != src) memcpy(src, from, (size_t)n * sizeof *src);
+        free(tmp);
+        free(count);
+    }
+    for (int64_t i = 0; i < n; i++) src[i] = key_double(src[i]);
+}
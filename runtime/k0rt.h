@@ -0,0 +1,129 @@
+#ifndef K0RT_H
+#define K0RT_H
+
+#include <stdint.h>
+
+/*
+ * k0 runtime library (libk0rt.a), linked into every k0 program.
+ * Output goes through one userspace buffer that is flushed at exit,
+ * before input is read, and at every newline when stdout is a terminal.
+ */
+
+/*
+ * A String is a pointer to one of these.  The compiler reads len (offset
+ * 0) and data (offset 8) directly for .length and get(i).
+ */
+typedef struct k0_str {
+    int64_t len;
+    const char *data;
+} k0_str;
+
+void k0_print_str(const k0_str *s);
+void k0_print_int(int v);
+void k0_println_int(int v);
+void k0_print_double(double v);
+void k0_println_double(double v);
+void k0_flush(void);
+
+/*
+ * Start over as if the process had just begun: set up again for the
+ * current fd 1 and $K0_SEED.  For a process forked from a k0 -server to
+ * run someone else's program.
+ */
+void k0_runtime_reinit(void);
+
+/* shortest text that reads back as v, in Kotlin's format; returns length */
+int k0_dtoa(double v, char *out);
+
+/*
+ * Input is read from stdin in large chunks; readln returns lines in
+ * place without copying them.  toInt/toDouble follow Kotlin's syntax and
+ * exit with a NumberFormatException message on bad input.
+ */
+k0_str *k0_readln(void);
+int k0_str_toInt(const k0_str *s);
+double k0_str_toDouble(const k0_str *s);
+
+/* substring returns a view; equals and compare scan 16 bytes at a time */
+k0_str *k0_str_view(const char *data, int64_t len);
+k0_str *k0_str_alloc(int64_t len);
+k0_str *k0_str_substring(const k0_str *s, int begin, int end);
+int k0_str_equals(const k0_str *a, const k0_str *b);
+int k0_str_compare(const k0_str *a, const k0_str *b);
+void k0_str_index_error(int index, int64_t len);
+k0_str *k0_str_from_int(int v);
+k0_str *k0_str_from_double(double v);
+k0_str *k0_str_from_bool(int v);
+
+/*
+ * "a$x" and a + b: the parts are passed in order, then k0_cat_end
+ * returns the new String, allocated once at its final length.
+ */
+void k0_cat_str(const k0_str *s);
+void k0_cat_int(int v);
+void k0_cat_double(double v);
+void k0_cat_bool(int v);
+k0_str *k0_cat_end(void);
+
+/*
+ * HashMap<K, Int>, K Int or String, as a Robin Hood hash table.  A
+ * missing key reads as 0.  Iteration: i = k0_map_next(m, i) from 0 until
+ * it returns 0, with the key of each step in k0_map_key(m, i).
+ */
+typedef struct k0_map k0_map;
+k0_map *k0_map_new(void);
+int k0_map_get_int(const k0_map *m, int key);
+int k0_map_get_str(const k0_map *m, const k0_str *key);
+int k0_map_getOrDefault_int(const k0_map *m, int key, int dflt);
+int k0_map_getOrDefault_str(const k0_map *m, const k0_str *key, int dflt);
+int k0_map_containsKey_int(const k0_map *m, int key);
+int k0_map_containsKey_str(const k0_map *m, const k0_str *key);
+void k0_map_put_int(k0_map *m, int key, int value);
+void k0_map_put_str(k0_map *m, const k0_str *key, int value);
+int k0_map_remove_int(k0_map *m, int key);
+int k0_map_remove_str(k0_map *m, const k0_str *key);
+int k0_map_size(const k0_map *m);
+int k0_map_next(const k0_map *m, int i);
+int64_t k0_map_key(const k0_map *m, int i);
+
+/*
+ * java.util.Random, a xoshiro256** generator seeded at startup.  Compiled
+ * code steps k0_rng inline and only calls k0_rand_bounded_slow for the
+ * rare rejection step of nextInt(n).
+ */
+extern uint64_t k0_rng[4];
+int k0_rand_int(void);
+int k0_rand_bounded(int n);
+int k0_rand_bounded_slow(int n, uint64_t m);
+double k0_rand_double(void);
+
+/*
+ * Arrays: an array value points at element 0, 16 bytes past the start
+ * of the allocation, and the length is the int64 at offset -16 (the
+ * compiler reads it there for .size).  Elements are `bits` wide, 1 for
+ * Array<Boolean>.  k0_array_new zeroes the elements.
+ */
+void *k0_array_new(int64_t n, int bits);
+void *k0_array_alloc(int64_t n, int bits);
+void k0_array_index_error(int index, int64_t len);
+void k0_array_fill_byte(int8_t *a, int v);
+void k0_array_fill_short(int16_t *a, int v);
+void k0_array_fill_long(int64_t *a, int v);
+void k0_array_fill_double(double *a, double v);
+void k0_array_fill_ptr(const void **a, const void *v);
+void k0_array_fill_bool(uint64_t *a, int v);
+void k0_array_sort_int(int *a);
+void k0_array_fill_int(int *a, int v);
+int *k0_array_copyOf_int(const int *a, int n);
+int k0_array_sum_int(const int *a);
+int k0_array_min_int(const int *a);
+int k0_array_max_int(const int *a);
+int k0_array_indexOf_int(const int *a, int v);
+void k0_array_sort_double(double *a);
+double *k0_array_copyOf_double(const double *a, int n);
+double k0_array_sum_double(const double *a);
+double k0_array_min_double(const double *a);
+double k0_array_max_double(const double *a);
+int k0_array_indexOf_double(const double *a, double v);
+
+#endif
@@ -25,6 +25,11 @@ int check_type_compatibility(typeptr expected, typeptr actual) {
     
     if (expected == actual)
         return 1;
+
+    /* Array<Byte> and Array<Int> hold Ints of different widths */
+    if (expected->basetype == ARRAY_TYPE && actual->basetype == ARRAY_TYPE)
+        return expected->u.a.elemtype == actual->u.a.elemtype &&
+               expected->u.a.elembits == actual->u.a.elembits;
     
     if (expected->basetype == actual->basetype)
         return 1;
@@ -52,7 +57,10 @@ void flattenExpressionList(struct tree *exprList, struct tree ***args, int *coun
             flattenExpressionList(exprList->kids[i], args, count);
         }
     } else {
-        *args = realloc(*args, ((*count) + 1) * sizeof(struct tree *));
+        /* double the array whenever the count reaches 0 or a power of two */
+        int n = *count;
+        if (n == 0 || (n & (n - 1)) == 0)
+            *args = realloc(*args, (n ? 2 * n : 1) * sizeof(struct tree *));
         if (!(*args)) {
             fprintf(stderr, "Memory allocation failed in flattenExpressionList\n");
             exit(1);
@@ -123,10 +131,70 @@ int is_null_literal(struct tree *t) {
     return 0;
 }
 
+int is_map_constructor(struct tree *t) {
+    if (!t || !t->symbolname || strcmp(t->symbolname, "functionCall") != 0)
+        return 0;
+    struct tree *callee = t->kids[0];
+    if (!callee || !callee->leaf)
+        return 0;
+    return strcmp(callee->leaf->text, "HashMap") == 0 ||
+           strcmp(callee->leaf->text, "hashMapOf") == 0 ||
+           strcmp(callee->leaf->text, "mutableMapOf") == 0;
+}
+
+/* a map operation's key (and value) against the receiver's HashMap<K, V> */
+static void check_map_args(typeptr map, struct tree **args, int actual,
+                           int has_value, int lineno) {
+    if (actual >= 1 && !check_type_compatibility(map->u.m.keytype, args[0]->type))
+        report_semantic_error("HashMap key has the wrong type", lineno);
+    if (has_value && actual >= 2 &&
+        !check_type_compatibility(map->u.m.valtype, args[1]->type))
+        report_semantic_error("HashMap value has the wrong type", lineno);
+}
+
+/*
+ * An Array method's element-typed argument and result: fill(v) and
+ * indexOf(v) take an element, sum/min/max return one and copyOf returns
+ * the array type.  The runtime kernels are for Int and Double elements,
+ * and a Double array's fill(v) and indexOf(v) take only a Double, as
+ * in Kotlin.
+ */
+static typeptr check_array_method(typeptr arr, SymbolTableEntry method,
+                                  struct tree **args, int actual, int lineno) {
+    const char *name = method->s + strlen("Array.");
+    int dbl = arr->u.a.elemtype == double_typeptr;
+    if (!(arr->u.a.elemtype == integer_typeptr && arr->u.a.elembits == 32) && !dbl) {
+        report_semantic_error("Array methods need an Array<Int> or Array<Double>", lineno);
+        return method->type->u.f.returntype;
+    }
+    if ((strcmp(name, "fill") == 0 || strcmp(name, "indexOf") == 0) && actual == 1 &&
+        (dbl ? args[0]->type != double_typeptr
+             : !check_type_compatibility(arr->u.a.elemtype, args[0]->type)))
+        report_semantic_error("Array element has the wrong type", lineno);
+    if (strcmp(name, "sum") == 0 || strcmp(name, "min") == 0 ||
+        strcmp(name, "max") == 0)
+        return arr->u.a.elemtype;
+    if (strcmp(name, "copyOf") == 0)
+        return arr;
+    return method->type->u.f.returntype;
+}
+
 void check_semantics_helper(struct tree *t, SymbolTable current_scope) {
     if (!t)
         return;
 
+    if (t->symbolname && strcmp(t->symbolname, "mapType") == 0) {
+        if (!t->type || t->type->basetype != MAP_TYPE) {
+            report_semantic_error("Unknown map type (use HashMap<K, V>)", t->lineno);
+        } else if ((t->type->u.m.keytype != integer_typeptr &&
+                    t->type->u.m.keytype != string_typeptr) ||
+                   t->type->u.m.valtype != integer_typeptr) {
+            report_semantic_error("HashMap keys must be Int or String and values Int",
+                                  t->lineno);
+        }
+        return;
+    }
+
     if (t->symbolname &&
         (strcmp(t->symbolname, "genericType") == 0 ||
         strcmp(t->symbolname, "nullableGenericType") == 0)) {
@@ -162,7 +230,8 @@ void check_semantics_helper(struct tree *t, SymbolTable current_scope) {
     
         if (!t->type
             || t->type->basetype != ARRAY_TYPE
-            || t->type->u.a.elemtype != ctorType->type)
+            || t->type->u.a.elemtype != ctorType->type
+            || t->type->u.a.elembits != array_elem_bits(ctorType))
         {
             report_semantic_error(
               "mismatched Array<…> in declaration",
@@ -244,6 +313,16 @@ void check_semantics_helper(struct tree *t, SymbolTable current_scope) {
             idText = t->kids[0]->leaf->text;
         if (idText) {
             SymbolTableEntry entry = lookup_symbol(current_scope, idText);
+            if (!entry) {
+                entry = lookup_method(current_scope, idText, NULL);
+                /* s.length, m.size and a.size are properties, not calls */
+                if (entry && (strcmp(entry->s, "String.length") == 0 ||
+                              strcmp(entry->s, "HashMap.size") == 0 ||
+                              strcmp(entry->s, "Array.size") == 0)) {
+                    t->type = entry->type->u.f.returntype;
+                    return;
+                }
+            }
             if (entry && entry->type) {
                 t->type = entry->type;
                 t->is_mutable = entry->mutable;
@@ -269,6 +348,29 @@ void check_semantics_helper(struct tree *t, SymbolTable current_scope) {
         current_scope = loop_scope;
     }
 
+    /* for (k in m.keys): k is declared beforehand, like a range loop's */
+    if (t->symbolname && strcmp(t->symbolname, "forStatementKotlinIn") == 0) {
+        struct tree *iter = t->kids[1];
+        SymbolTableEntry map = NULL, keys = NULL;
+        while (iter && !iter->leaf && iter->nkids == 1)
+            iter = iter->kids[0];
+        if (iter && iter->leaf)
+            keys = lookup_method(current_scope, iter->leaf->text, &map);
+        if (!keys || strcmp(keys->s, "HashMap.keys") != 0) {
+            report_semantic_error("for-in loops only iterate over a HashMap's keys", t->lineno);
+        } else {
+            SymbolTableEntry var = lookup_symbol(current_scope, t->kids[0]->leaf->text);
+            if (!var || !check_type_compatibility(var->type, map->type->u.m.keytype))
+                report_semantic_error("Loop variable must be a declared variable of the key type",
+                                      t->lineno);
+            else
+                t->kids[0]->type = var->type;
+            iter->type = map->type;
+        }
+        check_semantics_helper(t->kids[2], current_scope);
+        return;
+    }
+
     if (t->prodrule == 327 && t->scope != NULL) {
         if (t->kids[0] && t->kids[0]->leaf)
         current_scope = t->scope;
@@ -351,6 +453,13 @@ void check_semantics_helper(struct tree *t, SymbolTable current_scope) {
                 initializer->type = declared;
                 // printf("DEBUG: Treating 'Array(...) { ... }' as array initializer\n");
             }
+            if (is_map_constructor(initializer)) {
+                if (declared->basetype == MAP_TYPE)
+                    initializer->type = declared;
+                else
+                    report_semantic_error("HashMap() needs a declared HashMap<K, V> type",
+                                          initializer->lineno);
+            }
         }
     }
 
@@ -369,11 +478,18 @@ void check_semantics_helper(struct tree *t, SymbolTable current_scope) {
             }
         }
 
-        if (t->kids[1] && !check_type_compatibility(t->kids[1]->type, integer_typeptr)) {
+        int is_map = t->kids[0]->type && t->kids[0]->type->basetype == MAP_TYPE;
+        if (t->kids[1] && !is_map && !check_type_compatibility(t->kids[1]->type, integer_typeptr)) {
             report_semantic_error("Array index must be of integer type", t->kids[1]->lineno);
         }
         
-        if (t->kids[0]->type && t->kids[0]->type->basetype == ARRAY_TYPE) {
+        if (is_map) {
+            /* m[k] is m.get(k) */
+            if (!check_type_compatibility(t->kids[0]->type->u.m.keytype, t->kids[1]->type))
+                report_semantic_error("HashMap key has the wrong type", t->kids[1]->lineno);
+            t->type = t->kids[0]->type->u.m.valtype;
+            t->is_mutable = 1;
+        } else if (t->kids[0]->type && t->kids[0]->type->basetype == ARRAY_TYPE) {
             t->type = t->kids[0]->type->u.a.elemtype;
             t->is_mutable = t->kids[0]->is_mutable;
             t->is_nullable = t->kids[0]->is_nullable;
@@ -502,7 +618,10 @@ void check_semantics_helper(struct tree *t, SymbolTable current_scope) {
             }
             
             // printf("DEBUG: Array assignment: array var mutable=%d\n", arrayVar->is_mutable);
-            if (!arrayVar->is_mutable) {
+            if (arrayVar->type && arrayVar->type->basetype == MAP_TYPE) {
+                /* m[k] = v is m.put(k, v); a val map can still change */
+                lhs->type = arrayVar->type->u.m.valtype;
+            } else if (!arrayVar->is_mutable) {
                 report_semantic_error("Assignment to element of immutable array", lhs->lineno);
             }
             
@@ -611,6 +730,9 @@ void check_semantics_helper(struct tree *t, SymbolTable current_scope) {
 
         // printf("DEBUG: Checking function call for '%s' at line %d\n", funcName, t->kids[0]->lineno);
         SymbolTableEntry func_entry = lookup_symbol(current_scope, funcName);
+        SymbolTableEntry receiver = NULL;
+        if (!func_entry)
+            func_entry = lookup_method(current_scope, funcName, &receiver);
         
         if (!func_entry) {
             // printf("DEBUG: Undefined function '%s' in current scope chain starting at %p\n", funcName, current_scope);
@@ -622,7 +744,8 @@ void check_semantics_helper(struct tree *t, SymbolTable current_scope) {
             // printf("DEBUG: Function '%s' expects %d parameter(s), call has %d argument(s).\n",
             //        funcName, func_entry->param_count, actual);
             
-            if (func_entry->param_count != actual) {
+            if (actual > func_entry->param_count ||
+                actual < func_entry->param_count - func_entry->optional_params) {
                 report_semantic_error("Function call argument count mismatch", t->kids[0]->lineno);
             }
             for (int i = 0; i < actual; i++) {
@@ -635,7 +758,15 @@ void check_semantics_helper(struct tree *t, SymbolTable current_scope) {
                     report_semantic_error(errMsg, args[i]->lineno);
                 }
             }
-            if (func_entry->type && func_entry->type->u.f.returntype) {
+            if (receiver && receiver->type->basetype == MAP_TYPE)
+                check_map_args(receiver->type, args, actual,
+                               strcmp(func_entry->s, "HashMap.put") == 0 ||
+                               strcmp(func_entry->s, "HashMap.getOrDefault") == 0,
+                               t->kids[0]->lineno);
+            if (receiver && receiver->type->basetype == ARRAY_TYPE) {
+                t->type = check_array_method(receiver->type, func_entry, args, actual,
+                                             t->kids[0]->lineno);
+            } else if (func_entry->type && func_entry->type->u.f.returntype) {
                 t->type = func_entry->type->u.f.returntype;
             } else {
                 // printf("DEBUG: Function '%s' has no recorded return type.\n", funcName);
@@ -651,6 +782,16 @@ void check_semantics_helper(struct tree *t, SymbolTable current_scope) {
             idText = t->kids[0]->leaf->text;
         if (idText) {
             SymbolTableEntry entry = lookup_symbol(current_scope, idText);
+            if (!entry) {
+                entry = lookup_method(current_scope, idText, NULL);
+                /* s.length, m.size and a.size are properties, not calls */
+                if (entry && (strcmp(entry->s, "String.length") == 0 ||
+                              strcmp(entry->s, "HashMap.size") == 0 ||
+                              strcmp(entry->s, "Array.size") == 0)) {
+                    t->type = entry->type->u.f.returntype;
+                    return;
+                }
+            }
             if (entry && entry->type) {
                 t->type = entry->type;
                 // printf("DEBUG: Resolved leaf identifier '%s' to type %s\n", idText, typename(entry->type));
@@ -10,5 +10,6 @@ int check_type_compatibility(typeptr expected, typeptr actual);
 void report_semantic_error(const char *msg, int lineno);
 int is_operator(int prodrule);
 int is_null_literal(struct tree *t);
+int is_map_constructor(struct tree *t);
 
 #endif
@@ -0,0 +1,296 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "server.h"
+
+extern char **environ;
+
+/*
+ * Compile server.
+ *
+ * k0 -server PATH listens on a Unix socket.  A client (any k0 run with
+ * K0_SERVER=PATH in its environment) connects and sends its stdin,
+ * stdout and stderr as SCM_RIGHTS descriptors, then its working
+ * directory, environment and arguments.  The server forks a child for the request,
+ * which takes over the three descriptors and compiles; when the child
+ * exits, the server sends its exit status back as a 4-byte int.  So
+ * diagnostics, "Intermediate code will be written to ..." and a -run
+ * program's output go straight to the client's terminal, and the client
+ * exits with the status k0 would have.
+ *
+ * Whatever the server set up before accept() -- the builtin symbol
+ * table, the runtime directory -- is inherited warm by every compile,
+ * while the compile's own state (symbol tables, literal tables, label
+ * counters, the tree and the code list) lives in the forked child and
+ * goes away with it.  No request sees another's leftovers.  The child
+ * runs with the client's environment, and compile is expected to set
+ * up again whatever read the server's (the runtime's $K0_SEED and
+ * isatty(1), for -run).
+ *
+ * Message from the client:
+ *   int32 length                   with the three descriptors attached
+ *   cwd \0 env[0] \0 ... env[m-1] \0 \0 argv[0] \0 ... argv[n-1] \0
+ *                                  length bytes
+ * Reply: int32 status, the low 8 bits of the compile's exit status,
+ * or 128 + signal if it was killed.
+ */
+
+#define SERVER_MAX_REQUEST (1 << 20)
+#define SERVER_MAX_ARGS    4096
+
+static int write_all(int fd, const void *buf, size_t n) {
+    const char *p = buf;
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        p += w;
+        n -= w;
+    }
+    return 0;
+}
+
+static int read_all(int fd, void *buf, size_t n) {
+    char *p = buf;
+    while (n > 0) {
+        ssize_t r = read(fd, p, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        p += r;
+        n -= r;
+    }
+    return 0;
+}
+
+static int server_address(const char *path, struct sockaddr_un *a) {
+    memset(a, 0, sizeof *a);
+    a->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof a->sun_path) {
+        fprintf(stderr, "k0: socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(a->sun_path, path);
+    return 0;
+}
+
+/* ---------------------------------------------------------------- server */
+
+/* the length word and the client's fds 0, 1, 2 */
+static int receive_header(int conn, uint32_t *len, int fds[3]) {
+    char control[CMSG_SPACE(3 * sizeof(int))];
+    struct iovec iov = { len, sizeof *len };
+    struct msghdr msg = {
+        .msg_iov = &iov, .msg_iovlen = 1,
+        .msg_control = control, .msg_controllen = sizeof control,
+    };
+    ssize_t r;
+    while ((r = recvmsg(conn, &msg, MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR)
+        ;
+    if (r != sizeof *len) return -1;
+    struct cmsghdr *c = CMSG_FIRSTHDR(&msg);
+    if (!c || c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS ||
+        c->cmsg_len != CMSG_LEN(3 * sizeof(int)))
+        return -1;
+    memcpy(fds, CMSG_DATA(c), 3 * sizeof(int));
+    return 0;
+}
+
+/* in the forked child: read the request, take over its fds and
+   environment, and compile */
+static void handle(int conn, int (*compile)(int argc, char **argv)) {
+    uint32_t len;
+    int fds[3];
+    if (receive_header(conn, &len, fds) || len == 0 || len > SERVER_MAX_REQUEST)
+        _exit(1);
+
+    char *buf = malloc(len + 1);
+    char *argv[SERVER_MAX_ARGS + 1];
+    int argc = 0;
+    if (!buf || read_all(conn, buf, len)) _exit(1);
+    buf[len] = '\0';
+    const char *cwd = buf;
+    char *p = buf + strlen(buf) + 1;
+    clearenv();
+    for (; p < buf + len && *p; p += strlen(p) + 1)
+        putenv(p);
+    if (p >= buf + len) _exit(1);
+    for (p++; p < buf + len && argc < SERVER_MAX_ARGS; p += strlen(p) + 1)
+        argv[argc++] = p;
+    argv[argc] = NULL;
+    if (argc == 0) _exit(1);
+
+    close(conn);
+    for (int k = 0; k < 3; k++) {
+        dup2(fds[k], k);
+        close(fds[k]);
+    }
+    if (chdir(cwd) != 0) {
+        perror(cwd);
+        _exit(1);
+    }
+    int rc = compile(argc, argv);
+    fflush(stdout);
+    fflush(stderr);
+    _exit(rc);
+}
+
+/* requests being compiled: the child and the connection to answer */
+static struct { pid_t pid; int conn; } *running;
+static int nrunning, caprunning;
+
+static void sigchld(int sig) { (void)sig; }
+
+/* send each finished compile's status to its client */
+static void reap(void) {
+    int st;
+    pid_t pid;
+    while ((pid = waitpid(-1, &st, WNOHANG)) > 0) {
+        for (int k = 0; k < nrunning; k++) {
+            if (running[k].pid != pid) continue;
+            int32_t status = WIFEXITED(st) ? WEXITSTATUS(st) : 128 + WTERMSIG(st);
+            write_all(running[k].conn, &status, sizeof status);
+            close(running[k].conn);
+            running[k] = running[--nrunning];
+            break;
+        }
+    }
+}
+
+int serve(const char *path, int (*compile)(int argc, char **argv)) {
+    struct sockaddr_un a;
+    if (server_address(path, &a)) return 1;
+
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        perror("socket");
+        return 1;
+    }
+    unlink(path);
+    if (bind(sock, (struct sockaddr *)&a, sizeof a) < 0 || listen(sock, 64) < 0) {
+        perror(path);
+        return 1;
+    }
+    // SIGCHLD is only let in while waiting in ppoll, so a compile that
+    // finishes between reap() and the wait still wakes the server up
+    struct sigaction sa = { .sa_handler = sigchld };
+    sigset_t chld, waitmask;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGCHLD, &sa, NULL);
+    sigemptyset(&chld);
+    sigaddset(&chld, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &chld, &waitmask);
+    signal(SIGPIPE, SIG_IGN);
+    fprintf(stderr, "k0: serving on %s\n", path);
+
+    for (;;) {
+        reap();
+        struct pollfd pfd = { sock, POLLIN, 0 };
+        if (ppoll(&pfd, 1, NULL, &waitmask) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            return 1;
+        }
+        int conn = accept4(sock, NULL, NULL, SOCK_CLOEXEC);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            perror("accept");
+            return 1;
+        }
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(sock);
+            for (int k = 0; k < nrunning; k++) close(running[k].conn);
+            sa.sa_handler = SIG_DFL;
+            sigaction(SIGCHLD, &sa, NULL);
+            sigprocmask(SIG_SETMASK, &waitmask, NULL);
+            signal(SIGPIPE, SIG_DFL);
+            handle(conn, compile);
+        }
+        if (pid < 0) {
+            perror("fork");
+            close(conn);
+            continue;
+        }
+        if (nrunning == caprunning) {
+            caprunning = caprunning ? 2 * caprunning : 64;
+            running = realloc(running, caprunning * sizeof *running);
+            if (!running) {
+                fprintf(stderr, "out of memory\n");
+                exit(4);
+            }
+        }
+        running[nrunning].pid = pid;
+        running[nrunning++].conn = conn;
+    }
+}
+
+/* ---------------------------------------------------------------- client */
+
+int submit(const char *path, int argc, char **argv) {
+    struct sockaddr_un a;
+    if (server_address(path, &a)) return -1;
+
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) return -1;
+    if (connect(sock, (struct sockaddr *)&a, sizeof a) < 0) {
+        close(sock);
+        return -1;
+    }
+
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof cwd)) {
+        close(sock);
+        return -1;
+    }
+    size_t len = strlen(cwd) + 2;
+    for (char **e = environ; *e; e++)
+        if (**e) len += strlen(*e) + 1;
+    for (int i = 0; i < argc; i++) len += strlen(argv[i]) + 1;
+    char *buf = malloc(len), *p = buf;
+    if (!buf || len > SERVER_MAX_REQUEST) {
+        close(sock);
+        return -1;
+    }
+    p = stpcpy(p, cwd) + 1;
+    for (char **e = environ; *e; e++)
+        if (**e) p = stpcpy(p, *e) + 1;
+    *p++ = '\0';
+    for (int i = 0; i < argc; i++) p = stpcpy(p, argv[i]) + 1;
+
+    uint32_t n = len;
+    int fds[3] = { 0, 1, 2 };
+    char control[CMSG_SPACE(sizeof fds)];
+    struct iovec iov = { &n, sizeof n };
+    struct msghdr msg = {
+        .msg_iov = &iov, .msg_iovlen = 1,
+        .msg_control = control, .msg_controllen = sizeof control,
+    };
+    struct cmsghdr *c = CMSG_FIRSTHDR(&msg);
+    c->cmsg_level = SOL_SOCKET;
+    c->cmsg_type = SCM_RIGHTS;
+    c->cmsg_len = CMSG_LEN(sizeof fds);
+    memcpy(CMSG_DATA(c), fds, sizeof fds);
+
+    int32_t status;
+    int ok = sendmsg(sock, &msg, MSG_NOSIGNAL) == sizeof n &&
+             write_all(sock, buf, len) == 0 &&
+             read_all(sock, &status, sizeof status) == 0;
+    free(buf);
+    close(sock);
+    if (!ok) {
+        fprintf(stderr, "k0: compile server on %s failed the request\n", path);
+        return 1;
+    }
+    return status;
+}
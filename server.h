@@ -0,0 +1,13 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+/*
+ * listen on the Unix socket path and run compile(argc, argv) in a fresh
+ * child for every client request; only returns on an error
+ */
+int serve(const char *path, int (*compile)(int argc, char **argv));
+
+/* have the server at path run k0 argv; its exit status, -1 if no server */
+int submit(const char *path, int argc, char **argv);
+
+#endif
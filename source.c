@@ -0,0 +1,133 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "source.h"
+
+/*
+ * The file being compiled, mapped twice.  The scanner gets a private
+ * copy-on-write view with two NULs after the text (yy_scan_buffer scans
+ * it in place and writes a NUL after each token as it goes); diagnostics
+ * quote from a read-only view of the file as it is on disk, through an
+ * index of where each line starts, made the first time one is needed.
+ */
+static struct source {
+    char *scan;           /* size + 2 bytes, for the scanner */
+    size_t scan_len;      /* bytes mapped or allocated at scan */
+    const char *text;     /* the file itself, size bytes */
+    size_t size;
+    bool mapped;          /* else scan and text were malloc'd */
+    size_t *line;         /* line[n] = offset of line n + 1 */
+    int nlines;
+} src;
+
+/* a pipe or the like cannot be mapped: read it into two buffers */
+static int read_source(int fd) {
+    size_t cap = 8192, n = 0;
+    char *buf = malloc(cap);
+    ssize_t r;
+    while (buf && (r = read(fd, buf + n, cap - n - 2)) != 0) {
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            free(buf);
+            return -1;
+        }
+        n += r;
+        if (cap - n - 2 == 0) buf = realloc(buf, cap *= 2);
+    }
+    char *copy = buf ? malloc(n + 1) : NULL;
+    if (!copy) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+    buf[n] = buf[n + 1] = '\0';
+    memcpy(copy, buf, n);
+    src.scan = buf;
+    src.scan_len = n + 2;
+    src.text = copy;
+    src.size = n;
+    src.mapped = false;
+    return 0;
+}
+
+int map_source(const char *path) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0) return -1;
+    memset(&src, 0, sizeof src);
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        int r = read_source(fd);
+        close(fd);
+        return r;
+    }
+
+    // zero pages with the file laid over the front, so the two NULs past
+    // the end are there even when the size is a multiple of the page
+    size_t size = st.st_size;
+    long page = sysconf(_SC_PAGESIZE);
+    src.scan_len = (size + 2 + page - 1) / page * page;
+    src.scan = mmap(NULL, src.scan_len, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (src.scan == MAP_FAILED ||
+        (size > 0 && mmap(src.scan, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)) {
+        close(fd);
+        return -1;
+    }
+    src.text = size > 0 ? mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0) : "";
+    close(fd);
+    if (src.text == MAP_FAILED) return -1;
+    src.size = size;
+    src.mapped = true;
+    return 0;
+}
+
+void unmap_source(void) {
+    if (src.mapped) {
+        munmap(src.scan, src.scan_len);
+        if (src.size > 0) munmap((void *)src.text, src.size);
+    } else {
+        free(src.scan);
+        free((void *)src.text);
+    }
+    free(src.line);
+    memset(&src, 0, sizeof src);
+}
+
+char *source_buffer(size_t *size) {
+    *size = src.size + 2;
+    return src.scan;
+}
+
+/* line n of the source (from 1) and its length without the newline */
+const char *source_line(int n, size_t *len) {
+    if (!src.line) {
+        int cap = 1024;
+        src.line = malloc(cap * sizeof *src.line);
+        for (const char *p = src.text, *end = src.text + src.size; src.line; ) {
+            if (src.nlines == cap)
+                src.line = realloc(src.line, (cap *= 2) * sizeof *src.line);
+            if (!src.line) break;
+            src.line[src.nlines++] = p - src.text;
+            if (!(p = memchr(p, '\n', end - p))) break;
+            p++;
+        }
+        if (!src.line) {
+            fprintf(stderr, "out of memory\n");
+            exit(4);
+        }
+    }
+    if (n < 1 || n > src.nlines) return NULL;
+    size_t start = src.line[n - 1];
+    size_t end = n < src.nlines ? src.line[n] - 1 : src.size;
+    if (start >= src.size) return NULL;
+    *len = end - start;
+    return src.text + start;
+}
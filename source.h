@@ -0,0 +1,16 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stddef.h>
+
+/* map the file to compile; -1 (errno set) if it can't be read */
+int map_source(const char *path);
+void unmap_source(void);
+
+/* the text for yy_scan_buffer; *size counts the two NULs at the end */
+char *source_buffer(size_t *size);
+
+/* line n (from 1) as it is on disk, *len bytes without the newline */
+const char *source_line(int n, size_t *len);
+
+#endif
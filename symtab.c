@@ -3,6 +3,7 @@
 #include "tree.h"
 
 extern int error_count;
+extern char *strprintf(const char *fmt, ...);
 
 SymbolTable currentFunctionSymtab = NULL;
 
@@ -76,6 +77,9 @@ void insert_symbol(SymbolTable st, char *s, SymbolKind kind, typeptr type, int i
     newEntry->next = st->tbl[index];
     newEntry->mutable = is_mutable;
     newEntry->nullable = is_nullable;
+    newEntry->optional_params = 0;
+    newEntry->param_count = 0;
+    newEntry->param_types = NULL;
 
     if (st->parent == NULL) {
         newEntry->location.region = R_GLOBAL;
@@ -115,11 +119,41 @@ SymbolTableEntry lookup_symbol_current_scope(SymbolTable st, char *s) {
     return NULL;
 }
 
+/*
+ * A call through a variable, like s.toInt: the part before the last dot
+ * names a String variable and the rest picks the "String.<method>" builtin.
+ */
+SymbolTableEntry lookup_method(SymbolTable st, char *s, SymbolTableEntry *receiver) {
+    char *dot = strrchr(s, '.');
+    if (!dot || dot == s) return NULL;
+
+    char *var = strprintf("%.*s", (int)(dot - s), s);
+    SymbolTableEntry recv = lookup_symbol(st, var);
+    free(var);
+    if (!recv || recv->kind != VARIABLE || !recv->type)
+        return NULL;
+
+    const char *class_name;
+    if (recv->type == string_typeptr)
+        class_name = "String";
+    else if (recv->type->basetype == MAP_TYPE)
+        class_name = "HashMap";
+    else if (recv->type->basetype == ARRAY_TYPE)
+        class_name = "Array";
+    else
+        return NULL;
+    char *full = strprintf("%s%s", class_name, dot);
+    SymbolTableEntry method = lookup_symbol(st, full);
+    free(full);
+    if (method && receiver) *receiver = recv;
+    return method;
+}
+
 void check_undeclared(SymbolTable st, char *s) {
     if (strcmp(s, "Array") == 0) 
         return;
 
-    if (!lookup_symbol(st, s)) {
+    if (!lookup_symbol(st, s) && !lookup_method(st, s, NULL)) {
         fprintf(stderr, "Error: Undeclared variable '%s'\n", s);
         error_count++; 
     }
@@ -264,6 +298,10 @@ void add_predefined_symbols(SymbolTable st) {
     insert_symbol(st, "Int", CLASS_TYPE, integer_typeptr, 0, 0);
     insert_symbol(st, "Double", CLASS_TYPE, double_typeptr, 0, 0);
     insert_symbol(st, "Boolean", CLASS_TYPE, boolean_typeptr, 0, 0);
+    /* Ints in k0; only an Array<Byte/Short/Long> keeps their width */
+    insert_symbol(st, "Byte", CLASS_TYPE, integer_typeptr, 0, 0);
+    insert_symbol(st, "Short", CLASS_TYPE, integer_typeptr, 0, 0);
+    insert_symbol(st, "Long", CLASS_TYPE, integer_typeptr, 0, 0);
     insert_symbol(st, "String", CLASS_TYPE, string_typeptr, 0, 0);
     insert_symbol(st, "Unit", CLASS_TYPE, null_typeptr, 0, 1);
     
@@ -275,25 +313,70 @@ void add_predefined_symbols(SymbolTable st) {
     
     insert_method_symbol(st, "", "readln", typeptr_name("String"), 0, NULL);
     
+    /* k0 has no Char: get(i) is the byte's code as an Int */
     char *get_params[] = {"Int"};
-    insert_method_symbol(st, "String", "get", typeptr_name("Char"), 1, get_params);
+    insert_method_symbol(st, "String", "get", typeptr_name("Int"), 1, get_params);
     
     char *equals_params[] = {"String"};
     insert_method_symbol(st, "String", "equals", typeptr_name("Boolean"), 1, equals_params);
+    insert_method_symbol(st, "String", "compareTo", typeptr_name("Int"), 1, equals_params);
     
     insert_method_symbol(st, "String", "length", typeptr_name("Int"), 0, NULL);
     
     char *toString_params[] = {"Int"};  
     insert_method_symbol(st, "String", "toString", typeptr_name("String"), 1, toString_params);
+    lookup_symbol_current_scope(st, "String.toString")->optional_params = 1;
     
     char *valueOf_params[] = {"Any"};
     insert_method_symbol(st, "String", "valueOf", typeptr_name("String"), 1, valueOf_params);
     
     char *substring_params[] = {"Int", "Int"};
     insert_method_symbol(st, "String", "substring", typeptr_name("String"), 2, substring_params);
+    lookup_symbol_current_scope(st, "String.substring")->optional_params = 1;
+
+    insert_method_symbol(st, "String", "toInt", typeptr_name("Int"), 0, NULL);
+    insert_method_symbol(st, "String", "toDouble", typeptr_name("Double"), 0, NULL);
     
     insert_symbol(st, "java.util.Random", CLASS_TYPE, typeptr_name("Type"), 0, 0);
-    insert_method_symbol(st, "java.util.Random", "nextInt", typeptr_name("Int"), 0, NULL);
+    char *nextInt_params[] = {"Int"};
+    insert_method_symbol(st, "java.util.Random", "nextInt", typeptr_name("Int"), 1, nextInt_params);
+    lookup_symbol_current_scope(st, "java.util.Random.nextInt")->optional_params = 1;
+    insert_method_symbol(st, "java.util.Random", "nextDouble", typeptr_name("Double"), 0, NULL);
+    
+    /*
+     * HashMap<K, Int> with Int or String keys.  Keys are checked against
+     * the receiver's K in semantics.c; a missing key reads as 0.
+     */
+    insert_method_symbol(st, "", "HashMap", typeptr_name("Any"), 0, NULL);
+    insert_method_symbol(st, "", "hashMapOf", typeptr_name("Any"), 0, NULL);
+    insert_method_symbol(st, "", "mutableMapOf", typeptr_name("Any"), 0, NULL);
+    insert_symbol(st, "MutableMap", CLASS_TYPE, typeptr_name("Type"), 0, 0);
+    char *key_params[] = {"Any"};
+    char *put_params[] = {"Any", "Int"};
+    insert_method_symbol(st, "HashMap", "get", typeptr_name("Int"), 1, key_params);
+    insert_method_symbol(st, "HashMap", "getOrDefault", typeptr_name("Int"), 2, put_params);
+    insert_method_symbol(st, "HashMap", "put", typeptr_name("Unit"), 2, put_params);
+    insert_method_symbol(st, "HashMap", "containsKey", typeptr_name("Boolean"), 1, key_params);
+    insert_method_symbol(st, "HashMap", "remove", typeptr_name("Int"), 1, key_params);
+    insert_method_symbol(st, "HashMap", "size", typeptr_name("Int"), 0, NULL);
+    insert_method_symbol(st, "HashMap", "keys", typeptr_name("Any"), 0, NULL);
+
+    /*
+     * Array<Int> and Array<Double> methods, run by runtime kernels.  Element-typed
+     * parameters and results are Any here and resolved against the
+     * receiver's element type in semantics.c.
+     */
+    char *elem_params[] = {"Any"};
+    char *copyOf_params[] = {"Int"};
+    insert_method_symbol(st, "Array", "size", typeptr_name("Int"), 0, NULL);
+    insert_method_symbol(st, "Array", "sort", typeptr_name("Unit"), 0, NULL);
+    insert_method_symbol(st, "Array", "fill", typeptr_name("Unit"), 1, elem_params);
+    insert_method_symbol(st, "Array", "copyOf", typeptr_name("Any"), 1, copyOf_params);
+    lookup_symbol_current_scope(st, "Array.copyOf")->optional_params = 1;
+    insert_method_symbol(st, "Array", "sum", typeptr_name("Any"), 0, NULL);
+    insert_method_symbol(st, "Array", "min", typeptr_name("Any"), 0, NULL);
+    insert_method_symbol(st, "Array", "max", typeptr_name("Any"), 0, NULL);
+    insert_method_symbol(st, "Array", "indexOf", typeptr_name("Int"), 1, elem_params);
     
     insert_symbol(st, "java.lang.Math", CLASS_TYPE, typeptr_name("Type"), 0, 0);
     
@@ -321,11 +404,11 @@ void insert_method_symbol(SymbolTable st,
                             typeptr return_type,
                             int    param_count,
                             char **param_types) {
-    char full_name[256];
+    char *full_name;
     if (class_name[0] == '\0') {
-        snprintf(full_name, sizeof(full_name), "%s", method_name);
+        full_name = strprintf("%s", method_name);
     } else {
-        snprintf(full_name, sizeof(full_name), "%s.%s", class_name, method_name);
+        full_name = strprintf("%s.%s", class_name, method_name);
     }
 
     typeptr func_type = alctype(FUNC_TYPE);
@@ -355,4 +438,5 @@ void insert_method_symbol(SymbolTable st,
     } else {
         e->param_types = NULL;
     }
+    free(full_name);
 }
@@ -17,6 +17,7 @@ typedef struct sym_entry {
     SymbolKind kind;
     typeptr type;           
     int param_count; 
+    int optional_params;    /* trailing parameters a call may leave out */
     int mutable;
     int nullable;     
     typeptr *param_types;   
@@ -38,6 +39,7 @@ SymbolTable mksymtab(int nBuckets, SymbolTable parent);
 void insert_symbol(SymbolTable st, char *s, SymbolKind kind, typeptr type, int is_mutable, int is_nullable);
 SymbolTableEntry lookup_symbol(SymbolTable st, char *s);
 SymbolTableEntry lookup_symbol_current_scope(SymbolTable st, char *s);
+SymbolTableEntry lookup_method(SymbolTable st, char *s, SymbolTableEntry *receiver);
 void check_undeclared(SymbolTable st, char *s);
 void print_symbols(SymbolTable st);
 void free_symbol_table(SymbolTable st);
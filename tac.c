@@ -25,9 +25,19 @@ char *opcodenames[] = {
     "BLT", "BLE", "BGT", "BGE", "BEQ", "BNE", "BIF", "BNIF", "PARM", "CALL",
     "RETURN", "IADD", "DADD", "ISUB", "DSUB", "IMUL", "DMUL", "IDIV", "DDIV",
     "IEQ", "ILT", "ILE", "IGT", "IGE", "INE", "LBL", "BR", "BZ", "BNZ", "NOT",
-    "PUSH", "POP", "ALLOC", "DEALLOC", "MALLOC", "MOD", "ABS", "MAX", "MIN", "POW", "SIN", "COS", "TAN", "RAND", "SRAND"
+    "PUSH", "POP", "ALLOC", "DEALLOC", "MALLOC", "MOD",
+    [O_ABS - O_ADD] = "ABS", "MAX", "MIN", "POW", "SIN", "COS", "TAN", "RAND",
+    [O_CALLOC - O_ADD] = "CALLOC", "FILL", "VADD", "VSUB", "VMUL", "VSUM", "VMIN", "VMAX",
+    "SLEN", "SGET", "ALEN", "ALOAD", "ASTORE"
    };
-char *opcodename(int i) { return opcodenames[i-O_ADD]; }
+char *opcodename(int i) {
+    if (i >= D_GLOB && i <= D_PROT) return pseudoname(i);
+    if (i == O_DMOD) return "DMOD";
+    if (i < O_ADD || i - O_ADD >= (int)(sizeof opcodenames / sizeof opcodenames[0])
+        || opcodenames[i-O_ADD] == NULL)
+        return "UNKNOWN";
+    return opcodenames[i-O_ADD];
+}
 char *pseudonames[] = {
    "glob","proc", "loc", "lab", "end", "prot"
    };
@@ -56,13 +66,38 @@ struct addr *genlabel(void)
    return a;
 }
 
+/*
+ * Instructions are carved out of big chunks and never freed one at a
+ * time.  concat copies its first list every time, so generating a
+ * function leaves several times its final length behind in dead copies,
+ * and nothing tracks which lists are still shared; free_instrs() drops
+ * them all at once instead, when no instruction is in use any more:
+ * after each batch write_streamed writes out, and when the file is done.
+ * Only code generation makes instructions, and it runs on one thread.
+ */
+#define INSTR_CHUNK 4096   /* instructions per chunk */
+
+struct instr_chunk {
+   struct instr_chunk *next;
+   int used;
+   struct instr instr[INSTR_CHUNK];
+};
+
+static struct instr_chunk *instr_chunks;
+
 struct instr *gen(int op, struct addr a1, struct addr a2, struct addr a3)
 {
-  struct instr *rv = malloc(sizeof (struct instr));
-  if (rv == NULL) {
-     fprintf(stderr, "out of memory\n");
-     exit(4);
+  if (!instr_chunks || instr_chunks->used == INSTR_CHUNK) {
+     struct instr_chunk *c = malloc(sizeof *c);
+     if (c == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+        }
+     c->next = instr_chunks;
+     c->used = 0;
+     instr_chunks = c;
      }
+  struct instr *rv = &instr_chunks->instr[instr_chunks->used++];
   rv->opcode = op;
   rv->dest = a1;
   rv->src1 = a2;
@@ -70,20 +105,35 @@ struct instr *gen(int op, struct addr a1, struct addr a2, struct addr a3)
   rv->next = NULL;
   rv->is_double = 0;
   rv->is_ptr = 0;
+  rv->width = 0;
+  rv->unchecked = 0;
   return rv;
 }
 
+void free_instrs(void)
+{
+   while (instr_chunks) {
+      struct instr_chunk *next = instr_chunks->next;
+      free(instr_chunks);
+      instr_chunks = next;
+   }
+}
+
 struct instr *copylist(struct instr *l)
 {
-   if (l == NULL) return NULL;
-   // gen() zeroes out is_double by default
-   struct instr *lcopy = gen(l->opcode, l->dest, l->src1, l->src2);
-   // *carry over* the double-width flag
-   lcopy->is_double = l->is_double;
-    lcopy->is_ptr = l->is_ptr;
-   // copy the rest of the chain
-   lcopy->next = copylist(l->next);
-   return lcopy;
+   struct instr *head = NULL, **at = &head;
+   for (; l != NULL; l = l->next) {
+      // gen() zeroes out is_double by default
+      struct instr *lcopy = gen(l->opcode, l->dest, l->src1, l->src2);
+      // *carry over* the double-width flag
+      lcopy->is_double = l->is_double;
+      lcopy->is_ptr = l->is_ptr;
+      lcopy->width = l->width;
+      lcopy->unchecked = l->unchecked;
+      *at = lcopy;
+      at = &lcopy->next;
+   }
+   return head;
 }
 
 struct instr *append(struct instr *l1, struct instr *l2)
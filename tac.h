@@ -34,12 +34,23 @@ typedef struct tac_list {
 #define R_MEM    2013   
 #define R_RET    2014   
 
+/*
+ * R_PARAM n is the n-th Int/pointer or Double register argument, as in
+ * the C ABI (6 and 8 of them); PARAM_STACK + k is the k-th eightbyte
+ * the caller passed on the stack, whatever its type.
+ */
+#define PARAM_INT_REGS    6
+#define PARAM_DOUBLE_REGS 8
+#define PARAM_STACK       8
+
 
 struct instr {
    int opcode;
    struct addr dest, src1, src2;
    int is_double;
    int is_ptr;
+   int width;          /* O_ALOAD/O_ASTORE: element bits, 1 = bitset */
+   int unchecked;      /* O_ALOAD/O_ASTORE: index proven in range */
    struct instr *next;
 };
 #define O_ADD   3001
@@ -106,9 +117,36 @@ struct instr {
 #define O_COS   3062
 #define O_TAN   3063
 #define O_RAND  3064
-#define O_SRAND 3065
+#define O_CALLOC 3066
+#define O_FILL  3067
+#define O_VADD  3068
+#define O_VSUB  3069
+#define O_VMUL  3070
+#define O_VSUM  3071
+#define O_VMIN  3072
+#define O_VMAX  3073
+#define O_SLEN  3074
+#define O_SGET  3075
+#define O_ALEN  3076
+#define O_ALOAD 3077
+#define O_ASTORE 3078
+
+/*
+ * A whole program as the backends see it: the code list plus the String
+ * literals (R_GLOBAL n, as written in the source, quotes included) and
+ * the Double literals (O_LCONT n).
+ */
+struct tac_program {
+    struct instr *code;
+    int nstrings;
+    char **strings;
+    int nreals;
+    double *reals;
+};
 
 struct instr *gen(int, struct addr, struct addr, struct addr);
+void free_instrs(void);   /* every instruction gen has made */
+struct instr *copylist(struct instr *l);
 struct instr *concat(struct instr *, struct instr *);
 struct instr *append(struct instr *l1, struct instr *l2);  
 char *regionname(int i);
@@ -0,0 +1,30 @@
+	.file	"/root/repo/tests/errors/sem5.kt"
+	.section	.data.rel.ro.local,"aw"
+	.align	8
+	.section	.rodata
+	.align	8
+	.text
+	.globl	main
+	.type	main, @function
+main:
+.LFB0:
+	.cfi_startproc
+	endbr64
+	pushq	%rbp
+	.cfi_def_cfa_offset 16
+	.cfi_offset 6, -16
+	movq	%rsp, %rbp
+	.cfi_def_cfa_register 6
+	subq	$32, %rsp
+	movl	$5, -16(%rbp)
+	movl	$10, -24(%rbp)
+	movl	$10, -8(%rbp)
+	xorl	%eax, %eax
+	addq	$32, %rsp
+	leave
+	.cfi_def_cfa   7, 8
+	.cfi_endproc
+	ret
+.LFE0:
+	.size	main, .-main
+	.section .note.GNU-stack,"",@progbits
@@ -0,0 +1,103 @@
+	.file	"/root/repo/tests/k0/sem_test1.kt"
+	.section	.data.rel.ro.local,"aw"
+	.align	8
+.LC0:
+	.quad	.LC0E-.LC0S-1
+	.quad	.LC0S
+.LC1:
+	.quad	.LC1E-.LC1S-1
+	.quad	.LC1S
+.LC2:
+	.quad	.LC2E-.LC2S-1
+	.quad	.LC2S
+.LC3:
+	.quad	.LC3E-.LC3S-1
+	.quad	.LC3S
+	.section	.rodata
+	.align	8
+.LC0S:
+	.string	"What should we play?\n"
+.LC0E:
+.LC1S:
+	.string	"Fetch (1) \n Roll over (2)\n"
+.LC1E:
+.LC2S:
+	.string	"Fetch, eh"
+.LC2E:
+.LC3S:
+	.string	"Roll over?  Really?"
+.LC3E:
+	.text
+	.globl	play
+	.type	play, @function
+play:
+.LFB0:
+	.cfi_startproc
+	endbr64
+	pushq	%rbp
+	.cfi_def_cfa_offset 16
+	.cfi_offset 6, -16
+	movq	%rsp, %rbp
+	.cfi_def_cfa_register 6
+	subq	$112, %rsp
+	movl	$0, -32(%rbp)
+	movl	$0, -8(%rbp)
+	movl	$0, -40(%rbp)
+	movl	$0, -16(%rbp)
+	leaq	.LC0(%rip), %rdi
+	call	k0_print_str
+	leaq	.LC1(%rip), %rdi
+	call	k0_print_str
+	movl	$2, -48(%rbp)
+	movl	$2, -24(%rbp)
+	movl	$1, -56(%rbp)
+	jmp	.L1
+.L1:
+	movl	$2, -80(%rbp)
+	movl	-24(%rbp), %eax
+	cmpl	-80(%rbp), %eax
+	jne	.L3
+	leaq	.LC3(%rip), %rdi
+	call	k0_print_str
+	movl	$1, -88(%rbp)
+	movl	-8(%rbp), %eax
+	addl	-88(%rbp), %eax
+	movl	%eax, -96(%rbp)
+	movl	-96(%rbp), %eax
+	movl	%eax, -8(%rbp)
+.L3:
+.L2:
+	addq	$112, %rsp
+	leave
+	.cfi_def_cfa   7, 8
+	.cfi_endproc
+	ret
+.LFE0:
+	.size	play, .-play
+	.globl	main
+	.type	main, @function
+main:
+.LFB4:
+	.cfi_startproc
+	endbr64
+	pushq	%rbp
+	.cfi_def_cfa_offset 16
+	.cfi_offset 6, -16
+	movq	%rsp, %rbp
+	.cfi_def_cfa_register 6
+	subq	$48, %rsp
+	call	play
+	movl	%eax, -24(%rbp)
+	movl	$13, -32(%rbp)
+	movl	$13, -8(%rbp)
+	movq	0(%rbp), %rax
+	movq	%rax, -16(%rbp)
+	xorl	%eax, %eax
+	addq	$48, %rsp
+	leave
+	.cfi_def_cfa   7, 8
+	.cfi_endproc
+	ret
+.LFE4:
+	.size	main, .-main
+	.section .note.GNU-stack,"",@progbits
@@ -0,0 +1,63 @@
+	.file	"/root/repo/tests/k0/sem_test3.kt"
+	.section	.data.rel.ro.local,"aw"
+	.align	8
+	.section	.rodata
+	.align	8
+	.text
+	.globl	main
+	.type	main, @function
+main:
+.LFB0:
+	.cfi_startproc
+	endbr64
+	pushq	%rbp
+	.cfi_def_cfa_offset 16
+	.cfi_offset 6, -16
+	movq	%rsp, %rbp
+	.cfi_def_cfa_register 6
+	subq	$80, %rsp
+	movl	$8, -16(%rbp)
+	movslq	-16(%rbp), %rdi
+	movl	$32, %esi
+	call	k0_array_new
+	movq	%rax, -24(%rbp)
+	movq	-24(%rbp), %rax
+	movq	%rax, -8(%rbp)
+	movl	$5, -48(%rbp)
+	movq	-8(%rbp), %rax
+	movq	%rax, -32(%rbp)
+	movl	$5, -40(%rbp)
+	movq	-32(%rbp), %rax
+	movslq	-40(%rbp), %rcx
+	cmpq	-16(%rax), %rcx
+	jb	.Lidx0
+	movl	%ecx, %edi
+	movq	-16(%rax), %rsi
+	call	k0_array_index_error
+.Lidx0:
+	movl	-48(%rbp), %edx
+	movl	%edx, (%rax,%rcx,4)
+	movq	-8(%rbp), %rax
+	movq	%rax, -56(%rbp)
+	movl	$5, -64(%rbp)
+	movq	-56(%rbp), %rax
+	movslq	-64(%rbp), %rcx
+	cmpq	-16(%rax), %rcx
+	jb	.Lidx1
+	movl	%ecx, %edi
+	movq	-16(%rax), %rsi
+	call	k0_array_index_error
+.Lidx1:
+	movl	(%rax,%rcx,4), %eax
+	movl	%eax, -72(%rbp)
+	movl	-72(%rbp), %edi
+	call	k0_println_int
+	xorl	%eax, %eax
+	addq	$80, %rsp
+	leave
+	.cfi_def_cfa   7, 8
+	.cfi_endproc
+	ret
+.LFE0:
+	.size	main, .-main
+	.section .note.GNU-stack,"",@progbits
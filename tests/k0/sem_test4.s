@@ -0,0 +1,123 @@
+	.file	"/root/repo/tests/k0/sem_test4.kt"
+	.section	.data.rel.ro.local,"aw"
+	.align	8
+	.section	.rodata
+	.align	8
+	.text
+	.globl	main
+	.type	main, @function
+main:
+.LFB0:
+	.cfi_startproc
+	endbr64
+	pushq	%rbp
+	.cfi_def_cfa_offset 16
+	.cfi_offset 6, -16
+	movq	%rsp, %rbp
+	.cfi_def_cfa_register 6
+	subq	$208, %rsp
+	movl	$3, -32(%rbp)
+	movl	$3, -8(%rbp)
+	movl	$4, -40(%rbp)
+	movl	$4, -16(%rbp)
+	movl	$8, -48(%rbp)
+	movslq	-48(%rbp), %rdi
+	movl	$32, %esi
+	call	k0_array_new
+	movq	%rax, -56(%rbp)
+	movq	-56(%rbp), %rax
+	movq	%rax, -24(%rbp)
+	movl	$9, -80(%rbp)
+	movq	-24(%rbp), %rax
+	movq	%rax, -64(%rbp)
+	movl	$0, -72(%rbp)
+	movq	-64(%rbp), %rax
+	movslq	-72(%rbp), %rcx
+	cmpq	-16(%rax), %rcx
+	jb	.Lidx0
+	movl	%ecx, %edi
+	movq	-16(%rax), %rsi
+	call	k0_array_index_error
+.Lidx0:
+	movl	-80(%rbp), %edx
+	movl	%edx, (%rax,%rcx,4)
+	movl	$8, -104(%rbp)
+	movq	-24(%rbp), %rax
+	movq	%rax, -88(%rbp)
+	movl	$1, -96(%rbp)
+	movq	-88(%rbp), %rax
+	movslq	-96(%rbp), %rcx
+	cmpq	-16(%rax), %rcx
+	jb	.Lidx1
+	movl	%ecx, %edi
+	movq	-16(%rax), %rsi
+	call	k0_array_index_error
+.Lidx1:
+	movl	-104(%rbp), %edx
+	movl	%edx, (%rax,%rcx,4)
+	movq	-24(%rbp), %rax
+	movq	%rax, -128(%rbp)
+	movl	$0, -136(%rbp)
+	movq	-128(%rbp), %rax
+	movslq	-136(%rbp), %rcx
+	cmpq	-16(%rax), %rcx
+	jb	.Lidx2
+	movl	%ecx, %edi
+	movq	-16(%rax), %rsi
+	call	k0_array_index_error
+.Lidx2:
+	movl	(%rax,%rcx,4), %eax
+	movl	%eax, -144(%rbp)
+	movq	-24(%rbp), %rax
+	movq	%rax, -152(%rbp)
+	movl	$1, -160(%rbp)
+	movq	-152(%rbp), %rax
+	movslq	-160(%rbp), %rcx
+	cmpq	-16(%rax), %rcx
+	jb	.Lidx3
+	movl	%ecx, %edi
+	movq	-16(%rax), %rsi
+	call	k0_array_index_error
+.Lidx3:
+	movl	(%rax,%rcx,4), %eax
+	movl	%eax, -168(%rbp)
+	movl	-144(%rbp), %eax
+	addl	-168(%rbp), %eax
+	movl	%eax, -176(%rbp)
+	movq	-24(%rbp), %rax
+	movq	%rax, -112(%rbp)
+	movl	$2, -120(%rbp)
+	movq	-112(%rbp), %rax
+	movslq	-120(%rbp), %rcx
+	cmpq	-16(%rax), %rcx
+	jb	.Lidx4
+	movl	%ecx, %edi
+	movq	-16(%rax), %rsi
+	call	k0_array_index_error
+.Lidx4:
+	movl	-176(%rbp), %edx
+	movl	%edx, (%rax,%rcx,4)
+	movq	-24(%rbp), %rax
+	movq	%rax, -184(%rbp)
+	movl	$2, -192(%rbp)
+	movq	-184(%rbp), %rax
+	movslq	-192(%rbp), %rcx
+	cmpq	-16(%rax), %rcx
+	jb	.Lidx5
+	movl	%ecx, %edi
+	movq	-16(%rax), %rsi
+	call	k0_array_index_error
+.Lidx5:
+	movl	(%rax,%rcx,4), %eax
+	movl	%eax, -200(%rbp)
+	movl	-200(%rbp), %edi
+	call	k0_println_int
+	xorl	%eax, %eax
+	addq	$208, %rsp
+	leave
+	.cfi_def_cfa   7, 8
+	.cfi_endproc
+	ret
+.LFE0:
+	.size	main, .-main
+	.section .note.GNU-stack,"",@progbits
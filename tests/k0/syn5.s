@@ -0,0 +1,39 @@
+	.file	"/root/repo/tests/k0/syn5.kt"
+	.section	.data.rel.ro.local,"aw"
+	.align	8
+.LC0:
+	.quad	.LC0E-.LC0S-1
+	.quad	.LC0S
+	.section	.rodata
+	.align	8
+.LC0S:
+	.string	"less"
+.LC0E:
+	.text
+	.globl	main
+	.type	main, @function
+main:
+.LFB2:
+	.cfi_startproc
+	endbr64
+	pushq	%rbp
+	.cfi_def_cfa_offset 16
+	.cfi_offset 6, -16
+	movq	%rsp, %rbp
+	.cfi_def_cfa_register 6
+	subq	$32, %rsp
+	movl	$5, -16(%rbp)
+	movl	$5, -8(%rbp)
+	movl	$6, -24(%rbp)
+	leaq	.LC0(%rip), %rdi
+	call	k0_print_str
+.L3:
+	xorl	%eax, %eax
+	addq	$32, %rsp
+	leave
+	.cfi_def_cfa   7, 8
+	.cfi_endproc
+	ret
+.LFE2:
+	.size	main, .-main
+	.section .note.GNU-stack,"",@progbits
@@ -0,0 +1,36 @@
+	.file	"/root/repo/tests/k0/syn6.kt"
+	.section	.data.rel.ro.local,"aw"
+	.align	8
+.LC0:
+	.quad	.LC0E-.LC0S-1
+	.quad	.LC0S
+	.section	.rodata
+	.align	8
+.LC0S:
+	.string	"Missing braces"
+.LC0E:
+	.text
+	.globl	missingBraces
+	.type	missingBraces, @function
+missingBraces:
+.LFB0:
+	.cfi_startproc
+	endbr64
+	pushq	%rbp
+	.cfi_def_cfa_offset 16
+	.cfi_offset 6, -16
+	movq	%rsp, %rbp
+	.cfi_def_cfa_register 6
+	subq	$16, %rsp
+	movl	$1, -8(%rbp)
+	leaq	.LC0(%rip), %rdi
+	call	k0_print_str
+.L1:
+	addq	$16, %rsp
+	leave
+	.cfi_def_cfa   7, 8
+	.cfi_endproc
+	ret
+.LFE0:
+	.size	missingBraces, .-missingBraces
+	.section .note.GNU-stack,"",@progbits
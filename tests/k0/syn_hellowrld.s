@@ -0,0 +1,71 @@
+	.file	"/root/repo/tests/k0/syn_hellowrld.kt"
+	.section	.data.rel.ro.local,"aw"
+	.align	8
+.LC0:
+	.quad	.LC0E-.LC0S-1
+	.quad	.LC0S
+.LC1:
+	.quad	.LC1E-.LC1S-1
+	.quad	.LC1S
+	.section	.rodata
+	.align	8
+.LC0S:
+	.string	"wow"
+.LC0E:
+.LC1S:
+	.string	"Hello World"
+.LC1E:
+	.text
+	.globl	main
+	.type	main, @function
+main:
+.LFB0:
+	.cfi_startproc
+	endbr64
+	pushq	%rbp
+	.cfi_def_cfa_offset 16
+	.cfi_offset 6, -16
+	movq	%rsp, %rbp
+	.cfi_def_cfa_register 6
+	subq	$32, %rsp
+	movq	%rdi, -8(%rbp)
+	leaq	.LC0(%rip), %rax
+	movq	%rax, -16(%rbp)
+	leaq	.LC1(%rip), %rdi
+	call	k0_print_str
+	xorl	%eax, %eax
+	addq	$32, %rsp
+	leave
+	.cfi_def_cfa   7, 8
+	.cfi_endproc
+	ret
+.LFE0:
+	.size	main, .-main
+	.globl	silly
+	.type	silly, @function
+silly:
+.LFB1:
+	.cfi_startproc
+	endbr64
+	pushq	%rbp
+	.cfi_def_cfa_offset 16
+	.cfi_offset 6, -16
+	movq	%rsp, %rbp
+	.cfi_def_cfa_register 6
+	subq	$64, %rsp
+	movl	$10, -24(%rbp)
+	movl	$10, -8(%rbp)
+	movl	$10, -32(%rbp)
+	movl	$20, -40(%rbp)
+	movl	$20, -16(%rbp)
+	movl	$10, -48(%rbp)
+	movl	$20, -56(%rbp)
+	movl	$20, -8(%rbp)
+	addq	$64, %rsp
+	leave
+	.cfi_def_cfa   7, 8
+	.cfi_endproc
+	ret
+.LFE1:
+	.size	silly, .-silly
+	.section .note.GNU-stack,"",@progbits
@@ -0,0 +1,30 @@
+	.file	"/root/repo/tests/k0/syn_multiply.kt"
+	.section	.data.rel.ro.local,"aw"
+	.align	8
+	.section	.rodata
+	.align	8
+	.text
+	.globl	g
+	.type	g, @function
+g:
+.LFB0:
+	.cfi_startproc
+	endbr64
+	pushq	%rbp
+	.cfi_def_cfa_offset 16
+	.cfi_offset 6, -16
+	movq	%rsp, %rbp
+	.cfi_def_cfa_register 6
+	subq	$32, %rsp
+	movl	$2, -8(%rbp)
+	movl	$2, -16(%rbp)
+	movl	$4, -24(%rbp)
+	movl	-24(%rbp), %eax
+	addq	$32, %rsp
+	leave
+	.cfi_def_cfa   7, 8
+	.cfi_endproc
+	ret
+.LFE0:
+	.size	g, .-g
+	.section .note.GNU-stack,"",@progbits
@@ -0,0 +1,42 @@
+	.file	"/root/repo/tests/k0/syn_while.kt"
+	.section	.data.rel.ro.local,"aw"
+	.align	8
+	.section	.rodata
+	.align	8
+	.text
+	.globl	main
+	.type	main, @function
+main:
+.LFB2:
+	.cfi_startproc
+	endbr64
+	pushq	%rbp
+	.cfi_def_cfa_offset 16
+	.cfi_offset 6, -16
+	movq	%rsp, %rbp
+	.cfi_def_cfa_register 6
+	subq	$48, %rsp
+	movl	$0, -16(%rbp)
+	movl	$0, -8(%rbp)
+.L3:
+	movl	$10, -24(%rbp)
+	movl	-8(%rbp), %eax
+	cmpl	-24(%rbp), %eax
+	jge	.L4
+	movl	$1, -32(%rbp)
+	movl	-8(%rbp), %eax
+	addl	-32(%rbp), %eax
+	movl	%eax, -40(%rbp)
+	movl	-40(%rbp), %eax
+	movl	%eax, -8(%rbp)
+	jmp	.L3
+.L4:
+	xorl	%eax, %eax
+	addq	$48, %rsp
+	leave
+	.cfi_def_cfa   7, 8
+	.cfi_endproc
+	ret
+.LFE2:
+	.size	main, .-main
+	.section .note.GNU-stack,"",@progbits
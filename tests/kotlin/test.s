@@ -0,0 +1,85 @@
+	.file	"/root/repo/tests/kotlin/test.kt"
+	.section	.data.rel.ro.local,"aw"
+	.align	8
+.LC0:
+	.quad	.LC0E-.LC0S-1
+	.quad	.LC0S
+	.section	.rodata
+	.align	8
+.LC0S:
+	.string	"test"
+.LC0E:
+	.text
+	.globl	mathstuff
+	.type	mathstuff, @function
+mathstuff:
+.LFB0:
+	.cfi_startproc
+	endbr64
+	pushq	%rbp
+	.cfi_def_cfa_offset 16
+	.cfi_offset 6, -16
+	movq	%rsp, %rbp
+	.cfi_def_cfa_register 6
+	subq	$80, %rsp
+	movl	%edi, -8(%rbp)
+	movl	%esi, -16(%rbp)
+	movl	%edx, -24(%rbp)
+	movl	%ecx, -32(%rbp)
+	movl	-16(%rbp), %eax
+	addl	-24(%rbp), %eax
+	movl	%eax, -40(%rbp)
+	movl	-40(%rbp), %eax
+	movl	%eax, -8(%rbp)
+	movl	-8(%rbp), %eax
+	addl	-16(%rbp), %eax
+	movl	%eax, -48(%rbp)
+	movl	-48(%rbp), %eax
+	addl	-24(%rbp), %eax
+	movl	%eax, -56(%rbp)
+	movl	-56(%rbp), %eax
+	addl	-32(%rbp), %eax
+	movl	%eax, -64(%rbp)
+	movl	-64(%rbp), %eax
+	addq	$80, %rsp
+	leave
+	.cfi_def_cfa   7, 8
+	.cfi_endproc
+	ret
+.LFE0:
+	.size	mathstuff, .-mathstuff
+	.globl	main
+	.type	main, @function
+main:
+.LFB1:
+	.cfi_startproc
+	endbr64
+	pushq	%rbp
+	.cfi_def_cfa_offset 16
+	.cfi_offset 6, -16
+	movq	%rsp, %rbp
+	.cfi_def_cfa_register 6
+	subq	$48, %rsp
+	leaq	.LC0(%rip), %rdi
+	call	k0_print_str
+	movl	$1, -8(%rbp)
+	movl	$2, -16(%rbp)
+	movl	$3, -24(%rbp)
+	movl	$4, -32(%rbp)
+	movl	-8(%rbp), %edi
+	movl	-16(%rbp), %esi
+	movl	-24(%rbp), %edx
+	movl	-32(%rbp), %ecx
+	call	mathstuff
+	movl	%eax, -40(%rbp)
+	movl	-40(%rbp), %edi
+	call	k0_println_int
+	xorl	%eax, %eax
+	addq	$48, %rsp
+	leave
+	.cfi_def_cfa   7, 8
+	.cfi_endproc
+	ret
+.LFE1:
+	.size	main, .-main
+	.section .note.GNU-stack,"",@progbits
@@ -5,6 +5,7 @@
 #include "type.h"
 
 #include <stdarg.h>
+#include <stddef.h>
 #include <string.h>
 
 extern int yylineno;
@@ -12,32 +13,138 @@ extern char *current_filename;
 extern YYSTYPE yylval;
 extern int error_count;
 
+/*
+ * Token text, file names and node names are interned: one copy of each
+ * distinct spelling, shared by every token and tree node that has it, so
+ * a name used a thousand times is stored once and a token costs no
+ * allocation for its text.  Interned strings must not be freed or
+ * written to; free_interned() drops them all once the tree is gone.
+ */
+#define INTERN_BUCKETS 4096
+
+struct interned {
+    struct interned *next;
+    char text[];
+};
+
+static struct interned *interned[INTERN_BUCKETS];
+
+char *intern(const char *s) {
+    unsigned h = 5381;
+    for (const char *p = s; *p; p++) h = h * 33 + (unsigned char)*p;
+    struct interned **b = &interned[h % INTERN_BUCKETS];
+    for (struct interned *e = *b; e; e = e->next)
+        if (strcmp(e->text, s) == 0) return e->text;
+
+    size_t n = strlen(s) + 1;
+    struct interned *e = malloc(sizeof *e + n);
+    if (!e) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+    memcpy(e->text, s, n);
+    e->next = *b;
+    *b = e;
+    return e->text;
+}
 
-int alctoken(int category, char *text) {
-    yylval.treeptr = malloc(sizeof(struct tree));
-    if (!yylval.treeptr) {
-        fprintf(stderr, "Memory allocation failed for tree node\n");
-        exit(EXIT_FAILURE);
+void free_interned(void) {
+    for (int i = 0; i < INTERN_BUCKETS; i++) {
+        while (interned[i]) {
+            struct interned *next = interned[i]->next;
+            free(interned[i]);
+            interned[i] = next;
+        }
     }
+}
+
+/*
+ * Tree nodes, their child arrays and their tokens are carved out of big
+ * zeroed chunks rather than malloc'd one by one: no per-node allocator
+ * overhead, and a parent and its children end up next to each other.
+ * The chunks are kept oldest first.  The parser marks where each
+ * top-level declaration ends, so once a declaration's code is written
+ * release_declarations() can free every chunk before the next one's
+ * mark; free_trees() takes the rest when the file is done.
+ */
+#define ARENA_CHUNK (64 * 1024)
+#define ARENA_ALIGN _Alignof(double)   /* nothing in a node needs more */
+
+struct chunk {
+    struct chunk *next;
+    size_t used, size;
+    max_align_t data[];
+};
+
+static struct chunk *arena, *newest;   // oldest and newest chunk
+static int serial = 0;
 
-    yylval.treeptr->prodrule = category;
-    yylval.treeptr->symbolname = strdup(text);
-    yylval.treeptr->nkids = 0;
-    yylval.treeptr->leaf = malloc(sizeof(struct token));
-    yylval.treeptr->returned = 0;
+/*
+ * The end of a top-level declaration: the chunk and the node id the next
+ * one starts at, and one past the highest id the declaration itself has.
+ * A node made after the mark (a declaration's own node, reduced once the
+ * next token was read) only lives longer, never shorter.
+ */
+struct decl_end {
+    struct chunk *chunk;
+    int id, hi;
+};
+
+static struct decl_end *decls;
+static int ndecls;
+static struct decl_end last_token;   // where the latest token's node went
+
+struct node_attr *node_attrs;
+int attr_base;
+static int attr_cap;
+
+static void *tree_alloc(size_t n) {
+    n = (n + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+    if (!newest || newest->size - newest->used < n) {
+        size_t size = n > ARENA_CHUNK ? n : ARENA_CHUNK;
+        struct chunk *c = calloc(1, sizeof *c + size);
+        if (!c) {
+            fprintf(stderr, "out of memory\n");
+            exit(4);
+        }
+        c->size = size;
+        if (newest) newest->next = c;
+        else        arena = c;
+        newest = c;
+    }
+    void *p = (char *)newest->data + newest->used;
+    newest->used += n;
+    return p;
+}
+
+static struct tree *make_node(int prodrule, char *symbolname, int nkids) {
+    struct tree *t = tree_alloc(sizeof *t + nkids * sizeof(struct tree *));
+    t->id = serial++;
+    t->prodrule = prodrule;
+    t->symbolname = intern(symbolname);
+    t->nkids = nkids;
+    t->kids = (struct tree **)(t + 1);
+    t->lineno = yylineno;
+    return t;
+}
+
+int alctoken(int category, char *text) {
+    yylval.treeptr = make_node(category, text, 0);
+    last_token = (struct decl_end){ newest, yylval.treeptr->id, 0 };
+    yylval.treeptr->leaf = tree_alloc(sizeof(struct token));
 
     struct token *tok = yylval.treeptr->leaf;
     tok->category = category;
-    tok->text = strdup(text);
+    tok->text = yylval.treeptr->symbolname;
     tok->lineno = yylineno;
-    tok->filename = strdup(current_filename);
+    tok->filename = intern(current_filename);
 
     if (category == IntegerLiteral) {
         tok->value.ival = atoi(text);
     } else if (category == RealLiteral) {
         tok->value.dval = atof(text);
     } else if (category == StringLiteral) {
-        tok->value.sval = strdup(text);
+        tok->value.sval = tok->text;
     } else {
         tok->value.sval = NULL;
     }
@@ -64,7 +171,10 @@ void flattenParameterList(struct tree *node, struct tree ***params, int *count)
         return;
     if (node->symbolname) {
         if (strcmp(node->symbolname, "functionValueParameter") == 0) {
-            *params = realloc(*params, ((*count) + 1) * sizeof(struct tree *));
+            /* double the array whenever the count reaches 0 or a power of two */
+            int n = *count;
+            if (n == 0 || (n & (n - 1)) == 0)
+                *params = realloc(*params, (n ? 2 * n : 1) * sizeof(struct tree *));
             if (!(*params)) {
                 fprintf(stderr, "Memory allocation failed in flattenParameterList\n");
                 exit(1);
@@ -108,11 +218,9 @@ void computeFunctionParameters(struct tree *fvp, int *count, typeptr **types) {
     free(flat_params);
 }
 
-FuncSymbolTableList printsyms(struct tree *t, SymbolTable st) {
-    if (!t) return NULL;
-
-    static FuncSymbolTableList func_list_head = NULL;
-    static FuncSymbolTableList func_list_tail = NULL;
+/* the symbols declared under t; each function's scope goes on at *tail */
+static void collect_syms(struct tree *t, SymbolTable st, FuncSymbolTableList **tail) {
+    if (!t) return;
 
     SymbolTable current_scope = st;
 
@@ -155,12 +263,8 @@ FuncSymbolTableList printsyms(struct tree *t, SymbolTable st) {
             if (new_node) {
                 new_node->symtab = current_scope;
                 new_node->next = NULL;
-                if (func_list_tail) {
-                    func_list_tail->next = new_node;
-                    func_list_tail = new_node;
-                } else {
-                    func_list_head = func_list_tail = new_node;
-                }
+                **tail = new_node;
+                *tail = &new_node->next;
             }
         }
 
@@ -186,8 +290,13 @@ FuncSymbolTableList printsyms(struct tree *t, SymbolTable st) {
                             param_type = type_node->leaf->text;
                     }
                     
+                    typeptr ptype = typeptr_name(param_type);
+                    if (param_node->kids[1] &&
+                        (strcmp(param_node->kids[1]->symbolname, "mapType") == 0 ||
+                         strcmp(param_node->kids[1]->symbolname, "genericType") == 0))
+                        ptype = param_node->kids[1]->type;
                     if (param_name) {
-                        insert_symbol(current_scope, param_name, VARIABLE, typeptr_name(param_type), 1, param_node->kids[1]->is_nullable);
+                        insert_symbol(current_scope, param_name, VARIABLE, ptype, 1, param_node->kids[1]->is_nullable);
                     }
                 }
             }
@@ -241,10 +350,18 @@ FuncSymbolTableList printsyms(struct tree *t, SymbolTable st) {
     }
 
     for (int i = 0; i < t->nkids; i++) {
-        printsyms(t->kids[i], current_scope);
+        collect_syms(t->kids[i], current_scope, tail);
     }
-    
-    return func_list_head;
+}
+
+/*
+ * Enter the symbols declared in the tree into st and the function
+ * scopes it creates; returns those scopes, a new list for every file.
+ */
+FuncSymbolTableList printsyms(struct tree *t, SymbolTable st) {
+    FuncSymbolTableList head = NULL, *tail = &head;
+    collect_syms(t, st, &tail);
+    return head;
 }
 
 
@@ -259,37 +376,8 @@ void free_func_symtab_list(FuncSymbolTableList list) {
 
 
 
-void freetoken(struct token *t) {
-    if (!t) return;
-    free(t->text);
-    free(t->filename);
-    if (t->category == StringLiteral) {
-        free(t->value.sval);
-    }
-    free(t);
-}
-
-
-static int serial = 0;
 struct tree *alctree(int prodrule, char *symbolname, int nkids, ...) {
-    struct tree *t = malloc(sizeof(struct tree));
-    if (!t) {
-        fprintf(stderr, "Memory allocation failed for tree node\n");
-        exit(EXIT_FAILURE);
-    }
-
-    t->id = serial++;  
-    t->prodrule = prodrule;
-    t->symbolname = strdup(symbolname);
-    t->nkids = nkids;
-    t->leaf = NULL;
-    t->type = NULL;
-    t->is_mutable = 0;
-    t->is_nullable = 0;
-    t->lineno = yylineno;
-    t->scope = NULL;
-    t->place.region = R_NONE;
-    t->place.u.offset = 0;
+    struct tree *t = make_node(prodrule, symbolname, nkids);
 
     va_list args;
     va_start(args, nkids);
@@ -301,26 +389,104 @@ struct tree *alctree(int prodrule, char *symbolname, int nkids, ...) {
     return t;
 }
 
+/*
+ * add kid to the end of list, a node made by alctree with two kids.
+ * The kids array is full whenever nkids is a power of two; it then moves
+ * to a fresh one twice the size, so n appends copy fewer than 2n kids.
+ */
+struct tree *tree_append(struct tree *list, struct tree *kid) {
+    int n = list->nkids;
+    if ((n & (n - 1)) == 0) {
+        struct tree **kids = tree_alloc(2 * n * sizeof *kids);
+        memcpy(kids, list->kids, n * sizeof *kids);
+        list->kids = kids;
+    }
+    list->kids[list->nkids++] = kid;
+    return list;
+}
 
-void freetree(struct tree *t) {
-    if (!t) return;
-
-    for (int i = 0; i < t->nkids; i++) {
-        freetree(t->kids[i]);
-        t->kids[i] = NULL;  
+/*
+ * Called by the parser as it reduces a top-level declaration.  If it
+ * already read the token after it, that token starts the next one.
+ */
+void end_declaration(int lookahead) {
+    struct decl_end e = lookahead ? last_token
+                                  : (struct decl_end){ newest, serial, 0 };
+    e.hi = serial;
+    /* grow by doubling: the array is full whenever the count is 0 or a power of two */
+    if ((ndecls & (ndecls - 1)) == 0) {
+        decls = realloc(decls, (ndecls ? 2 * ndecls : 1) * sizeof *decls);
+        if (!decls) {
+            fprintf(stderr, "out of memory\n");
+            exit(4);
+        }
     }
+    decls[ndecls++] = e;
+}
 
-    if (t->leaf) {
-        freetoken(t->leaf);
-        t->leaf = NULL;
+int declaration_count(void) {
+    return ndecls;
+}
+
+/* the node ids of top-level declaration k are within lo .. hi-1 */
+void declaration_ids(int k, int *lo, int *hi) {
+    *lo = k ? decls[k-1].id : 0;
+    *hi = decls[k].hi;
+}
+
+int node_count(void) {
+    return serial;
+}
+
+/*
+ * Free the chunks holding nothing after declaration k.  Declarations
+ * 0..k and anything made before them (list nodes included) must not be
+ * used again.
+ */
+void release_declarations(int k) {
+    while (arena != decls[k].chunk) {
+        struct chunk *next = arena->next;
+        free(arena);
+        arena = next;
     }
+}
 
-    if (t->symbolname) {
-        free(t->symbolname);
-        t->symbolname = NULL;
+/*
+ * Attributes for nodes lo .. hi-1, every place still R_NONE.  The table
+ * is reused, so it only ever grows to the largest range asked for.
+ */
+void alloc_node_attrs(int lo, int hi) {
+    int n = hi - lo;
+    if (n > attr_cap) {
+        free(node_attrs);
+        node_attrs = malloc(n * sizeof *node_attrs);
+        if (!node_attrs) {
+            fprintf(stderr, "out of memory\n");
+            exit(4);
+        }
+        attr_cap = n;
     }
+    memset(node_attrs, 0, n * sizeof *node_attrs);
+    for (int i = 0; i < n; i++) node_attrs[i].place.region = R_NONE;
+    attr_base = lo;
+}
 
-    free(t);
+/* every node, token and node attribute of the current file */
+void free_trees(void) {
+    while (arena) {
+        struct chunk *next = arena->next;
+        free(arena);
+        arena = next;
+    }
+    newest = NULL;
+    free(decls);
+    decls = NULL;
+    ndecls = 0;
+    free(node_attrs);
+    node_attrs = NULL;
+    attr_cap = 0;
+    attr_base = 0;
+    serial = 0;
 }
 
 void printtree(struct tree *t, int depth) {
@@ -502,8 +668,8 @@ void print_graph2_TAC(struct tree *t, FILE *f) {
         }
     }
 
-    if (t->code) {
-        struct instr *curr = t->code;
+    if (ATTR(t)->code) {
+        struct instr *curr = ATTR(t)->code;
         int prev_id = -1;
         while (curr) {
             int instr_id = serial++;
@@ -25,31 +25,53 @@ struct token {
     } value;
 };
 
+/*
+ * A node holds only what the front end needs.  Its children are an
+ * array of exactly nkids pointers, and nodes, child arrays and tokens
+ * all come out of an arena that is given back one run of top-level
+ * declarations at a time (release_declarations) or by free_trees().
+ * Lists (statements, topLevelObjectList, expressionList, ...) are one
+ * node with a kid per element, grown by tree_append, not a chain of
+ * nested pairs, so walking a long list does not recurse once per item.
+ */
 struct tree {
-    int id;
-    int prodrule;
-    char *symbolname;
+    int id;                /* node_attrs[id - attr_base] */
+    int lineno;
     int nkids;
-    struct tree *kids[10];
+    short prodrule;
+    char is_mutable;
+    char is_nullable;
+    char *symbolname;
+    struct tree **kids;
     struct token *leaf;
     typeptr type;
-    int is_mutable;
-    int is_nullable;
-    int lineno;
     SymbolTable scope;
+};
+
+/*
+ * What the code generator works out for a node is kept beside the tree,
+ * in node_attrs, so the front end never pays for it.  The table covers
+ * only the nodes being generated, normally one top-level declaration:
+ * alloc_node_attrs(lo, hi) sets it up for ids lo .. hi-1.
+ */
+struct node_attr {
     struct addr place;
     struct instr *code;
-    int returned;
     struct addr first;     // Entry label for this node
     struct addr follow;    // Exit label for this node
     struct addr onTrue;    // Branch target when condition is true
     struct addr onFalse;   // Branch target when condition is false
-    int first_used;        // Flag indicating if first is used
-    int follow_used;       // Flag indicating if follow is used
-    int onTrue_used;       // Flag indicating if onTrue is used
-    int onFalse_used;      // Flag indicating if onFalse is used
+    unsigned first_used:1;     // Flag indicating if first is used
+    unsigned follow_used:1;    // Flag indicating if follow is used
+    unsigned onTrue_used:1;    // Flag indicating if onTrue is used
+    unsigned onFalse_used:1;   // Flag indicating if onFalse is used
+    unsigned returned:1;
 };
 
+extern struct node_attr *node_attrs;
+extern int attr_base;
+#define ATTR(t) (&node_attrs[(t)->id - attr_base])
+
 typedef struct func_symtab_list {
     SymbolTable symtab;
     struct func_symtab_list *next;
@@ -57,9 +79,18 @@ typedef struct func_symtab_list {
 
 FuncSymbolTableList printsyms(struct tree *t, SymbolTable st);
 void free_func_symtab_list(FuncSymbolTableList list);
+char *intern(const char *s);
+void free_interned(void);
 int alctoken(int category, char *text);
 struct tree *alctree(int prodrule, char *symbolname, int nkids, ...);
-void freetree(struct tree *t);
+struct tree *tree_append(struct tree *list, struct tree *kid);
+void end_declaration(int lookahead);
+int declaration_count(void);
+void declaration_ids(int k, int *lo, int *hi);
+int node_count(void);
+void release_declarations(int k);
+void free_trees(void);
+void alloc_node_attrs(int lo, int hi);
 void printtree(struct tree *t, int depth);
 void print_graph(struct tree *t, char *filename);
 char *get_type_name(struct tree *type_node);
@@ -37,7 +37,8 @@ char *typenam[] = {
    "func",    // index 6
    "class",   // index 7
    "package", // index 8
-   "any"      // index 9
+   "any",     // index 9
+   "map"      // index 10
 };
 
 typeptr alctype(int base)
@@ -94,6 +95,27 @@ typeptr alcfunctype(struct tree * r, struct tree * p, SymbolTable st)
     return rv;
 }
 
+/*
+ * Bits per element of an Array<T>.  Byte, Short and Long are Ints in k0
+ * but keep their own width in an array; Booleans are packed one per bit,
+ * and Doubles and Strings (pointers) take 8 bytes.
+ */
+int array_elem_bits(struct tree *elemNode) {
+   const char *name = NULL;
+   if (elemNode && elemNode->leaf)
+       name = elemNode->leaf->text;
+   else if (elemNode && elemNode->nkids > 0 && elemNode->kids[0] && elemNode->kids[0]->leaf)
+       name = elemNode->kids[0]->leaf->text;
+   if (!name) return 32;
+   if (strcmp(name, "Byte") == 0)    return 8;
+   if (strcmp(name, "Short") == 0)   return 16;
+   if (strcmp(name, "Boolean") == 0) return 1;
+   if (strcmp(name, "Long") == 0 || strcmp(name, "Double") == 0 ||
+       strcmp(name, "Float") == 0 || strcmp(name, "String") == 0)
+       return 64;
+   return 32;
+}
+
 /* Construct an array type from syntax (sub)trees.
    This routine should eventually use the provided subtrees to set the element type and size.
 */
@@ -103,6 +125,7 @@ typeptr alcarraytype(struct tree *elemNode, struct tree *sizeNode) {
    if (!rv) return NULL;
 
    rv->u.a.elemtype = elemNode->type;
+   rv->u.a.elembits = array_elem_bits(elemNode);
 
    if (sizeNode
        && sizeNode->leaf
@@ -116,6 +139,15 @@ typeptr alcarraytype(struct tree *elemNode, struct tree *sizeNode) {
    return rv;
 }
 
+/* HashMap<K, V>: the key and value types come from the type arguments */
+typeptr alcmaptype(struct tree *keyNode, struct tree *valNode) {
+   typeptr rv = alctype(MAP_TYPE);
+   if (!rv) return NULL;
+   rv->u.m.keytype = keyNode->type;
+   rv->u.m.valtype = valNode->type;
+   return rv;
+}
+
 char *typename(typeptr t)
 {
     if (!t) return "(NULL)";
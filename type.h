@@ -29,7 +29,8 @@ struct field {			/* members (fields) of structs */
 #define CLASSTYPE    1000007
 #define PACKAGE_TYPE 1000008
 #define ANY_TYPE     1000009
-#define LAST_TYPE    1000009
+#define MAP_TYPE     1000010
+#define LAST_TYPE    1000010
 
 typedef struct typeinfo {
    int basetype;
@@ -45,7 +46,12 @@ typedef struct typeinfo {
     struct arrayinfo {
         int size; /* -1 == unspecified/unknown/dontcare */
 	    struct typeinfo *elemtype;
+        int elembits; /* element width; Array<Boolean> is a bitset */
     }a;
+    struct mapinfo {
+        struct typeinfo *keytype;
+        struct typeinfo *valtype;
+    }m;
   } u;
 } *typeptr;
 
@@ -53,6 +59,8 @@ typedef struct typeinfo {
 typeptr alctype(int base);
 typeptr alcfunctype(struct tree * r, struct tree * p, struct sym_table * st);
 typeptr alcarraytype(struct tree * s, struct tree * e);
+int array_elem_bits(struct tree *elemNode);
+typeptr alcmaptype(struct tree * k, struct tree * v);
 char *typename(typeptr t);
 
 extern struct sym_table *global_table;
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tree.h"
+#include "tac.h"
+#include "k0gram.tab.h"
+#include "type.h"
+#include "codegen.h"
+#include "symtab.h"
+#include "unroll.h"
+
+/*
+ * Unrolling for forStatementKotlinRange.
+ *
+ * A range whose bounds are both integer literals and whose trip count is
+ * at most UNROLL_FULL_MAX is unrolled completely: each copy of the body is
+ * preceded by i = <constant>, which fold_constants() then propagates into
+ * the body, and the copies are followed by i = end + 1.  Any other range is unrolled unroll_factor times, with a
+ * remainder loop for the last (count % unroll_factor) iterations:
+ *
+ *         i = start
+ *     L1: t = i + (F-1); if t > end goto L2
+ *         body; i = i + 1; ... (F copies)
+ *         goto L1
+ *     L2: if i > end goto L3
+ *         body; i = i + 1
+ *         goto L2
+ *     L3:
+ *
+ * Only small bodies are copied, and never ones containing break or
+ * continue since those would need per-copy targets.
+ */
+
+#define NULL_ADDR ((struct addr){R_NONE, {.offset = 0}})
+
+#define UNROLL_FULL_MAX   8     /* max trip count to unroll completely */
+#define UNROLL_MAX_NODES 40     /* max body size (tree nodes) to copy */
+
+int unroll_factor = 4;          /* -funroll=N, N <= 1 disables */
+
+extern SymbolTable currentFunctionSymtab;
+extern struct addr new_temp(void);
+extern struct addr *genlabel(void);
+
+/* tree nodes in t, or -1 if t contains something we must not copy */
+static int body_size(struct tree *t) {
+    if (!t) return 0;
+    if (t->symbolname &&
+        (strcmp(t->symbolname, "breakStatement") == 0 ||
+         strcmp(t->symbolname, "continueStatement") == 0))
+        return -1;
+    int n = 1;
+    for (int i = 0; i < t->nkids; i++) {
+        int k = body_size(t->kids[i]);
+        if (k < 0) return -1;
+        n += k;
+    }
+    return n;
+}
+
+static int int_literal(struct tree *t, int *val) {
+    while (t && !t->leaf && t->nkids == 1) t = t->kids[0];
+    if (!t || !t->leaf || t->leaf->category != IntegerLiteral) return 0;
+    *val = t->leaf->value.ival;
+    return 1;
+}
+
+static struct addr immed(int v) {
+    return (struct addr){ .region = R_IMMED, .u.offset = v };
+}
+
+/* one copy of the body followed by i = i + 1 */
+static struct instr *body_step(struct tree *body, struct addr i_addr) {
+    generate_code(body);
+    struct instr *code = ATTR(body)->code;
+    struct addr inc = new_temp();
+    code = concat(code, gen(O_IADD, inc, i_addr, immed(1)));
+    return concat(code, gen(O_ASN, i_addr, inc, NULL_ADDR));
+}
+
+/* i is left at hi + 1, as the loop would leave it */
+static struct instr *unroll_full(struct tree *body, struct addr i_addr,
+                                 int lo, int hi) {
+    struct instr *code = NULL;
+    for (int k = lo; k <= hi; k++) {
+        code = concat(code, gen(O_ASN, i_addr, immed(k), NULL_ADDR));
+        generate_code(body);
+        code = concat(code, ATTR(body)->code);
+    }
+    return concat(code, gen(O_ASN, i_addr, immed(hi + 1), NULL_ADDR));
+}
+
+static struct instr *unroll_partial(struct tree *startExpr,
+                                    struct tree *endExpr,
+                                    struct tree *body, struct addr i_addr) {
+    generate_code(startExpr);
+    generate_code(endExpr);
+    struct instr *code = concat(ATTR(startExpr)->code, ATTR(endExpr)->code);
+    code = concat(code, gen(O_ASN, i_addr, ATTR(startExpr)->place, NULL_ADDR));
+
+    struct addr *main_top = genlabel();
+    struct addr *rem_top  = genlabel();
+    struct addr *done     = genlabel();
+
+    code = concat(code, gen(D_LABEL, *main_top, NULL_ADDR, NULL_ADDR));
+    struct addr last = new_temp();
+    code = concat(code, gen(O_IADD, last, i_addr, immed(unroll_factor - 1)));
+    code = concat(code, gen(O_BGT, *rem_top, last, ATTR(endExpr)->place));
+    for (int k = 0; k < unroll_factor; k++)
+        code = concat(code, body_step(body, i_addr));
+    code = concat(code, gen(O_BR, *main_top, NULL_ADDR, NULL_ADDR));
+
+    code = concat(code, gen(D_LABEL, *rem_top, NULL_ADDR, NULL_ADDR));
+    code = concat(code, gen(O_BGT, *done, i_addr, ATTR(endExpr)->place));
+    code = concat(code, body_step(body, i_addr));
+    code = concat(code, gen(O_BR, *rem_top, NULL_ADDR, NULL_ADDR));
+    return concat(code, gen(D_LABEL, *done, NULL_ADDR, NULL_ADDR));
+}
+
+struct instr *unroll_range_loop(struct tree *t) {
+    struct tree *loopVar   = t->kids[0];
+    struct tree *startExpr = t->kids[1];
+    struct tree *endExpr   = t->kids[2];
+    struct tree *body      = t->kids[3];
+    int lo, hi;
+
+    SymbolTableEntry entry = lookup_symbol(currentFunctionSymtab,
+                                           loopVar->leaf->text);
+    if (!entry) return NULL;
+
+    int size = body_size(body);
+    if (size < 0 || size > UNROLL_MAX_NODES) return NULL;
+
+    if (int_literal(startExpr, &lo) && int_literal(endExpr, &hi) &&
+        (long)hi - lo < UNROLL_FULL_MAX) {
+        if (hi < lo)   /* empty range: only i = lo, as the loop's test */
+            return gen(O_ASN, entry->location, immed(lo), NULL_ADDR);
+        return unroll_full(body, entry->location, lo, hi);
+    }
+    if (unroll_factor <= 1) return NULL;
+    return unroll_partial(startExpr, endExpr, body, entry->location);
+}
@@ -0,0 +1,10 @@
+#ifndef UNROLL_H
+#define UNROLL_H
+
+#include "tree.h"
+
+extern int unroll_factor;
+
+struct instr *unroll_range_loop(struct tree *t);
+
+#endif
@@ -0,0 +1,329 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tree.h"
+#include "tac.h"
+#include "k0gram.tab.h"
+#include "type.h"
+#include "codegen.h"
+#include "symtab.h"
+#include "vectorize.h"
+
+/*
+ * Loop vectorizer for counted range loops.
+ *
+ * forStatementKotlinRange is already a canonical counted loop: the
+ * induction variable steps by one from startExpr to endExpr and cannot be
+ * assigned in the body (it is a val).  So instead of rebuilding that from
+ * the TAC we match the loop body in the tree and, when every array access
+ * is indexed by exactly the induction variable, replace the whole loop by
+ * one vector kernel instruction.  Indices never differ between iterations'
+ * reads and writes, so there are no loop-carried dependences.
+ *
+ * Recognized bodies (one statement):
+ *     c[i] = x op y      x, y: a[i], variable or literal; op: + - *
+ *     c[i] = x           copy or broadcast
+ *     s = s + a[i]       sum reduction (also s = a[i] + s)
+ *     if (a[i] > m) m = a[i]   max reduction (also <, and m on the left)
+ * The element-wise forms take Int or Double arrays, all of one type,
+ * with scalars of that type; the kernel is is_double for Doubles.  The
+ * reductions are Int only: a vector Double sum would add in another
+ * order and round differently, and min/max would have to settle NaN
+ * and -0.0 the way the if does.
+ *
+ * Kernel operands are passed with O_PARM just like a call:
+ *     O_VADD/O_VSUB/O_VMUL   parms: dst ptr, lhs, rhs, count
+ *     O_VSUM/O_VMIN/O_VMAX   dest: accumulator; parms: src ptr, count
+ * An operand whose PARM has is_ptr set is a vector; otherwise it is a
+ * scalar broadcast across the lanes.
+ */
+
+#define NULL_ADDR ((struct addr){R_NONE, {.offset = 0}})
+
+extern SymbolTable currentFunctionSymtab;
+extern struct addr new_temp(void);
+extern struct addr *genlabel(void);
+extern struct addr double_const(double v, struct instr **code);
+
+static struct tree *strip(struct tree *t) {
+    while (t && !t->leaf && t->nkids == 1 && t->kids[0]) t = t->kids[0];
+    return t;
+}
+
+static int is_named(struct tree *t, const char *name) {
+    return t && t->symbolname && strcmp(t->symbolname, name) == 0;
+}
+
+static int is_ident(struct tree *t, const char *name) {
+    t = strip(t);
+    return t && t->leaf && t->leaf->category == Identifier &&
+           (!name || strcmp(t->leaf->text, name) == 0);
+}
+
+/* an Array<Int> or Array<Double> variable, by elem */
+static SymbolTableEntry array_var(struct tree *t, typeptr elem) {
+    t = strip(t);
+    if (!t || !t->leaf || t->leaf->category != Identifier) return NULL;
+    SymbolTableEntry e = lookup_symbol(currentFunctionSymtab, t->leaf->text);
+    if (!e || !e->type || e->type->basetype != ARRAY_TYPE ||
+        e->type->u.a.elemtype != elem ||
+        e->type->u.a.elembits != (elem == double_typeptr ? 64 : 32))
+        return NULL;
+    return e;
+}
+
+/* the element type of the array in a[i], or NULL */
+static typeptr access_elem(struct tree *t) {
+    t = strip(t);
+    if (!is_named(t, "arrayAccess") || t->nkids != 2 || !is_ident(t->kids[0], NULL))
+        return NULL;
+    SymbolTableEntry e = lookup_symbol(currentFunctionSymtab, strip(t->kids[0])->leaf->text);
+    return e && e->type && e->type->basetype == ARRAY_TYPE ? e->type->u.a.elemtype : NULL;
+}
+
+/* one kernel operand: an array indexed by the loop variable, or a scalar */
+struct voperand {
+    int is_vec;
+    SymbolTableEntry arr;   /* is_vec */
+    struct tree *scalar;    /* !is_vec: variable or literal */
+};
+
+/* an operand whose elements or value are of type elem */
+static int match_operand(struct tree *t, const char *ivar, typeptr elem,
+                         struct voperand *op) {
+    t = strip(t);
+    if (!t) return 0;
+    if (is_named(t, "arrayAccess") && t->nkids == 2) {
+        op->arr = array_var(t->kids[0], elem);
+        op->is_vec = 1;
+        return op->arr && is_ident(t->kids[1], ivar);
+    }
+    op->is_vec = 0;
+    op->scalar = t;
+    if (t->leaf && t->leaf->category ==
+                   (elem == double_typeptr ? RealLiteral : IntegerLiteral))
+        return 1;
+    if (t->leaf && t->leaf->category == Identifier &&
+        strcmp(t->leaf->text, ivar) != 0) {
+        SymbolTableEntry e = lookup_symbol(currentFunctionSymtab, t->leaf->text);
+        return e && e->type == elem && e->location.region == R_LOCAL;
+    }
+    return 0;
+}
+
+static struct instr *parm(struct addr a, int is_ptr) {
+    struct instr *p = gen(O_PARM, NULL_ADDR, a, NULL_ADDR);
+    p->is_ptr = is_ptr;
+    return p;
+}
+
+/* &arr[start] into a fresh pointer temp */
+static struct instr *element_ptr(SymbolTableEntry arr, struct addr start,
+                                 struct addr *out) {
+    struct addr off = new_temp();
+    int size = arr->type->u.a.elemtype == double_typeptr ? 8 : 4;
+    struct instr *code = gen(O_IMUL, off, start,
+                             (struct addr){ .region = R_IMMED, .u.offset = size });
+    *out = new_temp();
+    struct instr *add = gen(O_IADD, *out, arr->location, off);
+    add->is_ptr = 1;
+    return concat(code, add);
+}
+
+static struct instr *operand_parm(struct voperand *op, struct addr start,
+                                  int dbl, struct instr **code) {
+    if (op->is_vec) {
+        struct addr p;
+        *code = concat(*code, element_ptr(op->arr, start, &p));
+        return parm(p, 1);
+    }
+    generate_code(op->scalar);
+    *code = concat(*code, ATTR(op->scalar)->code);
+    struct instr *p = parm(ATTR(op->scalar)->place, 0);
+    p->is_double = dbl;
+    return p;
+}
+
+static struct instr *lower_elementwise(struct tree *lhs, struct tree *rhs,
+                                       const char *ivar, struct addr start,
+                                       struct addr count) {
+    struct voperand dst, a, b;
+    int opcode;
+
+    /* the kernel works on the destination's element type */
+    typeptr elem = access_elem(lhs);
+    if (!elem || !match_operand(lhs, ivar, elem, &dst) || !dst.is_vec) return NULL;
+
+    rhs = strip(rhs);
+    if (is_named(rhs, "additive_expression") && rhs->nkids == 2) {
+        opcode = rhs->prodrule == ADD ? O_VADD : O_VSUB;
+    } else if (is_named(rhs, "multiplicative_expression") && rhs->nkids == 2
+               && rhs->prodrule == MULT) {
+        opcode = O_VMUL;
+    } else {
+        /* plain copy/broadcast: c[i] = x is c[i] = x + 0, or x - 0.0
+           for Doubles, which keeps a -0.0 */
+        if (!match_operand(rhs, ivar, elem, &a)) return NULL;
+        b.is_vec = 0;
+        b.scalar = NULL;
+        opcode = elem == double_typeptr ? O_VSUB : O_VADD;
+        goto emit;
+    }
+    if (!match_operand(rhs->kids[0], ivar, elem, &a) ||
+        !match_operand(rhs->kids[1], ivar, elem, &b))
+        return NULL;
+    if (!a.is_vec && !b.is_vec) return NULL;
+
+emit: ;
+    struct instr *code = NULL;
+    struct instr *parms = NULL;
+    struct addr d;
+    code = concat(code, element_ptr(dst.arr, start, &d));
+    parms = concat(parms, parm(d, 1));
+    parms = concat(parms, operand_parm(&a, start, elem == double_typeptr, &code));
+    if (b.scalar || b.is_vec) {
+        parms = concat(parms, operand_parm(&b, start, elem == double_typeptr, &code));
+    } else if (elem == double_typeptr) {
+        struct instr *p = parm(double_const(0.0, &code), 0);
+        p->is_double = 1;
+        parms = concat(parms, p);
+    } else {
+        struct addr zero = new_temp();
+        code = concat(code, gen(O_ASN, zero,
+                                (struct addr){ .region = R_IMMED, .u.offset = 0 },
+                                NULL_ADDR));
+        parms = concat(parms, parm(zero, 0));
+    }
+    parms = concat(parms, parm(count, 0));
+    code = concat(code, parms);
+    struct instr *k = gen(opcode, NULL_ADDR, NULL_ADDR, NULL_ADDR);
+    k->is_double = elem == double_typeptr;
+    return concat(code, k);
+}
+
+static struct instr *reduction(int opcode, SymbolTableEntry acc,
+                               SymbolTableEntry arr, struct addr start,
+                               struct addr count) {
+    struct addr p;
+    struct instr *code = element_ptr(arr, start, &p);
+    code = concat(code, parm(p, 1));
+    code = concat(code, parm(count, 0));
+    return concat(code, gen(opcode, acc->location, NULL_ADDR, NULL_ADDR));
+}
+
+static SymbolTableEntry int_scalar_var(struct tree *t, const char *ivar) {
+    t = strip(t);
+    if (!is_ident(t, NULL) || strcmp(t->leaf->text, ivar) == 0) return NULL;
+    SymbolTableEntry e = lookup_symbol(currentFunctionSymtab, t->leaf->text);
+    return (e && e->type == integer_typeptr && e->location.region == R_LOCAL)
+           ? e : NULL;
+}
+
+/* s = s + a[i]  /  s = a[i] + s */
+static struct instr *lower_sum(struct tree *lhs, struct tree *rhs,
+                               const char *ivar, struct addr start,
+                               struct addr count) {
+    SymbolTableEntry s = int_scalar_var(lhs, ivar);
+    rhs = strip(rhs);
+    if (!s || !is_named(rhs, "additive_expression") || rhs->nkids != 2 ||
+        rhs->prodrule != ADD)
+        return NULL;
+    struct voperand a;
+    struct tree *other;
+    if (is_ident(rhs->kids[0], s->s))      other = rhs->kids[1];
+    else if (is_ident(rhs->kids[1], s->s)) other = rhs->kids[0];
+    else return NULL;
+    if (!match_operand(other, ivar, integer_typeptr, &a) || !a.is_vec) return NULL;
+    return reduction(O_VSUM, s, a.arr, start, count);
+}
+
+/* if (a[i] > m) m = a[i]  and the <, m-on-the-left variants */
+static struct instr *lower_minmax(struct tree *ifs, const char *ivar,
+                                  struct addr start, struct addr count) {
+    struct tree *cond = strip(ifs->kids[0]);
+    struct tree *then = strip(ifs->kids[1]);
+    if (!is_named(cond, "comparison") || cond->nkids != 2) return NULL;
+    if (!is_named(then, "assignment") || then->nkids != 2) return NULL;
+
+    SymbolTableEntry m = int_scalar_var(then->kids[0], ivar);
+    struct voperand src, a;
+    if (!m || !match_operand(then->kids[1], ivar, integer_typeptr, &src) || !src.is_vec)
+        return NULL;
+
+    int arr_left;
+    if (match_operand(cond->kids[0], ivar, integer_typeptr, &a) && a.is_vec &&
+        is_ident(cond->kids[1], m->s))
+        arr_left = 1;
+    else if (match_operand(cond->kids[1], ivar, integer_typeptr, &a) && a.is_vec &&
+             is_ident(cond->kids[0], m->s))
+        arr_left = 0;
+    else
+        return NULL;
+    if (a.arr != src.arr) return NULL;
+
+    int greater;
+    switch (cond->prodrule) {
+        case RANGLE: case GE: greater = 1; break;
+        case LANGLE: case LE: greater = 0; break;
+        default: return NULL;
+    }
+    /* a[i] > m keeps the maximum; m > a[i] keeps the minimum */
+    int opcode = (greater == arr_left) ? O_VMAX : O_VMIN;
+    return reduction(opcode, m, a.arr, start, count);
+}
+
+struct instr *vectorize_range_loop(struct tree *t) {
+    struct tree *loopVar   = t->kids[0];
+    struct tree *startExpr = t->kids[1];
+    struct tree *endExpr   = t->kids[2];
+    struct tree *body      = strip(t->kids[3]);
+    const char *ivar;
+
+    if (!loopVar || !loopVar->leaf || !body) return NULL;
+    ivar = loopVar->leaf->text;
+    SymbolTableEntry ientry = lookup_symbol(currentFunctionSymtab, loopVar->leaf->text);
+    if (!ientry) return NULL;
+
+    /* match before generating anything so a miss costs nothing */
+    int kind;
+    if (is_named(body, "assignment") && body->nkids == 2) {
+        struct tree *lhs = strip(body->kids[0]);
+        kind = is_named(lhs, "arrayAccess") ? 0 : 1;
+    } else if (is_named(body, "ifStatement") && body->nkids == 2) {
+        kind = 2;
+    } else {
+        return NULL;
+    }
+
+    struct addr start = new_temp(), count = new_temp();
+    struct instr *kernel;
+    if (kind == 0)
+        kernel = lower_elementwise(body->kids[0], body->kids[1], ivar,
+                                   start, count);
+    else if (kind == 1)
+        kernel = lower_sum(body->kids[0], body->kids[1], ivar, start, count);
+    else
+        kernel = lower_minmax(body, ivar, start, count);
+    if (!kernel) return NULL;
+
+    /* count = end - start + 1; a non-positive count runs no iterations */
+    generate_code(startExpr);
+    generate_code(endExpr);
+    struct instr *code = concat(ATTR(startExpr)->code, ATTR(endExpr)->code);
+    code = concat(code, gen(O_ASN, start, ATTR(startExpr)->place, NULL_ADDR));
+    code = concat(code, gen(O_ISUB, count, ATTR(endExpr)->place, start));
+    code = concat(code, gen(O_IADD, count, count,
+                            (struct addr){ .region = R_IMMED, .u.offset = 1 }));
+    code = concat(code, kernel);
+
+    /* i is left where the loop would leave it: start + count, or start */
+    struct addr *done = genlabel();
+    code = concat(code, gen(O_ASN, ientry->location, start, NULL_ADDR));
+    code = concat(code, gen(O_BLE, *done, count,
+                            (struct addr){ .region = R_IMMED, .u.offset = 0 }));
+    code = concat(code, gen(O_IADD, ientry->location, start, count));
+    code = concat(code, gen(D_LABEL, *done, NULL_ADDR, NULL_ADDR));
+    free(done);
+    return code;
+}
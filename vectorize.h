@@ -0,0 +1,8 @@
+#ifndef VECTORIZE_H
+#define VECTORIZE_H
+
+#include "tree.h"
+
+struct instr *vectorize_range_loop(struct tree *t);
+
+#endif
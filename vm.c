@@ -0,0 +1,997 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <dlfcn.h>
+
+#include "tac.h"
+#include "vm.h"
+#include "runtime/k0rt.h"
+
+/*
+ * TAC virtual machine.
+ *
+ * Runs the code list write_asm would translate, with the frame layout
+ * and the runtime of the native code: every value lives in the 8-byte
+ * slot at fp - offset (an Int in its low 4 bytes), arguments travel in
+ * six integer and eight double "registers" counted per class, and calls that
+ * are not to k0 functions go to the libk0rt/libm functions linked into
+ * k0 (as for -run).  A program therefore prints the same output and
+ * exits with the same status as its native build, which makes the VM
+ * an oracle for the backend (run_difftests.sh) as well as a way to run
+ * a program with no assembler or linker at all.
+ *
+ * The list is first encoded into an array of struct vop.  Labels and
+ * declarations disappear, branches point at their target vop, calls at
+ * the callee's first vop or at the C function, and each opcode becomes
+ * one of a few more specific kinds: an immediate operand, a pointer
+ * add, a double compare, an element width.  run() then dispatches with
+ * computed goto, one indirect jump at the end of every handler.
+ */
+
+enum {
+    K_MOV32, K_MOVI, K_MOV64, K_MOVSTR, K_PARI, K_PAR64, K_PARD,
+    K_STM, K_STMI, K_STMP, K_LDM, K_ADDR, K_LCONT, K_SCONT,
+    K_IADD, K_IADDI, K_PADD, K_ISUB, K_ISUBI, K_IMUL, K_IMULI, K_IDIV, K_IMOD,
+    K_DADD, K_DSUB, K_DMUL, K_DDIV, K_NEG, K_NOT,
+    K_IEQ, K_INE, K_ILT, K_ILE, K_IGT, K_IGE,
+    K_DEQ, K_DNE, K_DLT, K_DLE, K_DGT, K_DGE,
+    K_JMP, K_BZ, K_BNZ,
+    K_BLT, K_BLE, K_BGT, K_BGE, K_BEQ, K_BNE,
+    K_BLTI, K_BLEI, K_BGTI, K_BGEI, K_BEQI, K_BNEI,
+    K_ALLOC, K_MALLOC, K_CALLOC, K_FILL,
+    K_VADD, K_VSUB, K_VMUL, K_VSUM, K_VMIN, K_VMAX,
+    K_ABS, K_DMAX, K_DMIN, K_POW, K_SIN, K_COS, K_TAN, K_RAND,
+    K_SLEN, K_SGET, K_ALEN, K_ALOAD, K_ASTORE,
+    K_PARM32, K_PARMI, K_PARM64, K_PARMSTR, K_PARMD,
+    K_CALL, K_CCALL, K_RET, K_RETI, K_RET32, K_RET64, K_RETSTR, K_RETD,
+    NKINDS
+};
+
+/* what a call stores into its dest, and how a RAND, ALOAD or ASTORE runs */
+enum { RC_NONE, RC_INT, RC_PTR, RC_DBL };
+enum { RAND_INT, RAND_BOUNDED, RAND_DOUBLE };
+
+/* n bits for operands that may be immediate (or a String literal) */
+#define F_IMM1   1          /* b is a value, not a slot */
+#define F_IMM2   2          /* c is a value */
+#define F_STR    4          /* the String operand is the literal u.str */
+#define F_CHECK  8          /* ALOAD/ASTORE: check the index */
+#define F_WIDE  16          /* ASTORE 64: value slot is 64 bits */
+#define F_SEXT  32          /* ASTORE 64: value slot is an Int to widen */
+#define W_SHIFT  8          /* ALOAD/ASTORE: element bits in n >> W_SHIFT */
+
+struct vop {
+    union { int kind; const void *go; };
+    int a, b, c;        /* dest, src1, src2: slot offsets or immediates */
+    int n;              /* flags, element width, return class, arg number */
+    union {
+        struct vop *to;     /* branch target, k0 callee */
+        void *fn;           /* runtime callee */
+        k0_str *str;        /* String literal */
+        double d;           /* O_LCONT value */
+    } u;
+};
+
+#define VM_STACK   (64L << 20)
+#define VM_DEPTH   (1 << 20)
+
+typedef int32_t  __attribute__((may_alias)) vi32;
+typedef uint32_t __attribute__((may_alias)) vu32;
+typedef int64_t  __attribute__((may_alias)) vi64;
+typedef double   __attribute__((may_alias)) vdbl;
+typedef char    *__attribute__((may_alias)) vptr;
+
+#define I32(o) (*(vi32 *)(fp - (o)))
+#define U32(o) (*(vu32 *)(fp - (o)))
+#define I64(o) (*(vi64 *)(fp - (o)))
+#define DBL(o) (*(vdbl *)(fp - (o)))
+#define PTR(o) (*(vptr *)(fp - (o)))
+
+/*
+ * every runtime function fits this: Ints and pointers in order, Doubles
+ * in order, one parameter per argument register of the ABI (tac.h)
+ */
+typedef uint64_t (*icall)(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t,
+                          double, double, double, double,
+                          double, double, double, double);
+typedef double (*dcall)(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t,
+                        double, double, double, double,
+                        double, double, double, double);
+_Static_assert(PARAM_INT_REGS == 6 && PARAM_DOUBLE_REGS == 8,
+               "icall/dcall pass six Int and eight Double registers");
+
+/*
+ * Arguments travel through one array: the Int/pointer registers, the
+ * Double registers, then what the native code would pass on the stack.
+ * PARM and R_PARAM operands are indexes into it.
+ */
+union vm_arg { uint64_t i; double d; };
+#define ARG_DOUBLE PARAM_INT_REGS
+#define ARG_STACK  (PARAM_INT_REGS + PARAM_DOUBLE_REGS)
+
+static void vm_error(const char *fmt, const char *arg) {
+    fprintf(stderr, "k0: vm: ");
+    fprintf(stderr, fmt, arg);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+/* ---------------------------------------------------------------- encoding */
+
+struct encoder {
+    const struct tac_program *prog;
+    struct vop *ops;
+    struct instr **origin;      /* the instr each vop came from */
+    int nops, cap, caporigin;
+    int *label;                 /* label number -> vop index */
+    int nlabels;
+    struct { const char *name; int at; } *func;
+    int nfuncs, capfuncs;
+    k0_str *lits;
+    int argc, nint, ndouble, nstack, arg_ptr[6], arg_double[6];
+    int maxstack;               /* the most stack arguments of any call */
+    int in_main;                /* a bare return from main exits 0 */
+};
+
+static void *grow(void *p, size_t size, int need, int *cap) {
+    if (need <= *cap) return p;
+    int n = *cap ? *cap * 2 : 256;
+    while (n < need) n *= 2;
+    p = realloc(p, n * size);
+    if (!p) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+    *cap = n;
+    return p;
+}
+
+static void set_label(struct encoder *e, int l, int at) {
+    if (l < 0) return;
+    if (l >= e->nlabels) {
+        int old = e->nlabels, cap = e->nlabels;
+        e->label = grow(e->label, sizeof *e->label, l + 1, &cap);
+        for (int i = old; i < cap; i++) e->label[i] = -1;
+        e->nlabels = cap;
+    }
+    e->label[l] = at;
+}
+
+static struct vop *label_target(struct encoder *e, int l) {
+    if (l < 0 || l >= e->nlabels || e->label[l] < 0) {
+        char buf[32];
+        snprintf(buf, sizeof buf, "%d", l);
+        vm_error("branch to undefined label %s", buf);
+    }
+    return &e->ops[e->label[l]];
+}
+
+/* vop index of a k0 function, -1 before its D_PROC is encoded, -2 if none */
+static int find_func(struct encoder *e, const char *name) {
+    for (int i = 0; i < e->nfuncs; i++)
+        if (strcmp(e->func[i].name, name) == 0) return e->func[i].at;
+    return -2;
+}
+
+static void declare_funcs(struct encoder *e) {
+    for (struct instr *i = e->prog->code; i; i = i->next) {
+        if (i->opcode != D_PROC || i->src1.region != R_NAME) continue;
+        e->func = grow(e->func, sizeof *e->func, e->nfuncs + 1, &e->capfuncs);
+        e->func[e->nfuncs].name = i->src1.u.name;
+        e->func[e->nfuncs++].at = -1;
+    }
+}
+
+static void define_func(struct encoder *e, const char *name, int at) {
+    for (int i = 0; i < e->nfuncs; i++)
+        if (strcmp(e->func[i].name, name) == 0) e->func[i].at = at;
+}
+
+/* String literal text, escapes and all, to the header write_asm would emit */
+static void make_literal(k0_str *s, const char *text) {
+    size_t n = strlen(text);
+    char *buf = malloc(n + 1), *p = buf;
+    const char *q = text;
+    if (*q == '"') q++;
+    while (*q && !(*q == '"' && q[1] == '\0')) {
+        if (*q != '\\') {
+            *p++ = *q++;
+            continue;
+        }
+        q++;
+        switch (*q) {
+            case 'n': *p++ = '\n'; q++; break;
+            case 't': *p++ = '\t'; q++; break;
+            case 'r': *p++ = '\r'; q++; break;
+            case 'b': *p++ = '\b'; q++; break;
+            case 'f': *p++ = '\f'; q++; break;
+            case 'x': {
+                char *end;
+                *p++ = (char)strtol(q + 1, &end, 16);
+                q = end;
+                break;
+            }
+            default:
+                if (*q >= '0' && *q <= '7') {
+                    int v = 0;
+                    for (int k = 0; k < 3 && *q >= '0' && *q <= '7'; k++)
+                        v = v * 8 + (*q++ - '0');
+                    *p++ = (char)v;
+                } else if (*q) {
+                    *p++ = *q++;
+                }
+        }
+    }
+    *p = '\0';
+    s->len = p - buf;
+    s->data = buf;
+}
+
+static k0_str *literal(struct encoder *e, int i) {
+    if (i < 0 || i >= e->prog->nstrings) vm_error("no String literal %s", "");
+    return &e->lits[i];
+}
+
+static struct vop *emit(struct encoder *e, struct instr *from, int kind,
+                        int a, int b, int c, int n) {
+    e->ops = grow(e->ops, sizeof *e->ops, e->nops + 1, &e->cap);
+    e->origin = grow(e->origin, sizeof *e->origin, e->nops + 1, &e->caporigin);
+    struct vop *v = &e->ops[e->nops];
+    memset(v, 0, sizeof *v);
+    v->kind = kind;
+    v->a = a;
+    v->b = b;
+    v->c = c;
+    v->n = n;
+    e->origin[e->nops++] = from;
+    return v;
+}
+
+static int is_imm(struct addr a) { return a.region == R_IMMED; }
+
+static int ret_class(struct instr *i) {
+    return i->is_double ? RC_DBL : i->is_ptr ? RC_PTR : RC_INT;
+}
+
+static void encode_call(struct encoder *e, struct instr *i) {
+    int rc = i->dest.u.offset > 0 ? ret_class(i) : RC_NONE;
+    const char *name = i->src1.region == R_NAME ? i->src1.u.name : NULL;
+    struct vop *v;
+
+    // print/println take the typed runtime entry point, as in write_asm
+    if (name && (strcmp(name, "println") == 0 || strcmp(name, "print") == 0) &&
+        e->argc == 1) {
+        int ln = strcmp(name, "println") == 0;
+        name = e->arg_ptr[0]    ? "k0_print_str"
+             : e->arg_double[0] ? (ln ? "k0_println_double" : "k0_print_double")
+             :                    (ln ? "k0_println_int" : "k0_print_int");
+        v = emit(e, i, K_CCALL, 0, 0, 0, RC_NONE);
+    } else if (!name || find_func(e, name) != -2) {
+        v = emit(e, i, K_CALL, i->dest.u.offset, 0, 0, rc);
+        name = NULL;
+    } else {
+        v = emit(e, i, K_CCALL, i->dest.u.offset, 0, 0, rc);
+    }
+    if (name && !(v->u.fn = dlsym(RTLD_DEFAULT, name)))
+        vm_error("undefined function %s", name);
+    e->argc = e->nint = e->ndouble = e->nstack = 0;
+}
+
+static void encode_branch(struct encoder *e, struct instr *i) {
+    static const int swapped[] = { O_BGT, O_BGE, O_BLT, O_BLE, O_BEQ, O_BNE };
+    int op = i->opcode;
+    struct addr x = i->src1, y = i->src2;
+    if (is_imm(x) && is_imm(y)) {
+        int t;
+        switch (op) {
+            case O_BLT: t = x.u.offset <  y.u.offset; break;
+            case O_BLE: t = x.u.offset <= y.u.offset; break;
+            case O_BGT: t = x.u.offset >  y.u.offset; break;
+            case O_BGE: t = x.u.offset >= y.u.offset; break;
+            case O_BEQ: t = x.u.offset == y.u.offset; break;
+            default:    t = x.u.offset != y.u.offset; break;
+        }
+        if (t) emit(e, i, K_JMP, 0, 0, 0, 0);
+        return;
+    }
+    if (is_imm(x)) {
+        struct addr s = x;
+        x = y;
+        y = s;
+        op = swapped[op - O_BLT];
+    }
+    emit(e, i, (is_imm(y) ? K_BLTI : K_BLT) + (op - O_BLT), 0, x.u.offset, y.u.offset, 0);
+}
+
+/* where R_PARAM n of a callee is in the argument array */
+static int param_slot(struct instr *i) {
+    int n = i->src1.u.offset;
+    if (n >= PARAM_STACK) return ARG_STACK + n - PARAM_STACK;
+    return i->is_double ? ARG_DOUBLE + n : n;
+}
+
+static void encode_asn(struct encoder *e, struct instr *i) {
+    int d = i->dest.u.offset, s = i->src1.u.offset;
+    if (i->src1.region == R_PARAM) s = param_slot(i);
+    if (i->dest.region == R_MEM) {
+        emit(e, i, i->src1.region == R_IMMED ? K_STMI :
+                   i->src1.region == R_PARAM ? K_STMP : K_STM, d, s, 0, 0);
+    } else if (i->src1.region == R_MEM && i->dest.region == R_LOCAL) {
+        emit(e, i, K_LDM, d, s, 0, 0);
+    } else if (i->is_double) {
+        emit(e, i, i->src1.region == R_PARAM ? K_PARD : K_MOV64, d, s, 0, 0);
+    } else if (i->is_ptr) {
+        if (i->src1.region == R_GLOBAL)
+            emit(e, i, K_MOVSTR, d, 0, 0, 0)->u.str = literal(e, s);
+        else
+            emit(e, i, i->src1.region == R_PARAM ? K_PAR64 : K_MOV64, d, s, 0, 0);
+    } else {
+        emit(e, i, i->src1.region == R_IMMED ? K_MOVI :
+                   i->src1.region == R_PARAM ? K_PARI : K_MOV32, d, s, 0, 0);
+    }
+}
+
+/* a PARM loads the next register of its class, Int/pointer or Double,
+   or the next stack slot once those are used up */
+static void encode_parm(struct encoder *e, struct instr *i) {
+    int k = e->argc++, s = i->src1.u.offset;
+    int is_ptr = i->src1.region == R_GLOBAL || i->is_ptr;
+    int n;
+    if (i->is_double && e->ndouble < PARAM_DOUBLE_REGS)
+        n = ARG_DOUBLE + e->ndouble++;
+    else if (!i->is_double && e->nint < PARAM_INT_REGS)
+        n = e->nint++;
+    else {
+        n = ARG_STACK + e->nstack++;
+        if (e->nstack > e->maxstack) e->maxstack = e->nstack;
+    }
+    if (k < 6) {
+        e->arg_ptr[k] = is_ptr;
+        e->arg_double[k] = i->is_double;
+    }
+    if (i->is_double)
+        emit(e, i, K_PARMD, 0, s, 0, n);
+    else if (i->src1.region == R_GLOBAL)
+        emit(e, i, K_PARMSTR, 0, 0, 0, n)->u.str = literal(e, s);
+    else if (is_ptr)
+        emit(e, i, K_PARM64, 0, s, 0, n);
+    else
+        emit(e, i, is_imm(i->src1) ? K_PARMI : K_PARM32, 0, s, 0, n);
+}
+
+/* String operand: a literal or a slot */
+static int str_operand(struct encoder *e, struct vop *v, struct addr a) {
+    if (a.region != R_GLOBAL) return 0;
+    v->u.str = literal(e, a.u.offset);
+    return F_STR;
+}
+
+static void encode(struct encoder *e, struct instr *i) {
+    int d = i->dest.u.offset, s1 = i->src1.u.offset, s2 = i->src2.u.offset;
+    struct vop *v;
+    switch (i->opcode) {
+        case D_PROC:
+            if (i->src1.region == R_NAME) define_func(e, i->src1.u.name, e->nops);
+            e->in_main = i->src1.region == R_NAME && strcmp(i->src1.u.name, "main") == 0;
+            e->argc = e->nint = e->ndouble = e->nstack = 0;
+            break;
+        case D_LABEL: case O_LBL:
+            set_label(e, d, e->nops);
+            break;
+        case D_END:
+            emit(e, i, e->in_main ? K_RETI : K_RET, 0, 0, 0, 0);
+            break;
+        case O_ALLOC:
+            if (s1 > 0) emit(e, i, K_ALLOC, 0, s1, 0, 0);
+            break;
+        case O_MALLOC: case O_CALLOC:
+            emit(e, i, i->opcode == O_MALLOC ? K_MALLOC : K_CALLOC, d, s1, s2,
+                 is_imm(i->src1) ? F_IMM1 : 0);
+            e->argc = e->nint = e->ndouble = e->nstack = 0;
+            break;
+        case O_FILL:
+            emit(e, i, K_FILL, d, s1, s2,
+                 (is_imm(i->src1) ? F_IMM1 : 0) | (is_imm(i->src2) ? F_IMM2 : 0));
+            break;
+        case O_VADD: case O_VSUB: case O_VMUL:
+            emit(e, i, K_VADD + (i->opcode - O_VADD), 0, 0, 0,
+                 (e->arg_ptr[1] ? 1 : 0) | (e->arg_ptr[2] ? 2 : 0) |
+                 (i->is_double ? 4 : 0));
+            e->argc = e->nint = e->ndouble = e->nstack = 0;
+            break;
+        case O_VSUM: case O_VMIN: case O_VMAX:
+            emit(e, i, K_VSUM + (i->opcode - O_VSUM), d, 0, 0, 0);
+            e->argc = e->nint = e->ndouble = e->nstack = 0;
+            break;
+        case O_PARM:
+            encode_parm(e, i);
+            break;
+        case O_CALL:
+            encode_call(e, i);
+            break;
+        case O_RET:
+            if (i->src1.region == R_NONE)
+                emit(e, i, e->in_main ? K_RETI : K_RET, 0, 0, 0, 0);
+            else if (i->is_double)
+                emit(e, i, K_RETD, 0, s1, 0, 0);
+            else if (i->is_ptr && i->src1.region == R_GLOBAL)
+                emit(e, i, K_RETSTR, 0, 0, 0, 0)->u.str = literal(e, s1);
+            else if (i->is_ptr)
+                emit(e, i, K_RET64, 0, s1, 0, 0);
+            else
+                emit(e, i, is_imm(i->src1) ? K_RETI : K_RET32, 0, s1, 0, 0);
+            break;
+        case O_ASN:
+            encode_asn(e, i);
+            break;
+        case O_ADDR:
+            emit(e, i, K_ADDR, d, s1, 0, 0);
+            break;
+        case O_LCONT:
+            if (s1 < 0 || s1 >= e->prog->nreals) vm_error("no Double literal %s", "");
+            emit(e, i, K_LCONT, d, 0, 0, 0)->u.d = e->prog->reals[s1];
+            break;
+        case O_SCONT:
+            emit(e, i, K_SCONT, 0, s1, 0, 0)->u.str = literal(e, d);
+            break;
+        case O_IADD:
+            emit(e, i, i->is_ptr ? K_PADD : is_imm(i->src2) ? K_IADDI : K_IADD, d, s1, s2, 0);
+            break;
+        case O_ISUB:
+            emit(e, i, is_imm(i->src2) ? K_ISUBI : K_ISUB, d, s1, s2, 0);
+            break;
+        case O_IMUL:
+            emit(e, i, is_imm(i->src2) ? K_IMULI : K_IMUL, d, s1, s2, 0);
+            break;
+        case O_IDIV: emit(e, i, K_IDIV, d, s1, s2, 0); break;
+        case O_IMOD: emit(e, i, K_IMOD, d, s1, s2, 0); break;
+        case O_DADD: emit(e, i, K_DADD, d, s1, s2, 0); break;
+        case O_DSUB: emit(e, i, K_DSUB, d, s1, s2, 0); break;
+        case O_DMUL: emit(e, i, K_DMUL, d, s1, s2, 0); break;
+        case O_DDIV: emit(e, i, K_DDIV, d, s1, s2, 0); break;
+        case O_NEG:  emit(e, i, K_NEG, d, s1, 0, 0); break;
+        case O_NOT:  emit(e, i, K_NOT, d, s1, 0, 0); break;
+        case O_IEQ: case O_INE: case O_ILT: case O_ILE: case O_IGT: case O_IGE: {
+            static const int order[] = { 0, 2, 3, 4, 5, 1 };   /* IEQ ILT ILE IGT IGE INE */
+            int k = order[i->opcode - O_IEQ];
+            emit(e, i, (i->is_double ? K_DEQ : K_IEQ) + k, d, s1, s2, 0);
+            break;
+        }
+        case O_GOTO: case O_BR:
+            emit(e, i, K_JMP, 0, 0, 0, 0);
+            break;
+        case O_BZ: case O_BNIF:
+            emit(e, i, K_BZ, 0, s1, 0, 0);
+            break;
+        case O_BNZ: case O_BIF:
+            emit(e, i, K_BNZ, 0, s1, 0, 0);
+            break;
+        case O_BLT: case O_BLE: case O_BGT: case O_BGE: case O_BEQ: case O_BNE:
+            encode_branch(e, i);
+            break;
+        case O_ABS: emit(e, i, K_ABS, d, s1, 0, 0); break;
+        case O_MAX: emit(e, i, K_DMAX, d, s1, s2, 0); break;
+        case O_MIN: emit(e, i, K_DMIN, d, s1, s2, 0); break;
+        case O_POW: emit(e, i, K_POW, d, s1, s2, 0); break;
+        case O_SIN: emit(e, i, K_SIN, d, s1, 0, 0); break;
+        case O_COS: emit(e, i, K_COS, d, s1, 0, 0); break;
+        case O_TAN: emit(e, i, K_TAN, d, s1, 0, 0); break;
+        case O_RAND:
+            emit(e, i, K_RAND, d, s1,
+                 i->is_double ? RAND_DOUBLE :
+                 i->src1.region == R_NONE ? RAND_INT : RAND_BOUNDED,
+                 is_imm(i->src1) ? F_IMM1 : 0);
+            break;
+        case O_SLEN:
+            v = emit(e, i, K_SLEN, d, s1, 0, 0);
+            v->n = str_operand(e, v, i->src1);
+            break;
+        case O_SGET:
+            v = emit(e, i, K_SGET, d, s1, s2, 0);
+            v->n = str_operand(e, v, i->src1) | (is_imm(i->src2) ? F_IMM2 : 0);
+            break;
+        case O_ALEN:
+            emit(e, i, K_ALEN, d, s1, 0, 0);
+            break;
+        case O_ALOAD:
+            emit(e, i, K_ALOAD, d, s1, s2,
+                 (is_imm(i->src2) ? F_IMM2 : 0) | (i->unchecked ? 0 : F_CHECK) |
+                 (i->width ? i->width : 32) << W_SHIFT);
+            break;
+        case O_ASTORE: {
+            int w = i->width ? i->width : 32;
+            int n = (i->unchecked ? 0 : F_CHECK) | w << W_SHIFT;
+            if (is_imm(i->src1)) n |= F_IMM1;
+            v = emit(e, i, K_ASTORE, d, s1, s2, 0);
+            if (w == 64 && i->is_ptr)         n |= str_operand(e, v, i->src2) ? F_STR : F_WIDE;
+            else if (w == 64 && i->is_double) n |= F_WIDE;
+            else if (is_imm(i->src2))         n |= F_IMM2;
+            else if (w == 64)                 n |= F_SEXT;
+            v->n = n;
+            break;
+        }
+        default:
+            // nothing in write_asm either (D_GLOB, O_DEALLOC, ...)
+            break;
+    }
+}
+
+/* branch targets and callees once every label and function is known */
+static void link_ops(struct encoder *e) {
+    for (int k = 0; k < e->nops; k++) {
+        struct vop *v = &e->ops[k];
+        struct instr *i = e->origin[k];
+        if (v->kind == K_JMP || v->kind == K_BZ || v->kind == K_BNZ ||
+            (v->kind >= K_BLT && v->kind <= K_BNEI))
+            v->u.to = label_target(e, i->dest.u.offset);
+        else if (v->kind == K_CALL && i->src1.region == R_NAME) {
+            int at = find_func(e, i->src1.u.name);
+            if (at < 0) vm_error("function %s has no body", i->src1.u.name);
+            v->u.to = &e->ops[at];
+        }
+        else if (v->kind == K_CALL)
+            v->u.to = label_target(e, i->src1.u.offset);
+    }
+}
+
+/* ---------------------------------------------------------------- execution */
+
+struct frame {
+    struct vop *ret;        /* the vop after the call */
+    char *fp, *sp;
+};
+
+static void index_error(int64_t i, int64_t len) {
+    k0_array_index_error((int)i, len);
+}
+
+static uint64_t run(struct vop *ops, int nops, struct vop *entry, int maxstack) {
+    static const void *const go[NKINDS] = {
+        [K_MOV32] = &&mov32, [K_MOVI] = &&movi, [K_MOV64] = &&mov64,
+        [K_MOVSTR] = &&movstr, [K_PARI] = &&pari, [K_PAR64] = &&par64,
+        [K_PARD] = &&pard, [K_STM] = &&stm, [K_STMI] = &&stmi, [K_STMP] = &&stmp,
+        [K_LDM] = &&ldm, [K_ADDR] = &&addr, [K_LCONT] = &&lcont, [K_SCONT] = &&scont,
+        [K_IADD] = &&iadd, [K_IADDI] = &&iaddi, [K_PADD] = &&padd,
+        [K_ISUB] = &&isub, [K_ISUBI] = &&isubi, [K_IMUL] = &&imul, [K_IMULI] = &&imuli,
+        [K_IDIV] = &&idiv, [K_IMOD] = &&imod,
+        [K_DADD] = &&dadd, [K_DSUB] = &&dsub, [K_DMUL] = &&dmul, [K_DDIV] = &&ddiv,
+        [K_NEG] = &&neg, [K_NOT] = &&not,
+        [K_IEQ] = &&ieq, [K_INE] = &&ine, [K_ILT] = &&ilt, [K_ILE] = &&ile,
+        [K_IGT] = &&igt, [K_IGE] = &&ige,
+        [K_DEQ] = &&deq, [K_DNE] = &&dne, [K_DLT] = &&dlt, [K_DLE] = &&dle,
+        [K_DGT] = &&dgt, [K_DGE] = &&dge,
+        [K_JMP] = &&jmp, [K_BZ] = &&bz, [K_BNZ] = &&bnz,
+        [K_BLT] = &&blt, [K_BLE] = &&ble, [K_BGT] = &&bgt, [K_BGE] = &&bge,
+        [K_BEQ] = &&beq, [K_BNE] = &&bne,
+        [K_BLTI] = &&blti, [K_BLEI] = &&blei, [K_BGTI] = &&bgti, [K_BGEI] = &&bgei,
+        [K_BEQI] = &&beqi, [K_BNEI] = &&bnei,
+        [K_ALLOC] = &&alloc, [K_MALLOC] = &&malloc_, [K_CALLOC] = &&calloc_,
+        [K_FILL] = &&fill,
+        [K_VADD] = &&vadd, [K_VSUB] = &&vsub, [K_VMUL] = &&vmul,
+        [K_VSUM] = &&vsum, [K_VMIN] = &&vmin, [K_VMAX] = &&vmax,
+        [K_ABS] = &&abs_, [K_DMAX] = &&dmax, [K_DMIN] = &&dmin, [K_POW] = &&pow_,
+        [K_SIN] = &&sin_, [K_COS] = &&cos_, [K_TAN] = &&tan_, [K_RAND] = &&rand_,
+        [K_SLEN] = &&slen, [K_SGET] = &&sget, [K_ALEN] = &&alen,
+        [K_ALOAD] = &&aload, [K_ASTORE] = &&astore,
+        [K_PARM32] = &&parm32, [K_PARMI] = &&parmi, [K_PARM64] = &&parm64,
+        [K_PARMSTR] = &&parmstr, [K_PARMD] = &&parmd,
+        [K_CALL] = &&call, [K_CCALL] = &&ccall, [K_RET] = &&ret, [K_RETI] = &&reti,
+        [K_RET32] = &&ret32, [K_RET64] = &&ret64, [K_RETSTR] = &&retstr,
+        [K_RETD] = &&retd,
+    };
+    for (int k = 0; k < nops; k++) ops[k].go = go[ops[k].kind];
+
+    char *stack = malloc(VM_STACK);
+    struct frame *frames = malloc(VM_DEPTH * sizeof *frames);
+    union vm_arg *arg = calloc(ARG_STACK + maxstack, sizeof *arg);
+    if (!stack || !frames || !arg) {
+        fprintf(stderr, "out of memory\n");
+        exit(4);
+    }
+    int depth = 0, vkind;
+    char *fp = stack + VM_STACK - 64, *sp = fp;
+    uint64_t rax = 0;
+    double xmm0 = 0;
+    struct vop *pc = entry;
+
+    frames[depth++] = (struct frame){ NULL, fp, sp };
+
+#define NEXT     goto *(++pc)->go
+#define JUMP(t)  do { pc = (t); goto *pc->go; } while (0)
+#define BRANCH(cond) do { if (cond) JUMP(pc->u.to); NEXT; } while (0)
+#define VAL1(v)  (((v)->n & F_IMM1) ? (v)->b : I32((v)->b))
+#define VAL2(v)  (((v)->n & F_IMM2) ? (v)->c : I32((v)->c))
+#define STR1(v)  (((v)->n & F_STR) ? (v)->u.str : (k0_str *)PTR((v)->b))
+
+    goto *pc->go;
+
+mov32:  I32(pc->a) = I32(pc->b); NEXT;
+movi:   I32(pc->a) = pc->b; NEXT;
+mov64:  I64(pc->a) = I64(pc->b); NEXT;
+movstr: PTR(pc->a) = (char *)pc->u.str; NEXT;
+pari:   U32(pc->a) = (uint32_t)arg[pc->b].i; NEXT;
+par64:  I64(pc->a) = (int64_t)arg[pc->b].i; NEXT;
+pard:   DBL(pc->a) = arg[pc->b].d; NEXT;
+stm:    *(vi32 *)PTR(pc->a) = I32(pc->b); NEXT;
+stmi:   *(vi32 *)PTR(pc->a) = pc->b; NEXT;
+stmp:   *(vi32 *)PTR(pc->a) = (int32_t)arg[pc->b].i; NEXT;
+ldm:    I32(pc->a) = *(vi32 *)PTR(pc->b); NEXT;
+addr:   PTR(pc->a) = fp - pc->b; NEXT;
+lcont:  DBL(pc->a) = pc->u.d; NEXT;
+scont:  memcpy(pc->u.str, fp - pc->b, 8); NEXT;
+
+iadd:   U32(pc->a) = U32(pc->b) + U32(pc->c); NEXT;
+iaddi:  U32(pc->a) = U32(pc->b) + (uint32_t)pc->c; NEXT;
+padd:   PTR(pc->a) = PTR(pc->b) + I32(pc->c); NEXT;
+isub:   U32(pc->a) = U32(pc->b) - U32(pc->c); NEXT;
+isubi:  U32(pc->a) = U32(pc->b) - (uint32_t)pc->c; NEXT;
+imul:   U32(pc->a) = U32(pc->b) * U32(pc->c); NEXT;
+imuli:  U32(pc->a) = U32(pc->b) * (uint32_t)pc->c; NEXT;
+idiv:   I32(pc->a) = I32(pc->b) / I32(pc->c); NEXT;
+imod:   I32(pc->a) = I32(pc->b) % I32(pc->c); NEXT;
+dadd:   DBL(pc->a) = DBL(pc->b) + DBL(pc->c); NEXT;
+dsub:   DBL(pc->a) = DBL(pc->b) - DBL(pc->c); NEXT;
+dmul:   DBL(pc->a) = DBL(pc->b) * DBL(pc->c); NEXT;
+ddiv:   DBL(pc->a) = DBL(pc->b) / DBL(pc->c); NEXT;
+neg:    U32(pc->a) = 0u - U32(pc->b); NEXT;
+not:    I32(pc->a) = I32(pc->b) == 0; NEXT;
+
+ieq:    I32(pc->a) = I32(pc->b) == I32(pc->c); NEXT;
+ine:    I32(pc->a) = I32(pc->b) != I32(pc->c); NEXT;
+ilt:    I32(pc->a) = I32(pc->b) <  I32(pc->c); NEXT;
+ile:    I32(pc->a) = I32(pc->b) <= I32(pc->c); NEXT;
+igt:    I32(pc->a) = I32(pc->b) >  I32(pc->c); NEXT;
+ige:    I32(pc->a) = I32(pc->b) >= I32(pc->c); NEXT;
+deq:    I32(pc->a) = DBL(pc->b) == DBL(pc->c); NEXT;
+dne:    I32(pc->a) = DBL(pc->b) != DBL(pc->c); NEXT;
+dlt:    I32(pc->a) = DBL(pc->b) <  DBL(pc->c); NEXT;
+dle:    I32(pc->a) = DBL(pc->b) <= DBL(pc->c); NEXT;
+dgt:    I32(pc->a) = DBL(pc->b) >  DBL(pc->c); NEXT;
+dge:    I32(pc->a) = DBL(pc->b) >= DBL(pc->c); NEXT;
+
+jmp:    JUMP(pc->u.to);
+bz:     BRANCH(I32(pc->b) == 0);
+bnz:    BRANCH(I32(pc->b) != 0);
+blt:    BRANCH(I32(pc->b) <  I32(pc->c));
+ble:    BRANCH(I32(pc->b) <= I32(pc->c));
+bgt:    BRANCH(I32(pc->b) >  I32(pc->c));
+bge:    BRANCH(I32(pc->b) >= I32(pc->c));
+beq:    BRANCH(I32(pc->b) == I32(pc->c));
+bne:    BRANCH(I32(pc->b) != I32(pc->c));
+blti:   BRANCH(I32(pc->b) <  pc->c);
+blei:   BRANCH(I32(pc->b) <= pc->c);
+bgti:   BRANCH(I32(pc->b) >  pc->c);
+bgei:   BRANCH(I32(pc->b) >= pc->c);
+beqi:   BRANCH(I32(pc->b) == pc->c);
+bnei:   BRANCH(I32(pc->b) != pc->c);
+
+alloc:
+    sp -= pc->b;
+    if (sp < stack + 4096) {
+        k0_flush();
+        fprintf(stderr, "Exception in thread \"main\" java.lang.StackOverflowError\n");
+        exit(1);
+    }
+    NEXT;
+malloc_: PTR(pc->a) = k0_array_alloc(VAL1(pc), pc->c); NEXT;
+calloc_: PTR(pc->a) = k0_array_new(VAL1(pc), pc->c); NEXT;
+fill: {
+    vi32 *p = (vi32 *)PTR(pc->a);
+    int32_t x = VAL2(pc);
+    for (int64_t k = VAL1(pc); k > 0; k--) *p++ = x;
+    NEXT;
+}
+
+vadd:   vkind = K_VADD; goto vbinop;
+vsub:   vkind = K_VSUB; goto vbinop;
+vmul:   vkind = K_VMUL; goto vbinop;
+vbinop: if (pc->n & 4) {
+    // Doubles: a scalar operand came in a Double register, so the
+    // pointers and the count are the Int arguments in order
+    int ai = 1, ad = ARG_DOUBLE;
+    double *dst = (double *)arg[0].i, *x = NULL, *y = NULL, xs = 0, ys = 0;
+    if (pc->n & 1) x = (double *)arg[ai++].i; else xs = arg[ad++].d;
+    if (pc->n & 2) y = (double *)arg[ai++].i; else ys = arg[ad++].d;
+    for (int64_t k = 0, cnt = (int32_t)arg[ai].i; k < cnt; k++) {
+        double l = x ? x[k] : xs, r = y ? y[k] : ys;
+        dst[k] = vkind == K_VADD ? l + r : vkind == K_VSUB ? l - r : l * r;
+    }
+    NEXT;
+} else {
+    // parms: dst, lhs, rhs, count; n bit 0/1: lhs/rhs is a vector
+    vu32 *dst = (vu32 *)arg[0].i, *x = (vu32 *)arg[1].i, *y = (vu32 *)arg[2].i;
+    uint32_t xs = (uint32_t)arg[1].i, ys = (uint32_t)arg[2].i;
+    for (int64_t k = 0, cnt = (int32_t)arg[3].i; k < cnt; k++) {
+        uint32_t l = (pc->n & 1) ? x[k] : xs, r = (pc->n & 2) ? y[k] : ys;
+        dst[k] = vkind == K_VADD ? l + r : vkind == K_VSUB ? l - r : l * r;
+    }
+    NEXT;
+}
+vsum:   vkind = K_VSUM; goto vreduce;
+vmin:   vkind = K_VMIN; goto vreduce;
+vmax:   vkind = K_VMAX; goto vreduce;
+vreduce: {
+    // the dispatch address has replaced the kind, hence vkind
+    vi32 *src = (vi32 *)arg[0].i;
+    int32_t acc = I32(pc->a);
+    for (int64_t k = 0, cnt = (int32_t)arg[1].i; k < cnt; k++) {
+        if (vkind == K_VSUM) acc = (int32_t)((uint32_t)acc + (uint32_t)src[k]);
+        else if (vkind == K_VMAX ? src[k] > acc : src[k] < acc) acc = src[k];
+    }
+    I32(pc->a) = acc;
+    NEXT;
+}
+
+abs_:   DBL(pc->a) = fabs(DBL(pc->b)); NEXT;
+dmax:   DBL(pc->a) = DBL(pc->b) > DBL(pc->c) ? DBL(pc->b) : DBL(pc->c); NEXT;
+dmin:   DBL(pc->a) = DBL(pc->b) < DBL(pc->c) ? DBL(pc->b) : DBL(pc->c); NEXT;
+pow_:   DBL(pc->a) = pow(DBL(pc->b), DBL(pc->c)); NEXT;
+sin_:   DBL(pc->a) = sin(DBL(pc->b)); NEXT;
+cos_:   DBL(pc->a) = cos(DBL(pc->b)); NEXT;
+tan_:   DBL(pc->a) = tan(DBL(pc->b)); NEXT;
+rand_:
+    if (pc->c == RAND_DOUBLE) DBL(pc->a) = k0_rand_double();
+    else if (pc->c == RAND_INT) I32(pc->a) = k0_rand_int();
+    else I32(pc->a) = k0_rand_bounded(VAL1(pc));
+    NEXT;
+
+slen:   I32(pc->a) = (int32_t)STR1(pc)->len; NEXT;
+sget: {
+    const k0_str *s = STR1(pc);
+    uint64_t k = (uint32_t)VAL2(pc);
+    if (k >= (uint64_t)s->len) k0_str_index_error((int)k, s->len);
+    I32(pc->a) = (unsigned char)s->data[k];
+    NEXT;
+}
+alen:   I32(pc->a) = (int32_t)((vi64 *)PTR(pc->b))[-2]; NEXT;
+
+aload: {
+    char *arr = PTR(pc->b);
+    int64_t k = VAL2(pc);
+    if ((pc->n & F_CHECK) && (uint64_t)k >= (uint64_t)((vi64 *)arr)[-2])
+        index_error(k, ((vi64 *)arr)[-2]);
+    switch (pc->n >> W_SHIFT) {
+        case 1:  I32(pc->a) = (((vi64 *)arr)[k >> 6] >> (k & 63)) & 1; break;
+        case 8:  I32(pc->a) = ((int8_t *)arr)[k]; break;
+        case 16: I32(pc->a) = ((int16_t *)arr)[k]; break;
+        case 64: I64(pc->a) = ((vi64 *)arr)[k]; break;
+        default: I32(pc->a) = ((vi32 *)arr)[k]; break;
+    }
+    NEXT;
+}
+astore: {
+    char *arr = PTR(pc->a);
+    int64_t k = VAL1(pc), x;
+    if ((pc->n & F_CHECK) && (uint64_t)k >= (uint64_t)((vi64 *)arr)[-2])
+        index_error(k, ((vi64 *)arr)[-2]);
+    if (pc->n & F_STR)       x = (int64_t)(intptr_t)pc->u.str;
+    else if (pc->n & F_WIDE) x = I64(pc->c);
+    else if (pc->n & F_SEXT) x = I32(pc->c);
+    else                     x = VAL2(pc);
+    switch (pc->n >> W_SHIFT) {
+        case 1: {
+            vi64 *w = &((vi64 *)arr)[k >> 6];
+            *w = (*w & ~(1LL << (k & 63))) | ((int64_t)(x & 1) << (k & 63));
+            break;
+        }
+        case 8:  ((int8_t *)arr)[k] = (int8_t)x; break;
+        case 16: ((int16_t *)arr)[k] = (int16_t)x; break;
+        case 64: ((vi64 *)arr)[k] = x; break;
+        default: ((vi32 *)arr)[k] = (int32_t)x; break;
+    }
+    NEXT;
+}
+
+parm32:  arg[pc->n].i = U32(pc->b); NEXT;
+parmi:   arg[pc->n].i = (uint32_t)pc->b; NEXT;
+parm64:  arg[pc->n].i = (uint64_t)I64(pc->b); NEXT;
+parmstr: arg[pc->n].i = (uint64_t)(uintptr_t)pc->u.str; NEXT;
+parmd:   arg[pc->n].d = DBL(pc->b); NEXT;
+
+call:
+    if (depth == VM_DEPTH) {
+        k0_flush();
+        fprintf(stderr, "Exception in thread \"main\" java.lang.StackOverflowError\n");
+        exit(1);
+    }
+    frames[depth++] = (struct frame){ pc + 1, fp, sp };
+    fp = sp - 16;           /* return address and saved %rbp */
+    sp = fp;
+    JUMP(pc->u.to);
+ccall:
+    if (pc->n == RC_DBL)
+        xmm0 = ((dcall)pc->u.fn)(arg[0].i, arg[1].i, arg[2].i, arg[3].i, arg[4].i, arg[5].i,
+                                 arg[ARG_DOUBLE].d, arg[ARG_DOUBLE + 1].d,
+                                 arg[ARG_DOUBLE + 2].d, arg[ARG_DOUBLE + 3].d,
+                                 arg[ARG_DOUBLE + 4].d, arg[ARG_DOUBLE + 5].d,
+                                 arg[ARG_DOUBLE + 6].d, arg[ARG_DOUBLE + 7].d);
+    else
+        rax = ((icall)pc->u.fn)(arg[0].i, arg[1].i, arg[2].i, arg[3].i, arg[4].i, arg[5].i,
+                                arg[ARG_DOUBLE].d, arg[ARG_DOUBLE + 1].d,
+                                arg[ARG_DOUBLE + 2].d, arg[ARG_DOUBLE + 3].d,
+                                arg[ARG_DOUBLE + 4].d, arg[ARG_DOUBLE + 5].d,
+                                arg[ARG_DOUBLE + 6].d, arg[ARG_DOUBLE + 7].d);
+    goto result;
+
+reti:   rax = (uint32_t)pc->b; goto ret;
+ret32:  rax = U32(pc->b); goto ret;
+ret64:  rax = (uint64_t)I64(pc->b); goto ret;
+retstr: rax = (uint64_t)(uintptr_t)pc->u.str; goto ret;
+retd:   xmm0 = DBL(pc->b); goto ret;
+ret: {
+    struct frame *f = &frames[--depth];
+    fp = f->fp;
+    sp = f->sp;
+    if (!f->ret) goto done;
+    pc = f->ret - 1;
+}
+result:
+    switch (pc->n) {
+        case RC_INT: U32(pc->a) = (uint32_t)rax; break;
+        case RC_PTR: I64(pc->a) = (int64_t)rax; break;
+        case RC_DBL: DBL(pc->a) = xmm0; break;
+    }
+    NEXT;
+
+done:
+    free(stack);
+    free(frames);
+    free(arg);
+    return rax;
+
+#undef NEXT
+#undef JUMP
+#undef BRANCH
+#undef VAL1
+#undef VAL2
+#undef STR1
+}
+
+int vm_run(const struct tac_program *prog) {
+    struct encoder e = { .prog = prog };
+    e.lits = calloc(prog->nstrings + 1, sizeof *e.lits);
+    for (int k = 0; k < prog->nstrings; k++) make_literal(&e.lits[k], prog->strings[k]);
+
+    declare_funcs(&e);
+    for (struct instr *i = prog->code; i; i = i->next) encode(&e, i);
+    link_ops(&e);
+    int main_at = find_func(&e, "main");
+    if (main_at < 0) vm_error("no %s function", "main");
+    free(e.origin);
+    free(e.label);
+    free(e.func);
+    return (int)run(e.ops, e.nops, &e.ops[main_at], e.maxstack);
+}
+
+/* ---------------------------------------------------------------- .ic files */
+
+extern char *regionname(int i);
+extern char *opcodename(int i);
+
+static int opcode_number(const char *name) {
+    for (int op = O_ADD; op <= O_ASTORE; op++)
+        if (strcmp(opcodename(op), name) == 0) return op;
+    for (int op = D_GLOB; op <= D_PROT; op++)
+        if (strcmp(opcodename(op), name) == 0) return op;
+    if (strcmp(name, "DMOD") == 0) return O_DMOD;
+    return -1;
+}
+
+/* region:number as format_operand writes it, or a bare name */
+static int ic_operand(const char *tok, struct addr *a) {
+    const char *colon = strchr(tok, ':');
+    if (colon) {
+        for (int r = R_GLOBAL; r <= R_RET; r++) {
+            const char *name = regionname(r);
+            if (strlen(name) == (size_t)(colon - tok) && strncmp(name, tok, colon - tok) == 0) {
+                a->region = r;
+                a->u.offset = atoi(colon + 1);
+                return 1;
+            }
+        }
+        return 0;
+    }
+    a->region = R_NAME;
+    a->u.name = strdup(tok);
+    return 1;
+}
+
+static int ic_instr(char *line, struct instr *i) {
+    char *tok = strtok(line, " \t\n");
+    struct addr *opnd[] = { &i->dest, &i->src1, &i->src2 };
+    memset(i, 0, sizeof *i);
+    if ((i->opcode = opcode_number(tok)) < 0) return 0;
+    for (int k = 0; k < 3; k++)
+        if (!(tok = strtok(NULL, " \t\n")) || !ic_operand(tok, opnd[k])) return 0;
+    while ((tok = strtok(NULL, " \t\n"))) {
+        if (strcmp(tok, "d") == 0)              i->is_double = 1;
+        else if (strcmp(tok, "p") == 0)         i->is_ptr = 1;
+        else if (strcmp(tok, "u") == 0)         i->unchecked = 1;
+        else if (strncmp(tok, "w=", 2) == 0)    i->width = atoi(tok + 2);
+        else return 0;
+    }
+    return 1;
+}
+
+/*
+ * Read back what write_ic_file wrote: the .string and .double tables
+ * and the .code list.  Returns 0, or -1 after printing why not.
+ */
+int read_ic_file(const char *file, struct tac_program *p) {
+    enum { SEC_NONE, SEC_STRING, SEC_DOUBLE, SEC_DATA, SEC_CODE } sec = SEC_NONE;
+    FILE *f = fopen(file, "r");
+    char *line = NULL;
+    size_t size = 0;
+    int lineno = 0, capstr = 0, capdbl = 0;
+    struct instr **tail = &p->code;
+
+    if (!f) {
+        fprintf(stderr, "k0: cannot open %s\n", file);
+        return -1;
+    }
+    memset(p, 0, sizeof *p);
+    while (getline(&line, &size, f) > 0) {
+        char *s = line, *tab;
+        lineno++;
+        line[strcspn(line, "\n")] = '\0';
+        while (*s == ' ' || *s == '\t') s++;
+        if (*s == '\0' || strncmp(s, "/*", 2) == 0) continue;
+        if (strcmp(s, ".string") == 0) { sec = SEC_STRING; continue; }
+        if (strcmp(s, ".double") == 0) { sec = SEC_DOUBLE; continue; }
+        if (strcmp(s, ".data") == 0)   { sec = SEC_DATA; continue; }
+        if (strcmp(s, ".code") == 0)   { sec = SEC_CODE; continue; }
+
+        int ok = 1;
+        switch (sec) {
+            case SEC_STRING: {
+                // S<n>\t"<text as in the source>", quotes and all
+                size_t n;
+                if (!(tab = strchr(s, '\t')) || (n = strlen(tab + 1)) < 2 ||
+                    tab[1] != '"' || tab[n] != '"') {
+                    ok = 0;
+                    break;
+                }
+                tab[n] = '\0';
+                p->strings = grow(p->strings, sizeof *p->strings, p->nstrings + 1, &capstr);
+                p->strings[p->nstrings++] = strdup(tab + 2);
+                break;
+            }
+            case SEC_DOUBLE:
+                if (!(tab = strchr(s, '\t'))) {
+                    ok = 0;
+                    break;
+                }
+                p->reals = grow(p->reals, sizeof *p->reals, p->nreals + 1, &capdbl);
+                p->reals[p->nreals++] = strtod(tab + 1, NULL);
+                break;
+            case SEC_CODE: {
+                struct instr *i = malloc(sizeof *i);
+                if (!i) {
+                    fprintf(stderr, "out of memory\n");
+                    exit(4);
+                }
+                if (!(ok = ic_instr(s, i))) {
+                    free(i);
+                    break;
+                }
+                *tail = i;
+                tail = &i->next;
+                break;
+            }
+            default:
+                break;
+        }
+        if (!ok) {
+            fprintf(stderr, "%s:%d: cannot read intermediate code\n", file, lineno);
+            free(line);
+            fclose(f);
+            return -1;
+        }
+    }
+    free(line);
+    fclose(f);
+    return 0;
+}
@@ -0,0 +1,12 @@
+#ifndef VM_H
+#define VM_H
+
+#include "tac.h"
+
+/* run a program on the TAC virtual machine; returns main's exit status */
+int vm_run(const struct tac_program *prog);
+
+/* load a .ic file written by write_ic_file; 0 on success */
+int read_ic_file(const char *file, struct tac_program *p);
+
+#endif